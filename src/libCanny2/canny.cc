@@ -52,9 +52,15 @@
 /****************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
 
+#include <parallelfor.hh>
 #include <gaussderiv.hh>
+#include <fastgaussbank.hh>
 #include "canny.hh"
 
 #define BOOSTBLURFACTOR  1.0 //90.0
@@ -78,7 +84,7 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     int r, c, pos;
     float *dir_radians=NULL;   /* Gradient direction image.                */
     GrayImage img_dx, img_dy, img_mag;
-    GrayImage img_nms;
+    vector<unsigned char> vNms;  /* non-maximum suppression labels */
     int rows, cols;
 
     rows = image.height();
@@ -92,12 +98,14 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
         printf("Smoothing the image using a gaussian kernel.\n");
     if(VERBOSE)
         printf("Computing the X and Y first derivatives.\n");
-    FastGaussDxDy( image, sigma, img_dx, img_dy, BOOSTBLURFACTOR );
-
-    /*********************************************************************
-     * Compute the magnitude of the gradient
-     *********************************************************************/
-    FastGaussMag( img_dx, img_dy, img_mag );
+    /* (the magnitude is computed in the same pass) */
+    FastGaussBank fgb;
+    int nReq = fgb.addRequest( sigma, FGB_DX | FGB_DY | FGB_MAG,
+                               BOOSTBLURFACTOR );
+    fgb.apply( image );
+    img_dx  = fgb.getResult( nReq, FGB_DX );
+    img_dy  = fgb.getResult( nReq, FGB_DY );
+    img_mag = fgb.getResult( nReq, FGB_MAG );
 
     /***********************************************************************
       * Perform non-maximum suppression.
@@ -105,18 +113,14 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     if(VERBOSE)
         printf("Doing the non-maximal suppression.\n");
     //non_max_supp(img_mag, img_dx, img_dy, nms);
-    non_max_supp(img_mag, img_dx, img_dy, img_nms);
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
 
     /***********************************************************************
       * Use hysteresis to mark the edge pixels.
       ***********************************************************************/
-    /* intialize the edge image */
-    GrayImage tmp(image);
-    img_edge = tmp;
-
     if(VERBOSE)
         printf("Applying the hysteresis.\n");
-    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
 }
 
 
@@ -135,7 +139,7 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     float *dir_radians=NULL;   /* Gradient direction image.                */
     GrayImage img_dx, img_dy;
     GrayImage img_mag;
-    GrayImage img_nms;
+    vector<unsigned char> vNms;  /* non-maximum suppression labels */
     int rows, cols;
 
     rows = image.height();
@@ -149,13 +153,16 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
         printf("Smoothing the image using a gaussian kernel.\n");
     if(VERBOSE)
         printf("Computing the X and Y first derivatives.\n");
-    FastGaussDxDy( image, sigma, img_dx, img_dy, BOOSTBLURFACTOR );
-
-    /*********************************************************************
-     * Compute the magnitude and the direction up the gradient (the latter 
-     * in radians that are specified counteclockwise from the positive x-axis.)
-     *********************************************************************/
-    FastGaussMagDir( img_dx, img_dy, img_mag, img_dir );
+    /* (together with the magnitude and the direction up the gradient, */
+    /*  the latter in radians counterclockwise from the positive x-axis) */
+    FastGaussBank fgb;
+    int nReq = fgb.addRequest( sigma, FGB_DX | FGB_DY | FGB_MAG | FGB_DIR,
+                               BOOSTBLURFACTOR );
+    fgb.apply( image );
+    img_dx  = fgb.getResult( nReq, FGB_DX );
+    img_dy  = fgb.getResult( nReq, FGB_DY );
+    img_mag = fgb.getResult( nReq, FGB_MAG );
+    img_dir = fgb.getResult( nReq, FGB_DIR );
 
     /***********************************************************************
       * Perform non-maximum suppression.
@@ -167,16 +174,12 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     // 		exit(1);
     // 	}
 
-    non_max_supp(img_mag, img_dx, img_dy, img_nms);
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
 
     /***********************************************************************
       * Use hysteresis to mark the edge pixels.
       ***********************************************************************/
-    /* intialize the edge image */
-    GrayImage tmp(image);
-    img_edge = tmp;
-
-    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
 
     /***************************************************************************
       * Free all of the memory that we allocated except for the edge image that
@@ -200,7 +203,7 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     int r, c, pos;
     float *dir_radians=NULL;   /* Gradient direction image.                */
     GrayImage img_dx, img_dy;
-    GrayImage img_nms;
+    vector<unsigned char> vNms;  /* non-maximum suppression labels */
     int rows, cols;
 
     rows = image.height();
@@ -214,13 +217,16 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
         printf("Smoothing the image using a gaussian kernel.\n");
     if(VERBOSE)
         printf("Computing the X and Y first derivatives.\n");
-    FastGaussDxDy( image, sigma, img_dx, img_dy, BOOSTBLURFACTOR );
-
-    /*********************************************************************
-     * Compute the magnitude and the direction up the gradient (the latter 
-     * in radians that are specified counteclockwise from the positive x-axis.)
-     *********************************************************************/
-    FastGaussMagDir( img_dx, img_dy, img_mag, img_dir );
+    /* (together with the magnitude and the direction up the gradient, */
+    /*  the latter in radians counterclockwise from the positive x-axis) */
+    FastGaussBank fgb;
+    int nReq = fgb.addRequest( sigma, FGB_DX | FGB_DY | FGB_MAG | FGB_DIR,
+                               BOOSTBLURFACTOR );
+    fgb.apply( image );
+    img_dx  = fgb.getResult( nReq, FGB_DX );
+    img_dy  = fgb.getResult( nReq, FGB_DY );
+    img_mag = fgb.getResult( nReq, FGB_MAG );
+    img_dir = fgb.getResult( nReq, FGB_DIR );
 
     /***********************************************************************
       * Perform non-maximum suppression.
@@ -232,16 +238,12 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
     // 		exit(1);
     // 	}
 
-    non_max_supp(img_mag, img_dx, img_dy, img_nms);
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
 
     /***********************************************************************
       * Use hysteresis to mark the edge pixels.
       ***********************************************************************/
-    /* intialize the edge image */
-    GrayImage tmp(image);
-    img_edge = tmp;
-
-    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
 
     /***************************************************************************
       * Free all of the memory that we allocated except for the edge image that
@@ -267,7 +269,7 @@ void canny( const GrayImage &img_dx, const GrayImage &img_dy,
     float *dir_radians=NULL;   /* Gradient direction image.                */
     //GrayImage img_dx, img_dy;
     GrayImage img_mag;
-    GrayImage img_nms;
+    vector<unsigned char> vNms;  /* non-maximum suppression labels */
     int rows, cols;
 
     rows = img_dx.height();
@@ -292,633 +294,573 @@ void canny( const GrayImage &img_dx, const GrayImage &img_dy,
     if(VERBOSE)
         printf("Doing the non-maximal suppression.\n");
     //non_max_supp(img_mag, img_dx, img_dy, nms);
-    non_max_supp(img_mag, img_dx, img_dy, img_nms);
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
 
     /***********************************************************************
       * Use hysteresis to mark the edge pixels.
       ***********************************************************************/
-    /* intialize the edge image */
-    GrayImage tmp(cols,rows);
-    img_edge = tmp;
-
     if(VERBOSE)
         printf("Applying the hysteresis.\n");
-    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
 }
 
 
-void canny( const GrayImage& img_mag, float sigma, float tlow, float thigh,
-            int direction, GrayImage& img_edge)
+void canny( const GrayImage &img_dx, const GrayImage &img_dy,
+            const GrayImage &img_mag, float tlow, float thigh,
+            GrayImage &img_edge )
+  /*******************************************************************/
+  /* Canny edge detection on precomputed derivatives and gradient    */
+  /* magnitude (e.g. several scales from one FastGaussBank pass).    */
+  /* Only performs the non-maximum suppression and the hysteresis.   */
+  /*******************************************************************/
 {
-    unsigned char *nms;        /* Points that are local maximal magnitude. */
-    int r, c, pos;
-    float *dir_radians=NULL;   /* Gradient direction image.                */
-    GrayImage img_dx, img_dy;
-    GrayImage img_nms;
-    int rows, cols;
-
-    rows = img_mag.height();
-    cols = img_mag.width();
+    vector<unsigned char> vNms;  /* non-maximum suppression labels */
 
-    /***********************************************************************
-     * Perform non-maximum suppression.
-     ***********************************************************************/
     if(VERBOSE)
         printf("Doing the non-maximal suppression.\n");
-    //non_max_supp(img_mag, img_dx, img_dy, nms);
-    non_max_supp(img_mag, direction, img_nms);
-
-    /***********************************************************************
-     * Use hysteresis to mark the edge pixels.
-     ***********************************************************************/
-    /* intialize the edge image */
-    GrayImage tmp(img_mag);
-    img_edge = tmp;
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
 
     if(VERBOSE)
         printf("Applying the hysteresis.\n");
-    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
-
-}
-
-void apply_hysteresis( const GrayImage &img_mag, const GrayImage &img_nms,
-                       float tlow, float thigh, GrayImage &img_edge )
-/*******************************************************************/
-/* PROCEDURE: apply_hysteresis                                     */
-/* PURPOSE: This routine finds edges that are above some high      */
-/*          threshhold or are connected to a high pixel by a path  */
-/*          of pixels greater than a low threshold.                */
-/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
-/* DATE: 2/15/96                                                   */
-/********************************************************************/
-{
-    int r, c, pos, numedges, lowcount, highcount, lowthreshold, highthreshold,
-    i, hist[32768], rr, cc;
-    short int maximum_mag, sumpix;
-    int rows, cols;
-
-    rows = img_mag.height();
-    cols = img_mag.width();
-
-    /***************************************************************************
-      * Initialize the edge map to possible edges everywhere the non-maximal
-      * suppression suggested there could be an edge except for the border. At
-      * the border we say there can not be an edge because it makes the
-      * follow_edges algorithm more efficient to not worry about tracking an
-      * edge off the side of the image.
-      ***************************************************************************/
-    for(r=0,pos=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++,pos++)
-        {
-            if(img_nms(c,r).value() == (float) POSSIBLE_EDGE)
-                img_edge(c,r) = (float) POSSIBLE_EDGE;
-            else
-                img_edge(c,r) = (float) NOEDGE;
-        }
-    }
-
-    for(r=0;r<rows;r++)
-    {
-        img_edge(0,r)      = (float) NOEDGE;
-        img_edge(cols-1,r) = (float) NOEDGE;
-    }
-    for(c=0;c<cols;c++)
-    {
-        img_edge(c,0)      = (float) NOEDGE;
-        img_edge(c,rows-1) = (float) NOEDGE;
-    }
-
-    /***************************************************************************
-      * Compute the histogram of the magnitude image. Then use the histogram to
-      * compute hysteresis thresholds.
-      ***************************************************************************/
-    for(r=0;r<32768;r++)
-        hist[r] = 0;
-    for(r=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++)
-        {
-            if(img_edge(c,r).value() == (float) POSSIBLE_EDGE)
-                hist[(short int) img_mag(c,r).value()]++;
-        }
-    }
-
-    /***************************************************************************
-      * Compute the number of pixels that passed the nonmaximal suppression.
-      ***************************************************************************/
-    for(r=1,numedges=0;r<32768;r++)
-    {
-        if(hist[r] != 0)
-            maximum_mag = r;
-        numedges += hist[r];
-    }
-
-    highcount = (int)(numedges * thigh + 0.5);
-
-    /***************************************************************************
-      * Compute the high threshold value as the (100 * thigh) percentage point
-      * in the magnitude of the gradient histogram of all the pixels that passes
-      * non-maximal suppression. Then calculate the low threshold as a fraction
-      * of the computed high threshold value. John Canny said in his paper
-      * "A Computational Approach to Edge Detection" that "The ratio of the
-      * high to low threshold in the implementation is in the range two or three
-      * to one." That means that in terms of this implementation, we should
-      * choose tlow ~= 0.5 or 0.33333.
-      ***************************************************************************/
-    r = 1;
-    numedges = hist[1];
-    while((r<(maximum_mag-1)) && (numedges < highcount))
-    {
-        r++;
-        numedges += hist[r];
-    }
-    highthreshold = r;
-    lowthreshold = (int)(highthreshold * tlow + 0.5);
-
-    if(VERBOSE)
-    {
-        printf("The input low and high fractions of %f and %f computed to\n",
-               tlow, thigh);
-        printf("magnitude of the gradient threshold values of: %d %d\n",
-               lowthreshold, highthreshold);
-    }
-
-    /***************************************************************************
-      * This loop looks for pixels above the highthreshold to locate edges and
-      * then calls follow_edges to continue the edge.
-      ***************************************************************************/
-    for(r=1;r<rows-1;r++)
-    {
-        for(c=1;c<cols-1;c++)
-        {
-            if((img_edge(c,r).value() == (float) POSSIBLE_EDGE) &&
-                    (img_mag(c,r).value() >= highthreshold))
-            {
-                img_edge(c,r) = (float) EDGE;
-                follow_edges(img_edge, img_mag, c,r, lowthreshold );
-                // 				follow_edges((edge+pos), (mag+pos), lowthreshold, cols);
-            }
-        }
-    }
-
-    /***************************************************************************
-      * Set all the remaining possible edges to non-edges.
-      ***************************************************************************/
-    for(r=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++)
-            if(img_edge(c,r).value() != (float) EDGE)
-                img_edge(c,r) = (float) NOEDGE;
-    }
-}
-
-
-void apply_hysteresis( const GrayImage &img_mag, unsigned char *nms,
-                       float tlow, float thigh, GrayImage &img_edge )
-/*******************************************************************/
-/* PROCEDURE: apply_hysteresis                                     */
-/* PURPOSE: This routine finds edges that are above some high      */
-/*          threshhold or are connected to a high pixel by a path  */
-/*          of pixels greater than a low threshold.                */
-/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
-/* DATE: 2/15/96                                                   */
-/********************************************************************/
-{
-    int r, c, pos, numedges, lowcount, highcount, lowthreshold, highthreshold,
-    i, hist[32768], rr, cc;
-    short int maximum_mag, sumpix;
-    int rows, cols;
-
-    rows = img_mag.height();
-    cols = img_mag.width();
-
-    /***************************************************************************
-      * Initialize the edge map to possible edges everywhere the non-maximal
-      * suppression suggested there could be an edge except for the border. At
-      * the border we say there can not be an edge because it makes the
-      * follow_edges algorithm more efficient to not worry about tracking an
-      * edge off the side of the image.
-      ***************************************************************************/
-    for(r=0,pos=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++,pos++)
-        {
-            if(nms[pos] == POSSIBLE_EDGE)
-                img_edge(c,r) = (float) POSSIBLE_EDGE;
-            else
-                img_edge(c,r) = (float) NOEDGE;
-        }
-    }
-
-    for(r=0;r<rows;r++)
-    {
-        img_edge(0,r)      = (float) NOEDGE;
-        img_edge(cols-1,r) = (float) NOEDGE;
-    }
-    for(c=0;c<cols;c++)
-    {
-        img_edge(c,0)      = (float) NOEDGE;
-        img_edge(c,rows-1) = (float) NOEDGE;
-    }
-
-    /***************************************************************************
-      * Compute the histogram of the magnitude image. Then use the histogram to
-      * compute hysteresis thresholds.
-      ***************************************************************************/
-    for(r=0;r<32768;r++)
-        hist[r] = 0;
-    for(r=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++)
-        {
-            if(img_edge(c,r).value() == (float) POSSIBLE_EDGE)
-                hist[(short int) img_mag(c,r).value()]++;
-        }
-    }
-
-    /***************************************************************************
-      * Compute the number of pixels that passed the nonmaximal suppression.
-      ***************************************************************************/
-    for(r=1,numedges=0;r<32768;r++)
-    {
-        if(hist[r] != 0)
-            maximum_mag = r;
-        numedges += hist[r];
-    }
-
-    highcount = (int)(numedges * thigh + 0.5);
-
-    /***************************************************************************
-      * Compute the high threshold value as the (100 * thigh) percentage point
-      * in the magnitude of the gradient histogram of all the pixels that passes
-      * non-maximal suppression. Then calculate the low threshold as a fraction
-      * of the computed high threshold value. John Canny said in his paper
-      * "A Computational Approach to Edge Detection" that "The ratio of the
-      * high to low threshold in the implementation is in the range two or three
-      * to one." That means that in terms of this implementation, we should
-      * choose tlow ~= 0.5 or 0.33333.
-      ***************************************************************************/
-    r = 1;
-    numedges = hist[1];
-    while((r<(maximum_mag-1)) && (numedges < highcount))
-    {
-        r++;
-        numedges += hist[r];
-    }
-    highthreshold = r;
-    lowthreshold = (int)(highthreshold * tlow + 0.5);
-
-    if(VERBOSE)
-    {
-        printf("The input low and high fractions of %f and %f computed to\n",
-               tlow, thigh);
-        printf("magnitude of the gradient threshold values of: %d %d\n",
-               lowthreshold, highthreshold);
-    }
-
-    /***************************************************************************
-      * This loop looks for pixels above the highthreshold to locate edges and
-      * then calls follow_edges to continue the edge.
-      ***************************************************************************/
-    for(r=0,pos=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++,pos++)
-        {
-            if((img_edge(c,r).value() == (float) POSSIBLE_EDGE) &&
-                    (img_mag(c,r).value() >= highthreshold))
-            {
-                img_edge(c,r) = (float) EDGE;
-                follow_edges(img_edge, img_mag, c,r, lowthreshold );
-                // 				follow_edges((edge+pos), (mag+pos), lowthreshold, cols);
-            }
-        }
-    }
-
-    /***************************************************************************
-      * Set all the remaining possible edges to non-edges.
-      ***************************************************************************/
-    for(r=0,pos=0;r<rows;r++)
-    {
-        for(c=0;c<cols;c++,pos++)
-            if(img_edge(c,r).value() != (float) EDGE)
-                img_edge(c,r) = (float) NOEDGE;
-    }
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
 }
 
 
-void follow_edges( GrayImage &img_edge, const GrayImage &img_mag,
-                   int pos_x, int pos_y, short lowval )
-// void follow_edges(unsigned char *edgemapptr, short *edgemagptr,
-//             short lowval, int cols)
-/*******************************************************************/
-/* PROCEDURE: follow_edges                                         */
-/* PURPOSE: This procedure edges is a recursive routine that tra-  */
-/*          ces edgs along all paths whose magnitude values remain */
-/*          above some specifyable lower threshold.                */
-/* AUTHOR: Mike Heath                                              */
-/* DATE: 2/15/96                                                   */
-/*******************************************************************/
-{
-    short *tempmagptr;
-    unsigned char *tempmapptr;
-    int i;
-    float thethresh;
-    int x[8] = {1,1,0,-1,-1,-1,0,1};
-    int y[8] = {0,1,1,1,0,-1,-1,-1};
-    int cols;
-    int tmp_x, tmp_y;
-
-    cols = img_edge.width();
-
-    for(i=0;i<8;i++)
-    {
-        tmp_x = pos_x + x[i];
-        tmp_y = pos_y - y[i];
-        // 		tempmapptr = edgemapptr - y[i]*cols + x[i];
-        // 		tempmagptr = edgemagptr - y[i]*cols + x[i];
-
-        if( (img_edge(tmp_x,tmp_y).value() == (float) POSSIBLE_EDGE) &&
-                (img_mag(tmp_x,tmp_y).value() > (float) lowval) )
-        {
-            // 		if((*tempmapptr == POSSIBLE_EDGE) && (*tempmagptr > lowval)){
-            img_edge(tmp_x,tmp_y) = (float) EDGE;
-            follow_edges( img_edge, img_mag, tmp_x, tmp_y, lowval );
-            // 			*tempmapptr = (unsigned char) EDGE;
-            // 			follow_edges(tempmapptr,tempmagptr, lowval, cols);
-        }
-    }
-}
-
-
-void non_max_supp( const GrayImage &img_mag, const GrayImage &img_dx,
-                   const GrayImage &img_dy, GrayImage &result )
-/*******************************************************************/
-/* PROCEDURE: non_max_supp                                         */
-/* PURPOSE: applies non-maximal suppression to the magnitude of    */
-/*          the gradient image.                                    */
-/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
-/* DATE: 2/15/96                                                   */
-/********************************************************************/
+void canny( const GrayImage& img_mag, float sigma, float tlow, float thigh,
+            int direction, GrayImage& img_edge)
 {
-    //int rowcount, colcount;
-    int count;
-    //short *magrowptr,*magptr;
-    //short *gxrowptr,*gxptr;
-    //short *gyrowptr,*gyptr,z1,z2;
-    float z1, z2;
-    float m00, gx, gy;
-    //short m00,gx,gy;
-    float mag1,mag2,xperp,yperp;
-    //unsigned char *resultrowptr, *resultptr;
-    int ncols, nrows;
-    int c,r;
-    int x,y;
-
-    nrows = img_mag.height();
-    ncols = img_mag.width();
-
-    /* initialize the result image */
-    GrayImage tmp( img_mag.width(), img_mag.height() );
-    result = tmp;
-
-    /***********************************************************************
-      * Zero the edges of the result image.
-      ***********************************************************************/
-    for(c=0; c<ncols; c++)
-    {
-        result(c,0)       = (float) NOEDGE;  //0.0;
-        result(c,nrows-1) = (float) NOEDGE;  //0.0;
-    }
-
-    for(r=0; r<nrows; r++)
-    {
-        result(0,r)       = (float) NOEDGE;  //0.0;
-        result(ncols-1,r) = (float) NOEDGE;  //0.0;
-    }
-
-    /***********************************************************************
-      * Suppress non-maximum points.
-      ***********************************************************************/
-    for( y=1; y<nrows-1; y++ )
-    {
-        // 	for(rowcount=1,magrowptr=mag+ncols+1,gxrowptr=gradx+ncols+1,
-        // 				gyrowptr=grady+ncols+1,resultrowptr=result+ncols+1;
-        //       rowcount<nrows-2;
-        //       rowcount++,magrowptr+=ncols,gyrowptr+=ncols,gxrowptr+=ncols,
-        // 				resultrowptr+=ncols){
-        for( x=1; x<ncols-1; x++ )
-        {
-            // 		for(colcount=1,magptr=magrowptr,gxptr=gxrowptr,gyptr=gyrowptr,
-            // 					resultptr=resultrowptr;colcount<ncols-2;
-            // 				colcount++,magptr++,gxptr++,gyptr++,resultptr++){
-            m00 = img_mag(x,y).value();
-            // 			m00 = *magptr;
-            if( m00 == 0.0 )
-            {
-                result(x,y) = (float) NOEDGE;
-                //*resultptr = (unsigned char) NOEDGE;
-            }
-            else
-            {
-                xperp = -(gx = img_dx(x,y).value())/m00;
-                yperp =  (gy = img_dy(x,y).value())/m00;
-                // 				xperp = -(gx = *gxptr)/((float)m00);
-                // 				yperp =  (gy = *gyptr)/((float)m00);
-            }
-
-            if(gx >= 0.0)
-            {
-                if(gy >= 0.0)
-                {
-                    if (gx >= gy)
-                    {
-                        /* 111 */
-                        /* Left point */
-                        z1 = img_mag(x-1,y).value();
-                        z2 = img_mag(x-1,y-1).value();
-                        // 							z1 = *(magptr - 1);
-                        // 							z2 = *(magptr - ncols - 1);
+    unsigned char *nms;        /* Points that are local maximal magnitude. */
+    int r, c, pos;
+    float *dir_radians=NULL;   /* Gradient direction image.                */
+    GrayImage img_dx, img_dy;
+    GrayImage img_nms;
+    int rows, cols;
 
-                        mag1 = (m00 - z1)*xperp + (z2 - z1)*yperp;
+    rows = img_mag.height();
+    cols = img_mag.width();
 
-                        /* Right point */
-                        z1 = img_mag(x+1,y).value();
-                        z2 = img_mag(x+1,y+1).value();
-                        // 							z1 = *(magptr + 1);
-                        // 							z2 = *(magptr + ncols + 1);
+    /***********************************************************************
+     * Perform non-maximum suppression.
+     ***********************************************************************/
+    if(VERBOSE)
+        printf("Doing the non-maximal suppression.\n");
+    //non_max_supp(img_mag, img_dx, img_dy, nms);
+    non_max_supp(img_mag, direction, img_nms);
 
-                        mag2 = (m00 - z1)*xperp + (z2 - z1)*yperp;
-                    }
-                    else
-                    {
-                        /* 110 */
-                        /* Left point */
-                        z1 = img_mag(x  ,y-1).value();
-                        z2 = img_mag(x-1,y-1).value();
-                        // 							z1 = *(magptr - ncols);
-                        // 							z2 = *(magptr - ncols - 1);
+    /***********************************************************************
+     * Use hysteresis to mark the edge pixels.
+     ***********************************************************************/
+    if(VERBOSE)
+        printf("Applying the hysteresis.\n");
+    apply_hysteresis(img_mag, img_nms, tlow, thigh, img_edge);
 
-                        mag1 = (z1 - z2)*xperp + (z1 - m00)*yperp;
+}
 
-                        /* Right point */
-                        z1 = img_mag(x  ,y+1).value();
-                        z2 = img_mag(x+1,y+1).value();
-                        // 							z1 = *(magptr + ncols);
-                        // 							z2 = *(magptr + ncols + 1);
 
-                        mag2 = (z1 - z2)*xperp + (z1 - m00)*yperp;
-                    }
-                }
-                else
-                {
-                    if (gx >= -gy)
-                    {
-                        /* 101 */
-                        /* Left point */
-                        z1 = img_mag(x-1,y).value();
-                        z2 = img_mag(x-1,y+1).value();
-                        // 								z1 = *(magptr - 1);
-                        // 								z2 = *(magptr + ncols - 1);
+/*========================================================================*/
+/*        Banded non-maximum suppression and iterative hysteresis         */
+/*========================================================================*/
+/* The image rows are split into one band per thread (see parallelfor.hh) */
+/* and the intermediate results are kept in unsigned char label maps.     */
+/* The suppression evaluates all eight neighbors of a pixel and selects   */
+/* among them without branches, so the row loops can be vectorized. The   */
+/* hysteresis traces the edges with an explicit stack, first within each  */
+/* band in parallel, then (in one serial pass) across the band borders.   */
+/* The edge maps are identical to those of the original recursive code.   */
+
+static int g_nCannyThreads = 0;
+
+void setCannyNumThreads( int nThreads )
+  /* number of threads for the Canny stages (<=0: one per processor) */
+{
+  g_nCannyThreads = nThreads;
+}
 
-                        mag1 = (m00 - z1)*xperp + (z1 - z2)*yperp;
 
-                        /* Right point */
-                        z1 = img_mag(x+1,y).value();
-                        z2 = img_mag(x+1,y-1).value();
-                        // 								z1 = *(magptr + 1);
-                        // 								z2 = *(magptr - ncols + 1);
+int getCannyNumThreads()
+{
+  return g_nCannyThreads;
+}
 
-                        mag2 = (m00 - z1)*xperp + (z1 - z2)*yperp;
-                    }
-                    else
-                    {
-                        /* 100 */
-                        /* Left point */
-                        z1 = img_mag(x  ,y+1).value();
-                        z2 = img_mag(x-1,y+1).value();
-                        // 								z1 = *(magptr + ncols);
-                        // 								z2 = *(magptr + ncols - 1);
 
-                        mag1 = (z1 - z2)*xperp + (m00 - z1)*yperp;
+static int cannyBands( int rows )
+  /* number of bands (=threads) for an image of the given height */
+{
+  int nMaxBands = (rows-2) / CANNY_MIN_BAND_ROWS;
+  return getNumThreads( g_nCannyThreads, (nMaxBands > 1) ? nMaxBands : 1 );
+}
 
-                        /* Right point */
-                        z1 = img_mag(x  ,y-1).value();
-                        z2 = img_mag(x+1,y-1).value();
-                        // 								z1 = *(magptr - ncols);
-                        // 								z2 = *(magptr - ncols + 1);
 
-                        mag2 = (z1 - z2)*xperp  + (m00 - z1)*yperp;
-                    }
-                }
-            }
-            else
-            {
-                if (gy >= 0)
-                    // 					if ((gy = *gyptr) >= 0)
-                {
-                    if (-gx >= gy)
-                    {
-                        /* 011 */
-                        /* Left point */
-                        z1 = img_mag(x+1,y).value();
-                        z2 = img_mag(x+1,y-1).value();
-                        // 									z1 = *(magptr + 1);
-                        // 									z2 = *(magptr - ncols + 1);
+struct CannyNmsTask
+{
+  ImageView<GrayPixel>  vMag;
+  ImageView<GrayPixel>  vDx;
+  ImageView<GrayPixel>  vDy;
+  unsigned char        *pNms;
+
+  void operator()( int nThread, int nBegin, int nEnd );
+};
+
+
+void CannyNmsTask::operator()( int nThread, int nBegin, int nEnd )
+  /*******************************************************************/
+  /* Suppress the non-maxima in rows [nBegin,nEnd). The comparison   */
+  /* points are those of non_max_supp() by Mike Heath. Depending on  */
+  /* the gradient octant, mag1 and mag2 are                          */
+  /*                                                                 */
+  /*   |gx| >= |gy|:  sx*(m00-z1)*xperp + sy*(z2-z1)*yperp           */
+  /*   |gx| <  |gy|: -sx*(z2-z1)*xperp  - sy*(m00-z1)*yperp          */
+  /*                                                                 */
+  /* (sx, sy: signs of gx, gy; z1: horizontal resp. vertical, z2:    */
+  /* diagonal neighbor). Multiplying by +-1 is exact, so the results */
+  /* are bit-identical to the octant-wise code.                      */
+  /*******************************************************************/
+{
+  int cols = vMag.width();
+
+  for( int r=nBegin; r<nEnd; r++ ) {
+    const GrayPixel *pMag  = vMag.rowPtr(r);
+    const GrayPixel *pUp   = vMag.rowPtr(r-1);
+    const GrayPixel *pDown = vMag.rowPtr(r+1);
+    const GrayPixel *pDx   = vDx.rowPtr(r);
+    const GrayPixel *pDy   = vDy.rowPtr(r);
+    unsigned char   *pRes  = pNms + r*cols;
+
+    for( int c=1; c<cols-1; c++ ) {
+      float m00 = pMag[c].value();
+      float gx  = pDx[c].value();
+      float gy  = pDy[c].value();
+      float xperp = -gx/m00;
+      float yperp =  gy/m00;
+
+      /* all neighbors, then select (no branches) */
+      float zW  = pMag[c-1].value();
+      float zE  = pMag[c+1].value();
+      float zN  = pUp[c].value();
+      float zS  = pDown[c].value();
+      float zNW = pUp[c-1].value();
+      float zNE = pUp[c+1].value();
+      float zSW = pDown[c-1].value();
+      float zSE = pDown[c+1].value();
+
+      bool bPosX  = ( gx >= 0.0f );
+      bool bPosY  = ( gy >= 0.0f );
+      bool bHoriz = ( fabsf(gx) >= fabsf(gy) );
+
+      /* "left" and "right" comparison points */
+      float zH1  = bPosX ? zW : zE;
+      float zH2  = bPosX ? zE : zW;
+      float zV1  = bPosY ? zN : zS;
+      float zV2  = bPosY ? zS : zN;
+      float zUp1 = bPosX ? zNW : zNE;
+      float zUp2 = bPosX ? zNE : zNW;
+      float zDn1 = bPosX ? zSW : zSE;
+      float zDn2 = bPosX ? zSE : zSW;
+
+      float zAxis1 = bHoriz ? zH1 : zV1;
+      float zAxis2 = bHoriz ? zH2 : zV2;
+      float zDiag1 = bPosY ? zUp1 : zDn1;
+      float zDiag2 = bPosY ? zDn2 : zUp2;
+
+      float sx = ( bPosX == bHoriz ) ? 1.0f : -1.0f;
+      float sy = ( bPosY == bHoriz ) ? 1.0f : -1.0f;
+
+      float dCenter1 = m00 - zAxis1;
+      float dDiag1   = zDiag1 - zAxis1;
+      float dCenter2 = m00 - zAxis2;
+      float dDiag2   = zDiag2 - zAxis2;
+      float mag1 = ( sx*(bHoriz ? dCenter1 : dDiag1)*xperp +
+                     sy*(bHoriz ? dDiag1 : dCenter1)*yperp );
+      float mag2 = ( sx*(bHoriz ? dCenter2 : dDiag2)*xperp +
+                     sy*(bHoriz ? dDiag2 : dCenter2)*yperp );
+
+      bool bMax = ( (m00 != 0.0f) & !(mag1 > 0.0f) & !(mag2 > 0.0f) &
+                    !(fabsf(mag2) <= EPS) );
+      pRes[c] = bMax ? POSSIBLE_EDGE : NOEDGE;
+    }
+  }
+}
 
-                        mag1 = (z1 - m00)*xperp + (z2 - z1)*yperp;
 
-                        /* Right point */
-                        z1 = img_mag(x-1,y).value();
-                        z2 = img_mag(x-1,y+1).value();
-                        // 									z1 = *(magptr - 1);
-                        // 									z2 = *(magptr + ncols - 1);
+void non_max_supp( const GrayImage &img_mag, const GrayImage &img_dx,
+                   const GrayImage &img_dy, vector<unsigned char> &vNms )
+  /*******************************************************************/
+  /* Non-maximum suppression into a label map of POSSIBLE_EDGE and   */
+  /* NOEDGE (row by row, img_mag.width() entries per row).           */
+  /*******************************************************************/
+{
+  int rows = img_mag.height();
+  int cols = img_mag.width();
+
+  vNms.assign( rows*cols, (unsigned char) NOEDGE );
+  if( rows < 3 || cols < 3 )
+    return;
+
+  CannyNmsTask task;
+  task.vMag = img_mag.view();
+  task.vDx  = img_dx.view();
+  task.vDy  = img_dy.view();
+  task.pNms = &vNms[0];
+  parallelFor( 1, rows-1, cannyBands( rows ), task );
+}
 
-                        mag2 = (z1 - m00)*xperp + (z2 - z1)*yperp;
-                    }
-                    else
-                    {
-                        /* 010 */
-                        /* Left point */
-                        z1 = img_mag(x  ,y-1).value();
-                        z2 = img_mag(x+1,y-1).value();
-                        // 									z1 = *(magptr - ncols);
-                        // 									z2 = *(magptr - ncols + 1);
 
-                        mag1 = (z2 - z1)*xperp + (z1 - m00)*yperp;
+static void trace_edges( const GrayPixel *pMag, unsigned char *pEdge,
+                         int cols, int nRowBegin, int nRowEnd, float dLow,
+                         vector<int> &vStack )
+  /*******************************************************************/
+  /* Iterative version of follow_edges(): continue the edges from    */
+  /* all pixels on the stack (which are already marked as EDGE) over */
+  /* possible edges with a magnitude above dLow, staying in the rows */
+  /* [nRowBegin,nRowEnd). The stack is empty afterwards.             */
+  /*******************************************************************/
+{
+  const int vOffsets[8] = { 1, -cols+1, -cols, -cols-1,
+                            -1, cols-1, cols, cols+1 };
+  int nMin = nRowBegin*cols;
+  int nMax = nRowEnd*cols;
+
+  while( !vStack.empty() ) {
+    int pos = vStack.back();
+    vStack.pop_back();
+    for( int i=0; i<8; i++ ) {
+      int n = pos + vOffsets[i];
+      if( n >= nMin && n < nMax && pEdge[n] == POSSIBLE_EDGE &&
+          pMag[n].value() > dLow ) {
+        pEdge[n] = EDGE;
+        vStack.push_back( n );
+      }
+    }
+  }
+}
 
-                        /* Right point */
-                        z1 = img_mag(x  ,y+1).value();
-                        z2 = img_mag(x-1,y+1).value();
-                        // 									z1 = *(magptr + ncols);
-                        // 									z2 = *(magptr + ncols - 1);
 
-                        mag2 = (z2 - z1)*xperp + (z1 - m00)*yperp;
-                    }
-                }
-                else
-                {
-                    if (-gx >= -gy)
-                    {
-                        /* 001 */
-                        /* Left point */
-                        z1 = img_mag(x+1,y).value();
-                        z2 = img_mag(x+1,y+1).value();
-                        // 									z1 = *(magptr + 1);
-                        // 									z2 = *(magptr + ncols + 1);
+struct CannyHysteresisTask
+{
+  int                  nPhase;
+  const GrayPixel     *pMag;
+  const unsigned char *pNms;
+  unsigned char       *pEdge;
+  GrayPixel           *pResult;
+  int                  nRows;
+  int                  nCols;
+  float                dLow;
+  float                dHigh;
+  vector<int>          vHist;       // CANNY_HIST_SIZE+1 bins per thread
+  vector<int>          vBandBegin;  // rows of the tracing bands
+  vector<int>          vBandEnd;
+
+  void operator()( int nThread, int nBegin, int nEnd );
+};
+
+
+void CannyHysteresisTask::operator()( int nThread, int nBegin, int nEnd )
+{
+  int cols = nCols;
+
+  switch( nPhase ) {
+  case 0: {
+    /* initialize the edge map (no edges at the border) and histogram */
+    /* the magnitudes of the possible edges (all other pixels go to   */
+    /* an extra bin, which avoids a branch per pixel)                 */
+    int         *pHist = &vHist[nThread*(CANNY_HIST_SIZE+1)];
+    vector<int>  vBins( cols );
+    for( int r=nBegin; r<nEnd; r++ ) {
+      unsigned char       *pE = pEdge + r*cols;
+      const unsigned char *pN = pNms + r*cols;
+      const GrayPixel     *pM = pMag + r*cols;
+      if( r == 0 || r == nRows-1 ) {
+        memset( pE, NOEDGE, cols );
+        continue;
+      }
+      pE[0]      = NOEDGE;
+      pE[cols-1] = NOEDGE;
+      for( int c=1; c<cols-1; c++ ) {
+        bool  bPossible = ( pN[c] == POSSIBLE_EDGE );
+        float dMag      = min( pM[c].value(), (float) (CANNY_HIST_SIZE-1) );
+        pE[c]    = bPossible ? POSSIBLE_EDGE : NOEDGE;
+        vBins[c] = bPossible ? (int) dMag : CANNY_HIST_SIZE;
+      }
+      for( int c=1; c<cols-1; c++ )
+        pHist[vBins[c]]++;
+    }
+    break;
+  }
+
+  case 1: {
+    /* start the edges at the strong pixels and trace them within the */
+    /* band                                                           */
+    vBandBegin[nThread] = nBegin;
+    vBandEnd[nThread]   = nEnd;
+    vector<int>           vStack;
+    vector<unsigned char> vStrong( cols, 0 );
+    for( int r=nBegin; r<nEnd; r++ ) {
+      /* (the flags are only a hint: tracing may already have marked */
+      /*  the pixel as EDGE)                                         */
+      unsigned char   *pE = pEdge + r*cols;
+      const GrayPixel *pM = pMag + r*cols;
+      for( int c=1; c<cols-1; c++ )
+        vStrong[c] = ( (pE[c] == POSSIBLE_EDGE) & (pM[c].value() >= dHigh) );
+      for( int c=1; c<cols-1; c++ )
+        if( vStrong[c] && pE[c] == POSSIBLE_EDGE ) {
+          pE[c] = EDGE;
+          vStack.push_back( r*cols + c );
+          trace_edges( pMag, pEdge, cols, nBegin, nEnd, dLow, vStack );
+        }
+    }
+    break;
+  }
+
+  case 2:
+    /* write the result image */
+    for( int r=nBegin; r<nEnd; r++ ) {
+      const unsigned char *pE = pEdge + r*cols;
+      GrayPixel           *pR = pResult + r*cols;
+      for( int c=0; c<cols; c++ )
+        pR[c] = ( pE[c] == EDGE ) ? (float) EDGE : (float) NOEDGE;
+    }
+    break;
+  }
+}
 
-                        mag1 = (z1 - m00)*xperp + (z1 - z2)*yperp;
 
-                        /* Right point */
-                        z1 = img_mag(x-1,y).value();
-                        z2 = img_mag(x-1,y-1).value();
-                        // 									z1 = *(magptr - 1);
-                        // 									z2 = *(magptr - ncols - 1);
+void apply_hysteresis( const GrayImage &img_mag,
+                       const vector<unsigned char> &vNms,
+                       float tlow, float thigh, GrayImage &img_edge )
+  /*******************************************************************/
+  /* Hysteresis thresholding on a label map from non_max_supp(). The */
+  /* thresholds are determined exactly as in the original version    */
+  /* by Mike Heath (see below).                                      */
+  /*******************************************************************/
+{
+  int rows = img_mag.height();
+  int cols = img_mag.width();
+
+  img_edge = GrayImage( cols, rows );
+  if( rows < 3 || cols < 3 ) {
+    for( int r=0; r<rows; r++ ) {
+      GrayPixel *pR = img_edge.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        pR[c] = (float) NOEDGE;
+    }
+    return;
+  }
+
+  ImageView<GrayPixel> vMag = img_mag.view();
+  assert( vMag.stride() == cols );
+  assert( (int) vNms.size() == rows*cols );
+
+  vector<unsigned char> vEdge( rows*cols );
+  int nBands = cannyBands( rows );
+
+  CannyHysteresisTask task;
+  task.pMag    = vMag.rowPtr(0);
+  task.pNms    = &vNms[0];
+  task.pEdge   = &vEdge[0];
+  task.pResult = img_edge.rowPtr(0);
+  task.nRows   = rows;
+  task.nCols   = cols;
+  task.vHist.assign( nBands*(CANNY_HIST_SIZE+1), 0 );
+  task.vBandBegin.assign( nBands, 0 );
+  task.vBandEnd.assign( nBands, 0 );
+
+  /*----------------------------------*/
+  /* Edge map and magnitude histogram */
+  /*----------------------------------*/
+  task.nPhase = 0;
+  parallelFor( 0, rows, nBands, task );
+
+  vector<int> hist( CANNY_HIST_SIZE, 0 );
+  for( int t=0; t<nBands; t++ ) {
+    const int *pHist = &task.vHist[t*(CANNY_HIST_SIZE+1)];
+    for( int i=0; i<CANNY_HIST_SIZE; i++ )
+      hist[i] += pHist[i];
+  }
+
+  /*----------------------------------------------*/
+  /* Thresholds (as in the original version: the  */
+  /* thigh percentile of the possible edges above */
+  /* magnitude 1, and tlow times that value)      */
+  /*----------------------------------------------*/
+  int numedges    = 0;
+  int maximum_mag = 0;
+  for( int r=1; r<CANNY_HIST_SIZE; r++ ) {
+    if( hist[r] != 0 )
+      maximum_mag = r;
+    numedges += hist[r];
+  }
+  int highcount = (int)(numedges * thigh + 0.5);
+
+  int r = 1;
+  numedges = hist[1];
+  while( (r < maximum_mag-1) && (numedges < highcount) ) {
+    r++;
+    numedges += hist[r];
+  }
+  int highthreshold = r;
+  int lowthreshold  = (int)(highthreshold * tlow + 0.5);
+  task.dHigh = (float) highthreshold;
+  task.dLow  = (float) (short) lowthreshold;
+
+  if(VERBOSE)
+  {
+    printf("The input low and high fractions of %f and %f computed to\n",
+           tlow, thigh);
+    printf("magnitude of the gradient threshold values of: %d %d\n",
+           lowthreshold, highthreshold);
+  }
+
+  /*---------------------------------------*/
+  /* Trace the edges within the bands, ... */
+  /*---------------------------------------*/
+  task.nPhase = 1;
+  parallelFor( 1, rows-1, nBands, task );
+
+  /*--------------------------------------------------------*/
+  /* ... then continue them over the band borders. All the */
+  /* edge pixels that have a possible edge above the low   */
+  /* threshold on the other side of a border are restarted */
+  /* without the band restriction.                         */
+  /*--------------------------------------------------------*/
+  vector<int> vStack;
+  for( int t=1; t<nBands; t++ ) {
+    int nRow = task.vBandBegin[t];
+    if( nRow <= 1 || nRow >= rows-1 )
+      continue;
+    unsigned char   *pLower = &vEdge[0] + nRow*cols;
+    unsigned char   *pUpper = pLower - cols;
+    const GrayPixel *pMagL  = task.pMag + nRow*cols;
+    const GrayPixel *pMagU  = pMagL - cols;
+    for( int c=1; c<cols-1; c++ )
+      for( int d=-1; d<=1; d++ ) {
+        if( pUpper[c] == EDGE && pLower[c+d] == POSSIBLE_EDGE &&
+            pMagL[c+d].value() > task.dLow ) {
+          pLower[c+d] = EDGE;
+          vStack.push_back( nRow*cols + c+d );
+        }
+        if( pLower[c] == EDGE && pUpper[c+d] == POSSIBLE_EDGE &&
+            pMagU[c+d].value() > task.dLow ) {
+          pUpper[c+d] = EDGE;
+          vStack.push_back( (nRow-1)*cols + c+d );
+        }
+      }
+  }
+  trace_edges( task.pMag, &vEdge[0], cols, 1, rows-1, task.dLow, vStack );
+
+  /*--------------*/
+  /* Output image */
+  /*--------------*/
+  task.nPhase = 2;
+  parallelFor( 0, rows, nBands, task );
+}
 
-                        mag2 = (z1 - m00)*xperp + (z1 - z2)*yperp;
-                    }
-                    else
-                    {
-                        /* 000 */
-                        /* Left point */
-                        z1 = img_mag(x  ,y+1).value();
-                        z2 = img_mag(x+1,y+1).value();
-                        // 									z1 = *(magptr + ncols);
-                        // 									z2 = *(magptr + ncols + 1);
+void apply_hysteresis( const GrayImage &img_mag, const GrayImage &img_nms,
+                       float tlow, float thigh, GrayImage &img_edge )
+/*******************************************************************/
+/* PROCEDURE: apply_hysteresis                                     */
+/* PURPOSE: This routine finds edges that are above some high      */
+/*          threshhold or are connected to a high pixel by a path  */
+/*          of pixels greater than a low threshold.                */
+/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
+/* DATE: 2/15/96                                                   */
+/********************************************************************/
+{
+    int rows = img_mag.height();
+    int cols = img_mag.width();
 
-                        mag1 = (z2 - z1)*xperp + (m00 - z1)*yperp;
+    ImageView<GrayPixel>  vImgNms = img_nms.view();
+    vector<unsigned char> vNms( rows*cols );
+    for(int r=0; r<rows; r++)
+    {
+        const GrayPixel *pNms = vImgNms.rowPtr(r);
+        for(int c=0; c<cols; c++)
+            vNms[r*cols+c] = ( (pNms[c].value() == (float) POSSIBLE_EDGE) ?
+                               POSSIBLE_EDGE : NOEDGE );
+    }
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
+}
 
-                        /* Right point */
-                        z1 = img_mag(x  ,y-1).value();
-                        z2 = img_mag(x-1,y-1).value();
-                        // 									z1 = *(magptr - ncols);
-                        // 									z2 = *(magptr - ncols - 1);
 
-                        mag2 = (z2 - z1)*xperp + (m00 - z1)*yperp;
-                    }
-                }
-            }
+void apply_hysteresis( const GrayImage &img_mag, unsigned char *nms,
+                       float tlow, float thigh, GrayImage &img_edge )
+/*******************************************************************/
+/* PROCEDURE: apply_hysteresis                                     */
+/* PURPOSE: This routine finds edges that are above some high      */
+/*          threshhold or are connected to a high pixel by a path  */
+/*          of pixels greater than a low threshold.                */
+/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
+/* DATE: 2/15/96                                                   */
+/********************************************************************/
+{
+    vector<unsigned char> vNms( nms, nms + img_mag.width()*img_mag.height() );
+    apply_hysteresis(img_mag, vNms, tlow, thigh, img_edge);
+}
 
-            /* Now determine if the current point is a maximum point */
 
-            if ((mag1 > 0.0) || (mag2 > 0.0))
-            {
-                result(x,y) = (float) NOEDGE;
-                //*resultptr = (unsigned char) NOEDGE;
-            }
-            else
+void follow_edges( GrayImage &img_edge, const GrayImage &img_mag,
+                   int pos_x, int pos_y, short lowval )
+/*******************************************************************/
+/* PROCEDURE: follow_edges                                         */
+/* PURPOSE: This procedure traces edges along all paths whose      */
+/*          magnitude values remain above some specifyable lower   */
+/*          threshold. (Iterative; it used to be recursive, which  */
+/*          could overflow the stack on large images.)             */
+/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
+/* DATE: 2/15/96                                                   */
+/*******************************************************************/
+{
+    int x[8] = {1,1,0,-1,-1,-1,0,1};
+    int y[8] = {0,1,1,1,0,-1,-1,-1};
+    vector< pair<int,int> > vStack;
+
+    vStack.push_back( pair<int,int>( pos_x, pos_y ) );
+    while( !vStack.empty() )
+    {
+        pos_x = vStack.back().first;
+        pos_y = vStack.back().second;
+        vStack.pop_back();
+        for(int i=0;i<8;i++)
+        {
+            int tmp_x = pos_x + x[i];
+            int tmp_y = pos_y - y[i];
+
+            if( (img_edge(tmp_x,tmp_y).value() == (float) POSSIBLE_EDGE) &&
+                    (img_mag(tmp_x,tmp_y).value() > (float) lowval) )
             {
-                if (fabs(mag2) <= EPS)
-                    result(x,y) = (float) NOEDGE;
-                //*resultptr = (unsigned char) NOEDGE;
-                else
-                    result(x,y) = (float) POSSIBLE_EDGE;
-                //*resultptr = (unsigned char) POSSIBLE_EDGE;
+                img_edge(tmp_x,tmp_y) = (float) EDGE;
+                vStack.push_back( pair<int,int>( tmp_x, tmp_y ) );
             }
         }
     }
 }
 
+
+void non_max_supp( const GrayImage &img_mag, const GrayImage &img_dx,
+                   const GrayImage &img_dy, GrayImage &result )
+/*******************************************************************/
+/* PROCEDURE: non_max_supp                                         */
+/* PURPOSE: applies non-maximal suppression to the magnitude of    */
+/*          the gradient image.                                    */
+/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
+/* DATE: 2/15/96                                                   */
+/********************************************************************/
+{
+    int rows = img_mag.height();
+    int cols = img_mag.width();
+
+    vector<unsigned char> vNms;
+    non_max_supp(img_mag, img_dx, img_dy, vNms);
+
+    GrayImage tmp( cols, rows );
+    for(int r=0; r<rows; r++)
+    {
+        GrayPixel *pRes = tmp.rowPtr(r);
+        for(int c=0; c<cols; c++)
+            pRes[c] = (float) vNms[r*cols+c];
+    }
+    result = tmp;
+}
+
 void non_max_supp( const GrayImage &img_mag, int direction, GrayImage &result )
 /*******************************************************************/
 /* PROCEDURE: non_max_supp                                         */
@@ -1550,29 +1492,34 @@ void follow_edges(unsigned char *edgemapptr, short *edgemagptr, short lowval,
                   int cols)
 /*******************************************************************/
 /* PROCEDURE: follow_edges                                         */
-/* PURPOSE: This procedure edges is a recursive routine that       */
-/*          traces edgs along all paths whose magnitude values     */
-/*          remain above some specifyable lower threshhold.        */
+/* PURPOSE: This procedure traces edges along all paths whose      */
+/*          magnitude values remain above some specifyable lower   */
+/*          threshhold. (Iterative, with the offsets relative to   */
+/*          the start pixel on an explicit stack.)                 */
 /* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
 /* DATE: 2/15/96                                                   */
 /*******************************************************************/
 {
-    short *tempmagptr;
-    unsigned char *tempmapptr;
     int i;
-    float thethresh;
     int x[8] = {1,1,0,-1,-1,-1,0,1},
                y[8] = {0,1,1,1,0,-1,-1,-1};
+    vector<long> vStack;
 
-    for(i=0;i<8;i++)
+    vStack.push_back( 0 );
+    while( !vStack.empty() )
     {
-        tempmapptr = edgemapptr - y[i]*cols + x[i];
-        tempmagptr = edgemagptr - y[i]*cols + x[i];
-
-        if((*tempmapptr == POSSIBLE_EDGE) && (*tempmagptr > lowval))
+        long pos = vStack.back();
+        vStack.pop_back();
+        for(i=0;i<8;i++)
         {
-            *tempmapptr = (unsigned char) EDGE;
-            follow_edges(tempmapptr,tempmagptr, lowval, cols);
+            long tmppos = pos - y[i]*cols + x[i];
+
+            if((edgemapptr[tmppos] == POSSIBLE_EDGE) &&
+               (edgemagptr[tmppos] > lowval))
+            {
+                edgemapptr[tmppos] = (unsigned char) EDGE;
+                vStack.push_back( tmppos );
+            }
         }
     }
 }
@@ -25,6 +25,8 @@
 /****************/
 /*   Includes   */
 /****************/
+#include <vector>
+
 #include <grayimage.hh>
 
 /*******************/
@@ -38,6 +40,9 @@
 
 const float EPS = 0.0001;
 
+const int CANNY_HIST_SIZE     = 32768;  // bins of the magnitude histogram
+const int CANNY_MIN_BAND_ROWS = 32;     // min. rows per thread
+
 /***************************/
 /*   Function Prototypes   */
 /***************************/
@@ -56,6 +61,17 @@ void non_max_supp    ( const GrayImage &img_mag, const GrayImage &img_dx,
                        const GrayImage &img_dy, unsigned char *result );
 void non_max_supp( const GrayImage &img_mag, int direction, GrayImage &result );
 
+/* banded (multi-threaded) stages on label maps of NOEDGE/POSSIBLE_EDGE */
+void non_max_supp    ( const GrayImage &img_mag, const GrayImage &img_dx,
+                       const GrayImage &img_dy,
+                       std::vector<unsigned char> &vNms );
+void apply_hysteresis( const GrayImage &img_mag,
+                       const std::vector<unsigned char> &vNms,
+                       float tlow, float thigh, GrayImage &img_edge );
+
+void setCannyNumThreads( int nThreads );   // <=0: one per processor
+int  getCannyNumThreads();
+
 void apply_hysteresis( short int *mag, unsigned char *nms, int rows, int cols,
                        float tlow, float thigh, unsigned char *edge );
 void follow_edges    ( unsigned char *edgemapptr, short *edgemagptr,
@@ -79,6 +95,9 @@ void canny( const GrayImage &image, float sigma, float tlow, float thigh,
 void canny( const GrayImage &img_dx, const GrayImage &img_dy,
             float tlow, float thigh,
             GrayImage &img_edge );
+void canny( const GrayImage &img_dx, const GrayImage &img_dy,
+            const GrayImage &img_mag, float tlow, float thigh,
+            GrayImage &img_edge );
 void canny( const GrayImage& img_mag, float sigma, float tlow, float thigh,
             int direction, GrayImage& img_edge);
             
@@ -0,0 +1,203 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         cannybench.cc                                        */
+/*                                                                   */
+/* CONTENT      Benchmark for the banded Canny stages. Computes the  */
+/*              gradients of a synthetic test image once, then times */
+/*              the non-maximum suppression and the hysteresis       */
+/*              separately for several image sizes (640x480 up to    */
+/*              2 MP) and thread counts, and checks that every edge  */
+/*              map is identical to the one of a single-band run.    */
+/*                                                                   */
+/*              Not part of the library; compile with                */
+/*                g++ -O3 -fno-trapping-math -I. \                   */
+/*                    -I$(HOME)/code/include cannybench.cc \         */
+/*                    -lCanny2 -lGaussDeriv2 -limage2 -lpthread \    */
+/*                    -o cannybench                                  */
+/*              and run as                                           */
+/*                cannybench [#threads] [#runs]                      */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <grayimage.hh>
+#include <fastgaussbank.hh>
+#include "canny.hh"
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const float SIGMA      = 1.0;
+const float TLOW       = 0.4;
+const float THIGH      = 0.9;
+const int   NUM_SHAPES = 400;
+
+const int NUM_SIZES = 5;
+const int SIZES[NUM_SIZES][2] = { {  640,  480 }, { 1024,  768 },
+                                  { 1280,  960 }, { 1600, 1200 },
+                                  { 1920, 1080 } };
+
+
+double getTime()
+{
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+/*---------------------------------------------------------*/
+/*                       Test Image                        */
+/*---------------------------------------------------------*/
+GrayImage makeTestImage( int nWidth, int nHeight )
+  /*******************************************************************/
+  /* Random overlapping rectangles and discs plus some noise. The    */
+  /* shapes produce long closed contours that cross many band        */
+  /* borders, the noise produces weak edges for the hysteresis.      */
+  /*******************************************************************/
+{
+  GrayImage img( nWidth, nHeight );
+  for( int y=0; y<nHeight; y++ )
+    for( int x=0; x<nWidth; x++ )
+      img(x,y) = 128.0;
+
+  int nScale = ( nWidth + nHeight ) / 8;
+  for( int s=0; s<NUM_SHAPES; s++ ) {
+    int   cx   = rand() % nWidth;
+    int   cy   = rand() % nHeight;
+    int   r    = 4 + rand() % nScale;
+    float dVal = (float)( rand() % 256 );
+    bool  bDisc = ( rand() % 2 == 0 );
+    for( int y=max(0,cy-r); y<min(nHeight,cy+r); y++ )
+      for( int x=max(0,cx-r); x<min(nWidth,cx+r); x++ )
+        if( !bDisc || (x-cx)*(x-cx) + (y-cy)*(y-cy) < r*r )
+          img(x,y) = dVal;
+  }
+
+  for( int y=0; y<nHeight; y++ )
+    for( int x=0; x<nWidth; x++ )
+      img(x,y) = img(x,y).value() + 4.0*rand()/(float)RAND_MAX - 2.0;
+
+  return img;
+}
+
+
+/*---------------------------------------------------------*/
+/*                     Timed Canny Stages                  */
+/*---------------------------------------------------------*/
+void runStages( const GrayImage &imgMag, const GrayImage &imgDx,
+                const GrayImage &imgDy, int nThreads, int nRuns,
+                double &tNms, double &tHyst, GrayImage &imgEdge )
+  /* best-of-nRuns times (in ms) for both stages */
+{
+  setCannyNumThreads( nThreads );
+  tNms  = 1e10;
+  tHyst = 1e10;
+  for( int r=0; r<nRuns; r++ ) {
+    vector<unsigned char> vNms;
+    double t0 = getTime();
+    non_max_supp( imgMag, imgDx, imgDy, vNms );
+    double t1 = getTime();
+    apply_hysteresis( imgMag, vNms, TLOW, THIGH, imgEdge );
+    double t2 = getTime();
+
+    tNms  = min( tNms,  1000.0*(t1-t0) );
+    tHyst = min( tHyst, 1000.0*(t2-t1) );
+  }
+}
+
+
+int countEdges( const GrayImage &imgEdge )
+{
+  int nEdges = 0;
+  for( int y=0; y<imgEdge.height(); y++ )
+    for( int x=0; x<imgEdge.width(); x++ )
+      if( imgEdge(x,y).value() == EDGE )
+        nEdges++;
+  return nEdges;
+}
+
+
+bool sameEdges( const GrayImage &img1, const GrayImage &img2 )
+{
+  if( img1.width() != img2.width() || img1.height() != img2.height() )
+    return false;
+  for( int y=0; y<img1.height(); y++ )
+    for( int x=0; x<img1.width(); x++ )
+      if( img1(x,y).value() != img2(x,y).value() )
+        return false;
+  return true;
+}
+
+
+/*---------------------------------------------------------*/
+/*                       Main Program                      */
+/*---------------------------------------------------------*/
+int main( int argc, char **argv )
+{
+  int nThreads = ( argc>1 ? atoi( argv[1] ) : 0 );
+  int nRuns    = ( argc>2 ? atoi( argv[2] ) : 5 );
+
+  /* thread counts: the single-band reference, the requested count,  */
+  /* and an odd band count that puts the borders at uneven rows.     */
+  vector<int> vThreads;
+  vThreads.push_back( 1 );
+  vThreads.push_back( nThreads );
+  vThreads.push_back( 7 );
+
+  srand( 42 );
+  bool bAllOk = true;
+  cout << "   size    threads  NMS [ms]  hyst. [ms]   #edges  check" << endl;
+  for( int s=0; s<NUM_SIZES; s++ ) {
+    int nWidth  = SIZES[s][0];
+    int nHeight = SIZES[s][1];
+    GrayImage img = makeTestImage( nWidth, nHeight );
+
+    FastGaussBank fgb;
+    int nReq = fgb.addRequest( SIGMA, FGB_DX | FGB_DY | FGB_MAG );
+    fgb.apply( img );
+    GrayImage imgDx  = fgb.getResult( nReq, FGB_DX );
+    GrayImage imgDy  = fgb.getResult( nReq, FGB_DY );
+    GrayImage imgMag = fgb.getResult( nReq, FGB_MAG );
+
+    GrayImage imgRef;
+    for( unsigned t=0; t<vThreads.size(); t++ ) {
+      double tNms, tHyst;
+      GrayImage imgEdge;
+      runStages( imgMag, imgDx, imgDy, vThreads[t], nRuns,
+                 tNms, tHyst, imgEdge );
+
+      const char *szCheck = "reference";
+      if( t == 0 )
+        imgRef = imgEdge;
+      else if( sameEdges( imgEdge, imgRef ) )
+        szCheck = "identical";
+      else {
+        szCheck = "DIFFER!";
+        bAllOk  = false;
+      }
+
+      cout << setw(5) << nWidth << "x" << setw(4) << left << nHeight
+           << right << setw(6) << vThreads[t]
+           << fixed << setprecision(2)
+           << setw(10) << tNms << setw(12) << tHyst
+           << setw(9) << countEdges( imgEdge ) << "  " << szCheck << endl;
+    }
+  }
+  setCannyNumThreads( 0 );
+
+  return ( bAllOk ? 0 : 1 );
+}
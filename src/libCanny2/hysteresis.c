@@ -16,31 +16,53 @@
 
 /*****************************************************************************
  * PROCEDURE: follow_edges
- * PURPOSE: This procedure edges is a recursive routine that traces edgs along
- * all paths whose magnitude values remain above some specifyable lower
- * threshhold.
+ * PURPOSE: This procedure traces edges along all paths whose magnitude values
+ * remain above some specifyable lower threshhold. The pixels still to be
+ * visited (as offsets from edgemapptr) are kept on an explicit stack, since
+ * the original recursion could overflow the call stack on large images.
  * NAME: Mike Heath
  * DATE: 2/15/96
  *****************************************************************************/
 void follow_edges(unsigned char *edgemapptr, short *edgemagptr, short lowval,
 						 int cols)
 {
-	short *tempmagptr;
-	unsigned char *tempmapptr;
-	int i;
-	float thethresh;
+	long *stack, *newstack;
+	long pos, tmppos;
+	int  i, top, size;
 	int x[8] = {1,1,0,-1,-1,-1,0,1},
 		y[8] = {0,1,1,1,0,-1,-1,-1};
-		
+
+	size = 1024;
+	if((stack = (long *) malloc(size*sizeof(long))) == NULL){
+		fprintf(stderr, "Error allocating the edge stack.\n");
+		exit(1);
+	}
+	top = 0;
+	stack[top++] = 0;
+
+	while(top > 0){
+		pos = stack[--top];
 		for(i=0;i<8;i++){
-      tempmapptr = edgemapptr - y[i]*cols + x[i];
-      tempmagptr = edgemagptr - y[i]*cols + x[i];
-			
-      if((*tempmapptr == POSSIBLE_EDGE) && (*tempmagptr > lowval)){
-				*tempmapptr = (unsigned char) EDGE;
-				follow_edges(tempmapptr,tempmagptr, lowval, cols);
-      }
+			tmppos = pos - y[i]*cols + x[i];
+
+			if((edgemapptr[tmppos] == POSSIBLE_EDGE) &&
+				 (edgemagptr[tmppos] > lowval)){
+				edgemapptr[tmppos] = (unsigned char) EDGE;
+				if(top == size){
+					size *= 2;
+					if((newstack = (long *) realloc(stack, size*sizeof(long)))
+						 == NULL){
+						fprintf(stderr, "Error allocating the edge stack.\n");
+						free(stack);
+						exit(1);
+					}
+					stack = newstack;
+				}
+				stack[top++] = tmppos;
+			}
 		}
+	}
+	free(stack);
 }
 
 
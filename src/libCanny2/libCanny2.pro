@@ -8,7 +8,7 @@ VERSION = 2.1.1
 
 # CONFIG += debug
 CONFIG += release
-QMAKE_CXXFLAGS_RELEASE = -O3 -DQT_THREAD_SUPPORT #-march=pentium4 -mfpmath=sse -mmmx
+QMAKE_CXXFLAGS_RELEASE = -O3 -fno-trapping-math -DQT_THREAD_SUPPORT #-march=pentium4 -mfpmath=sse -mmmx
 
 CODE = $(HOME)/code
 
@@ -20,7 +20,7 @@ HEADERS += canny.hh
 SOURCES += canny.cc canny_edge.cc pgm_io.cc hysteresis.c
 
 IMAGE_LIBS   = -lGaussDeriv2 -limage2
-STD_LIBS     = -lm -lstdc++
+STD_LIBS     = -lm -lstdc++ -lpthread
 LIBS += -L$${CODE}/lib/i686 $${IMAGE_LIBS} $${STD_LIBS}
 
 
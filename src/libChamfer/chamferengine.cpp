@@ -0,0 +1,427 @@
+//
+// C++ Implementation: chamferengine
+//
+// Description: Batch evaluation of Chamfer matching scores on one
+//              distance transform image (see chamferengine.h).
+//
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+
+#include <math.h>
+#include <limits.h>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <parallelfor.hh>
+
+#include "chamfermatching.h"
+#include "chamferengine.h"
+
+const float ChamferEngine::REJECTED = -1.0;
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Scoring task
+//
+// Scores the (job,row) pairs [nBegin,nEnd) of a matchJobs() call.
+// Every template point is looked up in the padded integer DT, so
+// that points outside the image automatically contribute the
+// penalty of 255. The integer sum is exact and therefore gives the
+// same double (and float) score as ChamferMatching's summation.
+//
+// A position is rejected early as soon as the partial sum alone
+// already exceeds the threshold (the remaining DT values are all
+// non-negative). The threshold is the minimum of
+//  - the worst entry of the (full) candidate set before the call,
+//    and
+//  - the nMaxCandidates-th best score this thread has found so far.
+// Both are candidates that will end up in the set in any case, so a
+// rejected position would have been erased from the set again.
+//
+
+struct ChamferScoreTask
+{
+  vector<ChamferEngine::Job> *pJobs;
+  const vector<int>          *pTaskJob;    // job index per task
+  const vector<int>          *pTaskRow;    // row index per task
+  const int                  *pDt;
+  float                       dThresh;
+  bool                        bLocalPrune;
+  int                         nMaxCandidates;
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    const int *pDt = this->pDt;
+    vector<float> vBest;                    // max-heap of the best scores
+    if( bLocalPrune )
+      vBest.reserve( nMaxCandidates+1 );
+
+    for( int t=nBegin; t<nEnd; t++ )
+    {
+      ChamferEngine::Job &job = (*pJobs)[(*pTaskJob)[t]];
+      int           iy      = (*pTaskRow)[t];
+      int           nPoints = (int)job.pPoints->size();
+      double        dPoints = (double)nPoints;
+      const int    *pRow    = &job.vRowOffs[iy*nPoints];
+      float        *pDist   = &job.vDist[iy*job.nNumX];
+
+      for( int ix=0; ix<job.nNumX; ix++ )
+      {
+        const int *pCol = &job.vColOffs[ix*nPoints];
+        float dThr = dThresh;
+        if( bLocalPrune && (int)vBest.size()==nMaxCandidates )
+          dThr = min( dThr, vBest.front() );
+
+        //-- sum up the DT values in batches --//
+        int  nSum      = 0;
+        bool bRejected = false;
+        int  i         = 0;
+        while( i<nPoints )
+        {
+          int nBatchEnd = min( i+ChamferEngine::BATCH_SIZE, nPoints );
+          int s0=0, s1=0, s2=0, s3=0;
+          for( ; i+4<=nBatchEnd; i+=4 )
+          {
+            s0 += pDt[pRow[i  ] + pCol[i  ]];
+            s1 += pDt[pRow[i+1] + pCol[i+1]];
+            s2 += pDt[pRow[i+2] + pCol[i+2]];
+            s3 += pDt[pRow[i+3] + pCol[i+3]];
+          }
+          for( ; i<nBatchEnd; i++ )
+            s0 += pDt[pRow[i] + pCol[i]];
+          nSum += (s0 + s1) + (s2 + s3);
+
+          //-- early rejection --//
+          if( (float)(nSum/dPoints) > dThr )
+          {
+            bRejected = true;
+            break;
+          }
+        }
+
+        if( bRejected )
+        {
+          pDist[ix] = ChamferEngine::REJECTED;
+          continue;
+        }
+
+        float dDist = (float)(nSum/dPoints);
+        pDist[ix] = dDist;
+
+        //-- keep track of the best scores of this thread --//
+        if( bLocalPrune )
+        {
+          if( (int)vBest.size()<nMaxCandidates )
+          {
+            vBest.push_back( dDist );
+            push_heap( vBest.begin(), vBest.end() );
+          }
+          else if( dDist<vBest.front() )
+          {
+            pop_heap( vBest.begin(), vBest.end() );
+            vBest.back() = dDist;
+            push_heap( vBest.begin(), vBest.end() );
+          }
+        }
+      }
+    }
+  }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ChamferEngine
+//
+
+ChamferEngine::ChamferEngine()
+{
+  m_nThreads   = 0;
+  m_bIntegerDt = false;
+  m_nMaxDt     = 0;
+  m_nPadW      = 0;
+  m_nPadH      = 0;
+}
+
+
+ChamferEngine::ChamferEngine( const OpGrayImage &imgDt )
+{
+  m_nThreads = 0;
+  setDTImage( imgDt );
+}
+
+
+void ChamferEngine::setDTImage( const OpGrayImage &imgDt )
+{
+  m_imgDt = imgDt;
+  clearJobs();
+
+  int w = imgDt.width();
+  int h = imgDt.height();
+  m_nPadW = w+2;
+  m_nPadH = h+2;
+  m_vPadDt.assign( m_nPadW*m_nPadH, 255 );
+
+  //-- copy the DT values if they are all small integers --//
+  m_bIntegerDt = true;
+  m_nMaxDt     = 255;
+  ImageView<GrayPixel> dt = imgDt.view();
+  for( int y=0; y<h && m_bIntegerDt; y++ )
+  {
+    const GrayPixel *pSrc = dt.rowPtr(y);
+    int             *pDst = &m_vPadDt[(y+1)*m_nPadW + 1];
+    for( int x=0; x<w; x++ )
+    {
+      float v = pSrc[x].value();
+      if( !(v>=0.0 && v<=(float)MAX_DT_VALUE) || v!=(float)(int)v )
+      {
+        m_bIntegerDt = false;
+        break;
+      }
+      pDst[x]  = (int)v;
+      m_nMaxDt = max( m_nMaxDt, pDst[x] );
+    }
+  }
+}
+
+
+void ChamferEngine::computeDTImage( const OpGrayImage &img,
+                                    float dThreshLo, float dThreshHi )
+{
+  setDTImage( ChamferMatching::getDTImage( img, dThreshLo, dThreshHi ) );
+}
+
+
+void ChamferEngine::addJob( const OpGrayImage &imgTempl,
+                            const EdgePtVec   &vPoints,
+                            int nTemplateId,
+                            int x, int y, int w, int h )
+{
+  addJob( imgTempl, vPoints, nTemplateId, x, y, w, h, 1.0, 1 );
+  m_vJobs.back().bScaled = false;
+}
+
+
+void ChamferEngine::addJob( const OpGrayImage &imgTempl,
+                            const EdgePtVec   &vPoints,
+                            int nTemplateId,
+                            int x, int y, int w, int h,
+                            float dScaleFact, int nStepSize )
+  // imgTempl and vPoints are referenced until matchJobs() is called.
+{
+  if( nStepSize<1 )
+  {
+    cerr << "Error in ChamferEngine::addJob(): "
+         << "Invalid step size " << nStepSize << "!" << endl;
+    nStepSize = 1;
+  }
+
+  Job job;
+  job.pTempl      = &imgTempl;
+  job.pPoints     = &vPoints;
+  job.nTemplateId = nTemplateId;
+  job.x           = x;
+  job.y           = y;
+  job.w           = w;
+  job.h           = h;
+  job.dScaleFact  = dScaleFact;
+  job.nStepSize   = nStepSize;
+  job.bScaled     = true;
+  m_vJobs.push_back( job );
+}
+
+
+void ChamferEngine::clearJobs()
+{
+  m_vJobs.clear();
+}
+
+
+void ChamferEngine::prepareJob( Job &job ) const
+  // Compute the candidate positions and, per shift in x and y, the
+  // offsets of all template points into the padded DT. The point
+  // coordinates are computed with exactly the same expressions as in
+  // ChamferMatching::distanceOnFeatures().
+{
+  const EdgePtVec &vPoints = *job.pPoints;
+  int nPoints = (int)vPoints.size();
+  int img_w   = m_imgDt.width();
+  int img_h   = m_imgDt.height();
+  int maxx    = min( img_w, job.x+job.w );
+  int maxy    = min( img_h, job.y+job.h );
+
+  job.nStartX = job.x;
+  job.nStartY = job.y;
+  job.nNumX   = ( maxx>job.x ? (maxx-job.x-1)/job.nStepSize + 1 : 0 );
+  job.nNumY   = ( maxy>job.y ? (maxy-job.y-1)/job.nStepSize + 1 : 0 );
+  if( job.bScaled )
+  {
+    job.nTplH = (int)floor(job.pTempl->height()*job.dScaleFact + 0.5);
+    job.nTplW = (int)floor(job.pTempl->width()*job.dScaleFact + 0.5);
+  }
+  else
+  {
+    job.nTplH = job.pTempl->height();
+    job.nTplW = job.pTempl->width();
+  }
+
+  job.vColOffs.resize( job.nNumX*nPoints );
+  job.vRowOffs.resize( job.nNumY*nPoints );
+  job.vDist.assign( job.nNumX*job.nNumY, REJECTED );
+
+  float dScaleFact = job.dScaleFact;
+  for( int ix=0; ix<job.nNumX; ix++ )
+  {
+    int  shift_x = job.nStartX + ix*job.nStepSize;
+    int *pCol    = &job.vColOffs[ix*nPoints];
+    for( int i=0; i<nPoints; i++ )
+    {
+      int cx;
+      if( job.bScaled )
+        cx = (int)floor(shift_x + vPoints[i].x()*dScaleFact + 0.5);
+      else
+        cx = shift_x + vPoints[i].x();
+      cx = min( max( cx, -1 ), img_w );
+      pCol[i] = cx+1;
+    }
+  }
+  for( int iy=0; iy<job.nNumY; iy++ )
+  {
+    int  shift_y = job.nStartY + iy*job.nStepSize;
+    int *pRow    = &job.vRowOffs[iy*nPoints];
+    for( int i=0; i<nPoints; i++ )
+    {
+      int cy;
+      if( job.bScaled )
+        cy = (int)floor(shift_y + vPoints[i].y()*dScaleFact + 0.5);
+      else
+        cy = shift_y + vPoints[i].y();
+      cy = min( max( cy, -1 ), img_h );
+      pRow[i] = (cy+1)*m_nPadW;
+    }
+  }
+}
+
+
+bool ChamferEngine::hasDuplicateJobs() const
+  // Two jobs with the same template id and scale can produce equal
+  // candidates, which must not be counted twice by the early
+  // rejection.
+{
+  vector< pair<int,float> > vKeys;
+  for( unsigned i=0; i<m_vJobs.size(); i++ )
+    vKeys.push_back( make_pair( m_vJobs[i].nTemplateId,
+                                m_vJobs[i].dScaleFact ) );
+  sort( vKeys.begin(), vKeys.end() );
+  return ( adjacent_find( vKeys.begin(), vKeys.end() ) != vKeys.end() );
+}
+
+
+void ChamferEngine::matchReference( CombiCandidateSet &vCandidates,
+                                    int nMaxCandidates ) const
+{
+  for( unsigned j=0; j<m_vJobs.size(); j++ )
+  {
+    const Job &job = m_vJobs[j];
+    if( job.bScaled )
+      ChamferMatching::matchTemplateOnWindow( vCandidates, m_imgDt,
+                                              *job.pTempl, *job.pPoints,
+                                              job.nTemplateId,
+                                              job.x, job.y, job.w, job.h,
+                                              job.dScaleFact, job.nStepSize,
+                                              nMaxCandidates );
+    else
+      ChamferMatching::matchTemplateOnWindow( vCandidates, m_imgDt,
+                                              *job.pTempl, *job.pPoints,
+                                              job.nTemplateId,
+                                              job.x, job.y, job.w, job.h,
+                                              nMaxCandidates );
+  }
+}
+
+
+void ChamferEngine::matchJobs( CombiCandidateSet &vCandidates,
+                               int nMaxCandidates )
+  // Score all jobs and insert the results into vCandidates, which is
+  // limited to the nMaxCandidates best entries. The job list is
+  // cleared afterwards.
+{
+  //-- check if the fast path applies --//
+  bool bFast = ( m_bIntegerDt && nMaxCandidates>=1 &&
+                 (int)vCandidates.size()<=nMaxCandidates );
+  for( unsigned j=0; j<m_vJobs.size() && bFast; j++ )
+  {
+    int nPoints = (int)m_vJobs[j].pPoints->size();
+    if( nPoints==0 || nPoints>INT_MAX/m_nMaxDt )
+      bFast = false;
+  }
+  if( !bFast )
+  {
+    matchReference( vCandidates, nMaxCandidates );
+    clearJobs();
+    return;
+  }
+
+  //-- prepare the jobs and list the (job,row) tasks --//
+  vector<int> vTaskJob;
+  vector<int> vTaskRow;
+  for( unsigned j=0; j<m_vJobs.size(); j++ )
+  {
+    prepareJob( m_vJobs[j] );
+    for( int iy=0; iy<m_vJobs[j].nNumY; iy++ )
+    {
+      vTaskJob.push_back( j );
+      vTaskRow.push_back( iy );
+    }
+  }
+
+  //-- rejection threshold from the current candidate set --//
+  float dThresh = numeric_limits<float>::infinity();
+  if( (int)vCandidates.size()==nMaxCandidates )
+  {
+    const CombiCandidate &cWorst = *(--vCandidates.end());
+    if( cWorst.getCombScore()==0.0 )
+      dThresh = cWorst.getDist();
+    else if( cWorst.getCombScore()>0.0 )
+      dThresh = REJECTED;            // new candidates all rank behind it
+  }
+
+  //-- score all positions --//
+  ChamferScoreTask task;
+  task.pJobs          = &m_vJobs;
+  task.pTaskJob       = &vTaskJob;
+  task.pTaskRow       = &vTaskRow;
+  task.pDt            = &m_vPadDt[0];
+  task.dThresh        = dThresh;
+  task.bLocalPrune    = !hasDuplicateJobs();
+  task.nMaxCandidates = nMaxCandidates;
+  parallelFor( 0, (int)vTaskJob.size(), m_nThreads, task );
+
+  //-- insert the results in the original order --//
+  for( unsigned j=0; j<m_vJobs.size(); j++ )
+  {
+    const Job &job = m_vJobs[j];
+    for( int iy=0; iy<job.nNumY; iy++ )
+      for( int ix=0; ix<job.nNumX; ix++ )
+      {
+        float dDist = job.vDist[iy*job.nNumX + ix];
+        if( dDist==REJECTED )
+          continue;
+
+        int shift_x = job.nStartX + ix*job.nStepSize;
+        int shift_y = job.nStartY + iy*job.nStepSize;
+        vCandidates.insert( CombiCandidate( QRect(shift_x, shift_y,
+                                                  job.nTplW, job.nTplH),
+                                            job.dScaleFact, dDist,
+                                            job.nTemplateId, 0) );
+
+        if( (int)vCandidates.size() > nMaxCandidates )
+          vCandidates.erase( --vCandidates.end() );
+      }
+  }
+
+  clearJobs();
+}
@@ -0,0 +1,136 @@
+//
+// C++ Interface: chamferengine
+//
+// Description: Batch evaluation of Chamfer matching scores on one
+//              distance transform image. The DT is prepared once per
+//              image; all template/scale/window jobs that are added
+//              are then scored together (in parallel) and merged into
+//              a CombiCandidateSet. The resulting set is identical to
+//              the one obtained by calling
+//              ChamferMatching::matchTemplateOnWindow() for each job
+//              in the order the jobs were added.
+//
+//
+// Copyright: See COPYING file that comes with this distribution
+//
+//
+#ifndef CHAMFERENGINE_H
+#define CHAMFERENGINE_H
+
+#include <vector>
+#include <opgrayimage.hh>
+
+#include "Candidate.h"
+#include "chamferimage.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ChamferEngine class
+//
+// Usage:
+//   ChamferEngine engine( imgDT );
+//   for( all templates and scales )
+//     engine.addJob( imgTempl, vPoints, nTemplateId,
+//                    x, y, w, h, dScaleFact, nStepSize );
+//   engine.matchJobs( vCandidates, nMaxCandidates );
+//
+// The fast path works on integer DT values (as produced by
+// ImageOperations::distanceTransform()). For other DT images, empty
+// templates, or candidate sets that already hold more than
+// nMaxCandidates entries, the jobs are passed on to ChamferMatching
+// unchanged.
+//
+
+class ChamferEngine
+{
+public:
+    ChamferEngine();
+    ChamferEngine( const OpGrayImage &imgDt );
+
+    //-- preparation --//
+    void setDTImage      ( const OpGrayImage &imgDt );
+    void computeDTImage  ( const OpGrayImage &img,
+                           float dThreshLo=0.4, float dThreshHi=0.8 );
+
+    const OpGrayImage& getDTImage() const { return m_imgDt; }
+
+    void setNumThreads   ( int nThreads ) { m_nThreads = nThreads; }
+    int  getNumThreads   () const         { return m_nThreads; }
+
+    //-- jobs --//
+    void addJob          ( const OpGrayImage &imgTempl,
+                           const EdgePtVec   &vPoints,
+                           int nTemplateId,
+                           int x, int y, int w, int h );
+    void addJob          ( const OpGrayImage &imgTempl,
+                           const EdgePtVec   &vPoints,
+                           int nTemplateId,
+                           int x, int y, int w, int h,
+                           float dScaleFact, int nStepSize );
+    void clearJobs       ();
+    int  numJobs         () const { return (int)m_vJobs.size(); }
+
+    //-- matching --//
+    void matchJobs       ( CombiCandidateSet &vCandidates,
+                           int nMaxCandidates );
+
+public:
+    // a scored position is not inserted if it is already known to
+    // lose against nMaxCandidates others
+    static const float REJECTED;
+
+    // number of template points summed up between two early
+    // rejection tests
+    static const int   BATCH_SIZE = 64;
+
+    // DT values above this bound are not handled by the fast path
+    static const int   MAX_DT_VALUE = (1 << 20);
+
+public:
+    struct Job
+    {
+        const OpGrayImage *pTempl;
+        const EdgePtVec   *pPoints;
+        int                nTemplateId;
+        int                x, y, w, h;
+        float              dScaleFact;
+        int                nStepSize;
+        bool               bScaled;
+
+        // candidate positions and the resulting template size
+        int                nStartX, nStartY;
+        int                nNumX, nNumY;
+        int                nTplW, nTplH;
+
+        // gather offsets into the padded DT, per shift and point
+        vector<int>        vColOffs;   // nNumX x nPoints
+        vector<int>        vRowOffs;   // nNumY x nPoints
+
+        // scores of all positions (REJECTED if pruned)
+        vector<float>      vDist;
+    };
+
+protected:
+    void   prepareJob      ( Job &job ) const;
+    void   matchReference  ( CombiCandidateSet &vCandidates,
+                             int nMaxCandidates ) const;
+    bool   hasDuplicateJobs() const;
+
+protected:
+    OpGrayImage   m_imgDt;
+    int           m_nThreads;
+
+    // DT with a one-pixel border of 255 (the penalty for template
+    // points outside the image), stored as integers row by row
+    bool          m_bIntegerDt;
+    int           m_nMaxDt;
+    int           m_nPadW;
+    int           m_nPadH;
+    vector<int>   m_vPadDt;
+
+    vector<Job>   m_vJobs;
+};
+
+#endif //CHAMFERENGINE_H
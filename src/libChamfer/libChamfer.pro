@@ -12,16 +12,20 @@ CODE = $(HOME)/code
 
 INCLUDEPATH += . $(HOME)/code/include
 
+LIBS += -lpthread
+
 # Input
 HEADERS += Candidate.h \
            chamferimage.h \
 	         chamfermatching.h \
            array2d.h \
            integralimage.h \
+           chamferengine.h \
 
 SOURCES += chamferimage.cpp \
            chamfermatching.cpp \
 	         integralimage.cpp \
+           chamferengine.cpp \
 
 
 # make install
@@ -18,12 +18,21 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 #include <math.h>
+#include <values.h>   // for FLT_MAX
 
 #include <chamfermatching.h>
+#include <distkernels.hh>
 
 #include "codebook.hh"
 
+/*******************/
+/*   Definitions   */
+/*******************/
+const int  MATCH_FEATURE_BLOCK = 64;          // features per block
+const long MATCH_CLUSTER_BYTES = 256*1024;    // cluster block size (~L2)
+
 /*---------------------------------------------------------*/
 /*                   Matching to Codebook                  */
 /*---------------------------------------------------------*/
@@ -138,44 +147,13 @@ void Codebook::matchToCodebookCorr( const vector<FeatureVector> &vFeatures,
 /* the codebook cluster centers using the NGC measure.             */
 /*******************************************************************/
 {
-  /*-------------------------------*/
-  /* Initialize the result vectors */
-  /*-------------------------------*/
-  vNearestNeighbor.clear();
-  vNearestNeighborSim.clear();
-
-  vvAllNeighbors.clear();
-  vector< vector<int> > tmpVec1( vFeatures.size() );
-  vvAllNeighbors = tmpVec1;
-
-  vvAllNeighborsSim.clear();
-  vector< vector<float> > tmpVec2( vFeatures.size() );
-  vvAllNeighborsSim = tmpVec2;
-
   /*------------------------*/
   /*   simple Correlation   */
   /*------------------------*/
   //cout << "      Computing correlation similarities..." << endl;
-  for( int i=0; i<(int)vFeatures.size(); i++ ) {
-    float dSim    = 0.0;
-    float dMaxSim = 0.0;
-    int   nMaxIdx = -1;
-    for( int k=0; k<(int)m_vClusters.size(); k++) {
-      dSim = vFeatures[i].compCorrelation( m_vClusters[k] );
-      if ( dSim > dMaxSim ) {
-        dMaxSim = dSim;
-        nMaxIdx = k;
-      }
-
-      if( dSim > dRejectionThresh ) {
-        vvAllNeighbors[i].push_back( k );
-        vvAllNeighborsSim[i].push_back( dSim );
-      }
-    }
-
-    vNearestNeighbor.push_back( nMaxIdx );
-    vNearestNeighborSim.push_back( dMaxSim );
-  }
+  matchToClusterMatrix( vFeatures, dRejectionThresh, false, 1.0,
+                        vNearestNeighbor, vNearestNeighborSim,
+                        vvAllNeighbors, vvAllNeighborsSim );
   //cout << "      done." << endl;
 }
 
@@ -189,51 +167,231 @@ void Codebook::matchToCodebookEuclid( const vector<FeatureVector> &vFeatures,
                                       vector<vector<float> > &vvAllNeighborsSim) const
 /*******************************************************************/
 /* Compare all extracted feature vectors from a test image with    */
-/* the codebook cluster centers using Euclidean distances.         */
+/* the codebook cluster centers using Euclidean distances. If the  */
+/* matching parameters ask for approximate matching and the search */
+/* tree is up to date, the balltree is used instead of comparing   */
+/* with all clusters.                                              */
 /*******************************************************************/
 {
-  /*-------------------------------*/
-  /* Initialize the result vectors */
-  /*-------------------------------*/
-  vNearestNeighbor.clear();
-  vNearestNeighborSim.clear();
-
-  vvAllNeighbors.clear();
-  vector< vector<int> > tmpVec1( vFeatures.size() );
-  vvAllNeighbors = tmpVec1;
+  /***************************/
+  /*   Euclidean distances   */
+  /***************************/
+  //cout << "      Computing Euclidean distances..." << endl;
+  int nMaxChecks = 0;
+  if( m_parMatching.isValid() )
+    nMaxChecks = m_parMatching.params()->m_nMaxLeafChecks;
+
+  if( nMaxChecks > 0 && m_bClusterTreeValid && 
+      m_btClusters.numPoints() == m_vClusters.size() )
+    matchToClusterTree( vFeatures, dRejectionThresh, dDistFactor, 
+                        nMaxChecks, vNearestNeighbor, vNearestNeighborSim,
+                        vvAllNeighbors, vvAllNeighborsSim );
+  else
+    matchToClusterMatrix( vFeatures, dRejectionThresh, true, dDistFactor,
+                          vNearestNeighbor, vNearestNeighborSim,
+                          vvAllNeighbors, vvAllNeighborsSim );
+  //cout << "      done." << endl;
+}
 
-  vvAllNeighborsSim.clear();
-  vector< vector<float> > tmpVec2( vFeatures.size() );
-  vvAllNeighborsSim = tmpVec2;
 
-  /**************************/
-  /*   simple Correlation   */
-  /**************************/
-  //cout << "      Computing Euclidean distances..." << endl;
+void Codebook::matchToClusterMatrix( const vector<FeatureVector> &vFeatures,
+                                     float dRejectionThresh,
+                                     bool  bEuclidean,
+                                     float dDistFactor,
+                                     vector<int>    &vNearestNeighbor,
+                                     vector<float>  &vNearestNeighborSim,
+                                     vector<vector<int> >   &vvAllNeighbors,
+                                     vector<vector<float> > &vvAllNeighborsSim) const
+/*******************************************************************/
+/* Compare all features with all cluster centers as one blocked    */
+/* matrix product F*C' on the contiguous cluster matrix. For the   */
+/* correlation measure, the similarity is the dot product itself;  */
+/* for the Euclidean measure, the squared distances are obtained   */
+/* as ||f||^2 + ||c||^2 - 2 f*c and mapped to exp(-d/dDistFactor). */
+/* The features are processed in blocks of MATCH_FEATURE_BLOCK     */
+/* against blocks of clusters that fit into the L2 cache, in in-   */
+/* creasing cluster order, so the neighbor lists come out in the   */
+/* same order as with a simple double loop.                        */
+/*******************************************************************/
+{
+  int nFeatures = (int)vFeatures.size();
+  int nClusters = (int)m_vClusters.size();
+
+  vNearestNeighbor.assign   ( nFeatures, -1 );
+  vNearestNeighborSim.assign( nFeatures, 0.0 );
+  vvAllNeighbors.assign     ( nFeatures, vector<int>() );
+  vvAllNeighborsSim.assign  ( nFeatures, vector<float>() );
+  if( nFeatures==0 || nClusters==0 )
+    return;
 
-  for( int i=0; i<(int)vFeatures.size(); i++ ) {
-    float dSim    = 0.0;
-    float dMaxSim = 0.0;
-    int   nMaxIdx = -1;
-    for( int k=0; k<(int)m_vClusters.size(); k++ ) {
-      float dDist = vFeatures[i].compSSD( m_vClusters[k] );
+  /*-------------------------------------*/
+  /* Get the features and clusters as    */
+  /* contiguous matrices                 */
+  /*-------------------------------------*/
+  FeatureMatrix        fmTmpClusters;
+  const FeatureMatrix *pClusters = &m_fmClusters;
+  if( m_fmClusters.numRows() != nClusters ||
+      m_fmClusters.numDims() != m_vClusters.front().numDims() ) {
+    fmTmpClusters.setRows( m_vClusters );
+    pClusters = &fmTmpClusters;
+  }
 
-      dSim = exp( -dDist/dDistFactor );
-      if ( dSim > dMaxSim ) {
-        dMaxSim = dSim;
-        nMaxIdx = k;
+  FeatureMatrix fmFeatures( vFeatures );
+  if( fmFeatures.numDims() != pClusters->numDims() ) {
+    cerr << "    Error in Codebook::matchToClusterMatrix(): "
+         << "Feature dimension (" << fmFeatures.numDims() 
+         << ") doesn't match the codebook (" << pClusters->numDims() 
+         << ")!" << endl;
+    return;
+  }
+  int nDims   = fmFeatures.numDims();
+  int nStride = fmFeatures.stride();
+
+  /* Euclidean case: sim > dRejectionThresh <=> dist < dMaxDist */
+  float dMaxDist = FLT_MAX;
+  if( bEuclidean && dRejectionThresh > 0.0 )
+    dMaxDist = -dDistFactor*log( dRejectionThresh );
+
+  /* best distance so far (Euclidean case) */
+  vector<float> vMinDist( nFeatures, FLT_MAX );
+
+  int nClBlock = (int)( MATCH_CLUSTER_BYTES/(sizeof(float)*nStride) );
+  nClBlock = max( nClBlock, 16 );
+  nClBlock = min( nClBlock, nClusters );
+  vector<float> vDots( MATCH_FEATURE_BLOCK*nClBlock );
+
+  /*--------------------*/
+  /* Blocked comparison */
+  /*--------------------*/
+  for( int f0=0; f0<nFeatures; f0+=MATCH_FEATURE_BLOCK ) {
+    int nFBlock = min( MATCH_FEATURE_BLOCK, nFeatures-f0 );
+
+    for( int c0=0; c0<nClusters; c0+=nClBlock ) {
+      int nCBlock = min( nClBlock, nClusters-c0 );
+      distCorrelationBlock( fmFeatures.row(f0), nFBlock, nStride,
+                            pClusters->row(c0), nCBlock, nStride, nDims,
+                            &vDots[0], nCBlock );
+
+      for( int i=0; i<nFBlock; i++ ) {
+        int          idx   = f0 + i;
+        const float *pDots = &vDots[i*nCBlock];
+
+        if( bEuclidean ) {
+          float dNormF = fmFeatures.sqrNorm( idx );
+          for( int k=0; k<nCBlock; k++ ) {
+            float dDist = ( dNormF + pClusters->sqrNorm( c0+k ) - 
+                            2.0*pDots[k] );
+            if( dDist < 0.0 )  // rounding errors
+              dDist = 0.0;
+
+            if( dDist < vMinDist[idx] ) {
+              vMinDist[idx]         = dDist;
+              vNearestNeighbor[idx] = c0 + k;
+            }
+
+            if( dDist < dMaxDist ) {
+              float dSim = exp( -dDist/dDistFactor );
+              if( dSim > dRejectionThresh ) {
+                vvAllNeighbors[idx].push_back( c0 + k );
+                vvAllNeighborsSim[idx].push_back( dSim );
+              }
+            }
+          }
+
+        } else
+          for( int k=0; k<nCBlock; k++ ) {
+            float dSim = pDots[k];
+            if( dSim > vNearestNeighborSim[idx] ) {
+              vNearestNeighborSim[idx] = dSim;
+              vNearestNeighbor[idx]    = c0 + k;
+            }
+
+            if( dSim > dRejectionThresh ) {
+              vvAllNeighbors[idx].push_back( c0 + k );
+              vvAllNeighborsSim[idx].push_back( dSim );
+            }
+          }
       }
+    }
+  }
 
-      if( dSim > dRejectionThresh ) {
-        vvAllNeighbors[i].push_back( k );
-        vvAllNeighborsSim[i].push_back( dSim );
+  /* the nearest neighbor similarity (0 => no neighbor, as before) */
+  if( bEuclidean )
+    for( int i=0; i<nFeatures; i++ ) {
+      float dSim = 0.0;
+      if( vNearestNeighbor[i] >= 0 )
+        dSim = exp( -vMinDist[i]/dDistFactor );
+      if( dSim > 0.0 )
+        vNearestNeighborSim[i] = dSim;
+      else
+        vNearestNeighbor[i] = -1;
+    }
+}
+
+
+void Codebook::matchToClusterTree( const vector<FeatureVector> &vFeatures,
+                                   float dRejectionThresh,
+                                   float dDistFactor,
+                                   int   nMaxChecks,
+                                   vector<int>    &vNearestNeighbor,
+                                   vector<float>  &vNearestNeighborSim,
+                                   vector<vector<int> >   &vvAllNeighbors,
+                                   vector<vector<float> > &vvAllNeighborsSim) const
+/*******************************************************************/
+/* Approximate Euclidean matching with a best-bin-first search in  */
+/* the balltree on the cluster centers, which stops after about    */
+/* nMaxChecks distance computations per feature. Clusters that are */
+/* not reached are missing from the neighbor lists (and the NN may */
+/* be wrong); otherwise, the results are the same as with matchTo- */
+/* ClusterMatrix(). Use balltreerecall to choose nMaxChecks.       */
+/*******************************************************************/
+{
+  int nFeatures = (int)vFeatures.size();
+
+  vNearestNeighbor.assign   ( nFeatures, -1 );
+  vNearestNeighborSim.assign( nFeatures, 0.0 );
+  vvAllNeighbors.assign     ( nFeatures, vector<int>() );
+  vvAllNeighborsSim.assign  ( nFeatures, vector<float>() );
+  if( nFeatures==0 || m_vClusters.empty() )
+    return;
+
+  /* sim > dRejectionThresh <=> dist < dMaxDist */
+  float dMaxDist = FLT_MAX;
+  if( dRejectionThresh > 0.0 )
+    dMaxDist = -dDistFactor*log( dRejectionThresh );
+
+  BallTreeSearchState      bsState;
+  vector<unsigned>         vIdzs;
+  vector<float>            vDists;
+  vector<pair<int,float> > vMatches;
+  for( int i=0; i<nFeatures; i++ ) {
+    vIdzs.clear();
+    vDists.clear();
+    m_btClusters.findNeighborsApprox( vFeatures[i], dMaxDist, nMaxChecks,
+                                      vIdzs, vDists, bsState );
+
+    /* nearest neighbor (0 => no neighbor, as before) */
+    if( !bsState.vBest.empty() ) {
+      float dSim = exp( -bsState.vBest.front().first/dDistFactor );
+      if( dSim > 0.0 ) {
+        vNearestNeighbor[i]    = (int)bsState.vBest.front().second;
+        vNearestNeighborSim[i] = dSim;
       }
     }
 
-    vNearestNeighbor.push_back( nMaxIdx );
-    vNearestNeighborSim.push_back( dMaxSim );
+    /* all neighbors above the threshold, in cluster order */
+    vMatches.clear();
+    for( unsigned k=0; k<vIdzs.size(); k++ ) {
+      float dSim = exp( -vDists[k]/dDistFactor );
+      if( dSim > dRejectionThresh )
+        vMatches.push_back( pair<int,float>( (int)vIdzs[k], dSim ) );
+    }
+    sort( vMatches.begin(), vMatches.end() );
+    for( unsigned k=0; k<vMatches.size(); k++ ) {
+      vvAllNeighbors[i].push_back( vMatches[k].first );
+      vvAllNeighborsSim[i].push_back( vMatches[k].second );
+    }
   }
-  //cout << "      done." << endl;
 }
 
 
@@ -16,6 +16,7 @@
 /*   Includes   */
 /****************/
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <iomanip>
 #include <math.h>
@@ -53,6 +54,7 @@ Codebook::Codebook()
   m_bClustersValid   = false;
   m_bPrototypesValid = false;
   m_bKeepPatches     = true;
+  m_bClusterTreeValid = false;
 }
 
 
@@ -79,6 +81,11 @@ void Codebook::setClusterParams( ClusterParams parCluster )
 void Codebook::setMatchingParams( MatchingParams parMatching )
 {
   m_parMatching = parMatching;
+
+  /* approximate matching needs the search tree */
+  if( m_parMatching.isValid() && 
+      m_parMatching.params()->m_nMaxLeafChecks > 0 )
+    updateClusterTree();
 }
 
 
@@ -97,6 +104,9 @@ void Codebook::clear()
   m_bPrototypesValid = false;
   m_bKeepPatches = true;
   m_vClusters.clear();
+  m_fmClusters.clear();
+  m_btClusters.clear();
+  m_bClusterTreeValid = false;
   m_vClusterPatches.clear();
   m_vClusterAssignment.clear();
   m_vPrototypes.clear();
@@ -180,6 +190,7 @@ void Codebook::normalizeFeatures( int nFeatureType )
 void Codebook::normalizeClusters( int nFeatureType )
 {
   normalizeFeatures( m_vClusters, nFeatureType );
+  updateClusterMatrix();
 }
 
 
@@ -225,6 +236,38 @@ int Codebook::getNumClusters() const
 }
 
 
+void Codebook::updateClusterMatrix()
+/*******************************************************************/
+/* Copy the cluster centers into the contiguous matrix used for    */
+/* matching. This has to be called again whenever m_vClusters is   */
+/* changed from outside (the matching routines fall back to a tem- */
+/* porary copy if the number of rows doesn't match).               */
+/*******************************************************************/
+{
+  m_fmClusters.setRows( m_vClusters );
+
+  /* the search tree is rebuilt when it is needed next */
+  m_bClusterTreeValid = false;
+}
+
+
+void Codebook::updateClusterTree()
+/*******************************************************************/
+/* Build the balltree on the cluster centers that is used for ap-  */
+/* proximate matching (MatchingGUI::m_nMaxLeafChecks > 0). This is */
+/* done automatically by setMatchingParams() if necessary.         */
+/*******************************************************************/
+{
+  if( m_bClusterTreeValid )
+    return;
+
+  m_btClusters.clear();
+  if( !m_vClusters.empty() )
+    m_btClusters.build( m_vClusters );
+  m_bClusterTreeValid = true;
+}
+
+
 vector<FeatureVector> Codebook::getClusters() const    
 { 
   if( !m_bClustersValid )
@@ -335,36 +378,46 @@ void Codebook::loadCodebook( string sFileName, bool bKeepPatches,
   int pos = sRawName.rfind( "." );
   sRawName.erase( pos );
 
-  /*----------------------------*/
-  /* Load the codebook features */
-  /*----------------------------*/
-  if( !loadFeatures( sFileName, m_vFeatures, bVerbose ) )
-    return;
+  if( isModelFile( sFileName ) ) {
+    /*----------------------------------------------------*/
+    /* Binary codebook: features, assignments, trace, and */
+    /* cluster centers are all contained in the one file. */
+    /*----------------------------------------------------*/
+    if( !loadCodebookBinary( sFileName, bVerbose ) )
+      return;
+
+  } else {
+    /*----------------------------*/
+    /* Load the codebook features */
+    /*----------------------------*/
+    if( !loadFeatures( sFileName, m_vFeatures, bVerbose ) )
+      return;
   
-  /*--------------------------------------*/
-  /* Load the corresponding image patches */
-  /*--------------------------------------*/
-  if( m_bKeepPatches ) {
-    string sPatchFile( sRawName + ".patches.flz" );
-    loadPatches( sPatchFile, m_vImagePatches, bVerbose );
-  }
+    /*--------------------------------------*/
+    /* Load the corresponding image patches */
+    /*--------------------------------------*/
+    if( m_bKeepPatches ) {
+      string sPatchFile( sRawName + ".patches.flz" );
+      loadPatches( sPatchFile, m_vImagePatches, bVerbose );
+    }
 
-  /*------------------------------*/
-  /* Load the cluster assignments */
-  /*------------------------------*/
-  string sAssignName( sRawName + ".ass" );  
-  loadClusterAssignments( sAssignName, m_vClusterAssignment, bVerbose );
+    /*------------------------------*/
+    /* Load the cluster assignments */
+    /*------------------------------*/
+    string sAssignName( sRawName + ".ass" );  
+    loadClusterAssignments( sAssignName, m_vClusterAssignment, bVerbose );
   
-  /*------------------------*/
-  /* Load the cluster trace */
-  /*------------------------*/
-  string sTraceFile( sRawName + ".trc" );
-  loadClusterTrace( sTraceFile, m_vClusterTrace, bVerbose );
+    /*------------------------*/
+    /* Load the cluster trace */
+    /*------------------------*/
+    string sTraceFile( sRawName + ".trc" );
+    loadClusterTrace( sTraceFile, m_vClusterTrace, bVerbose );
 
-  /*-----------------------------*/
-  /* Compute the cluster centers */
-  /*-----------------------------*/
-  computeClusterCenters();
+    /*-----------------------------*/
+    /* Compute the cluster centers */
+    /*-----------------------------*/
+    computeClusterCenters();
+  }
 
   /*---------------------*/
   /* Load the prototypes */
@@ -617,6 +670,102 @@ void Codebook::saveCodebook( string sFileName, bool bKeepPatches,
   if( bVerbose )
     cout << "Saving Codebook done." << endl;
 }
+
+
+static void packFeatureVectors( const vector<FeatureVector> &vVectors,
+                                vector<char> &vBuffer )
+  /* binary model file layout: (unsigned) nRows, nDims, then the data */
+{
+  unsigned nHeader[2];
+  nHeader[0] = vVectors.size();
+  nHeader[1] = ( vVectors.empty() ? 0 : vVectors.front().numDims() );
+  vBuffer.resize( sizeof(nHeader) + 
+                  (size_t)nHeader[0]*nHeader[1]*sizeof(float) );
+  memcpy( &vBuffer[0], nHeader, sizeof(nHeader) );
+  float *pData = (float*) &vBuffer[sizeof(nHeader)];
+  for( unsigned i=0; i<nHeader[0]; i++ ) {
+    assert( vVectors[i].numDims() == (int)nHeader[1] );
+    memcpy( pData + (size_t)i*nHeader[1], vVectors[i].getDataPtr(), 
+            nHeader[1]*sizeof(float) );
+  }
+}
+
+
+static bool unpackFeatureVectors( const char *pBuffer, size_t nSize,
+                                  vector<FeatureVector> &vVectors )
+{
+  unsigned nHeader[2];
+  if( pBuffer==0 || nSize < sizeof(nHeader) )
+    return false;
+  memcpy( nHeader, pBuffer, sizeof(nHeader) );
+  if( nSize != sizeof(nHeader) + (size_t)nHeader[0]*nHeader[1]*sizeof(float) )
+    return false;
+
+  const float *pData = (const float*) (pBuffer + sizeof(nHeader));
+  vVectors.clear();
+  vVectors.reserve( nHeader[0] );
+  for( unsigned i=0; i<nHeader[0]; i++ ) {
+    const float *pRow = pData + (size_t)i*nHeader[1];
+    vVectors.push_back( FeatureVector( vector<float>( pRow, 
+                                                      pRow+nHeader[1] ) ) );
+  }
+  return true;
+}
+
+
+void Codebook::saveCodebookBinary( string sFileName, bool bVerbose )
+/*******************************************************************/
+/* Save the codebook features, cluster assignments, cluster trace, */
+/* and the cluster centers to a single binary model file, which    */
+/* loadCodebook() reads without any parsing. The parameters are    */
+/* saved to a separate *.params file as usual; image patches and   */
+/* prototypes are not stored.                                      */
+/*******************************************************************/
+{ 
+  if( bVerbose )
+    cout << "SaveCodebookBinary() called..." << endl;
+
+  if( !m_bClustersValid && !m_vFeatures.empty() )
+    computeClusterCenters();
+
+  /*----------------------------*/
+  /* Pack the codebook contents */
+  /*----------------------------*/
+  vector<char> vFeatures, vClusters;
+  packFeatureVectors( m_vFeatures, vFeatures );
+  packFeatureVectors( m_vClusters, vClusters );
+
+  ModelFileWriter mfWriter;
+  mfWriter.addSection( MODELSEC_CB_FEATURES, &vFeatures[0], vFeatures.size() );
+  mfWriter.addSection( MODELSEC_CB_CLUSTERS, &vClusters[0], vClusters.size() );
+  mfWriter.addSection( MODELSEC_CB_ASSIGNMENT, 
+                       ( m_vClusterAssignment.empty() ? 0 : 
+                         &m_vClusterAssignment[0] ),
+                       m_vClusterAssignment.size()*sizeof(int) );
+  mfWriter.addSection( MODELSEC_CB_TRACE, 
+                       ( m_vClusterTrace.empty() ? 0 : &m_vClusterTrace[0] ),
+                       m_vClusterTrace.size()*sizeof(ClStep) );
+  if( !mfWriter.write( sFileName ) )
+    cerr << "  WARNING: Couldn't save codebook!" << endl;
+
+  /*-------------------------*/
+  /* Save the parameter file */
+  /*-------------------------*/
+  string sRawName( sFileName );
+  int pos = sRawName.rfind( "." );
+  if( pos != (int)string::npos )
+    sRawName.erase( pos );
+  string sParamName( sRawName + ".params" );
+  if( m_parCluster.isValid() )
+    m_parCluster.params()->saveParams( sParamName );
+  if( m_parMatching.isValid() )
+    m_parMatching.params()->saveParams( sParamName );
+
+  if( bVerbose )
+    cout << "Saving Codebook done." << endl;
+}
+
+
 void Codebook::computeClusterCenters_HF()
 {
 	// Get the cluster in random forest format
@@ -645,6 +794,7 @@ void Codebook::computeClusterCenters_HF()
 	FeatureVector fvTmp( m_vFeatures.front().numDims() );
   	vector<FeatureVector> vTmp( vvAssignment.size(), fvTmp );
  	m_vClusters = vTmp;
+	updateClusterMatrix();
 
 	m_bClustersValid = true;
 }
@@ -694,6 +844,7 @@ void Codebook::computeClusterCenters()
     if( m_bKeepPatches )
       m_vClusterPatches[i] = m_vClusterPatches[i].div((float)vNumMembers[i]);
   }
+  updateClusterMatrix();
 
   m_bClustersValid = true;
 }
@@ -1975,6 +2126,55 @@ void Codebook::saveClusterTrace( string sFileName, bool bVerbose )
 }
 
 
+bool Codebook::loadCodebookBinary( string sFileName, bool bVerbose )
+/*******************************************************************/
+/* Load the codebook contents from a binary model file (see save-  */
+/* CodebookBinary()). The cluster centers are taken from the file  */
+/* instead of being recomputed. Features and clusters are copied   */
+/* into FeatureVectors, the file is unmapped on return.            */
+/*******************************************************************/
+{
+  if( bVerbose )
+    cout << "  Loading binary codebook..." << endl;
+
+  MappedModelFile mfFile;
+  if( !mfFile.open( sFileName ) )
+    return false;
+
+  size_t nFeatSize, nClustSize, nAssignSize, nTraceSize;
+  const char *pFeatures = mfFile.section( MODELSEC_CB_FEATURES, nFeatSize );
+  const char *pClusters = mfFile.section( MODELSEC_CB_CLUSTERS, nClustSize );
+  const int  *pAssign   = (const int*) 
+    mfFile.section( MODELSEC_CB_ASSIGNMENT, nAssignSize );
+  const ClStep *pTrace  = (const ClStep*) 
+    mfFile.section( MODELSEC_CB_TRACE, nTraceSize );
+
+  if( !unpackFeatureVectors( pFeatures, nFeatSize, m_vFeatures ) ||
+      !unpackFeatureVectors( pClusters, nClustSize, m_vClusters ) ) {
+    cerr << "    Loading binary codebook failed..." << endl
+         << "      (Path is: '" << sFileName << "')" << endl;
+    m_vFeatures.clear();
+    m_vClusters.clear();
+    return false;
+  }
+  if( pAssign != 0 )
+    m_vClusterAssignment.assign( pAssign, 
+                                 pAssign + nAssignSize/sizeof(int) );
+  if( pTrace != 0 )
+    m_vClusterTrace.assign( pTrace, pTrace + nTraceSize/sizeof(ClStep) );
+
+  /* the image patches are not stored in the binary format */
+  m_bKeepPatches = false;
+  updateClusterMatrix();
+  m_bClustersValid = true;
+
+  if( bVerbose )
+    cout << "  done (" << m_vFeatures.size() << " features, "
+         << m_vClusters.size() << " clusters)." << endl;
+  return true;
+}
+
+
 void Codebook::loadPrototypes( string sFileName, bool bVerbose )
 /*******************************************************************/
 /* Load the most typical patch in each cluster (used e.g. for      */
@@ -24,6 +24,9 @@ using namespace std;
 #include <qdir.h>
 
 #include <featurevector.hh>
+#include <featurematrix.hh>
+#include <modelfile.hh>
+#include <balltree.hh>
 #include <cluster.hh>
 #include <clstep.hh>
 #include <featurecue.hh>
@@ -85,18 +88,22 @@ public:
   /**********************/
   int                   getNumFeatures() const       
   { return (int)m_vFeatures.size(); }
-  vector<FeatureVector> getFeatures() const    { return m_vFeatures; }
+  const vector<FeatureVector>& getFeatures() const { return m_vFeatures; }
   
   int                   getNumClusters() const;
   vector<FeatureVector> getClusters() const;
   vector<int>           getPrototypes() const;
   vector<int>           getClusterAssignment() const;
 
-  vector<OpGrayImage>   getImagePatches() const   {return m_vImagePatches; }
+  const FeatureMatrix&  getClusterMatrix() const { return m_fmClusters; }
+  void                  updateClusterMatrix();
+  void                  updateClusterTree();
+
+  const vector<OpGrayImage>& getImagePatches() const {return m_vImagePatches;}
   vector<OpGrayImage>   getClusterPatches() const;
   OpGrayImage           getClusterPatch( int idx ) const;
 
-  vector<ClStep>        getClusterTrace() const {return m_vClusterTrace; }
+  const vector<ClStep>& getClusterTrace() const {return m_vClusterTrace; }
 
   void                  setClusterAssignment( const vector<int> &vAssignment )
   { assert( m_vFeatures.size()==vAssignment.size() );
@@ -122,6 +129,7 @@ public:
                        bool bVerbose=true );
   void saveCodebook  ( string sFileName, FeatureCue &fcCue,
                        bool bKeepPatches=true, bool bVerbose=true );
+  void saveCodebookBinary( string sFileName, bool bVerbose=true );
 
   void computeClusterCenters   ();
   void computeClusterCenters_HF();
@@ -160,7 +168,26 @@ public:
                               vector<float>           &vNearestNeighborSim,
                               vector<vector<int> >   &vvAllNeighbors,
                               vector<vector<float> > &vvAllNeighborsSim) const;
- 
+
+protected:
+  void matchToClusterMatrix ( const vector<FeatureVector> &vImgFeatures,
+                              float dRejectionThresh,
+                              bool  bEuclidean,
+                              float dDistFact,
+                              vector<int>             &vNearestNeighbor,
+                              vector<float>           &vNearestNeighborSim,
+                              vector<vector<int> >   &vvAllNeighbors,
+                              vector<vector<float> > &vvAllNeighborsSim) const;
+  void matchToClusterTree   ( const vector<FeatureVector> &vImgFeatures,
+                              float dRejectionThresh,
+                              float dDistFact,
+                              int   nMaxChecks,
+                              vector<int>             &vNearestNeighbor,
+                              vector<float>           &vNearestNeighborSim,
+                              vector<vector<int> >   &vvAllNeighbors,
+                              vector<vector<float> > &vvAllNeighborsSim) const;
+
+public:
   void matchToCodebookChamfer   ( const vector<FeatureVector> &vFeatures,
                                   float dRejectionThresh,
                                   vector<int>             &vNearestNeighbor,
@@ -260,6 +287,8 @@ public:
   void savePrototypes        ( string sFilename, bool bVerbose=false );
   void loadPrototypes        ( string sFileName, bool bVerbose=false );
 
+  bool loadCodebookBinary    ( string sFileName, bool bVerbose=false );
+
 protected:
   void updateMatchingParams     ( int nFeatureType );
 
@@ -284,6 +313,9 @@ public:
   RandomForest 		m_rfRandomForest;  
 
   vector<FeatureVector> m_vClusters;
+  FeatureMatrix         m_fmClusters;  // contiguous copy of m_vClusters
+  BallTree              m_btClusters;  // for approximate matching
+  bool                  m_bClusterTreeValid;
   vector<int>           m_vClusterAssignment;
   vector<ClStep>        m_vClusterTrace;
   
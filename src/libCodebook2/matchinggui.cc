@@ -84,6 +84,13 @@ MatchingGUI::MatchingGUI( QWidget *parent, const char *name )
   editSimFact->setMaximumWidth(50);
   m_dFeatureSimFact = atof( editSimFact->text() );
   QT_CONNECT_LINEEDIT( editSimFact, FeatureSimFact );
+
+  QHBox        *hbChecks    = new QHBox( selCompMethod, "hbChecks" );
+  QLabel       *labChecks   = new QLabel( "Max Checks:", hbChecks );
+  QLineEdit    *editChecks  = new QLineEdit( "0", hbChecks, "edChecks" );
+  editChecks->setMaximumWidth(50);
+  m_nMaxLeafChecks = atoi( editChecks->text() );
+  QT_CONNECT_LINEEDIT( editChecks, MaxLeafChecks );
   
   selCorrel->setChecked( true );
   m_nCompareSelect = CMP_CORRELATION;
@@ -103,7 +110,8 @@ void MatchingGUI::saveParams( string sFileName, bool bVerbose )
     stream << "\n*** Section MatchingGUI ***\n"
            << "m_nCompareSelect: " << m_nCompareSelect << "\n"
            << "m_dRejectionThresh: " << m_dRejectionThresh << "\n"
-           << "m_dFeatureSimFact: " << m_dFeatureSimFact << "\n";
+           << "m_dFeatureSimFact: " << m_dFeatureSimFact << "\n"
+           << "m_nMaxLeafChecks: " << m_nMaxLeafChecks << "\n";
     qfile.close();
   }
 }
@@ -162,6 +170,8 @@ void MatchingGUI::loadParams( string sFileName, bool bVerbose )
         emit sigRejectionThresholdChanged(val);
       else if (name.compare("m_dFeatureSimFact")==0)
         emit sigFeatureSimFactChanged(val);
+      else if (name.compare("m_nMaxLeafChecks")==0)
+        emit sigMaxLeafChecksChanged(val);
       else
         cerr << "XXXXXXXXX     WARNING: variable " << name.latin1()
              << " unknown !!!     XXXXXXXXXXXX" << endl;
@@ -179,6 +189,8 @@ QT_IMPLEMENT_LINEEDIT_FLOAT( MatchingGUI::slot, RejectionThreshold,
                              m_dRejectionThresh, 2 )
 QT_IMPLEMENT_LINEEDIT_FLOAT( MatchingGUI::slot, FeatureSimFact, 
                              m_dFeatureSimFact, 1 )
+QT_IMPLEMENT_LINEEDIT_INT  ( MatchingGUI::slot, MaxLeafChecks, 
+                             m_nMaxLeafChecks )
 
 QT_IMPLEMENT_RADIOBUTTON( MatchingGUI::slot, CompMethod, m_nCompareSelect )
 
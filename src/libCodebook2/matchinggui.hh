@@ -50,8 +50,10 @@ public slots:
   /**************************/
   void slotSetRejectionThreshold( const QString &text );
   void slotSetFeatureSimFact    ( const QString &text );
+  void slotSetMaxLeafChecks     ( const QString &text );
   void slotUpdateRejectionThreshold();
   void slotUpdateFeatureSimFact();
+  void slotUpdateMaxLeafChecks();
 
   void slotSelectCompMethod      ( int   id );
 
@@ -61,6 +63,7 @@ signals:
   /**************************/
   void sigRejectionThresholdChanged( const QString& );
   void sigFeatureSimFactChanged    ( const QString& );
+  void sigMaxLeafChecksChanged     ( const QString& );
 
 public:
   /*********************/
@@ -80,6 +83,10 @@ public:
   int    m_nCompareSelect;
   float  m_dRejectionThresh;
   float  m_dFeatureSimFact;
+
+  /* Approximate matching: max. #distance computations per feature */
+  /* (0 = exact matching; only used with Euclidean distances)      */
+  int    m_nMaxLeafChecks;
 };
 
 #endif
@@ -30,8 +30,8 @@
 /*   Function Implementations   */
 /********************************/
 
-void compareCodebookNGC( vector<FeatureVector> vSrcImgFeatures,
-                         vector<FeatureVector> vClusters,
+void compareCodebookNGC( const vector<FeatureVector> &vSrcImgFeatures,
+                         const vector<FeatureVector> &vClusters,
                          float dRejectionThresh,
                          vector<int>             &vNearestNeighbor,
                          vector<float>           &vNearestNeighborSim,
@@ -86,13 +86,13 @@ void compareCodebookNGC( vector<FeatureVector> vSrcImgFeatures,
 }
 
 
-void compareCodebookNGCEdges( vector<FeatureVector> vSrcImgFeatures,
-                              vector<FeatureVector> vFeatureMaps,
-                              vector<FeatureVector> vGradMagMaps,
-                              vector<FeatureVector> vClusters,
-                              vector<FeatureVector> vAveragedMaps,
-                              vector<float>         vAveragedMapsSum,
-                              vector<FeatureVector> vTrainGradMagMaps,
+void compareCodebookNGCEdges( const vector<FeatureVector> &vSrcImgFeatures,
+                              const vector<FeatureVector> &vFeatureMaps,
+                              const vector<FeatureVector> &vGradMagMaps,
+                              const vector<FeatureVector> &vClusters,
+                              const vector<FeatureVector> &vAveragedMaps,
+                              const vector<float>         &vAveragedMapsSum,
+                              const vector<FeatureVector> &vTrainGradMagMaps,
                               float dRejectionThresh,
                               vector<int>             &vNearestNeighbor,
                               vector<float>           &vNearestNeighborSim,
@@ -703,7 +703,7 @@ void compareCodebookChamferOrientation( const vector<FeatureVector> &vSrcImgFeat
 
 
 
-double computeNGC( FeatureVector &p1, FeatureVector &p2 )
+double computeNGC( const FeatureVector &p1, const FeatureVector &p2 )
 /*******************************************************************/
 /* Compute the normalized grayscale correlation (NGC) between two  */
 /* feature vectors.                                                */
@@ -738,11 +738,11 @@ double computeNGC( FeatureVector &p1, FeatureVector &p2 )
 }
 
 
-double computeFigureNGC( /*const*/ FeatureVector &p1,
-                                   /*const*/ FeatureVector &p2,
-                                   /*const*/ FeatureVector &seg,
-                                   /*const*/ FeatureVector &gradMagMap,
-                                   /*const*/ FeatureVector &trainGradMagMap,
+double computeFigureNGC( const FeatureVector &p1,
+                                   const FeatureVector &p2,
+                                   const FeatureVector &seg,
+                                   const FeatureVector &gradMagMap,
+                                   const FeatureVector &trainGradMagMap,
                                    float sum  )
 /*******************************************************************/
 /* Compute the normalized grayscale correlation (NGC) between two  */
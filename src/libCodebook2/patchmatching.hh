@@ -40,21 +40,21 @@ const int NORM_ENERGY      = 3;
 /*   Function Prototypes   */
 /***************************/
 
-void compareCodebookNGC        ( vector<FeatureVector> vSrcImgFeatures,
-                                 vector<FeatureVector> vClusters,
+void compareCodebookNGC        ( const vector<FeatureVector> &vSrcImgFeatures,
+                                 const vector<FeatureVector> &vClusters,
                                  float dRejectionThresh,
                                  vector<int>             &vNearestNeighbor,
                                  vector<float>           &vNearestNeighborSim,
                                  vector< vector<int> >   &vvAllNeighbors,
                                  vector< vector<float> > &vvAllNeighborsSim );
 
-void compareCodebookNGCEdges   ( vector<FeatureVector> vSrcImgFeatures,
-                                 vector<FeatureVector> vFeatureMaps,
-                                 vector<FeatureVector> vGradMagMaps,
-                                 vector<FeatureVector> vClusters,
-                                 vector<FeatureVector> vAveragedMaps,
-                                 vector<float>         vAveragedMapsSum,
-                                 vector<FeatureVector> vTrainGradMagMaps,
+void compareCodebookNGCEdges   ( const vector<FeatureVector> &vSrcImgFeatures,
+                                 const vector<FeatureVector> &vFeatureMaps,
+                                 const vector<FeatureVector> &vGradMagMaps,
+                                 const vector<FeatureVector> &vClusters,
+                                 const vector<FeatureVector> &vAveragedMaps,
+                                 const vector<float>         &vAveragedMapsSum,
+                                 const vector<FeatureVector> &vTrainGradMagMaps,
                                  float dRejectionThresh,
                                  vector<int>             &vNearestNeighbor,
                                  vector<float>           &vNearestNeighborSim,
@@ -116,13 +116,13 @@ void compareCodebookChamferOrientation( const vector<FeatureVector> &vSrcImgFeat
                              vector< vector<int> >   &vvAllNeighbors,
                              vector< vector<float> > &vvAllNeighborsSim, bool symDist=false );
 
-double computeNGC      ( /*const*/ FeatureVector &p1,
-                                   /*const*/ FeatureVector &p2 );
-double computeFigureNGC( /*const*/ FeatureVector &p1,
-                                   /*const*/ FeatureVector &p2,
-                                   /*const*/ FeatureVector &seg,
-                                   /*const*/ FeatureVector &gradMagMap,
-                                   /*const*/ FeatureVector &trainGradMagMap,
+double computeNGC      ( const FeatureVector &p1,
+                                   const FeatureVector &p2 );
+double computeFigureNGC( const FeatureVector &p1,
+                                   const FeatureVector &p2,
+                                   const FeatureVector &seg,
+                                   const FeatureVector &gradMagMap,
+                                   const FeatureVector &trainGradMagMap,
                                    float sum  );
 
 #endif
@@ -12,7 +12,8 @@ INCLUDEPATH += . $${CODE}/include
 
 # Input
 HEADERS += container.hh \
-           sharedcontainer.hh 
+           sharedcontainer.hh \
+           parallelfor.hh
 
 #SOURCES += container.cc
 
@@ -0,0 +1,130 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         parallelfor.hh                                       */
+/*                                                                   */
+/* CONTENT      Minimal pthread-based helper for data-parallel loops.*/
+/*              The index range [nBegin,nEnd) is split into one      */
+/*              contiguous block per thread, and the task object is  */
+/*              called once per block as                             */
+/*                                                                   */
+/*                  task( nThread, nBlockBegin, nBlockEnd );         */
+/*                                                                   */
+/*              Thread t always receives the t-th block in index     */
+/*              order, so results that are collected per thread and  */
+/*              concatenated in thread order are identical to those  */
+/*              of a serial loop.                                    */
+/*                                                                   */
+/*              The calling thread processes block 0 itself; with    */
+/*              one thread (or a too small range), the task is sim-  */
+/*              ply called directly without creating any threads.    */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef PARALLELFOR_HH
+#define PARALLELFOR_HH
+
+using namespace std;
+
+/****************/
+/*   Includes   */
+/****************/
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+
+/*******************/
+/*   Definitions   */
+/*******************/
+inline int getNumProcessors()
+  /* number of online processors (at least 1) */
+{
+  long nProcs = sysconf( _SC_NPROCESSORS_ONLN );
+  return ( nProcs > 0 ? (int)nProcs : 1 );
+}
+
+
+inline int getNumThreads( int nThreads, int nTasks )
+  /*******************************************************************/
+  /* Resolve a thread count parameter: values <= 0 select one thread */
+  /* per processor. The result is clipped to the number of tasks.    */
+  /*******************************************************************/
+{
+  if( nThreads <= 0 )
+    nThreads = getNumProcessors();
+  if( nThreads > nTasks )
+    nThreads = nTasks;
+  return ( nThreads > 0 ? nThreads : 1 );
+}
+
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+template<class Task>
+struct ParallelForBlock
+{
+  Task *pTask;
+  int   nThread;
+  int   nBegin;
+  int   nEnd;
+};
+
+
+template<class Task>
+void* parallelForThread( void *pArg )
+{
+  ParallelForBlock<Task> *pBlock = (ParallelForBlock<Task>*) pArg;
+  (*pBlock->pTask)( pBlock->nThread, pBlock->nBegin, pBlock->nEnd );
+  return 0;
+}
+
+
+template<class Task>
+int parallelFor( int nBegin, int nEnd, int nThreads, Task &task )
+  /*******************************************************************/
+  /* Run task on the index range [nBegin,nEnd) with (at most) the    */
+  /* given number of threads (<=0: one per processor). Returns the   */
+  /* number of blocks (= threads) actually used.                     */
+  /*******************************************************************/
+{
+  int nTasks = nEnd - nBegin;
+  nThreads = getNumThreads( nThreads, nTasks );
+  if( nThreads == 1 ) {
+    task( 0, nBegin, nEnd );
+    return 1;
+  }
+
+  /* split the range into contiguous blocks of (nearly) equal size */
+  vector< ParallelForBlock<Task> > vBlocks( nThreads );
+  for( int t=0; t<nThreads; t++ ) {
+    vBlocks[t].pTask   = &task;
+    vBlocks[t].nThread = t;
+    vBlocks[t].nBegin  = nBegin + (int)( (long)nTasks*t/nThreads );
+    vBlocks[t].nEnd    = nBegin + (int)( (long)nTasks*(t+1)/nThreads );
+  }
+
+  /* start the worker threads; fall back to the caller if that fails */
+  vector<pthread_t> vThreads( nThreads );
+  vector<bool>      vStarted( nThreads, false );
+  for( int t=1; t<nThreads; t++ )
+    vStarted[t] = ( pthread_create( &vThreads[t], 0,
+                                    parallelForThread<Task>,
+                                    &vBlocks[t] ) == 0 );
+
+  task( 0, vBlocks[0].nBegin, vBlocks[0].nEnd );
+  for( int t=1; t<nThreads; t++ )
+    if( vStarted[t] )
+      pthread_join( vThreads[t], 0 );
+    else
+      task( t, vBlocks[t].nBegin, vBlocks[t].nEnd );
+
+  return nThreads;
+}
+
+
+#endif
@@ -317,7 +317,7 @@ void Detector::addCue()
   /*--------------------------------------*/
   QString qsStartDir( m_qsDirCodebooks );
   QString qsCBName = QFileDialog::getOpenFileName( qsStartDir,
-                                      "Vectors (*.fls *.flz);;All files (*.*)",
+                                 "Vectors (*.fls *.flz *.bin);;All files (*.*)",
                                                    this->params(), 
                                                    "LoadCodebook",
                                                    "Select a codebook" );
@@ -328,7 +328,7 @@ void Detector::addCue()
   /* Ask for a file name for the occurrences */
   /*-----------------------------------------*/
   QString qsOccName = QFileDialog::getOpenFileName( qsCBName,
-                                      "Vectors (*.fls *.flz);;All files (*.*)",
+                                 "Vectors (*.fls *.flz *.bin);;All files (*.*)",
                                                     this->params(), 
                                                     "LoadOccurrences",
                                                  "Select an occurrence file");
@@ -505,7 +505,7 @@ void Detector::loadCodebook( unsigned nIdx, bool bVerbose )
   /*---------------------*/
   QString qsStartDir( m_qsDirCodebooks );
   QString qsFileName = QFileDialog::getOpenFileName( qsStartDir,
-                   "Vectors (*.fls *.flz);;All files (*.*)",
+                   "Vectors (*.fls *.flz *.bin);;All files (*.*)",
                                                      this->params() );
   if ( qsFileName.isEmpty() )
     return;
@@ -590,7 +590,7 @@ void Detector::loadOccurrences( unsigned nIdx, bool bVerbose )
 { 
   QString qsFileName = 
     QFileDialog::getOpenFileName( m_qsDirCodebooks, 
-                                  "Vectors (*.fls *.flz);;All files (*.*)",
+                                 "Vectors (*.fls *.flz *.bin);;All files (*.*)",
                                   this->params() );
   if ( qsFileName.isEmpty() )
     return;
@@ -1345,8 +1345,8 @@ vector<Hypothesis> Detector::getPatchHypotheses( bool bDisplayResults,
 //       for(unsigned i=0; i<vVotes.size(); i++ ) {
       for( list<HoughVote>::iterator it=vVotes.begin(); 
            it!=vVotes.end(); it++ ) {
-        hScales.insertValue( it->getCoords().at(2) );
-        hScaleScores.incrementValue( it->getCoords().at(2),
+        hScales.insertValue( it->coord(2) );
+        hScaleScores.incrementValue( it->coord(2),
                                      it->getValue() );
       }
       QImage imgQScaleHisto; 
@@ -1802,7 +1802,7 @@ void Detector::displayOccScaleFootprint()
   /* Create a histogram for each cue */
   for(unsigned nIdx=0; nIdx<m_nNumCues; nIdx++ ) {
     /* Get the occurrences */
-    VecVecOccurrence vvOccurrences = m_vISMReco[nIdx].getOccurrences();
+    const VecVecOccurrence &vvOccurrences = m_vISMReco[nIdx].getOccurrences();
 
     /* create a scale footprint for the occurrences */
     for(unsigned i=0; i<vvOccurrences.size(); i++ )
@@ -24,6 +24,8 @@
 
 #include <dogscalespace.hh>
 #include <histogram.hh>
+#include <fastgaussbank.hh>
+#include <canny.hh>
 
 #include "polcoe.h"
 
@@ -82,9 +84,11 @@ void applyEdgeScaleSpace( OpGrayImage img,
                           float dScaleFactor, bool bNormOri,
                           PointVector &vPoints,
                           vector<OpGrayImage> &vEdgePatches,
-                          vector<OpGrayImage> &vDirPatches )
+                          vector<OpGrayImage> &vDirPatches,
+                          ScaleSpaceCache *pScaleCache )
   /*******************************************************************/
-  /* Create an Edge Scale Space   */
+  /* Create an Edge Scale Space. If a scale space cache for img is   */
+  /* given, the DoG levels are taken from there.                     */
   /*******************************************************************/
 {
   cout << "  ::applyEdgeScaleSpace( " << nNumOctaves << ", " 
@@ -96,7 +100,13 @@ void applyEdgeScaleSpace( OpGrayImage img,
   /****************************/
   /* Create a DoG Scale Space */
   /****************************/
-  DoGScaleSpace dogScale( img, nNumOctaves, nLevelsPerOctave, dScaleSigma0 );
+  DoGScaleSpace dogScale;
+  if( pScaleCache != 0 && pScaleCache->isCompatible( img ) )
+    dogScale = DoGScaleSpace( *pScaleCache, nNumOctaves, nLevelsPerOctave, 
+                              dScaleSigma0 );
+  else
+    dogScale = DoGScaleSpace( img, nNumOctaves, nLevelsPerOctave, 
+                              dScaleSigma0 );
 
   /****************************************/
   /* Create edge images at several scales */
@@ -105,6 +115,13 @@ void applyEdgeScaleSpace( OpGrayImage img,
   //double dFactor   = sqrt(2.0);
   //double dLimit    = 8.0f;
 
+  /* compute the gradients for all scales in one filter bank pass */
+  FastGaussBank fgbEdges;
+  for ( double dSigma=dEdgeMinSigma; dSigma<dEdgeMaxSigma; 
+        dSigma*=dEdgeIncSigma )
+    fgbEdges.addRequest( (float)dSigma, FGB_DX | FGB_DY | FGB_MAG | FGB_DIR );
+  fgbEdges.apply( img );
+
   PointVector vEdgePoints;
   vEdgePatches.clear();
   vDirPatches.clear();
@@ -112,14 +129,18 @@ void applyEdgeScaleSpace( OpGrayImage img,
   long nNumBeforeScales = 0;
   long nNumBeforeThresh = 0;
   long nNumBeforeAngles = 0;
+  int  nLevel = 0;
   for ( double dSigma=dEdgeMinSigma; dSigma<dEdgeMaxSigma; 
-        dSigma*=dEdgeIncSigma ) {
+        dSigma*=dEdgeIncSigma, nLevel++ ) {
     cout << "    Generating edge image with sigma=" << dSigma << "..." << endl;
     
     /* Extract edges at the current scale */
-    OpGrayImage imgEdges, imgMag, imgDirs;
-    img.opCannyEdges( dSigma, dThreshCannyLo, dThreshCannyHi, 
-                      imgEdges, imgMag, imgDirs );
+    OpGrayImage imgEdges;
+    OpGrayImage imgMag ( fgbEdges.getResult( nLevel, FGB_MAG ) );
+    OpGrayImage imgDirs( fgbEdges.getResult( nLevel, FGB_DIR ) );
+    canny( fgbEdges.getResult( nLevel, FGB_DX ), 
+           fgbEdges.getResult( nLevel, FGB_DY ), imgMag,
+           dThreshCannyLo, dThreshCannyHi, imgEdges );
 
     // For Debugging only:
     //     InterestPoint ptTmp;
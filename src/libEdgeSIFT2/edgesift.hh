@@ -33,6 +33,7 @@ using namespace std;
 #include <opgrayimage.hh>
 #include <opinterestimage.hh>
 #include <featurevector.hh>
+#include <scalespacecache.hh>
 
 
 /*******************/
@@ -50,7 +51,8 @@ void applyEdgeScaleSpace( OpGrayImage img,
                           float dScaleFactor, bool bNormOri,
                           PointVector &vPoints,
                           vector<OpGrayImage> &vEdgePatches,
-                          vector<OpGrayImage> &vDirPatches );
+                          vector<OpGrayImage> &vDirPatches,
+                          ScaleSpaceCache *pScaleCache=0 );
 
 
 void createEdgeFeatures( /*const*/ PointVector &vPoints,
@@ -21,6 +21,8 @@ SOURCES += gauss.cc \
            polcoe.cc \
            edgesift.cc
 
+IMAGE_LIBS   = -lCanny2 -lGaussDeriv2 -limage2
+LIBS += -L$${CODE}/lib/i686 $${IMAGE_LIBS}
 
 # make install
 target.path = ~/code/lib/i686
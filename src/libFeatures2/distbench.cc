@@ -0,0 +1,157 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         distbench.cc                                         */
+/*                                                                   */
+/* CONTENT      Microbenchmark for the distance kernels. Compares    */
+/*              one query against a block of random descriptors      */
+/*              with every kernel level supported by the processor,  */
+/*              for 128-d (SIFT) and 625-d (25x25 patch) vectors,    */
+/*              and reports the time per comparison and the maximal  */
+/*              relative deviation from the scalar results.          */
+/*                                                                   */
+/*              Not part of the library; compile with                */
+/*                g++ -O3 -I. distbench.cc distkernels.cc \           */
+/*                    -o distbench                                   */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "distkernels.hh"
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const int NUM_VECTORS = 4096;
+const int NUM_QUERIES = 64;
+
+const int MEASURE_SSD   = 0;
+const int MEASURE_CORR  = 1;
+const int MEASURE_CHI2  = 2;
+const int MEASURE_BHATT = 3;
+const int MEASURE_SSD_BATCH  = 4;
+const int MEASURE_CORR_BATCH = 5;
+const int NUM_MEASURES  = 6;
+
+const char* MEASURE_NAMES[NUM_MEASURES] =
+  { "SSD", "Correlation", "Chi2", "Bhattacharyya",
+    "SSD (batch)", "Correlation (batch)" };
+
+
+double getTime()
+{
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+void runMeasure( int nMeasure, const vector<float> &vQueries,
+                 const vector<float> &vData, int nDims,
+                 vector<float> &vResults )
+  /* compare all queries against all data vectors */
+{
+  vResults.resize( NUM_QUERIES*NUM_VECTORS );
+  for( int q=0; q<NUM_QUERIES; q++ ) {
+    const float *pQuery = &vQueries[q*nDims];
+    float       *pRes   = &vResults[q*NUM_VECTORS];
+    switch( nMeasure ) {
+    case MEASURE_SSD_BATCH:
+      distSSDBatch( pQuery, &vData[0], NUM_VECTORS, nDims, nDims, pRes );
+      break;
+    case MEASURE_CORR_BATCH:
+      distCorrelationBatch( pQuery, &vData[0], NUM_VECTORS, nDims, nDims,
+                            pRes );
+      break;
+    default:
+      for( int v=0; v<NUM_VECTORS; v++ ) {
+        const float *pData = &vData[v*nDims];
+        switch( nMeasure ) {
+        case MEASURE_SSD:   pRes[v] = distSSD( pQuery, pData, nDims ); break;
+        case MEASURE_CORR:
+          pRes[v] = distCorrelation( pQuery, pData, nDims ); break;
+        case MEASURE_CHI2:  pRes[v] = distChi2( pQuery, pData, nDims ); break;
+        case MEASURE_BHATT:
+          pRes[v] = distBhattSum( pQuery, pData, nDims ); break;
+        }
+      }
+    }
+  }
+}
+
+
+void benchmark( int nDims )
+{
+  /* random non-negative descriptors, with some empty bins for chi2 */
+  vector<float> vData( NUM_VECTORS*nDims );
+  vector<float> vQueries( NUM_QUERIES*nDims );
+  for( unsigned i=0; i<vData.size(); i++ )
+    vData[i] = ( rand()%4==0 ? 0.0 : rand()/(float)RAND_MAX );
+  for( unsigned i=0; i<vQueries.size(); i++ )
+    vQueries[i] = ( rand()%4==0 ? 0.0 : rand()/(float)RAND_MAX );
+
+  cout << endl << "  " << nDims << "-d vectors (" << NUM_QUERIES << "x"
+       << NUM_VECTORS << " comparisons):" << endl;
+  cout << "    " << setw(22) << left << "measure" << right;
+  int nMaxLevel = getMaxDistKernelLevel();
+  for( int l=0; l<=nMaxLevel; l++ )
+    cout << setw(12) << getDistKernelName(l);
+  cout << "    speedup   max rel.err" << endl;
+
+  for( int m=0; m<NUM_MEASURES; m++ ) {
+    cout << "    " << setw(22) << left << MEASURE_NAMES[m] << right;
+    vector<float> vReference;
+    double dScalarTime = 0.0;
+    double dBestTime   = 0.0;
+    float  dMaxErr     = 0.0;
+    for( int l=0; l<=nMaxLevel; l++ ) {
+      setDistKernelLevel( l );
+      vector<float> vResults;
+      runMeasure( m, vQueries, vData, nDims, vResults ); // warm-up
+      double dStart = getTime();
+      runMeasure( m, vQueries, vData, nDims, vResults );
+      double dTime = ( getTime() - dStart )/(NUM_QUERIES*NUM_VECTORS);
+      cout << setw(9) << setprecision(1) << fixed << dTime*1e9 << " ns";
+
+      if( l==0 ) {
+        vReference  = vResults;
+        dScalarTime = dTime;
+      } else
+        for( unsigned i=0; i<vResults.size(); i++ ) {
+          float dErr = ( fabs(vResults[i] - vReference[i]) /
+                         max(fabs(vReference[i]), 1e-6f) );
+          dMaxErr = max( dMaxErr, dErr );
+        }
+      dBestTime = dTime;
+    }
+    cout << setw(10) << setprecision(2) << dScalarTime/dBestTime << "x"
+         << setw(14) << scientific << dMaxErr << endl;
+  }
+  setDistKernelLevel( -1 );
+}
+
+
+int main()
+{
+  cout << "Distance kernel benchmark (best level: "
+       << getDistKernelName( getMaxDistKernelLevel() ) << ")" << endl;
+
+  srand( 42 );
+  benchmark( 128 );
+  benchmark( 625 );
+
+  return 0;
+}
@@ -0,0 +1,896 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         distkernels.cc                                       */
+/*                                                                   */
+/* CONTENT      Low-level distance kernels on raw float arrays, used */
+/*              by the FeatureVector comparison measures and by the  */
+/*              codebook matching. Each kernel exists in a scalar,   */
+/*              an SSE, and an AVX2 version; the fastest version     */
+/*              supported by the processor is selected at runtime.   */
+/*                                                                   */
+/*              The SIMD versions are compiled with per-function     */
+/*              target attributes, so the library itself does not    */
+/*              need to be built with -msse2/-mavx2 and still runs   */
+/*              on older processors.                                 */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <math.h>
+
+#include "distkernels.hh"
+
+#if ( defined(__x86_64__) || defined(__i386__) ) &&  \
+    ( defined(__clang__) || ( defined(__GNUC__) && __GNUC__ >= 5 ) )
+#define DIST_USE_X86_SIMD
+#include <immintrin.h>
+#define DIST_TARGET_SSE   __attribute__((target("sse2")))
+#define DIST_TARGET_AVX2  __attribute__((target("avx2,fma")))
+#endif
+
+
+/*===================================================================*/
+/*                          Scalar Kernels                           */
+/*===================================================================*/
+
+static float ssdScalar( const float *pA, const float *pB, int nDims )
+{
+  float dSum = 0.0;
+  for( int i=0; i<nDims; i++ ) {
+    float diff = pA[i] - pB[i];
+    dSum      += diff*diff;
+  }
+  return dSum;
+}
+
+
+static float corrScalar( const float *pA, const float *pB, int nDims )
+{
+  float dSum = 0.0;
+  for( int i=0; i<nDims; i++ )
+    dSum += pA[i]*pB[i];
+  return dSum;
+}
+
+
+static float chi2Scalar( const float *pA, const float *pB, int nDims,
+                         float dCoeff1, float dCoeff2 )
+{
+  /* accumulate in double precision, as chstwo_measure() did */
+  double dSum = 0.0;
+  for( int i=0; i<nDims; i++ )
+    if( pA[i] != 0.0 || pB[i] != 0.0 ) {
+      double temp = dCoeff1*pA[i] - dCoeff2*pB[i];
+      dSum += temp*temp / (pA[i] + pB[i]);
+    }
+  return (float)dSum;
+}
+
+
+static float bhattScalar( const float *pA, const float *pB, int nDims )
+{
+  float dSum = 0.0;
+  for( int i=0; i<nDims; i++ )
+    dSum += sqrt( pA[i]*pB[i] );
+  return dSum;
+}
+
+
+static void ssdBatchScalar( const float *pQuery, const float *pData,
+                            int nVectors, int nDims, int nStride,
+                            float *pResults )
+{
+  for( int v=0; v<nVectors; v++ )
+    pResults[v] = ssdScalar( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static void corrBatchScalar( const float *pQuery, const float *pData,
+                             int nVectors, int nDims, int nStride,
+                             float *pResults )
+{
+  for( int v=0; v<nVectors; v++ )
+    pResults[v] = corrScalar( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static void corrBlockScalar( const float *pQueries, int nQueries,
+                             int nQueryStride, const float *pData,
+                             int nVectors, int nStride, int nDims,
+                             float *pResults, int nResultStride )
+{
+  for( int q=0; q<nQueries; q++ )
+    corrBatchScalar( pQueries + (long)q*nQueryStride, pData, nVectors,
+                     nDims, nStride, pResults + (long)q*nResultStride );
+}
+
+
+#ifdef DIST_USE_X86_SIMD
+/*===================================================================*/
+/*                            SSE Kernels                            */
+/*===================================================================*/
+/* All kernels process 8 entries per iteration in two accumulators,  */
+/* followed by one 4-entry step and a scalar tail. The batched ver-  */
+/* sions use exactly the same summation order per vector, so they    */
+/* return bitwise the same values as the single comparisons.         */
+
+static inline DIST_TARGET_SSE float hsumSSE( __m128 v )
+{
+  __m128 vShuf = _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,3,0,1) );
+  __m128 vSums = _mm_add_ps( v, vShuf );
+  vShuf = _mm_movehl_ps( vShuf, vSums );
+  vSums = _mm_add_ss( vSums, vShuf );
+  return _mm_cvtss_f32( vSums );
+}
+
+
+static DIST_TARGET_SSE float ssdSSE( const float *pA, const float *pB,
+                                     int nDims )
+{
+  __m128 vSum0 = _mm_setzero_ps();
+  __m128 vSum1 = _mm_setzero_ps();
+  int i=0;
+  for( ; i+8<=nDims; i+=8 ) {
+    __m128 vD0 = _mm_sub_ps( _mm_loadu_ps(pA+i),   _mm_loadu_ps(pB+i) );
+    __m128 vD1 = _mm_sub_ps( _mm_loadu_ps(pA+i+4), _mm_loadu_ps(pB+i+4) );
+    vSum0 = _mm_add_ps( vSum0, _mm_mul_ps(vD0,vD0) );
+    vSum1 = _mm_add_ps( vSum1, _mm_mul_ps(vD1,vD1) );
+  }
+  if( i+4<=nDims ) {
+    __m128 vD0 = _mm_sub_ps( _mm_loadu_ps(pA+i), _mm_loadu_ps(pB+i) );
+    vSum0 = _mm_add_ps( vSum0, _mm_mul_ps(vD0,vD0) );
+    i += 4;
+  }
+  float dSum = hsumSSE( _mm_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ ) {
+    float diff = pA[i] - pB[i];
+    dSum      += diff*diff;
+  }
+  return dSum;
+}
+
+
+static DIST_TARGET_SSE float corrSSE( const float *pA, const float *pB,
+                                      int nDims )
+{
+  __m128 vSum0 = _mm_setzero_ps();
+  __m128 vSum1 = _mm_setzero_ps();
+  int i=0;
+  for( ; i+8<=nDims; i+=8 ) {
+    vSum0 = _mm_add_ps( vSum0, _mm_mul_ps( _mm_loadu_ps(pA+i),
+                                           _mm_loadu_ps(pB+i) ) );
+    vSum1 = _mm_add_ps( vSum1, _mm_mul_ps( _mm_loadu_ps(pA+i+4),
+                                           _mm_loadu_ps(pB+i+4) ) );
+  }
+  if( i+4<=nDims ) {
+    vSum0 = _mm_add_ps( vSum0, _mm_mul_ps( _mm_loadu_ps(pA+i),
+                                           _mm_loadu_ps(pB+i) ) );
+    i += 4;
+  }
+  float dSum = hsumSSE( _mm_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    dSum += pA[i]*pB[i];
+  return dSum;
+}
+
+
+static inline DIST_TARGET_SSE __m128 chi2StepSSE( __m128 vA, __m128 vB,
+                                                  __m128 vC1, __m128 vC2 )
+  /* chi2 terms of 4 bins; bins with a=b=0 are masked out. */
+{
+  __m128 vZero = _mm_setzero_ps();
+  __m128 vMask = _mm_or_ps( _mm_cmpneq_ps(vA, vZero),
+                            _mm_cmpneq_ps(vB, vZero) );
+  __m128 vNum  = _mm_sub_ps( _mm_mul_ps(vC1, vA), _mm_mul_ps(vC2, vB) );
+  __m128 vTerm = _mm_div_ps( _mm_mul_ps(vNum, vNum), _mm_add_ps(vA, vB) );
+  return _mm_and_ps( vMask, vTerm );
+}
+
+
+static DIST_TARGET_SSE float chi2SSE( const float *pA, const float *pB,
+                                      int nDims,
+                                      float dCoeff1, float dCoeff2 )
+{
+  __m128 vC1   = _mm_set1_ps( dCoeff1 );
+  __m128 vC2   = _mm_set1_ps( dCoeff2 );
+  __m128 vSum0 = _mm_setzero_ps();
+  __m128 vSum1 = _mm_setzero_ps();
+  int i=0;
+  for( ; i+8<=nDims; i+=8 ) {
+    vSum0 = _mm_add_ps( vSum0, chi2StepSSE( _mm_loadu_ps(pA+i),
+                                            _mm_loadu_ps(pB+i),
+                                            vC1, vC2 ) );
+    vSum1 = _mm_add_ps( vSum1, chi2StepSSE( _mm_loadu_ps(pA+i+4),
+                                            _mm_loadu_ps(pB+i+4),
+                                            vC1, vC2 ) );
+  }
+  if( i+4<=nDims ) {
+    vSum0 = _mm_add_ps( vSum0, chi2StepSSE( _mm_loadu_ps(pA+i),
+                                            _mm_loadu_ps(pB+i),
+                                            vC1, vC2 ) );
+    i += 4;
+  }
+  float dSum = hsumSSE( _mm_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    if( pA[i] != 0.0 || pB[i] != 0.0 ) {
+      float temp = dCoeff1*pA[i] - dCoeff2*pB[i];
+      dSum += temp*temp / (pA[i] + pB[i]);
+    }
+  return dSum;
+}
+
+
+static DIST_TARGET_SSE float bhattSSE( const float *pA, const float *pB,
+                                       int nDims )
+{
+  __m128 vSum0 = _mm_setzero_ps();
+  __m128 vSum1 = _mm_setzero_ps();
+  int i=0;
+  for( ; i+8<=nDims; i+=8 ) {
+    vSum0 = _mm_add_ps( vSum0, _mm_sqrt_ps( _mm_mul_ps(_mm_loadu_ps(pA+i),
+                                                       _mm_loadu_ps(pB+i))));
+    vSum1 = _mm_add_ps( vSum1, _mm_sqrt_ps(_mm_mul_ps(_mm_loadu_ps(pA+i+4),
+                                                      _mm_loadu_ps(pB+i+4))));
+  }
+  if( i+4<=nDims ) {
+    vSum0 = _mm_add_ps( vSum0, _mm_sqrt_ps( _mm_mul_ps(_mm_loadu_ps(pA+i),
+                                                       _mm_loadu_ps(pB+i))));
+    i += 4;
+  }
+  float dSum = hsumSSE( _mm_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    dSum += sqrt( pA[i]*pB[i] );
+  return dSum;
+}
+
+
+static DIST_TARGET_SSE void ssdBatchSSE( const float *pQuery,
+                                         const float *pData,
+                                         int nVectors, int nDims,
+                                         int nStride, float *pResults )
+  /* two vectors at a time, so that each query load is used twice */
+{
+  int v=0;
+  for( ; v+2<=nVectors; v+=2 ) {
+    const float *pB0 = pData + (long)v*nStride;
+    const float *pB1 = pB0 + nStride;
+    __m128 vSum00 = _mm_setzero_ps(), vSum01 = _mm_setzero_ps();
+    __m128 vSum10 = _mm_setzero_ps(), vSum11 = _mm_setzero_ps();
+    int i=0;
+    for( ; i+8<=nDims; i+=8 ) {
+      __m128 vQ0 = _mm_loadu_ps( pQuery+i );
+      __m128 vQ1 = _mm_loadu_ps( pQuery+i+4 );
+      __m128 vD00 = _mm_sub_ps( vQ0, _mm_loadu_ps(pB0+i) );
+      __m128 vD01 = _mm_sub_ps( vQ1, _mm_loadu_ps(pB0+i+4) );
+      __m128 vD10 = _mm_sub_ps( vQ0, _mm_loadu_ps(pB1+i) );
+      __m128 vD11 = _mm_sub_ps( vQ1, _mm_loadu_ps(pB1+i+4) );
+      vSum00 = _mm_add_ps( vSum00, _mm_mul_ps(vD00,vD00) );
+      vSum01 = _mm_add_ps( vSum01, _mm_mul_ps(vD01,vD01) );
+      vSum10 = _mm_add_ps( vSum10, _mm_mul_ps(vD10,vD10) );
+      vSum11 = _mm_add_ps( vSum11, _mm_mul_ps(vD11,vD11) );
+    }
+    if( i+4<=nDims ) {
+      __m128 vQ0 = _mm_loadu_ps( pQuery+i );
+      __m128 vD00 = _mm_sub_ps( vQ0, _mm_loadu_ps(pB0+i) );
+      __m128 vD10 = _mm_sub_ps( vQ0, _mm_loadu_ps(pB1+i) );
+      vSum00 = _mm_add_ps( vSum00, _mm_mul_ps(vD00,vD00) );
+      vSum10 = _mm_add_ps( vSum10, _mm_mul_ps(vD10,vD10) );
+      i += 4;
+    }
+    float dSum0 = hsumSSE( _mm_add_ps(vSum00, vSum01) );
+    float dSum1 = hsumSSE( _mm_add_ps(vSum10, vSum11) );
+    for( ; i<nDims; i++ ) {
+      float diff0 = pQuery[i] - pB0[i];
+      float diff1 = pQuery[i] - pB1[i];
+      dSum0 += diff0*diff0;
+      dSum1 += diff1*diff1;
+    }
+    pResults[v]   = dSum0;
+    pResults[v+1] = dSum1;
+  }
+  if( v<nVectors )
+    pResults[v] = ssdSSE( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static DIST_TARGET_SSE void corrBatchSSE( const float *pQuery,
+                                          const float *pData,
+                                          int nVectors, int nDims,
+                                          int nStride, float *pResults )
+  /* two vectors at a time, so that each query load is used twice */
+{
+  int v=0;
+  for( ; v+2<=nVectors; v+=2 ) {
+    const float *pB0 = pData + (long)v*nStride;
+    const float *pB1 = pB0 + nStride;
+    __m128 vSum00 = _mm_setzero_ps(), vSum01 = _mm_setzero_ps();
+    __m128 vSum10 = _mm_setzero_ps(), vSum11 = _mm_setzero_ps();
+    int i=0;
+    for( ; i+8<=nDims; i+=8 ) {
+      __m128 vQ0 = _mm_loadu_ps( pQuery+i );
+      __m128 vQ1 = _mm_loadu_ps( pQuery+i+4 );
+      vSum00 = _mm_add_ps( vSum00, _mm_mul_ps(vQ0, _mm_loadu_ps(pB0+i)) );
+      vSum01 = _mm_add_ps( vSum01, _mm_mul_ps(vQ1, _mm_loadu_ps(pB0+i+4)) );
+      vSum10 = _mm_add_ps( vSum10, _mm_mul_ps(vQ0, _mm_loadu_ps(pB1+i)) );
+      vSum11 = _mm_add_ps( vSum11, _mm_mul_ps(vQ1, _mm_loadu_ps(pB1+i+4)) );
+    }
+    if( i+4<=nDims ) {
+      __m128 vQ0 = _mm_loadu_ps( pQuery+i );
+      vSum00 = _mm_add_ps( vSum00, _mm_mul_ps(vQ0, _mm_loadu_ps(pB0+i)) );
+      vSum10 = _mm_add_ps( vSum10, _mm_mul_ps(vQ0, _mm_loadu_ps(pB1+i)) );
+      i += 4;
+    }
+    float dSum0 = hsumSSE( _mm_add_ps(vSum00, vSum01) );
+    float dSum1 = hsumSSE( _mm_add_ps(vSum10, vSum11) );
+    for( ; i<nDims; i++ ) {
+      dSum0 += pQuery[i]*pB0[i];
+      dSum1 += pQuery[i]*pB1[i];
+    }
+    pResults[v]   = dSum0;
+    pResults[v+1] = dSum1;
+  }
+  if( v<nVectors )
+    pResults[v] = corrSSE( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static DIST_TARGET_SSE void corrBlockSSE( const float *pQueries,
+                                          int nQueries, int nQueryStride,
+                                          const float *pData, int nVectors,
+                                          int nStride, int nDims,
+                                          float *pResults, int nResultStride )
+  /*******************************************************************/
+  /* Dot products of a block of queries with a block of vectors,     */
+  /* computed in tiles of 2 queries x 4 vectors, so that each loaded */
+  /* entry is used 2 or 4 times.                                     */
+  /*******************************************************************/
+{
+  int q=0;
+  for( ; q+2<=nQueries; q+=2 ) {
+    const float *pQ0 = pQueries + (long)q*nQueryStride;
+    const float *pQ1 = pQ0 + nQueryStride;
+    float       *pR0 = pResults + (long)q*nResultStride;
+    float       *pR1 = pR0 + nResultStride;
+    int v=0;
+    for( ; v+4<=nVectors; v+=4 ) {
+      const float *pB0 = pData + (long)v*nStride;
+      const float *pB1 = pB0 + nStride;
+      const float *pB2 = pB1 + nStride;
+      const float *pB3 = pB2 + nStride;
+      __m128 vSum00 = _mm_setzero_ps(), vSum01 = _mm_setzero_ps();
+      __m128 vSum02 = _mm_setzero_ps(), vSum03 = _mm_setzero_ps();
+      __m128 vSum10 = _mm_setzero_ps(), vSum11 = _mm_setzero_ps();
+      __m128 vSum12 = _mm_setzero_ps(), vSum13 = _mm_setzero_ps();
+      int i=0;
+      for( ; i+4<=nDims; i+=4 ) {
+        __m128 vQ0 = _mm_loadu_ps( pQ0+i );
+        __m128 vQ1 = _mm_loadu_ps( pQ1+i );
+        __m128 vB  = _mm_loadu_ps( pB0+i );
+        vSum00 = _mm_add_ps( vSum00, _mm_mul_ps(vQ0, vB) );
+        vSum10 = _mm_add_ps( vSum10, _mm_mul_ps(vQ1, vB) );
+        vB     = _mm_loadu_ps( pB1+i );
+        vSum01 = _mm_add_ps( vSum01, _mm_mul_ps(vQ0, vB) );
+        vSum11 = _mm_add_ps( vSum11, _mm_mul_ps(vQ1, vB) );
+        vB     = _mm_loadu_ps( pB2+i );
+        vSum02 = _mm_add_ps( vSum02, _mm_mul_ps(vQ0, vB) );
+        vSum12 = _mm_add_ps( vSum12, _mm_mul_ps(vQ1, vB) );
+        vB     = _mm_loadu_ps( pB3+i );
+        vSum03 = _mm_add_ps( vSum03, _mm_mul_ps(vQ0, vB) );
+        vSum13 = _mm_add_ps( vSum13, _mm_mul_ps(vQ1, vB) );
+      }
+      float dSum0[4] = { hsumSSE(vSum00), hsumSSE(vSum01),
+                         hsumSSE(vSum02), hsumSSE(vSum03) };
+      float dSum1[4] = { hsumSSE(vSum10), hsumSSE(vSum11),
+                         hsumSSE(vSum12), hsumSSE(vSum13) };
+      for( ; i<nDims; i++ ) {
+        dSum0[0] += pQ0[i]*pB0[i];  dSum1[0] += pQ1[i]*pB0[i];
+        dSum0[1] += pQ0[i]*pB1[i];  dSum1[1] += pQ1[i]*pB1[i];
+        dSum0[2] += pQ0[i]*pB2[i];  dSum1[2] += pQ1[i]*pB2[i];
+        dSum0[3] += pQ0[i]*pB3[i];  dSum1[3] += pQ1[i]*pB3[i];
+      }
+      for( int k=0; k<4; k++ ) {
+        pR0[v+k] = dSum0[k];
+        pR1[v+k] = dSum1[k];
+      }
+    }
+    for( ; v<nVectors; v++ ) {
+      pR0[v] = corrSSE( pQ0, pData + (long)v*nStride, nDims );
+      pR1[v] = corrSSE( pQ1, pData + (long)v*nStride, nDims );
+    }
+  }
+  if( q<nQueries )
+    corrBatchSSE( pQueries + (long)q*nQueryStride, pData, nVectors, nDims,
+                  nStride, pResults + (long)q*nResultStride );
+}
+
+
+/*===================================================================*/
+/*                           AVX2 Kernels                            */
+/*===================================================================*/
+/* Same structure as the SSE kernels, with 8-wide registers: 16 en-  */
+/* tries per iteration, one 8-entry step, and a scalar tail.         */
+
+static inline DIST_TARGET_AVX2 float hsumAVX( __m256 v )
+{
+  __m128 vLo   = _mm_add_ps( _mm256_castps256_ps128(v),
+                             _mm256_extractf128_ps(v, 1) );
+  __m128 vShuf = _mm_shuffle_ps( vLo, vLo, _MM_SHUFFLE(2,3,0,1) );
+  __m128 vSums = _mm_add_ps( vLo, vShuf );
+  vShuf = _mm_movehl_ps( vShuf, vSums );
+  vSums = _mm_add_ss( vSums, vShuf );
+  return _mm_cvtss_f32( vSums );
+}
+
+
+static DIST_TARGET_AVX2 float ssdAVX2( const float *pA, const float *pB,
+                                       int nDims )
+{
+  __m256 vSum0 = _mm256_setzero_ps();
+  __m256 vSum1 = _mm256_setzero_ps();
+  int i=0;
+  for( ; i+16<=nDims; i+=16 ) {
+    __m256 vD0 = _mm256_sub_ps( _mm256_loadu_ps(pA+i),
+                                _mm256_loadu_ps(pB+i) );
+    __m256 vD1 = _mm256_sub_ps( _mm256_loadu_ps(pA+i+8),
+                                _mm256_loadu_ps(pB+i+8) );
+    vSum0 = _mm256_fmadd_ps( vD0, vD0, vSum0 );
+    vSum1 = _mm256_fmadd_ps( vD1, vD1, vSum1 );
+  }
+  if( i+8<=nDims ) {
+    __m256 vD0 = _mm256_sub_ps( _mm256_loadu_ps(pA+i),
+                                _mm256_loadu_ps(pB+i) );
+    vSum0 = _mm256_fmadd_ps( vD0, vD0, vSum0 );
+    i += 8;
+  }
+  float dSum = hsumAVX( _mm256_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ ) {
+    float diff = pA[i] - pB[i];
+    dSum      += diff*diff;
+  }
+  return dSum;
+}
+
+
+static DIST_TARGET_AVX2 float corrAVX2( const float *pA, const float *pB,
+                                        int nDims )
+{
+  __m256 vSum0 = _mm256_setzero_ps();
+  __m256 vSum1 = _mm256_setzero_ps();
+  int i=0;
+  for( ; i+16<=nDims; i+=16 ) {
+    vSum0 = _mm256_fmadd_ps( _mm256_loadu_ps(pA+i),
+                             _mm256_loadu_ps(pB+i), vSum0 );
+    vSum1 = _mm256_fmadd_ps( _mm256_loadu_ps(pA+i+8),
+                             _mm256_loadu_ps(pB+i+8), vSum1 );
+  }
+  if( i+8<=nDims ) {
+    vSum0 = _mm256_fmadd_ps( _mm256_loadu_ps(pA+i),
+                             _mm256_loadu_ps(pB+i), vSum0 );
+    i += 8;
+  }
+  float dSum = hsumAVX( _mm256_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    dSum += pA[i]*pB[i];
+  return dSum;
+}
+
+
+static inline DIST_TARGET_AVX2 __m256 chi2StepAVX2( __m256 vA, __m256 vB,
+                                                    __m256 vC1, __m256 vC2 )
+  /* chi2 terms of 8 bins; bins with a=b=0 are masked out. */
+{
+  __m256 vZero = _mm256_setzero_ps();
+  __m256 vMask = _mm256_or_ps( _mm256_cmp_ps(vA, vZero, _CMP_NEQ_UQ),
+                               _mm256_cmp_ps(vB, vZero, _CMP_NEQ_UQ) );
+  __m256 vNum  = _mm256_sub_ps( _mm256_mul_ps(vC1, vA),
+                                _mm256_mul_ps(vC2, vB) );
+  __m256 vTerm = _mm256_div_ps( _mm256_mul_ps(vNum, vNum),
+                                _mm256_add_ps(vA, vB) );
+  return _mm256_and_ps( vMask, vTerm );
+}
+
+
+static DIST_TARGET_AVX2 float chi2AVX2( const float *pA, const float *pB,
+                                        int nDims,
+                                        float dCoeff1, float dCoeff2 )
+{
+  __m256 vC1   = _mm256_set1_ps( dCoeff1 );
+  __m256 vC2   = _mm256_set1_ps( dCoeff2 );
+  __m256 vSum0 = _mm256_setzero_ps();
+  __m256 vSum1 = _mm256_setzero_ps();
+  int i=0;
+  for( ; i+16<=nDims; i+=16 ) {
+    vSum0 = _mm256_add_ps( vSum0, chi2StepAVX2( _mm256_loadu_ps(pA+i),
+                                                _mm256_loadu_ps(pB+i),
+                                                vC1, vC2 ) );
+    vSum1 = _mm256_add_ps( vSum1, chi2StepAVX2( _mm256_loadu_ps(pA+i+8),
+                                                _mm256_loadu_ps(pB+i+8),
+                                                vC1, vC2 ) );
+  }
+  if( i+8<=nDims ) {
+    vSum0 = _mm256_add_ps( vSum0, chi2StepAVX2( _mm256_loadu_ps(pA+i),
+                                                _mm256_loadu_ps(pB+i),
+                                                vC1, vC2 ) );
+    i += 8;
+  }
+  float dSum = hsumAVX( _mm256_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    if( pA[i] != 0.0 || pB[i] != 0.0 ) {
+      float temp = dCoeff1*pA[i] - dCoeff2*pB[i];
+      dSum += temp*temp / (pA[i] + pB[i]);
+    }
+  return dSum;
+}
+
+
+static DIST_TARGET_AVX2 float bhattAVX2( const float *pA, const float *pB,
+                                         int nDims )
+{
+  __m256 vSum0 = _mm256_setzero_ps();
+  __m256 vSum1 = _mm256_setzero_ps();
+  int i=0;
+  for( ; i+16<=nDims; i+=16 ) {
+    vSum0 = _mm256_add_ps( vSum0,
+                           _mm256_sqrt_ps( _mm256_mul_ps(
+                                             _mm256_loadu_ps(pA+i),
+                                             _mm256_loadu_ps(pB+i) ) ) );
+    vSum1 = _mm256_add_ps( vSum1,
+                           _mm256_sqrt_ps( _mm256_mul_ps(
+                                             _mm256_loadu_ps(pA+i+8),
+                                             _mm256_loadu_ps(pB+i+8) ) ) );
+  }
+  if( i+8<=nDims ) {
+    vSum0 = _mm256_add_ps( vSum0,
+                           _mm256_sqrt_ps( _mm256_mul_ps(
+                                             _mm256_loadu_ps(pA+i),
+                                             _mm256_loadu_ps(pB+i) ) ) );
+    i += 8;
+  }
+  float dSum = hsumAVX( _mm256_add_ps(vSum0, vSum1) );
+  for( ; i<nDims; i++ )
+    dSum += sqrt( pA[i]*pB[i] );
+  return dSum;
+}
+
+
+static DIST_TARGET_AVX2 void ssdBatchAVX2( const float *pQuery,
+                                           const float *pData,
+                                           int nVectors, int nDims,
+                                           int nStride, float *pResults )
+  /* two vectors at a time, so that each query load is used twice */
+{
+  int v=0;
+  for( ; v+2<=nVectors; v+=2 ) {
+    const float *pB0 = pData + (long)v*nStride;
+    const float *pB1 = pB0 + nStride;
+    __m256 vSum00 = _mm256_setzero_ps(), vSum01 = _mm256_setzero_ps();
+    __m256 vSum10 = _mm256_setzero_ps(), vSum11 = _mm256_setzero_ps();
+    int i=0;
+    for( ; i+16<=nDims; i+=16 ) {
+      __m256 vQ0  = _mm256_loadu_ps( pQuery+i );
+      __m256 vQ1  = _mm256_loadu_ps( pQuery+i+8 );
+      __m256 vD00 = _mm256_sub_ps( vQ0, _mm256_loadu_ps(pB0+i) );
+      __m256 vD01 = _mm256_sub_ps( vQ1, _mm256_loadu_ps(pB0+i+8) );
+      __m256 vD10 = _mm256_sub_ps( vQ0, _mm256_loadu_ps(pB1+i) );
+      __m256 vD11 = _mm256_sub_ps( vQ1, _mm256_loadu_ps(pB1+i+8) );
+      vSum00 = _mm256_fmadd_ps( vD00, vD00, vSum00 );
+      vSum01 = _mm256_fmadd_ps( vD01, vD01, vSum01 );
+      vSum10 = _mm256_fmadd_ps( vD10, vD10, vSum10 );
+      vSum11 = _mm256_fmadd_ps( vD11, vD11, vSum11 );
+    }
+    if( i+8<=nDims ) {
+      __m256 vQ0  = _mm256_loadu_ps( pQuery+i );
+      __m256 vD00 = _mm256_sub_ps( vQ0, _mm256_loadu_ps(pB0+i) );
+      __m256 vD10 = _mm256_sub_ps( vQ0, _mm256_loadu_ps(pB1+i) );
+      vSum00 = _mm256_fmadd_ps( vD00, vD00, vSum00 );
+      vSum10 = _mm256_fmadd_ps( vD10, vD10, vSum10 );
+      i += 8;
+    }
+    float dSum0 = hsumAVX( _mm256_add_ps(vSum00, vSum01) );
+    float dSum1 = hsumAVX( _mm256_add_ps(vSum10, vSum11) );
+    for( ; i<nDims; i++ ) {
+      float diff0 = pQuery[i] - pB0[i];
+      float diff1 = pQuery[i] - pB1[i];
+      dSum0 += diff0*diff0;
+      dSum1 += diff1*diff1;
+    }
+    pResults[v]   = dSum0;
+    pResults[v+1] = dSum1;
+  }
+  if( v<nVectors )
+    pResults[v] = ssdAVX2( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static DIST_TARGET_AVX2 void corrBatchAVX2( const float *pQuery,
+                                            const float *pData,
+                                            int nVectors, int nDims,
+                                            int nStride, float *pResults )
+  /* two vectors at a time, so that each query load is used twice */
+{
+  int v=0;
+  for( ; v+2<=nVectors; v+=2 ) {
+    const float *pB0 = pData + (long)v*nStride;
+    const float *pB1 = pB0 + nStride;
+    __m256 vSum00 = _mm256_setzero_ps(), vSum01 = _mm256_setzero_ps();
+    __m256 vSum10 = _mm256_setzero_ps(), vSum11 = _mm256_setzero_ps();
+    int i=0;
+    for( ; i+16<=nDims; i+=16 ) {
+      __m256 vQ0 = _mm256_loadu_ps( pQuery+i );
+      __m256 vQ1 = _mm256_loadu_ps( pQuery+i+8 );
+      vSum00 = _mm256_fmadd_ps( vQ0, _mm256_loadu_ps(pB0+i),   vSum00 );
+      vSum01 = _mm256_fmadd_ps( vQ1, _mm256_loadu_ps(pB0+i+8), vSum01 );
+      vSum10 = _mm256_fmadd_ps( vQ0, _mm256_loadu_ps(pB1+i),   vSum10 );
+      vSum11 = _mm256_fmadd_ps( vQ1, _mm256_loadu_ps(pB1+i+8), vSum11 );
+    }
+    if( i+8<=nDims ) {
+      __m256 vQ0 = _mm256_loadu_ps( pQuery+i );
+      vSum00 = _mm256_fmadd_ps( vQ0, _mm256_loadu_ps(pB0+i), vSum00 );
+      vSum10 = _mm256_fmadd_ps( vQ0, _mm256_loadu_ps(pB1+i), vSum10 );
+      i += 8;
+    }
+    float dSum0 = hsumAVX( _mm256_add_ps(vSum00, vSum01) );
+    float dSum1 = hsumAVX( _mm256_add_ps(vSum10, vSum11) );
+    for( ; i<nDims; i++ ) {
+      dSum0 += pQuery[i]*pB0[i];
+      dSum1 += pQuery[i]*pB1[i];
+    }
+    pResults[v]   = dSum0;
+    pResults[v+1] = dSum1;
+  }
+  if( v<nVectors )
+    pResults[v] = corrAVX2( pQuery, pData + (long)v*nStride, nDims );
+}
+
+
+static DIST_TARGET_AVX2 void corrBlockAVX2( const float *pQueries,
+                                            int nQueries, int nQueryStride,
+                                            const float *pData, int nVectors,
+                                            int nStride, int nDims,
+                                            float *pResults, int nResultStride )
+  /*******************************************************************/
+  /* Dot products of a block of queries with a block of vectors,     */
+  /* computed in tiles of 2 queries x 4 vectors, so that each loaded */
+  /* entry is used 2 or 4 times.                                     */
+  /*******************************************************************/
+{
+  int q=0;
+  for( ; q+2<=nQueries; q+=2 ) {
+    const float *pQ0 = pQueries + (long)q*nQueryStride;
+    const float *pQ1 = pQ0 + nQueryStride;
+    float       *pR0 = pResults + (long)q*nResultStride;
+    float       *pR1 = pR0 + nResultStride;
+    int v=0;
+    for( ; v+4<=nVectors; v+=4 ) {
+      const float *pB0 = pData + (long)v*nStride;
+      const float *pB1 = pB0 + nStride;
+      const float *pB2 = pB1 + nStride;
+      const float *pB3 = pB2 + nStride;
+      __m256 vSum00 = _mm256_setzero_ps(), vSum01 = _mm256_setzero_ps();
+      __m256 vSum02 = _mm256_setzero_ps(), vSum03 = _mm256_setzero_ps();
+      __m256 vSum10 = _mm256_setzero_ps(), vSum11 = _mm256_setzero_ps();
+      __m256 vSum12 = _mm256_setzero_ps(), vSum13 = _mm256_setzero_ps();
+      int i=0;
+      for( ; i+8<=nDims; i+=8 ) {
+        __m256 vQ0 = _mm256_loadu_ps( pQ0+i );
+        __m256 vQ1 = _mm256_loadu_ps( pQ1+i );
+        __m256 vB  = _mm256_loadu_ps( pB0+i );
+        vSum00 = _mm256_fmadd_ps( vQ0, vB, vSum00 );
+        vSum10 = _mm256_fmadd_ps( vQ1, vB, vSum10 );
+        vB     = _mm256_loadu_ps( pB1+i );
+        vSum01 = _mm256_fmadd_ps( vQ0, vB, vSum01 );
+        vSum11 = _mm256_fmadd_ps( vQ1, vB, vSum11 );
+        vB     = _mm256_loadu_ps( pB2+i );
+        vSum02 = _mm256_fmadd_ps( vQ0, vB, vSum02 );
+        vSum12 = _mm256_fmadd_ps( vQ1, vB, vSum12 );
+        vB     = _mm256_loadu_ps( pB3+i );
+        vSum03 = _mm256_fmadd_ps( vQ0, vB, vSum03 );
+        vSum13 = _mm256_fmadd_ps( vQ1, vB, vSum13 );
+      }
+      float dSum0[4] = { hsumAVX(vSum00), hsumAVX(vSum01),
+                         hsumAVX(vSum02), hsumAVX(vSum03) };
+      float dSum1[4] = { hsumAVX(vSum10), hsumAVX(vSum11),
+                         hsumAVX(vSum12), hsumAVX(vSum13) };
+      for( ; i<nDims; i++ ) {
+        dSum0[0] += pQ0[i]*pB0[i];  dSum1[0] += pQ1[i]*pB0[i];
+        dSum0[1] += pQ0[i]*pB1[i];  dSum1[1] += pQ1[i]*pB1[i];
+        dSum0[2] += pQ0[i]*pB2[i];  dSum1[2] += pQ1[i]*pB2[i];
+        dSum0[3] += pQ0[i]*pB3[i];  dSum1[3] += pQ1[i]*pB3[i];
+      }
+      for( int k=0; k<4; k++ ) {
+        pR0[v+k] = dSum0[k];
+        pR1[v+k] = dSum1[k];
+      }
+    }
+    for( ; v<nVectors; v++ ) {
+      pR0[v] = corrAVX2( pQ0, pData + (long)v*nStride, nDims );
+      pR1[v] = corrAVX2( pQ1, pData + (long)v*nStride, nDims );
+    }
+  }
+  if( q<nQueries )
+    corrBatchAVX2( pQueries + (long)q*nQueryStride, pData, nVectors, nDims,
+                   nStride, pResults + (long)q*nResultStride );
+}
+#endif // DIST_USE_X86_SIMD
+
+
+/*===================================================================*/
+/*                         Kernel Selection                          */
+/*===================================================================*/
+
+struct DistKernelTable
+{
+  float (*pfSSD)      ( const float*, const float*, int );
+  float (*pfCorr)     ( const float*, const float*, int );
+  float (*pfChi2)     ( const float*, const float*, int, float, float );
+  float (*pfBhatt)    ( const float*, const float*, int );
+  void  (*pfSSDBatch) ( const float*, const float*, int, int, int, float* );
+  void  (*pfCorrBatch)( const float*, const float*, int, int, int, float* );
+  void  (*pfCorrBlock)( const float*, int, int, const float*, int, int, int,
+                        float*, int );
+};
+
+/* constant-initialized, so usable during static initialization */
+static const DistKernelTable s_vKernelTables[] = {
+  { ssdScalar, corrScalar, chi2Scalar, bhattScalar,
+    ssdBatchScalar, corrBatchScalar, corrBlockScalar }
+#ifdef DIST_USE_X86_SIMD
+  ,{ ssdSSE, corrSSE, chi2SSE, bhattSSE,
+     ssdBatchSSE, corrBatchSSE, corrBlockSSE }
+  ,{ ssdAVX2, corrAVX2, chi2AVX2, bhattAVX2,
+     ssdBatchAVX2, corrBatchAVX2, corrBlockAVX2 }
+#endif
+};
+
+static const DistKernelTable *s_pKernels = &s_vKernelTables[0];
+static int                    s_nLevel   = DIST_KERNEL_SCALAR;
+
+
+int getMaxDistKernelLevel()
+  /* the best kernel level supported by this processor */
+{
+#ifdef DIST_USE_X86_SIMD
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") )
+    return DIST_KERNEL_AVX2;
+  if( __builtin_cpu_supports("sse2") )
+    return DIST_KERNEL_SSE;
+#endif
+  return DIST_KERNEL_SCALAR;
+}
+
+
+int setDistKernelLevel( int nLevel )
+  /*******************************************************************/
+  /* Select the kernel level (clipped to the supported range) and    */
+  /* return the level actually used. Negative values select the best */
+  /* supported level. Not thread-safe; only meant to be called at    */
+  /* program start, e.g. for benchmarking.                           */
+  /*******************************************************************/
+{
+  int nMaxLevel = getMaxDistKernelLevel();
+  if( nLevel < 0 || nLevel > nMaxLevel )
+    nLevel = nMaxLevel;
+
+  s_nLevel   = nLevel;
+  s_pKernels = &s_vKernelTables[nLevel];
+  return nLevel;
+}
+
+
+int getDistKernelLevel()
+{
+  return s_nLevel;
+}
+
+
+const char* getDistKernelName( int nLevel )
+{
+  switch( nLevel ) {
+  case DIST_KERNEL_SCALAR: return "scalar";
+  case DIST_KERNEL_SSE:    return "SSE";
+  case DIST_KERNEL_AVX2:   return "AVX2";
+  default:                 return "unknown";
+  }
+}
+
+
+/* select the best kernels when the library is loaded */
+static int s_nInitLevel = setDistKernelLevel( -1 );
+
+
+/*===================================================================*/
+/*                        Exported Functions                         */
+/*===================================================================*/
+
+float distSSD( const float *pA, const float *pB, int nDims )
+{
+  return s_pKernels->pfSSD( pA, pB, nDims );
+}
+
+
+float distCorrelation( const float *pA, const float *pB, int nDims )
+{
+  return s_pKernels->pfCorr( pA, pB, nDims );
+}
+
+
+float distChi2( const float *pA, const float *pB, int nDims,
+                float dCoeff1, float dCoeff2 )
+{
+  return s_pKernels->pfChi2( pA, pB, nDims, dCoeff1, dCoeff2 );
+}
+
+
+float distBhattSum( const float *pA, const float *pB, int nDims )
+{
+  return s_pKernels->pfBhatt( pA, pB, nDims );
+}
+
+
+void distSSDBatch( const float *pQuery, const float *pData,
+                   int nVectors, int nDims, int nStride, float *pResults )
+{
+  s_pKernels->pfSSDBatch( pQuery, pData, nVectors, nDims, nStride,
+                          pResults );
+}
+
+
+void distCorrelationBatch( const float *pQuery, const float *pData,
+                           int nVectors, int nDims, int nStride,
+                           float *pResults )
+{
+  s_pKernels->pfCorrBatch( pQuery, pData, nVectors, nDims, nStride,
+                           pResults );
+}
+
+
+void distCorrelationBlock( const float *pQueries, int nQueries,
+                           int nQueryStride, const float *pData,
+                           int nVectors, int nStride, int nDims,
+                           float *pResults, int nResultStride )
+{
+  s_pKernels->pfCorrBlock( pQueries, nQueries, nQueryStride, pData,
+                           nVectors, nStride, nDims, pResults,
+                           nResultStride );
+}
+
+
+void distChi2Batch( const float *pQuery, float dQuerySum,
+                    const float *pData, const float *pDataSums,
+                    int nVectors, int nDims, int nStride, float *pResults )
+  /*******************************************************************/
+  /* Chi-square measure of the query against each vector of the      */
+  /* block. If pDataSums is given, the measure is normalized by the  */
+  /* vector sums as in FeatureVector::compChi2Measure(); otherwise,  */
+  /* the unnormalized measure is returned.                           */
+  /*******************************************************************/
+{
+  const DistKernelTable *pKernels = s_pKernels;
+  for( int v=0; v<nVectors; v++ ) {
+    float dCoeff1 = 1.0;
+    float dCoeff2 = 1.0;
+    if( pDataSums != 0 ) {
+      dCoeff1 = sqrt( pDataSums[v]/dQuerySum );
+      dCoeff2 = sqrt( dQuerySum/pDataSums[v] );
+    }
+    pResults[v] = pKernels->pfChi2( pQuery, pData + (long)v*nStride, nDims,
+                                    dCoeff1, dCoeff2 );
+  }
+}
+
+
+void distBhattSumBatch( const float *pQuery, const float *pData,
+                        int nVectors, int nDims, int nStride,
+                        float *pResults )
+{
+  const DistKernelTable *pKernels = s_pKernels;
+  for( int v=0; v<nVectors; v++ )
+    pResults[v] = pKernels->pfBhatt( pQuery, pData + (long)v*nStride,
+                                     nDims );
+}
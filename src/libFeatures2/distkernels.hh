@@ -0,0 +1,84 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         distkernels.hh                                       */
+/*                                                                   */
+/* CONTENT      Low-level distance kernels on raw float arrays, used */
+/*              by the FeatureVector comparison measures and by the  */
+/*              codebook matching. Each kernel exists in a scalar,   */
+/*              an SSE, and an AVX2 version; the fastest version     */
+/*              supported by the processor is selected at runtime.   */
+/*                                                                   */
+/*              The batched versions compare one query against a     */
+/*              contiguous block of nVectors vectors, which are      */
+/*              stored nStride floats apart.                         */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef LEIBE_DISTKERNELS_HH
+#define LEIBE_DISTKERNELS_HH
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const int DIST_KERNEL_SCALAR = 0;
+const int DIST_KERNEL_SSE    = 1;
+const int DIST_KERNEL_AVX2   = 2;
+
+
+/****************************/
+/*   Associated Functions   */
+/****************************/
+
+/*---------------------*/
+/* Kernel selection    */
+/*---------------------*/
+int         getDistKernelLevel();
+int         getMaxDistKernelLevel();
+int         setDistKernelLevel( int nLevel );
+const char* getDistKernelName ( int nLevel );
+
+/*---------------------*/
+/* Single comparisons  */
+/*---------------------*/
+/* sum( (a[i]-b[i])^2 ) */
+float distSSD        ( const float *pA, const float *pB, int nDims );
+
+/* sum( a[i]*b[i] ) */
+float distCorrelation( const float *pA, const float *pB, int nDims );
+
+/* sum( (c1*a[i]-c2*b[i])^2/(a[i]+b[i]) ), skipping bins with a=b=0 */
+float distChi2       ( const float *pA, const float *pB, int nDims,
+                       float dCoeff1=1.0, float dCoeff2=1.0 );
+
+/* sum( sqrt(a[i]*b[i]) ) */
+float distBhattSum   ( const float *pA, const float *pB, int nDims );
+
+/*---------------------*/
+/* Batched comparisons */
+/*---------------------*/
+void  distSSDBatch        ( const float *pQuery, const float *pData,
+                            int nVectors, int nDims, int nStride,
+                            float *pResults );
+void  distCorrelationBatch( const float *pQuery, const float *pData,
+                            int nVectors, int nDims, int nStride,
+                            float *pResults );
+/* dot products of nQueries queries with nVectors vectors; the result */
+/* for query q and vector v is stored in pResults[q*nResultStride+v]. */
+void  distCorrelationBlock( const float *pQueries, int nQueries,
+                            int nQueryStride, const float *pData,
+                            int nVectors, int nStride, int nDims,
+                            float *pResults, int nResultStride );
+void  distChi2Batch       ( const float *pQuery, float dQuerySum,
+                            const float *pData, const float *pDataSums,
+                            int nVectors, int nDims, int nStride,
+                            float *pResults );
+void  distBhattSumBatch   ( const float *pQuery, const float *pData,
+                            int nVectors, int nDims, int nStride,
+                            float *pResults );
+
+#endif // LEIBE_DISTKERNELS_HH
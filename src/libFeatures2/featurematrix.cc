@@ -0,0 +1,285 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         featurematrix.cc                                     */
+/*                                                                   */
+/* CONTENT      Define a matrix class that stores a set of feature   */
+/*              vectors of equal dimension as the rows of a single   */
+/*              aligned, row-major float array, together with their  */
+/*              squared norms. This is the layout expected by the    */
+/*              batched distance kernels.                            */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+#include "distkernels.hh"
+#include "featurematrix.hh"
+
+/*===================================================================*/
+/*                         Class FeatureMatrix                       */
+/*===================================================================*/
+
+/***********************************************************/
+/*                      Constructors                       */
+/***********************************************************/
+
+FeatureMatrix::FeatureMatrix()
+  /* standard constructor */
+{
+  m_nRows   = 0;
+  m_nDims   = 0;
+  m_nStride = 0;
+  m_pData   = 0;
+}
+
+
+FeatureMatrix::FeatureMatrix( int nRows, int nDims )
+  /* alternate constructor: zero matrix of the given size */
+{
+  m_nRows   = 0;
+  m_nDims   = 0;
+  m_nStride = 0;
+  m_pData   = 0;
+  resize( nRows, nDims );
+}
+
+
+FeatureMatrix::FeatureMatrix( const vector<FeatureVector> &vRows )
+  /* alternate constructor: one row per feature vector */
+{
+  m_nRows   = 0;
+  m_nDims   = 0;
+  m_nStride = 0;
+  m_pData   = 0;
+  setRows( vRows );
+}
+
+
+FeatureMatrix::FeatureMatrix( const FeatureMatrix &other )
+  /* copy constructor */
+{
+  m_nRows   = 0;
+  m_nDims   = 0;
+  m_nStride = 0;
+  m_pData   = 0;
+  copyFromOther( other );
+}
+
+
+FeatureMatrix::~FeatureMatrix()
+  /* standard destructor */
+{
+  clear();
+}
+
+
+FeatureMatrix& FeatureMatrix::operator=( const FeatureMatrix &other )
+  /* assignment operator */
+{
+  if( &other != this )
+    copyFromOther( other );
+  return *this;
+}
+
+
+void FeatureMatrix::copyFromOther( const FeatureMatrix &other )
+{
+  resize( other.m_nRows, other.m_nDims );
+  if( m_pData != 0 )
+    memcpy( m_pData, other.m_pData, sizeof(float)*m_nRows*(long)m_nStride );
+  m_vSqrNorms = other.m_vSqrNorms;
+}
+
+
+/***********************************************************/
+/*                    Access Functions                     */
+/***********************************************************/
+
+void FeatureMatrix::clear()
+{
+  if( m_pData != 0 )
+    free( m_pData );
+  m_pData   = 0;
+  m_nRows   = 0;
+  m_nDims   = 0;
+  m_nStride = 0;
+  m_vSqrNorms.clear();
+}
+
+
+void FeatureMatrix::resize( int nRows, int nDims )
+  /*******************************************************************/
+  /* Reallocate the matrix for nRows rows of nDims entries. All en-  */
+  /* tries (including the row padding) and norms are set to 0.       */
+  /*******************************************************************/
+{
+  assert( nRows >= 0 && nDims >= 0 );
+  clear();
+
+  m_nRows   = nRows;
+  m_nDims   = nDims;
+  m_nStride = (nDims + FM_ROW_ALIGN-1)/FM_ROW_ALIGN*FM_ROW_ALIGN;
+  m_vSqrNorms.assign( nRows, 0.0 );
+
+  long nSize = sizeof(float)*m_nRows*(long)m_nStride;
+  if( nSize == 0 )
+    return;
+
+  void *pMem = 0;
+  if( posix_memalign( &pMem, sizeof(float)*FM_ROW_ALIGN, nSize ) != 0 ) {
+    cerr << "Error in FeatureMatrix::resize(): "
+         << "Couldn't allocate " << nRows << "x" << nDims << " matrix!"
+         << endl;
+    m_nRows = m_nDims = m_nStride = 0;
+    m_vSqrNorms.clear();
+    return;
+  }
+  m_pData = (float*) pMem;
+  memset( m_pData, 0, nSize );
+}
+
+
+void FeatureMatrix::setRows( const vector<FeatureVector> &vRows )
+  /*******************************************************************/
+  /* Copy the given feature vectors (which must all have the same    */
+  /* dimension) into the matrix rows and compute their norms.        */
+  /*******************************************************************/
+{
+  if( vRows.empty() ) {
+    clear();
+    return;
+  }
+
+  resize( (int)vRows.size(), vRows.front().numDims() );
+  for( int i=0; i<m_nRows; i++ )
+    setRow( i, vRows[i] );
+}
+
+
+void FeatureMatrix::setRow( int nRow, const FeatureVector &fvRow )
+{
+  if( fvRow.numDims() != m_nDims ) {
+    cerr << "Error in FeatureMatrix::setRow(): "
+         << "Dimension mismatch (" << fvRow.numDims() << " instead of "
+         << m_nDims << ")!" << endl;
+    return;
+  }
+  setRow( nRow, fvRow.getDataPtr() );
+}
+
+
+void FeatureMatrix::setRow( int nRow, const float *pRow )
+  /* copy nDims entries into the given row and update its norm */
+{
+  float *pDst = row( nRow );
+  if( m_nDims > 0 )
+    memcpy( pDst, pRow, sizeof(float)*m_nDims );
+  m_vSqrNorms[nRow] = distCorrelation( pDst, pDst, m_nDims );
+}
+
+
+void FeatureMatrix::computeNorms()
+  /* recompute the squared norms after writing directly to the rows */
+{
+  for( int i=0; i<m_nRows; i++ )
+    m_vSqrNorms[i] = distCorrelation( row(i), row(i), m_nDims );
+}
+
+
+FeatureVector FeatureMatrix::getRow( int nRow ) const
+{
+  const float *pRow = row( nRow );
+  return FeatureVector( vector<float>( pRow, pRow + m_nDims ) );
+}
+
+
+/****************************/
+/*   Associated Functions   */
+/****************************/
+
+bool saveFeatureMatrix( string sFileName, const FeatureMatrix &fmData, 
+                        bool bVerbose )
+  /*******************************************************************/
+  /* Save the matrix as a binary (uncompressed) FeatureVector list,  */
+  /* i.e. a text header followed by one dense block of raw floats.   */
+  /* The file can be read by loadFeatureMatrix() as well as by       */
+  /* loadFeatureVectorList().                                        */
+  /*******************************************************************/
+{
+  GzOutputStream ofile( sFileName, false );
+  if( !ofile ) {
+    cerr << "Error in saveFeatureMatrix(): Couldn't open file '" 
+         << sFileName << "'!" << endl;
+    return false;
+  }
+  if( bVerbose )
+    cout << "  Saving " << fmData.numRows() << "x" << fmData.numDims()
+         << " feature matrix..." << endl;
+
+  writeFeatureListHeader( ofile, fmData.numRows(), fmData.numDims(), false );
+  ofile << "Data:" << endl;
+  for( int i=0; i<fmData.numRows(); i++ )
+    ofile.write( (const char*) fmData.row(i), 
+                 fmData.numDims()*sizeof(float) );
+
+  ofile.close();
+  if( !ofile ) {
+    cerr << "Error in saveFeatureMatrix(): Couldn't write file '" 
+         << sFileName << "'!" << endl;
+    return false;
+  }
+  return true;
+}
+
+
+bool loadFeatureMatrix( string sFileName, FeatureMatrix &fmData, 
+                        bool bVerbose, int nThreads )
+  /*******************************************************************/
+  /* Load a FeatureVector list (text or binary, plain or gzipped)    */
+  /* directly into the rows of the matrix, without creating any      */
+  /* FeatureVector objects. Text data is parsed in parallel with     */
+  /* nThreads threads (<=0: one per processor).                      */
+  /*******************************************************************/
+{
+  fmData.clear();
+
+  GzInputStream ifile( sFileName );
+  if( !ifile ) {
+    cerr << "Error in loadFeatureMatrix(): Couldn't open file '" 
+         << sFileName << "'!" << endl;
+    return false;
+  }
+
+  int  nRows, nDims;
+  bool bAscii;
+  if( !readFeatureListHeader( ifile, nRows, nDims, bAscii, bVerbose ) )
+    return false;
+
+  fmData.resize( nRows, nDims );
+  if( fmData.numRows() != nRows )
+    return false;
+
+  vector<float*> vRows( nRows );
+  for( int i=0; i<nRows; i++ )
+    vRows[i] = fmData.row(i);
+
+  if( !readFeatureListData( ifile, vRows, nDims, bAscii, nThreads ) ) {
+    cerr << "Error in loadFeatureMatrix(): Couldn't read the data of '"
+         << sFileName << "'!" << endl;
+    fmData.clear();
+    return false;
+  }
+  fmData.computeNorms();
+
+  if( bVerbose )
+    cout << "    found " << nRows << " feature vectors." << endl;
+  return true;
+}
@@ -0,0 +1,105 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         featurematrix.hh                                     */
+/*                                                                   */
+/* CONTENT      Define a matrix class that stores a set of feature   */
+/*              vectors of equal dimension as the rows of a single   */
+/*              aligned, row-major float array, together with their  */
+/*              squared norms. This is the layout expected by the    */
+/*              batched distance kernels.                            */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef LEIBE_FEATUREMATRIX_HH
+#define LEIBE_FEATUREMATRIX_HH
+
+using namespace std;
+
+/****************/
+/*   Includes   */
+/****************/
+#include <vector>
+#include <string>
+#include <cassert>
+
+#include "featurevector.hh"
+
+/*******************/
+/*   Definitions   */
+/*******************/
+/* rows start at multiples of this many floats (32 bytes) */
+const int FM_ROW_ALIGN = 8;
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+/*===================================================================*/
+/*                         Class FeatureMatrix                       */
+/*===================================================================*/
+class FeatureMatrix
+{
+public:
+  FeatureMatrix();
+  FeatureMatrix( int nRows, int nDims );
+  FeatureMatrix( const vector<FeatureVector> &vRows );
+  FeatureMatrix( const FeatureMatrix &other );
+  ~FeatureMatrix();
+
+  FeatureMatrix& operator=( const FeatureMatrix &other );
+
+protected:
+  void copyFromOther( const FeatureMatrix &other );
+
+public:
+  /*******************************/
+  /*   Content Access Functions  */
+  /*******************************/
+  void  clear();
+  void  resize ( int nRows, int nDims );
+
+  void  setRows( const vector<FeatureVector> &vRows );
+  void  setRow ( int nRow, const FeatureVector &fvRow );
+  void  setRow ( int nRow, const float *pRow );
+
+  void  computeNorms();
+
+  FeatureVector getRow( int nRow ) const;
+
+  bool  empty()   const { return (m_nRows == 0); }
+  int   numRows() const { return m_nRows; }
+  int   numDims() const { return m_nDims; }
+  int   stride()  const { return m_nStride; }
+
+  const float* data() const { return m_pData; }
+  const float* row ( int nRow ) const
+  { assert( nRow>=0 && nRow<m_nRows ); return m_pData + (long)nRow*m_nStride; }
+  float*       row ( int nRow )
+  { assert( nRow>=0 && nRow<m_nRows ); return m_pData + (long)nRow*m_nStride; }
+
+  const float* sqrNorms() const { return ( m_nRows>0 ? &m_vSqrNorms[0] : 0 ); }
+  float        sqrNorm ( int nRow ) const { return m_vSqrNorms[nRow]; }
+
+protected:
+  int            m_nRows;
+  int            m_nDims;
+  int            m_nStride;     // row distance in floats (padded)
+
+  float         *m_pData;       // zero-padded, 32-byte aligned
+  vector<float>  m_vSqrNorms;
+};
+
+
+/****************************/
+/*   Associated Functions   */
+/****************************/
+bool saveFeatureMatrix( string sFileName, const FeatureMatrix &fmData, 
+                        bool bVerbose=false );
+bool loadFeatureMatrix( string sFileName, FeatureMatrix &fmData, 
+                        bool bVerbose=false, int nThreads=0 );
+
+
+#endif // LEIBE_FEATUREMATRIX_HH
@@ -22,11 +22,17 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
 #include <math.h>
 #include <values.h>   // for FLT_MAX
-#include <stdlib.h>   // for system()
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <locale.h>
 
 #include <chisquare.hh>
+#include "distkernels.hh"
+#include <parallelfor.hh>
 #include "featurevector.hh"
 
 /*******************/
@@ -35,6 +41,9 @@
 const float MIN_STDDEV   = 0.00001;
 const float MIN_VARIANCE = 0.00001;
 
+/* ASCII feature lists are parsed in blocks of this many bytes */
+const int   FVL_ASCII_BLOCKSIZE = 16*1024*1024;
+
 /*===================================================================*/
 /*                         Class FeatureVector                       */
 /*===================================================================*/
@@ -71,7 +80,7 @@ FeatureVector::FeatureVector( const FeatureVector &other )
 }
 
 
-FeatureVector::FeatureVector( vector<float> data )
+FeatureVector::FeatureVector( const vector<float> &data )
 	: m_vBins(data)
   /* copy constructor */
 {
@@ -82,7 +91,7 @@ FeatureVector::FeatureVector( vector<float> data )
 }
 
 
-FeatureVector::FeatureVector( vector<double> data )
+FeatureVector::FeatureVector( const vector<double> &data )
   /* copy constructor */
 {
   m_nDims = data.size();
@@ -96,16 +105,17 @@ FeatureVector::FeatureVector( vector<double> data )
 }
 
 
-FeatureVector& FeatureVector::operator=( FeatureVector other )
+FeatureVector& FeatureVector::operator=( const FeatureVector &other )
   /* assignment operator */
 {
   //cout << "    FeatureVector::operator=() called." << endl;
-  copyFromOther( other );
+  if( &other != this )
+    copyFromOther( other );
   return *this;
 }
 
 
-FeatureVector& FeatureVector::operator=( vector<float> data )
+FeatureVector& FeatureVector::operator=( const vector<float> &data )
   /* assignment operator */
 {
   //cout << "    FeatureVector::operator=() called." << endl;
@@ -117,7 +127,7 @@ FeatureVector& FeatureVector::operator=( vector<float> data )
 }
 
 
-FeatureVector& FeatureVector::operator=( vector<double> data )
+FeatureVector& FeatureVector::operator=( const vector<double> &data )
   /* assignment operator */
 {
   //cout << "    FeatureVector::operator=() called." << endl;
@@ -131,6 +141,20 @@ FeatureVector& FeatureVector::operator=( vector<double> data )
 }
 
 
+void FeatureVector::swap( FeatureVector &other )
+  /*******************************************************************/
+  /* Exchange the contents of two feature vectors without copying    */
+  /* the bins. Use this instead of an assignment when the source is  */
+  /* not needed anymore (e.g. to hand over a temporary vector).      */
+  /*******************************************************************/
+{
+  std::swap( m_nDims,         other.m_nDims );
+  std::swap( m_bSizeDefined,  other.m_bSizeDefined );
+  std::swap( m_nTotalNumBins, other.m_nTotalNumBins );
+  m_vBins.swap( other.m_vBins );
+}
+
+
 FeatureVector::~FeatureVector()
   /* standard destructor */
 {
@@ -330,7 +354,7 @@ bool  FeatureVector::save( string filename )
 }
 
 
-void  FeatureVector::writeHeader( ofstream &ofile )
+void  FeatureVector::writeHeader( ostream &ofile )
 {
   /* write the number of dimensions */
   ofile << "Dimensions:" << endl;
@@ -342,7 +366,7 @@ void  FeatureVector::writeHeader( ofstream &ofile )
 }
 
 
-void  FeatureVector::writeData( ofstream &ofile ) const
+void  FeatureVector::writeData( ostream &ofile ) const
 {
   /* write the data key word */
   //ofile << "Data:" << endl;
@@ -401,7 +425,7 @@ bool  FeatureVector::load( string filename, bool verbose )
 }
 
 
-bool  FeatureVector::readHeader( ifstream &ifile, bool &isAscii, 
+bool  FeatureVector::readHeader( istream &ifile, bool &isAscii, 
 			     bool verbose )
 {
   /* read the next line => must be key word 'Dimensions:' */
@@ -444,7 +468,7 @@ bool  FeatureVector::readHeader( ifstream &ifile, bool &isAscii,
 }
 
 
-bool  FeatureVector::readData( ifstream &ifile, bool isAscii )
+bool  FeatureVector::readData( istream &ifile, bool isAscii )
 {
   /* read the next line => must be key word 'Data:' */
   string line;
@@ -1161,14 +1185,7 @@ float FeatureVector::compSSD( const FeatureVector &other ) const
   int nTotalBins = calcTotalNumBins();
   assert( other.calcTotalNumBins() == nTotalBins );
 
-  /* calculate the minimum and the sums */
-  float ssd = 0.0;
-  for( int i=0; i<nTotalBins; i++ ) {
-    float diff = m_vBins[i] - other.m_vBins[i];
-    ssd       += diff*diff;
-  }
-
-  return ssd;
+  return distSSD( getDataPtr(), other.getDataPtr(), nTotalBins );
 }
 
 
@@ -1185,13 +1202,7 @@ float FeatureVector::compCorrelation( const FeatureVector &other ) const
   int nTotalBins = calcTotalNumBins();
   assert( other.calcTotalNumBins() == nTotalBins );
 
-  /* calculate the minimum and the sums */
-  float corr = 0.0;
-  for( int i=0; i<nTotalBins; i++ ) {
-    corr += m_vBins[i] * other.m_vBins[i];
-  }
-
-  return corr;
+  return distCorrelation( getDataPtr(), other.getDataPtr(), nTotalBins );
 }
 
 
@@ -1248,15 +1259,18 @@ float FeatureVector::compChi2Measure( const FeatureVector &other,
   int nTotalBins = calcTotalNumBins();
   assert( other.calcTotalNumBins() == nTotalBins );
 
-  /* calculate the minimum and the sums */
-  double df, chisq;
-  if ( bNormalize )
-    chstwo_measure( m_vBins, other.m_vBins, 0, getSum(), other.getSum(), 
-						&df, &chisq );
-  else
-    chstwo_measure( m_vBins, other.m_vBins, 0, 1.0, 1.0, &df, &chisq );
+  /* same measure as chstwo_measure(), but without copying the bins */
+  double coeff1 = 1.0;
+  double coeff2 = 1.0;
+  if ( bNormalize ) {
+    double sum1 = getSum();
+    double sum2 = other.getSum();
+    coeff1 = sqrt(sum2/sum1);
+    coeff2 = sqrt(sum1/sum2);
+  }
 
-  return chisq;
+  return distChi2( getDataPtr(), other.getDataPtr(), nTotalBins, 
+                   coeff1, coeff2 );
 }
 
 
@@ -1318,12 +1332,9 @@ float FeatureVector::compBhattacharyya( const FeatureVector &other,
     factor = 1.0/(sum1*sum2);
   }
 
-  /* calculate the minimum and the Bhattacharyya distance */
-  float sum = 0.0;
-  for ( int i=0; i<nTotalBins; i++ ) {
-    float fact = sqrt(m_vBins[i]*other.m_vBins[i]*factor);
-    sum += fact;
-  }
+  /* calculate the Bhattacharyya coefficient */
+  float sum = ( distBhattSum( getDataPtr(), other.getDataPtr(), nTotalBins )*
+                sqrt(factor) );
 
   if ( sum > 0.0 )
     return -log(sum);
@@ -1365,13 +1376,16 @@ ostream& operator<<( ostream& os, const FeatureVector& pt )
 
 bool saveFeatureVectorList( string filename, 
                             const vector<FeatureVector> &vFeatureVectors,
-                            bool gzip, bool verbose )
+                            bool gzip, bool verbose, bool binary )
   /*******************************************************************/
   /* Save the given vector of feature vectors to disk in text format.*/
   /* The vectors will be saved under the given file name. If a file  */
   /* with this name already exists, it will be overwritten.          */
-  /* The parameter gzip specifies if the file shall be gzipped       */
-  /* after saving.                                                   */
+  /* The parameter gzip specifies if the file shall be gzipped. The  */
+  /* data is compressed in-process while writing; gzipped lists get  */
+  /* the extension .flz (other names get an additional .gz).         */
+  /* If binary is set, the data is written as one dense block of raw */
+  /* floats (in host byte order) after the text header.              */
   /*******************************************************************/
 {
   assert( vFeatureVectors.size() > 0 );
@@ -1379,7 +1393,7 @@ bool saveFeatureVectorList( string filename,
     assert( vFeatureVectors[i].isValid() );
   }
 
-  ofstream ofile;
+  GzOutputStream ofile;
 
   /* check for the .flz extension and change it into .fls */
   int pos;
@@ -1393,12 +1407,23 @@ bool saveFeatureVectorList( string filename,
     if ( (pos=filename.rfind( ".gz" )) != (int)string::npos )
       filename = filename.substr(0, pos);
 
+  if ( gzip )
+    filename = filename + ".gz";
+
+  /* check for the .fls.gz file extension and change it into .flz */
+  if ( (pos=filename.rfind( ".fls.gz" )) != (int)string::npos ) {
+    if ( verbose )
+      cout << "  shortening extension .fls.gz into .flz..." << endl;
+    filename = filename.substr(0, pos) + ".flz";
+  }
+
   /* try to open the file */
-  ofile.open( filename.c_str() );
+  ofile.open( filename, gzip );
   if ( !ofile ) {
     /* try to compensate for broken network connections */
     cerr << "Couldn't open output file, trying again... ";
-    ofile.open( filename.c_str() );
+    ofile.clear();
+    ofile.open( filename, gzip );
     if ( ofile )
       cerr << "SUCCESS!" << endl;
     else {
@@ -1408,47 +1433,37 @@ bool saveFeatureVectorList( string filename,
       return false;
     }
   }
+  if ( verbose && gzip )
+    cout << "  writing gzipped..." << endl;
  
-  /* write the key word 'FeatureVectorList' */
-  ofile << "FeatureVectorList" << endl;
-
-  /* write the number of feature vectors */
-  ofile << "FeatureVectors:" << endl;
-  ofile << vFeatureVectors.size() << endl;
-
-  /* write the number of dimensions */
-  ofile << "Dimensions:" << endl;
-  ofile << vFeatureVectors[0].numDims() << endl;
-  
-  /* write the data file format */
-  ofile << "Format:" << endl;
-  ofile << "Ascii" << endl;
+  /* write the header */
+  int nDims = vFeatureVectors[0].numDims();
+  writeFeatureListHeader( ofile, vFeatureVectors.size(), nDims, !binary );
 
-  /* write the data for all vectors */
-  for( int i=0; i<(int)vFeatureVectors.size(); i++ ) {
-    /* write the data key word */
+  if ( binary ) {
+    /* write the data for all vectors as one block */
     ofile << "Data:" << endl;
+    for( int i=0; i<(int)vFeatureVectors.size(); i++ ) {
+      assert( vFeatureVectors[i].numDims() == nDims );
+      ofile.write( (const char*) vFeatureVectors[i].getDataPtr(), 
+                   nDims*sizeof(float) );
+    }
 
-    vFeatureVectors[i].writeData( ofile );
-  }
+  } else
+    /* write the data for all vectors */
+    for( int i=0; i<(int)vFeatureVectors.size(); i++ ) {
+      /* write the data key word */
+      ofile << "Data:" << endl;
+
+      vFeatureVectors[i].writeData( ofile );
+    }
 
   /* close the file */
   ofile.close();
-
-  if ( gzip ) {
-    /* gzip the file */
-    if ( verbose )
-      cout << "  gzipping..." << endl;
-    system( string("gzip -f " + filename).c_str() );
-    filename = filename + ".gz";
-  }
-
-  /* check for the .fls.gz file extension and change it into .flz */
-  if ( (pos=filename.rfind( ".fls.gz" )) != (int)string::npos ) {
-    if ( verbose )
-      cout << "  shortening extension .fls.gz into .flz..." << endl;
-    filename = filename.substr(0, pos);
-    system( string("mv " + filename+".fls.gz " + filename+".flz").c_str() );
+  if ( !ofile ) {
+    cerr << "Error in saveFeatureVectorList(): Couldn't write file '" 
+         << filename << "'!" << endl;
+    return false;
   }
 
   return true;
@@ -1457,73 +1472,28 @@ bool saveFeatureVectorList( string filename,
 
 bool loadFeatureVectorList( string filename, 
                             vector<FeatureVector> &vFeatureVectors, 
-                            bool verbose )
+                            bool verbose, int nThreads )
   /*******************************************************************/
   /* Load the feature vectors from the given file. The file must ex- */
-  /* ist and must contain a vector list in text format. The function */
-  /* will return a vector of feature vectors and the function value  */
-  /* 'true' in case of success, otherwise 'false'.                   */
+  /* ist and must contain a vector list in text or binary format.    */
+  /* The function will return a vector of feature vectors and the    */
+  /* function value 'true' in case of success, otherwise 'false'.    */
+  /* Text data is parsed with nThreads threads (<=0: one per CPU).   */
   /*******************************************************************/
 {
- ifstream ifile;
- string tmpfile(tempnam(NULL,NULL));
+  /* compressed (.flz, .gz) and plain files are read the same way */
+  GzInputStream ifile;
 
   /* clear this vector */
   vFeatureVectors.clear();
 
-#ifdef USE_GZCAT
-  int  pos;
-  if ( (pos=filename.rfind( ".flz" )) != (int)string::npos ) {
-    if ( verbose ) { 
-      cout << "  found compressed (.flz)... " << endl;
-    }
-    //int ret=system (string("gzcat "+filename+" > " +tmpfile.c_str()).c_str());
-    int ret=system (string("gzip -c -d "+filename+" > " +tmpfile.c_str()).c_str());
-    if (ret!=0) {
-      cout << " ERROR could not decompress file " << endl;
-      cout << "     (.gz is gzcat's alternative ending to look for..) " << endl;
-      cout << "     file: " << filename << endl;
-      cout << "     tmp-file: " << tmpfile << endl;
-      cout << "     cmd: " 
-        //     << string("gzcat "+filename+" > " +tmpfile.c_str()).c_str() << endl;
-           << string("gzip -c -d "+filename+" > " +tmpfile.c_str()).c_str() << endl;
-      system (string ("rm "+tmpfile).c_str()); 
-      exit(1);
-    }
-    filename = tmpfile;
-  } /* IF compressed */
-#else
-
-  /* check for the .flz file extension and change it into .fls.gz */
-  bool shortname = false;
-  string originalname = filename;
-  int  pos;
-  if ( (pos=filename.rfind( ".flz" )) != (int)string::npos ) {
-    if ( verbose )
-      cout << "  found suffix .flz: changing into .fls.gz..." << endl;
-    system( string("mv " + filename + " " + filename.substr(0,pos) + 
-		   ".fls.gz").c_str() );
-    shortname = true;
-    filename = filename.substr(0, pos) + ".fls.gz";
-  }
-
-  /* check for the .gz file extension and gunzip the file if it's there */
-  bool gunzipped = false;
-  if ( (pos=filename.rfind( ".gz" )) != (int)string::npos ) {
-    if ( verbose )
-      cout << "  found suffix .gz: gunzipping..." << endl;
-    system( string("gunzip -f " + filename).c_str() );
-    gunzipped = true;
-    filename = filename.substr(0, pos);
-  }
-#endif
-
   /* try to open the file */
-  ifile.open( filename.c_str() );
+  ifile.open( filename );
   if ( !ifile ) {
     /* try to compensate for broken network connections */
     cerr << "Couldn't open input file, trying again... ";
-    ifile.open( filename.c_str() );
+    ifile.clear();
+    ifile.open( filename );
     if ( ifile )
       cout << "SUCCESS!" << endl;
     else {
@@ -1535,6 +1505,62 @@ bool loadFeatureVectorList( string filename,
     }
   }
 
+  /* read the header */
+  int  nVectors, nDims;
+  bool isAscii;
+  if ( !readFeatureListHeader( ifile, nVectors, nDims, isAscii, verbose ) )
+    return false;
+
+  FeatureVector fvEmpty( nDims );
+  vFeatureVectors.assign( nVectors, fvEmpty );
+  vector<float*> vRows( nVectors );
+  for( int j=0; j<nVectors; j++ )
+    vRows[j] = vFeatureVectors[j].getDataPtr();
+  
+  /* read the data */
+  if ( verbose )
+    cout << "  Loading feature vectors..." << endl;
+  bool success = readFeatureListData( ifile, vRows, nDims, isAscii, 
+                                      nThreads );
+  if ( !success ) {
+    cerr << "Error in loadFeatureVectorList(): Couldn't read the data of '"
+         << filename << "'!" << endl;
+    vFeatureVectors.clear();
+  }
+  if ( verbose )
+    cout << "    found " << vFeatureVectors.size() << " feature vectors." 
+         << endl;
+
+  /* close the file */
+  ifile.close();
+
+  return success;
+}
+
+
+void writeFeatureListHeader( ostream &ofile, int nVectors, int nDims,
+                             bool isAscii )
+{
+  /* write the key word 'FeatureVectorList' */
+  ofile << "FeatureVectorList" << endl;
+
+  /* write the number of feature vectors */
+  ofile << "FeatureVectors:" << endl;
+  ofile << nVectors << endl;
+
+  /* write the number of dimensions */
+  ofile << "Dimensions:" << endl;
+  ofile << nDims << endl;
+  
+  /* write the data file format */
+  ofile << "Format:" << endl;
+  ofile << ( isAscii ? "Ascii" : "Binary" ) << endl;
+}
+
+
+bool readFeatureListHeader( istream &ifile, int &nVectors, int &nDims,
+                            bool &isAscii, bool verbose )
+{
   /* read the first line => determines the type of the file, */
   /* must be 'FeatureVectorList' */
   if ( !readKeyWord( ifile, "FeatureVectorList featurevectorlist FEATUREVECTORLIST" ) ) {
@@ -1550,27 +1576,21 @@ bool loadFeatureVectorList( string filename,
     return false;
 
   /* read the number of vectors */
-  int nVectors;
   ifile >> nVectors;
   if ( verbose )
     cout << "    FeatureVectors: " << nVectors << endl;
-  vFeatureVectors.reserve( nVectors );
 
   /* read the next line => must be key word 'Dimensions:' */
   if ( !readKeyWord( ifile, "Dimensions: dimensions:" ) )
     return false;
 
   /* read the number of dimensions */
-  int nDims;
   ifile >> nDims;
   if ( verbose )
     cout << "    Dimensions: " << nDims << endl;
-  for( int j=0; j<nVectors; j++ ) {
-    FeatureVector hist;
-    hist.setNumDims( nDims );
-    //vFeatureVectors[j] = hist;
-    vFeatureVectors.push_back(hist);
-    //vFeatureVectors[j].setNumDims( nDims );
+  if ( !ifile || nVectors < 0 || nDims < 0 ) {
+    cerr << "Error in loadFeatureVectorList: Invalid list size!" << endl;
+    return false;
   }
   
   /* read the next line => must be key word 'Format:' */
@@ -1579,7 +1599,7 @@ bool loadFeatureVectorList( string filename,
 
   /* read the next line => must be key word 'ASCII' or 'BIN' */
   string format;
-  bool isAscii = false;
+  isAscii = false;
   ifile >> format;
   if ( (format == "ascii") || (format == "Ascii") || (format == "ASCII") ) {
     if ( verbose )
@@ -1598,45 +1618,233 @@ bool loadFeatureVectorList( string filename,
          << endl;
     return false;
   }
-  
-  /* read the data */
-  if ( verbose )
-    cout << "  Loading feature vectors..." << endl;
-  bool success = true;
-  for( int j=0; j<nVectors; j++ )
-    if( success )
-      success = vFeatureVectors[j].readData( ifile, isAscii );
-  if ( verbose )
-    cout << "    found " << vFeatureVectors.size() << " feature vectors." 
-         << endl;
 
-  /* close the file */
-  ifile.close();
-  
-#ifdef USE_GZCAT
- system (string ("rm "+tmpfile).c_str()); 
-#else
-  if ( gunzipped ) {
-    /* gzip the file */
-    if ( verbose )
-      cout << "  gzipping again..." << endl;
-    system( string("gzip -f " + filename).c_str() );
+  return true;
+}
+
+
+/*----------------------------*/
+/* Parallel ASCII list parser */
+/*----------------------------*/
+static const char* findRecordStart( const char *pBegin, const char *pPos, 
+                                    const char *pEnd )
+  /*******************************************************************/
+  /* Each record of an ASCII list starts with the key word 'Data:',  */
+  /* and the values themselves never contain a ':'. Return the start */
+  /* of the first key word that ends at or after pPos (or pEnd).     */
+  /*******************************************************************/
+{
+  const char *pColon = (const char*) memchr( pPos, ':', pEnd - pPos );
+  if ( pColon == 0 )
+    return pEnd;
+  while ( pColon > pBegin && !isspace( (unsigned char) pColon[-1] ) )
+    pColon--;
+  return pColon;
+}
+
+
+struct FeatureListParser
+{
+  /* in */
+  const vector<const char*> *pvChunks;   // nChunks+1 record boundaries
+  const vector<float*>      *pvRows;
+  int                        nDims;
+  locale_t                   locC;
+  bool                       bCount;
+  /* in/out */
+  vector<int>               *pvFirstRow; // records per chunk (counting)
+  vector<char>              *pvOk;
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    for( int c=nBegin; c<nEnd; c++ )
+      if ( bCount )
+        (*pvFirstRow)[c] = countRecords( c );
+      else
+        (*pvOk)[c] = parseRecords( c );
   }
 
-  if ( shortname ) {
-    /* change the filename from .fls.gz to .flz */
-    if ( verbose )
-      cout << "  restoring the original filename with extension .flz..." 
-	   << endl;
-    system( string("mv " + filename + ".gz " + originalname).c_str() );
+  int countRecords( int c ) const
+  {
+    const char *p    = (*pvChunks)[c];
+    const char *pEnd = (*pvChunks)[c+1];
+    int nRecords = 0;
+    while ( (p=(const char*) memchr( p, ':', pEnd - p )) != 0 ) {
+      nRecords++;
+      p++;
+    }
+    return nRecords;
   }
-#endif
 
-  return success;
+  bool parseRecords( int c ) const
+  {
+    const char *p    = (*pvChunks)[c];
+    const char *pEnd = (*pvChunks)[c+1];
+    int nRow = (*pvFirstRow)[c];
+    const char *pColon;
+    while ( (pColon=(const char*) memchr( p, ':', pEnd - p )) != 0 ) {
+      /* check the key word */
+      const char *pWord = pColon;
+      while ( pWord > p && !isspace( (unsigned char) pWord[-1] ) )
+        pWord--;
+      if ( pColon - pWord != 4 || 
+           ( strncmp( pWord, "Data", 4 ) && strncmp( pWord, "data", 4 ) ) )
+        return false;
+
+      /* parse the values (in the "C" locale, as the streams do) */
+      float *pRow = (*pvRows)[nRow++];
+      p = pColon + 1;
+      for( int d=0; d<nDims; d++ ) {
+        char *pNext;
+        pRow[d] = strtof_l( p, &pNext, locC );
+        if ( pNext == p || pNext > pEnd )
+          return false;
+        p = pNext;
+      }
+    }
+    return true;
+  }
+};
+
+
+static bool parseFeatureListBlock( const char *pBegin, const char *pEnd,
+                                   const vector<float*> &vRows, 
+                                   int &nRowsDone, int nDims, 
+                                   locale_t locC, int nThreads )
+  /*******************************************************************/
+  /* Parse a block of complete ASCII records. The block is split at  */
+  /* record boundaries into one chunk per thread. A first pass counts*/
+  /* the records per chunk to find the row each chunk starts with.   */
+  /*******************************************************************/
+{
+  long nBytes = pEnd - pBegin;
+  int  nChunks = getNumThreads( nThreads, (int)(nBytes/4096) + 1 );
+
+  vector<const char*> vChunks( nChunks+1 );
+  vChunks[0]       = pBegin;
+  vChunks[nChunks] = pEnd;
+  for( int c=1; c<nChunks; c++ ) {
+    vChunks[c] = findRecordStart( pBegin, pBegin + nBytes*c/nChunks, pEnd );
+    if ( vChunks[c] < vChunks[c-1] )
+      vChunks[c] = vChunks[c-1];
+  }
+
+  vector<int>  vFirstRow( nChunks, 0 );
+  vector<char> vOk( nChunks, false );
+  FeatureListParser parser;
+  parser.pvChunks   = &vChunks;
+  parser.pvRows     = &vRows;
+  parser.nDims      = nDims;
+  parser.locC       = locC;
+  parser.pvFirstRow = &vFirstRow;
+  parser.pvOk       = &vOk;
+
+  /* count the records per chunk */
+  parser.bCount = true;
+  parallelFor( 0, nChunks, nChunks, parser );
+  int nRow = nRowsDone;
+  for( int c=0; c<nChunks; c++ ) {
+    int nRecords = vFirstRow[c];
+    vFirstRow[c] = nRow;
+    nRow += nRecords;
+  }
+  if ( nRow > (int)vRows.size() ) {
+    cerr << "Error in readFeatureListData(): "
+         << "More records than feature vectors!" << endl;
+    return false;
+  }
+
+  /* parse them */
+  parser.bCount = false;
+  parallelFor( 0, nChunks, nChunks, parser );
+  for( int c=0; c<nChunks; c++ )
+    if ( !vOk[c] ) {
+      cerr << "Error in readFeatureListData(): "
+           << "Parse error in record " << vFirstRow[c] << "ff." << endl;
+      return false;
+    }
+
+  nRowsDone = nRow;
+  return true;
+}
+
+
+bool readFeatureListData( istream &ifile, const vector<float*> &vRows,
+                          int nDims, bool isAscii, int nThreads )
+  /*******************************************************************/
+  /* Read the data part of a feature list (after the header) into    */
+  /* the given rows of nDims floats each. Binary data is one dense   */
+  /* block. ASCII data is read in large blocks which are cut behind  */
+  /* the last complete record and parsed in parallel.                */
+  /*******************************************************************/
+{
+  if ( !isAscii ) {
+    /* read key word 'Data:' and the end of its line */
+    if ( !readKeyWord( ifile, "Data: data:" ) )
+      return false;
+    if ( ifile.get() != '\n' )
+      return false;
+
+    for( int j=0; j<(int)vRows.size(); j++ )
+      if ( !ifile.read( (char*) vRows[j], nDims*sizeof(float) ) )
+        return false;
+    return true;
+  }
+
+  locale_t locC = newlocale( LC_ALL_MASK, "C", (locale_t) 0 );
+  if ( locC == (locale_t) 0 ) {
+    cerr << "Error in readFeatureListData(): "
+         << "Couldn't create the \"C\" locale!" << endl;
+    return false;
+  }
+
+  /* (one extra byte for the terminating 0 that stops strtof) */
+  vector<char> vBuffer( FVL_ASCII_BLOCKSIZE + 1 );
+  long nFill     = 0;
+  int  nRowsDone = 0;
+  bool bEof      = false;
+  bool ok        = true;
+  while ( ok && !bEof ) {
+    /* a single record doesn't fit => enlarge the buffer */
+    if ( nFill == (long)vBuffer.size()-1 )
+      vBuffer.resize( 2*vBuffer.size()-1 );
+
+    ifile.read( &vBuffer[nFill], vBuffer.size()-1 - nFill );
+    nFill += ifile.gcount();
+    bEof = !ifile;
+    vBuffer[nFill] = '\0';
+
+    /* parse everything up to the start of the last (incomplete) record */
+    const char *pBegin = &vBuffer[0];
+    const char *pEnd   = pBegin + nFill;
+    const char *pCut   = pEnd;
+    if ( !bEof ) {
+      while ( pCut > pBegin && pCut[-1] != ':' )
+        pCut--;
+      if ( pCut > pBegin )
+        pCut = findRecordStart( pBegin, pCut-1, pEnd );
+    }
+
+    ok = parseFeatureListBlock( pBegin, pCut, vRows, nRowsDone, nDims, 
+                                locC, nThreads );
+
+    /* keep the rest for the next block */
+    nFill = pEnd - pCut;
+    if ( nFill > 0 )
+      memmove( &vBuffer[0], pCut, nFill );
+  }
+  freelocale( locC );
+
+  if ( ok && nRowsDone != (int)vRows.size() ) {
+    cerr << "Error in readFeatureListData(): Found only " << nRowsDone 
+         << " of " << vRows.size() << " feature vectors!" << endl;
+    ok = false;
+  }
+  return ok;
 }
 
 
-bool  readKeyWord( ifstream &ifile, string KeyWords )
+bool  readKeyWord( istream &ifile, string KeyWords )
 {
   /* extract the key words to look for */
   vector<string> vWords = extractWords( KeyWords );
@@ -1688,7 +1896,7 @@ vector<string> extractWords( string WordList )
 }
 
 
-void computeFeatureStatistics( vector<FeatureVector> vFeatureVectors, 
+void computeFeatureStatistics( const vector<FeatureVector> &vFeatureVectors,
                                vector<float> &vMeans, 
                                vector<float> &vVariances )
   /*******************************************************************/
@@ -30,13 +30,13 @@
 #include <fstream>
 
 #include <grayimage.hh>
+#include "gzstream.hh"
 
 using namespace std;
 
 /*************************/
 /*   Class Definitions   */
 /*************************/
-#define USE_GZCAT USE_GZCAT
 
 /*===================================================================*/
 /*                         Class FeatureVector                       */
@@ -47,14 +47,16 @@ class FeatureVector
 public:
     FeatureVector();
     FeatureVector( int nDims );
-    FeatureVector( vector<float> data );
-    FeatureVector( vector<double> data );
+    FeatureVector( const vector<float> &data );
+    FeatureVector( const vector<double> &data );
     FeatureVector( const FeatureVector &other );
     virtual ~FeatureVector();
 
-    FeatureVector& operator=( FeatureVector other );
-    FeatureVector& operator=( vector<float> other );
-    FeatureVector& operator=( vector<double> other );
+    FeatureVector& operator=( const FeatureVector &other );
+    FeatureVector& operator=( const vector<float> &other );
+    FeatureVector& operator=( const vector<double> &other );
+
+    void swap( FeatureVector &other );
 
 protected:
     virtual void  copyFromOther( const FeatureVector &other );
@@ -81,6 +83,11 @@ public:
   virtual void  setData( vector<float> data );
   virtual void  setData( vector<double> data );
   vector<float> getData() const     { return m_vBins; }
+  const vector<float>& getDataRef() const { return m_vBins; }
+  const float*  getDataPtr() const
+  { return ( m_vBins.empty() ? 0 : &m_vBins[0] ); }
+  float*        getDataPtr()
+  { return ( m_vBins.empty() ? 0 : &m_vBins[0] ); }
 
   virtual void  clear();
 
@@ -96,11 +103,11 @@ public:
   virtual bool  save( string filename );
   virtual bool  load( string filename, bool verbose=false );
 
-  virtual void  writeHeader( ofstream &ofile );
-  virtual void  writeData( ofstream &ofile ) const;
-  virtual bool  readHeader( ifstream &ifile, bool &isAscii, 
+  virtual void  writeHeader( ostream &ofile );
+  virtual void  writeData( ostream &ofile ) const;
+  virtual bool  readHeader( istream &ifile, bool &isAscii, 
 														bool verbose=false );
-  virtual bool  readData( ifstream &ifile, bool isAscii=true );
+  virtual bool  readData( istream &ifile, bool isAscii=true );
 
 public:
   /**********************/
@@ -165,7 +172,8 @@ public:
   float getSum() const;
   void  getMinMax( float &min, float &max ) const;
   
-  friend void computeFeatureStatistics( vector<FeatureVector> vFeatureVectors, 
+  friend void computeFeatureStatistics( 
+                              const vector<FeatureVector> &vFeatureVectors,
 																				vector<float> &vMeans, 
 																				vector<float> &vVariances );
 
@@ -202,12 +210,20 @@ ostream& operator<<( ostream& os, const FeatureVector& pt );
 
 bool saveFeatureVectorList( string filename,
                             const vector<FeatureVector> &vFeatureVectors,
-                            bool gzip=true, bool verbose=false );
+                            bool gzip=true, bool verbose=false,
+                            bool binary=false );
 bool loadFeatureVectorList( string filename,
                             vector<FeatureVector> &vFeatureVectors,
-                            bool verbose=false );
+                            bool verbose=false, int nThreads=0 );
+
+void writeFeatureListHeader( ostream &ofile, int nVectors, int nDims,
+                             bool isAscii );
+bool readFeatureListHeader ( istream &ifile, int &nVectors, int &nDims,
+                             bool &isAscii, bool verbose=false );
+bool readFeatureListData   ( istream &ifile, const vector<float*> &vRows,
+                             int nDims, bool isAscii, int nThreads=0 );
 
-bool readKeyWord( ifstream &ifile, string KeyWords );
+bool readKeyWord( istream &ifile, string KeyWords );
 vector<string> extractWords( string WordList );
 
 void computeFeatureStatistics( vector<FeatureVector> vFeatureVectors,
@@ -0,0 +1,211 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         gzstream.cc                                          */
+/*                                                                   */
+/* CONTENT      C++ streams on top of zlib's gzFile interface, used  */
+/*              for reading and writing the (gzipped) FeatureVector  */
+/*              and Histogram lists in-process. Input streams read   */
+/*              gzip-compressed and uncompressed files alike; output */
+/*              streams write gzip-compatible files (or plain text). */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include "gzstream.hh"
+
+/*===================================================================*/
+/*                          Class GzStreamBuf                        */
+/*===================================================================*/
+
+GzStreamBuf::GzStreamBuf()
+  /* standard constructor */
+{
+  m_gzFile = 0;
+  m_bWrite = false;
+  setg( m_acBuffer, m_acBuffer, m_acBuffer );
+  setp( 0, 0 );
+}
+
+
+GzStreamBuf::~GzStreamBuf()
+  /* standard destructor */
+{
+  close();
+}
+
+
+bool GzStreamBuf::open( const string &sFileName, bool bWrite,
+                        bool bCompress )
+  /*******************************************************************/
+  /* Open the file for reading or writing. When reading, zlib finds  */
+  /* out by itself whether the file is compressed. When writing with */
+  /* bCompress=false, the file is written as plain text.             */
+  /*******************************************************************/
+{
+  if( isOpen() )
+    return false;
+
+  const char *pMode = ( !bWrite ? "rb" : ( bCompress ? "wb6" : "wbT" ) );
+  m_gzFile = gzopen( sFileName.c_str(), pMode );
+  if( m_gzFile == 0 )
+    return false;
+  gzbuffer( m_gzFile, GZSTREAM_BUFSIZE );
+
+  m_bWrite = bWrite;
+  if( m_bWrite ) {
+    setg( 0, 0, 0 );
+    setp( m_acBuffer, m_acBuffer + GZSTREAM_BUFSIZE );
+  } else {
+    setg( m_acBuffer, m_acBuffer, m_acBuffer );
+    setp( 0, 0 );
+  }
+  return true;
+}
+
+
+bool GzStreamBuf::close()
+  /* returns false if the remaining data couldn't be written */
+{
+  if( !isOpen() )
+    return true;
+
+  bool ok = true;
+  if( m_bWrite )
+    ok = flushBuffer();
+  if( gzclose( m_gzFile ) != Z_OK )
+    ok = false;
+  m_gzFile = 0;
+  setg( m_acBuffer, m_acBuffer, m_acBuffer );
+  setp( 0, 0 );
+  return ok;
+}
+
+
+GzStreamBuf::int_type GzStreamBuf::underflow()
+  /* refill the get area with the next block of decompressed data */
+{
+  if( gptr() < egptr() )
+    return traits_type::to_int_type( *gptr() );
+  if( !isOpen() || m_bWrite )
+    return traits_type::eof();
+
+  int nRead = gzread( m_gzFile, m_acBuffer, GZSTREAM_BUFSIZE );
+  if( nRead <= 0 )
+    return traits_type::eof();
+
+  setg( m_acBuffer, m_acBuffer, m_acBuffer + nRead );
+  return traits_type::to_int_type( *gptr() );
+}
+
+
+GzStreamBuf::int_type GzStreamBuf::overflow( int_type c )
+  /* compress the put area and start a new one */
+{
+  if( !isOpen() || !m_bWrite )
+    return traits_type::eof();
+  if( !flushBuffer() )
+    return traits_type::eof();
+
+  if( !traits_type::eq_int_type( c, traits_type::eof() ) ) {
+    *pptr() = traits_type::to_char_type( c );
+    pbump( 1 );
+  }
+  return traits_type::not_eof( c );
+}
+
+
+int GzStreamBuf::sync()
+{
+  if( isOpen() && m_bWrite && !flushBuffer() )
+    return -1;
+  return 0;
+}
+
+
+bool GzStreamBuf::flushBuffer()
+{
+  int nBytes = pptr() - pbase();
+  if( nBytes > 0 && gzwrite( m_gzFile, pbase(), nBytes ) != nBytes )
+    return false;
+  setp( m_acBuffer, m_acBuffer + GZSTREAM_BUFSIZE );
+  return true;
+}
+
+
+/*===================================================================*/
+/*                        Class GzInputStream                        */
+/*===================================================================*/
+
+GzInputStream::GzInputStream()
+  : istream( 0 )
+  /* standard constructor */
+{
+  init( &m_sbBuffer );
+}
+
+
+GzInputStream::GzInputStream( const string &sFileName )
+  : istream( 0 )
+  /* alternate constructor: open the given file */
+{
+  init( &m_sbBuffer );
+  open( sFileName );
+}
+
+
+void GzInputStream::open( const string &sFileName )
+{
+  if( !m_sbBuffer.open( sFileName, false ) )
+    setstate( ios::failbit );
+  else
+    clear();
+}
+
+
+void GzInputStream::close()
+{
+  if( !m_sbBuffer.close() )
+    setstate( ios::failbit );
+}
+
+
+/*===================================================================*/
+/*                        Class GzOutputStream                       */
+/*===================================================================*/
+
+GzOutputStream::GzOutputStream()
+  : ostream( 0 )
+  /* standard constructor */
+{
+  init( &m_sbBuffer );
+}
+
+
+GzOutputStream::GzOutputStream( const string &sFileName, bool bCompress )
+  : ostream( 0 )
+  /* alternate constructor: open the given file */
+{
+  init( &m_sbBuffer );
+  open( sFileName, bCompress );
+}
+
+
+void GzOutputStream::open( const string &sFileName, bool bCompress )
+{
+  if( !m_sbBuffer.open( sFileName, true, bCompress ) )
+    setstate( ios::failbit );
+  else
+    clear();
+}
+
+
+void GzOutputStream::close()
+{
+  if( !m_sbBuffer.close() )
+    setstate( ios::failbit );
+}
@@ -0,0 +1,112 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         gzstream.hh                                          */
+/*                                                                   */
+/* CONTENT      C++ streams on top of zlib's gzFile interface, used  */
+/*              for reading and writing the (gzipped) FeatureVector  */
+/*              and Histogram lists in-process. Input streams read   */
+/*              gzip-compressed and uncompressed files alike; output */
+/*              streams write gzip-compatible files (or plain text). */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef LEIBE_GZSTREAM_HH
+#define LEIBE_GZSTREAM_HH
+
+using namespace std;
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <string>
+#include <zlib.h>
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const int GZSTREAM_BUFSIZE = 64*1024;
+
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+/*===================================================================*/
+/*                          Class GzStreamBuf                        */
+/*===================================================================*/
+class GzStreamBuf : public streambuf
+{
+public:
+  GzStreamBuf();
+  ~GzStreamBuf();
+
+private:
+  /* not copyable (owns the file) */
+  GzStreamBuf( const GzStreamBuf &other );
+  GzStreamBuf& operator=( const GzStreamBuf &other );
+
+public:
+  bool open ( const string &sFileName, bool bWrite, bool bCompress=true );
+  bool close();
+
+  bool isOpen() const { return (m_gzFile != 0); }
+
+protected:
+  virtual int_type underflow();
+  virtual int_type overflow ( int_type c );
+  virtual int      sync();
+
+  bool flushBuffer();
+
+protected:
+  gzFile m_gzFile;
+  bool   m_bWrite;
+  char   m_acBuffer[GZSTREAM_BUFSIZE];
+};
+
+
+/*===================================================================*/
+/*                        Class GzInputStream                        */
+/*===================================================================*/
+class GzInputStream : public istream
+{
+public:
+  GzInputStream();
+  GzInputStream( const string &sFileName );
+
+public:
+  void open ( const string &sFileName );
+  void close();
+
+  bool is_open() const { return m_sbBuffer.isOpen(); }
+
+protected:
+  GzStreamBuf m_sbBuffer;
+};
+
+
+/*===================================================================*/
+/*                        Class GzOutputStream                       */
+/*===================================================================*/
+class GzOutputStream : public ostream
+{
+public:
+  GzOutputStream();
+  GzOutputStream( const string &sFileName, bool bCompress=true );
+
+public:
+  void open ( const string &sFileName, bool bCompress=true );
+  void close();
+
+  bool is_open() const { return m_sbBuffer.isOpen(); }
+
+protected:
+  GzStreamBuf m_sbBuffer;
+};
+
+
+#endif // LEIBE_GZSTREAM_HH
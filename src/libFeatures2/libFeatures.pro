@@ -15,8 +15,12 @@ CODE = $(HOME)/code
 INCLUDEPATH += . $${CODE}/include
 
 # Input
-HEADERS += featurevector.hh
-SOURCES += featurevector.cc
+HEADERS += featurevector.hh featurematrix.hh distkernels.hh modelfile.hh \
+           gzstream.hh
+SOURCES += featurevector.cc featurematrix.cc distkernels.cc modelfile.cc \
+           gzstream.cc
+
+LIBS += -lz -lpthread
 
 # make install
 target.path = ~/code/lib/i686
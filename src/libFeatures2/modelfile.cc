@@ -0,0 +1,275 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         modelfile.cc                                         */
+/*                                                                   */
+/* CONTENT      Versioned binary container for the recognition model */
+/*              (codebook, occurrences, occurrence maps). The file   */
+/*              consists of a header, a table of typed sections, and */
+/*              the raw section contents, each of them aligned to    */
+/*              MODELFILE_ALIGN bytes. The contents are written in   */
+/*              host byte order. The header holds the marker         */
+/*              MODELFILE_BYTEORDER, and files written on a machine  */
+/*              with another byte order are rejected. A              */
+/*              MappedModelFile mmaps the whole file read-only. The  */
+/*              loaders copy the sections into their in-memory       */
+/*              structures and release the mapping again; compared   */
+/*              with the text formats, they save the parsing, not    */
+/*              the memory.                                          */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "modelfile.hh"
+
+/*===================================================================*/
+/*                        Class ModelFileWriter                      */
+/*===================================================================*/
+
+ModelFileWriter::ModelFileWriter()
+  /* standard constructor */
+{
+}
+
+
+void ModelFileWriter::addSection( unsigned nType, const void *pData,
+                                  size_t nSize )
+{
+  m_vTypes.push_back( nType );
+  m_vData.push_back ( (const char*) pData );
+  m_vSizes.push_back( nSize );
+}
+
+
+bool ModelFileWriter::write( const string &sFileName ) const
+  /*******************************************************************/
+  /* Write the header, the section table, and the section contents.  */
+  /* The file is written to a temporary name first and renamed at    */
+  /* the end, so that processes which still map an older version of  */
+  /* the file are not affected.                                      */
+  /*******************************************************************/
+{
+  /*------------------------------*/
+  /* Prepare the header and table */
+  /*------------------------------*/
+  ModelFileHeader hdHeader;
+  memset( &hdHeader, 0, sizeof(hdHeader) );
+  memcpy( hdHeader.acMagic, MODELFILE_MAGIC, sizeof(MODELFILE_MAGIC) );
+  hdHeader.nVersion     = MODELFILE_VERSION;
+  hdHeader.nByteOrder   = MODELFILE_BYTEORDER;
+  hdHeader.nNumSections = m_vTypes.size();
+
+  vector<ModelFileSection> vSections( m_vTypes.size() );
+  unsigned long long nOffset = ( sizeof(ModelFileHeader) +
+                                 vSections.size()*sizeof(ModelFileSection) );
+  for( unsigned i=0; i<vSections.size(); i++ ) {
+    nOffset = (nOffset + MODELFILE_ALIGN-1)/MODELFILE_ALIGN*MODELFILE_ALIGN;
+    memset( &vSections[i], 0, sizeof(ModelFileSection) );
+    vSections[i].nType   = m_vTypes[i];
+    vSections[i].nOffset = nOffset;
+    vSections[i].nSize   = m_vSizes[i];
+    nOffset += m_vSizes[i];
+  }
+
+  /*----------------*/
+  /* Write the file */
+  /*----------------*/
+  string sTmpName( sFileName + ".tmp" );
+  FILE *fp = fopen( sTmpName.c_str(), "wb" );
+  if( fp == 0 ) {
+    cerr << "Error in ModelFileWriter::write(): "
+         << "Couldn't open file '" << sTmpName << "'!" << endl;
+    return false;
+  }
+
+  bool ok = ( fwrite( &hdHeader, sizeof(hdHeader), 1, fp ) == 1 );
+  if( ok && !vSections.empty() )
+    ok = ( fwrite( &vSections[0], sizeof(ModelFileSection), vSections.size(),
+                   fp ) == vSections.size() );
+
+  char acPad[MODELFILE_ALIGN];
+  memset( acPad, 0, MODELFILE_ALIGN );
+  long nPos = ( sizeof(ModelFileHeader) +
+                vSections.size()*sizeof(ModelFileSection) );
+  for( unsigned i=0; i<vSections.size() && ok; i++ ) {
+    size_t nPad = vSections[i].nOffset - nPos;
+    if( nPad > 0 )
+      ok = ( fwrite( acPad, 1, nPad, fp ) == nPad );
+    if( ok && m_vSizes[i] > 0 )
+      ok = ( fwrite( m_vData[i], 1, m_vSizes[i], fp ) == m_vSizes[i] );
+    nPos = vSections[i].nOffset + m_vSizes[i];
+  }
+
+  if( fclose( fp ) != 0 )
+    ok = false;
+  if( ok )
+    ok = ( rename( sTmpName.c_str(), sFileName.c_str() ) == 0 );
+  if( !ok ) {
+    cerr << "Error in ModelFileWriter::write(): "
+         << "Couldn't write file '" << sFileName << "'!" << endl;
+    remove( sTmpName.c_str() );
+  }
+  return ok;
+}
+
+
+/*===================================================================*/
+/*                        Class MappedModelFile                      */
+/*===================================================================*/
+
+MappedModelFile::MappedModelFile()
+  /* standard constructor */
+{
+  m_pBase     = 0;
+  m_nFileSize = 0;
+}
+
+
+MappedModelFile::~MappedModelFile()
+  /* standard destructor */
+{
+  close();
+}
+
+
+bool MappedModelFile::open( const string &sFileName, bool bVerbose )
+  /*******************************************************************/
+  /* Map the file and check its header and section table. Files with */
+  /* a different version or byte order are rejected.                 */
+  /*******************************************************************/
+{
+  close();
+
+  int fd = ::open( sFileName.c_str(), O_RDONLY );
+  if( fd < 0 ) {
+    if( bVerbose )
+      cerr << "Error in MappedModelFile::open(): "
+           << "Couldn't open file '" << sFileName << "'!" << endl;
+    return false;
+  }
+
+  struct stat stInfo;
+  if( fstat( fd, &stInfo ) != 0 ||
+      stInfo.st_size < (off_t)sizeof(ModelFileHeader) ) {
+    if( bVerbose )
+      cerr << "Error in MappedModelFile::open(): "
+           << "File '" << sFileName << "' is too short!" << endl;
+    ::close( fd );
+    return false;
+  }
+
+  size_t nFileSize = stInfo.st_size;
+  void *pMap = mmap( 0, nFileSize, PROT_READ, MAP_SHARED, fd, 0 );
+  ::close( fd );
+  if( pMap == MAP_FAILED ) {
+    if( bVerbose )
+      cerr << "Error in MappedModelFile::open(): "
+           << "Couldn't map file '" << sFileName << "'!" << endl;
+    return false;
+  }
+  m_pBase     = (const char*) pMap;
+  m_nFileSize = nFileSize;
+
+  /*------------------*/
+  /* Check the header */
+  /*------------------*/
+  ModelFileHeader hdHeader;
+  memcpy( &hdHeader, m_pBase, sizeof(hdHeader) );
+  string sProblem;
+  if( memcmp( hdHeader.acMagic, MODELFILE_MAGIC, sizeof(MODELFILE_MAGIC) ) )
+    sProblem = "not a binary model file";
+  else if( hdHeader.nByteOrder != MODELFILE_BYTEORDER )
+    sProblem = "wrong byte order";
+  else if( hdHeader.nVersion != MODELFILE_VERSION )
+    sProblem = "unsupported version";
+  else if( sizeof(ModelFileHeader) +
+           (size_t)hdHeader.nNumSections*sizeof(ModelFileSection) >
+           m_nFileSize )
+    sProblem = "truncated section table";
+
+  /*------------------------*/
+  /* Read the section table */
+  /*------------------------*/
+  if( sProblem.empty() ) {
+    m_vSections.resize( hdHeader.nNumSections );
+    if( !m_vSections.empty() )
+      memcpy( &m_vSections[0], m_pBase + sizeof(ModelFileHeader),
+              m_vSections.size()*sizeof(ModelFileSection) );
+    for( unsigned i=0; i<m_vSections.size() && sProblem.empty(); i++ )
+      if( m_vSections[i].nOffset > m_nFileSize ||
+          m_vSections[i].nSize > m_nFileSize - m_vSections[i].nOffset )
+        sProblem = "truncated section";
+  }
+
+  if( !sProblem.empty() ) {
+    if( bVerbose )
+      cerr << "Error in MappedModelFile::open(): "
+           << "File '" << sFileName << "': " << sProblem << "!" << endl;
+    close();
+    return false;
+  }
+  return true;
+}
+
+
+void MappedModelFile::close()
+{
+  if( m_pBase != 0 )
+    munmap( (void*) m_pBase, m_nFileSize );
+  m_pBase     = 0;
+  m_nFileSize = 0;
+  m_vSections.clear();
+}
+
+
+bool MappedModelFile::hasSection( unsigned nType ) const
+{
+  for( unsigned i=0; i<m_vSections.size(); i++ )
+    if( m_vSections[i].nType == nType )
+      return true;
+  return false;
+}
+
+
+const char* MappedModelFile::section( unsigned nType, size_t &nSize ) const
+  /* returns 0 (and nSize=0) if the section doesn't exist */
+{
+  for( unsigned i=0; i<m_vSections.size(); i++ )
+    if( m_vSections[i].nType == nType ) {
+      nSize = m_vSections[i].nSize;
+      return m_pBase + m_vSections[i].nOffset;
+    }
+  nSize = 0;
+  return 0;
+}
+
+
+/****************************/
+/*   Associated Functions   */
+/****************************/
+
+bool isModelFile( const string &sFileName )
+  /* check only the magic number (e.g. to select the loader) */
+{
+  FILE *fp = fopen( sFileName.c_str(), "rb" );
+  if( fp == 0 )
+    return false;
+
+  char acMagic[sizeof(MODELFILE_MAGIC)];
+  bool ok = ( fread( acMagic, sizeof(acMagic), 1, fp ) == 1 &&
+              memcmp( acMagic, MODELFILE_MAGIC, sizeof(acMagic) ) == 0 );
+  fclose( fp );
+  return ok;
+}
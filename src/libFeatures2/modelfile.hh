@@ -0,0 +1,154 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         modelfile.hh                                         */
+/*                                                                   */
+/* CONTENT      Versioned binary container for the recognition model */
+/*              (codebook, occurrences, occurrence maps). The file   */
+/*              consists of a header, a table of typed sections, and */
+/*              the raw section contents, each of them aligned to    */
+/*              MODELFILE_ALIGN bytes. The contents are written in   */
+/*              host byte order. The header holds the marker         */
+/*              MODELFILE_BYTEORDER, and files written on a machine  */
+/*              with another byte order are rejected. A              */
+/*              MappedModelFile mmaps the whole file read-only. The  */
+/*              loaders copy the sections into their in-memory       */
+/*              structures and release the mapping again; compared   */
+/*              with the text formats, they save the parsing, not    */
+/*              the memory.                                          */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef LEIBE_MODELFILE_HH
+#define LEIBE_MODELFILE_HH
+
+using namespace std;
+
+/****************/
+/*   Includes   */
+/****************/
+#include <vector>
+#include <string>
+#include <stddef.h>
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const char     MODELFILE_MAGIC[8]  = { 'L','I','S','M','B','I','N','\0' };
+const unsigned MODELFILE_VERSION   = 1;
+const unsigned MODELFILE_BYTEORDER = 0x01020304; // in host byte order
+const unsigned MODELFILE_ALIGN     = 64;
+
+/*---------------*/
+/* Section types */
+/*---------------*/
+/* codebook (libCodebook2) */
+const unsigned MODELSEC_CB_FEATURES    = 0x0101; // [nRows,nDims] + floats
+const unsigned MODELSEC_CB_ASSIGNMENT  = 0x0102; // int per feature
+const unsigned MODELSEC_CB_TRACE       = 0x0103; // (int,int,float,int)
+const unsigned MODELSEC_CB_CLUSTERS    = 0x0104; // [nRows,nDims] + floats
+/* occurrences (libISM2) */
+const unsigned MODELSEC_OCC_OFFSETS    = 0x0201; // nClusters+1 unsigned
+const unsigned MODELSEC_OCC_RECORDS    = 0x0202; // ClusterOccurrence
+const unsigned MODELSEC_OCCMAP_INDEX   = 0x0203; // (w,h,offset) per map
+const unsigned MODELSEC_OCCMAP_DATA    = 0x0204; // floats
+/* random forest (libRandomForest) */
+const unsigned MODELSEC_RF_PARAMS      = 0x0301; // RFFileParams
+const unsigned MODELSEC_RF_NODES       = 0x0302; // RFFileNode per node
+const unsigned MODELSEC_RF_CLASSES     = 0x0303; // RFFileClass
+const unsigned MODELSEC_RF_COORDS      = 0x0304; // (x,y) floats
+/* compiled random forest (libRandomForest) */
+const unsigned MODELSEC_CRF_NODES      = 0x0311; // CompiledForest::Node
+const unsigned MODELSEC_CRF_ROOTS      = 0x0312; // int per tree
+const unsigned MODELSEC_CRF_LEAFKEYS   = 0x0313; // unsigned per leaf
+const unsigned MODELSEC_CRF_LEAFTREES  = 0x0314; // int per leaf
+const unsigned MODELSEC_CRF_PROPORTION = 0x0315; // float per leaf+class
+const unsigned MODELSEC_CRF_VALID      = 0x0316; // unsigned per leaf+class
+const unsigned MODELSEC_CRF_COEFF      = 0x0317; // float per leaf+class
+const unsigned MODELSEC_CRF_COORDSTART = 0x0318; // unsigned, #leaf*class+1
+const unsigned MODELSEC_CRF_COORDS     = 0x0319; // (x,y) floats
+
+/*----------------------*/
+/* On-disk file layout  */
+/*----------------------*/
+struct ModelFileHeader
+{
+  char     acMagic[8];
+  unsigned nVersion;
+  unsigned nByteOrder;
+  unsigned nNumSections;
+  unsigned nReserved;
+};
+
+struct ModelFileSection
+{
+  unsigned      nType;
+  unsigned      nReserved;
+  unsigned long long nOffset;  // from the start of the file
+  unsigned long long nSize;    // in bytes
+};
+
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+/*===================================================================*/
+/*                        Class ModelFileWriter                      */
+/*===================================================================*/
+/* Collects the sections and writes them in one go. The section data */
+/* is not copied and has to stay valid until write() has returned.   */
+class ModelFileWriter
+{
+public:
+  ModelFileWriter();
+
+public:
+  void addSection( unsigned nType, const void *pData, size_t nSize );
+  bool write     ( const string &sFileName ) const;
+
+protected:
+  vector<unsigned>    m_vTypes;
+  vector<const char*> m_vData;
+  vector<size_t>      m_vSizes;
+};
+
+
+/*===================================================================*/
+/*                        Class MappedModelFile                      */
+/*===================================================================*/
+class MappedModelFile
+{
+public:
+  MappedModelFile();
+  ~MappedModelFile();
+
+private:
+  /* not copyable (owns the mapping) */
+  MappedModelFile( const MappedModelFile &other );
+  MappedModelFile& operator=( const MappedModelFile &other );
+
+public:
+  bool open ( const string &sFileName, bool bVerbose=true );
+  void close();
+
+  bool isOpen() const { return (m_pBase != 0); }
+
+  bool        hasSection( unsigned nType ) const;
+  const char* section   ( unsigned nType, size_t &nSize ) const;
+
+protected:
+  const char                *m_pBase;
+  size_t                     m_nFileSize;
+  vector<ModelFileSection>   m_vSections;
+};
+
+
+/****************************/
+/*   Associated Functions   */
+/****************************/
+bool isModelFile( const string &sFileName );
+
+#endif // LEIBE_MODELFILE_HH
@@ -34,6 +34,7 @@
 #include <math.h>
 
 #include "gaussderiv.hh"
+#include "fastgaussbank.hh"
 
 /******************/
 /*   Prototypes   */
@@ -41,11 +42,8 @@
 void make_gaussian_kernel( float sigma, float **kernel, int *windowsize ); 
 double angle_radians     ( double x, double y );
 
-/* Prototypes for "GrayImage" images */
-void gaussian_smooth ( const GrayImage &image, float sigma, GrayImage &res, 
-											 float boostfactor=1.0 );
-void derivative_x_y  ( const GrayImage &image,
-											 GrayImage &img_dx, GrayImage &img_dy );
+/* Prototypes for "GrayImage" images (smoothing and derivatives */
+/* are computed by a FastGaussBank, see fastgaussbank.cc)        */
 void magnitude_x_y   ( const GrayImage &img_dx, const GrayImage &img_dy,
 											 GrayImage &img_mag );
 void magnitude_x_y2  ( const GrayImage &img_dx, const GrayImage &img_dy,
@@ -141,29 +139,30 @@ double angle_radians(double x, double y)
 void FastGauss(const GrayImage &image, float sigma, GrayImage &res, 
 							 float boostfactor)
 {
-	gaussian_smooth( image, sigma, res, boostfactor );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_GAUSS, boostfactor );
+	fgb.apply( image );
+	res = fgb.getResult( 0, FGB_GAUSS );
 }
 
 
 void FastGaussDx(const GrayImage &image, float sigma, GrayImage &img_dx, 
 								 float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dy;
-
-	gaussian_smooth( image, sigma, img_gauss, boostfactor );
-	derivative_x_y ( img_gauss, img_dx, img_dy );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_DX, boostfactor );
+	fgb.apply( image );
+	img_dx = fgb.getResult( 0, FGB_DX );
 }
 
 
 void FastGaussDy(const GrayImage &image, float sigma, GrayImage &img_dy, 
 								 float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dx;
-
-	gaussian_smooth( image, sigma, img_gauss, boostfactor );
-	derivative_x_y ( img_gauss, img_dx, img_dy );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_DY, boostfactor );
+	fgb.apply( image );
+	img_dy = fgb.getResult( 0, FGB_DY );
 }
 
 
@@ -171,22 +170,21 @@ void FastGaussDxDy(const GrayImage &image, float sigma,
 									 GrayImage &img_dx, GrayImage &img_dy,
 									 float boostfactor)
 {
-	GrayImage img_gauss;
-
-	gaussian_smooth( image, sigma, img_gauss, boostfactor );
-	derivative_x_y ( img_gauss, img_dx, img_dy );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_DX | FGB_DY, boostfactor );
+	fgb.apply( image );
+	img_dx = fgb.getResult( 0, FGB_DX );
+	img_dy = fgb.getResult( 0, FGB_DY );
 }
 
 
 void FastGaussMag(const GrayImage &image, float sigma, GrayImage &img_mag,
 									float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dx, img_dy;
-
-	gaussian_smooth( image, sigma, img_gauss, boostfactor );
-	derivative_x_y ( img_gauss, img_dx, img_dy );
-	magnitude_x_y  ( img_dx, img_dy, img_mag );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_MAG, boostfactor );
+	fgb.apply( image );
+	img_mag = fgb.getResult( 0, FGB_MAG );
 }
 
 
@@ -200,12 +198,10 @@ void FastGaussMag ( const GrayImage &img_dx, const GrayImage &img_dy,
 void FastGaussMag2(const GrayImage &image, float sigma, GrayImage &img_mag,
 									 float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dx, img_dy;
-
-	gaussian_smooth( image, sigma, img_gauss, boostfactor );
-	derivative_x_y ( img_gauss, img_dx, img_dy );
-	magnitude_x_y2 ( img_dx, img_dy, img_mag );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_MAG2, boostfactor );
+	fgb.apply( image );
+	img_mag = fgb.getResult( 0, FGB_MAG2 );
 }
 
 
@@ -219,12 +215,10 @@ void FastGaussMag2( const GrayImage &img_dx, const GrayImage &img_dy,
 void FastGaussDir(const GrayImage &image, float sigma, GrayImage &img_dir,
 									float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dx, img_dy;
-
-	gaussian_smooth ( image, sigma, img_gauss, boostfactor );
-	derivative_x_y  ( img_gauss, img_dx, img_dy );
-	radian_direction( img_dx, img_dy, img_dir, -1, -1 );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_DIR, boostfactor );
+	fgb.apply( image );
+	img_dir = fgb.getResult( 0, FGB_DIR );
 }
 
 
@@ -247,13 +241,11 @@ void FastGaussMagDir(const GrayImage &image, float sigma,
 										 GrayImage &img_mag, GrayImage &img_dir,
 										 float boostfactor)
 {
-	GrayImage img_gauss;
-	GrayImage img_dx, img_dy;
-
-	gaussian_smooth ( image, sigma, img_gauss, boostfactor );
-	derivative_x_y  ( img_gauss, img_dx, img_dy );
-	magnitude_x_y   ( img_dx, img_dy, img_mag );
-	radian_direction( img_dx, img_dy, img_dir, -1, -1 );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_MAG | FGB_DIR, boostfactor );
+	fgb.apply( image );
+	img_mag = fgb.getResult( 0, FGB_MAG );
+	img_dir = fgb.getResult( 0, FGB_DIR );
 }
 
 
@@ -263,10 +255,15 @@ void FastGaussDxDyMagDir(const GrayImage &image, float sigma,
 												 GrayImage &img_mag, GrayImage &img_dir,
 												 float boostfactor)
 {
-	gaussian_smooth ( image, sigma, img_gauss, boostfactor );
-	derivative_x_y  ( img_gauss, img_dx, img_dy );
-	magnitude_x_y   ( img_dx, img_dy, img_mag );
-	radian_direction( img_dx, img_dy, img_dir, -1, -1 );
+	FastGaussBank fgb;
+	fgb.addRequest( sigma, FGB_GAUSS | FGB_DX | FGB_DY | FGB_MAG | FGB_DIR, 
+									boostfactor );
+	fgb.apply( image );
+	img_gauss = fgb.getResult( 0, FGB_GAUSS );
+	img_dx    = fgb.getResult( 0, FGB_DX );
+	img_dy    = fgb.getResult( 0, FGB_DY );
+	img_mag   = fgb.getResult( 0, FGB_MAG );
+	img_dir   = fgb.getResult( 0, FGB_DIR );
 }
 
 
@@ -327,159 +324,6 @@ void MakeGaussKernel2D( float sigma, GrayImage &kernel )
 }
 
 
-void gaussian_smooth( const GrayImage &image, float sigma, GrayImage &res, 
-											float boostfactor)
-	/*******************************************************************/
-	/* PROCEDURE: gaussian_smooth                                      */
-	/* PURPOSE: Blur an image with a gaussian filter by convolving     */
-	/*          with two separate filter masks for x and y direction.  */
-	/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */    
-	/* DATE: 2/15/96                                                   */
-	 /******************************************************************/
-{
-	int r, c, rr, cc,    /* Counter variables. */
-		windowsize,        /* Dimension of the gaussian kernel. */
-		center;            /* Half of the windowsize. */
-	float *tempim,       /* Buffer for separable filter gaussian smoothing. */
-		*kernel,        /* A one dimensional gaussian kernel. */
-		dot,            /* Dot product summing variable. */
-		sum;            /* Sum of the kernel weights variable. */
-	int rows, cols; 
-
-	rows = image.height();
-	cols = image.width();
-	
-	/***********************************************************************
-   * Create a 1-dimensional gaussian smoothing kernel.
-   ***********************************************************************/
-	if(VERBOSE) printf("   Computing the gaussian smoothing kernel.\n");
-	make_gaussian_kernel(sigma, &kernel, &windowsize);
-	center = windowsize / 2;
-	
-	/***********************************************************************
-   * Allocate a temporary buffer image and the smoothed image.
-   ***********************************************************************/
-	if((tempim = (float *) calloc(rows*cols, sizeof(float))) == NULL){
-		fprintf(stderr, "Error allocating the buffer image.\n");
-		exit(1);
-	}
-
-	/* initialize the result image */
-	GrayImage tmp( image );
-	res = tmp;
-	
-	/***********************************************************************
-   * Blur in the x - direction.
-   ***********************************************************************/
-	if(VERBOSE) printf("   Bluring the image in the X-direction.\n");
-	for(r=0;r<rows;r++){
-		for(c=0;c<cols;c++){
-			dot = 0.0;
-			sum = 0.0;
-			for(cc=(-center);cc<=center;cc++){
-				if(((c+cc) >= 0) && ((c+cc) < cols)){
-					dot += (float)image(c+cc,r).value() * kernel[center+cc];
-					sum += kernel[center+cc];
-				}
-			}
-			tempim[r*cols+c] = dot/sum;
-		}
-	}
-	
-	/***********************************************************************
-   * Blur in the y - direction.
-   ***********************************************************************/
-	if(VERBOSE) printf("   Bluring the image in the Y-direction.\n");
-	for(c=0;c<cols;c++){
-		for(r=0;r<rows;r++){
-			sum = 0.0;
-			dot = 0.0;
-			for(rr=(-center);rr<=center;rr++){
-				if(((r+rr) >= 0) && ((r+rr) < rows)){
-					dot += tempim[(r+rr)*cols+c] * kernel[center+rr];
-					sum += kernel[center+rr];
-				}
-			}
-			res(c,r) = (dot*boostfactor/sum);
-			//(*smoothedimg)[r*cols+c] = (short int)(dot*BOOSTBLURFACTOR/sum + 0.5);
-		}
-	}
-	
-	free(tempim);
-	free(kernel);
-}
-
-
-void derivative_x_y(const GrayImage &image,
-										 GrayImage &img_dx, GrayImage &img_dy)
-	/*******************************************************************/
-	/* PROCEDURE: derivative_x_y                                       */
-	/* PURPOSE: Compute the first derivative of the image in both the  */
-	/*          x and y directions. The differential filters that are  */
-	/*          used are:                                              */
-	/*                                                                 */
-	/*                                          -1                     */
-	/*         dx =  -1 0 +1     and       dy =  0                     */
-	/*                                          +1                     */
-	/*                                                                 */
-	/* AUTHOR: Mike Heath, modified by Bastian Leibe                   */
-	/* DATE: 2/15/96                                                   */
-	/*******************************************************************/
-{
-	int r, c, pos;
-	int rows, cols;
-
-	rows = image.height();
-	cols = image.width();
-	
-	/***********************************************************************
-   * Allocate images to store the derivatives.
-   ***********************************************************************/
-	/* initialize the result images */
-	GrayImage tmp( image );
-	img_dx = tmp;
-	img_dy = tmp;
-	
-	/***********************************************************************
-   * Compute the x-derivative. Adjust the derivative at the borders to avoid
-   * losing pixels.
-   ***********************************************************************/
-	if(VERBOSE) printf("   Computing the X-direction derivative.\n");
-	for(r=0;r<rows;r++){
-		//pos = r * cols;
-		//(*delta_x)[pos] = smoothedimg[pos+1] - smoothedimg[pos];
-		pos = 0;
-		img_dx(pos,r) = image(pos+1,r).value() - image(pos,r).value();
-		pos++;
-		for(c=1;c<(cols-1);c++,pos++){
-			//(*delta_x)[pos] = smoothedimg[pos+1] - smoothedimg[pos-1];
-			img_dx(pos,r) = image(pos+1,r).value() - image(pos-1,r).value();
-		}
-		//(*delta_x)[pos] = smoothedimg[pos] - smoothedimg[pos-1];
-		img_dx(pos,r) = image(pos,r).value() - image(pos-1,r).value();
-	}
-	
-	/***********************************************************************
-   * Compute the y-derivative. Adjust the derivative at the borders to avoid
-   * losing pixels.
-   ***********************************************************************/
-	if(VERBOSE) printf("   Computing the Y-direction derivative.\n");
-	for(c=0;c<cols;c++){
-		//pos = c;
-		//(*delta_y)[pos] = smoothedimg[pos+cols] - smoothedimg[pos];
-		pos = 0;
-		img_dy(c,pos) = image(c, pos+1).value() - image(c, pos).value();
-		pos++;
-		for(r=1;r<(rows-1);r++,pos++){
-			//(*delta_y)[pos] = smoothedimg[pos+cols] - smoothedimg[pos-cols];
-			img_dy(c,pos) = image(c, pos+1).value() - image(c, pos-1).value();
-		}
-		//(*delta_y)[pos] = smoothedimg[pos] - smoothedimg[pos-cols];
-		img_dy(c,pos) = image(c, pos).value() - image(c, pos-1).value();
-	}
-}
-
-
 void magnitude_x_y(const GrayImage &img_dx, const GrayImage &img_dy,
 									 GrayImage &img_mag )
 	/*******************************************************************/
@@ -502,14 +346,19 @@ void magnitude_x_y(const GrayImage &img_dx, const GrayImage &img_dy,
    * Allocate an image to store the magnitude of the gradient.
    ***********************************************************************/
 	/* initialize the magnitude image */
+	ImageView<GrayPixel> vdx = img_dx.view();
+	ImageView<GrayPixel> vdy = img_dy.view();
 	GrayImage tmp( img_dx );
 	img_mag = tmp;
 	
 	for(r=0;r<rows;r++){
+		const GrayPixel *pDx  = vdx.rowPtr(r);
+		const GrayPixel *pDy  = vdy.rowPtr(r);
+		GrayPixel       *pMag = img_mag.rowPtr(r);
 		for(c=0;c<cols;c++){
-			sq1 = img_dx(c,r).value() * img_dx(c,r).value();
-			sq2 = img_dy(c,r).value() * img_dy(c,r).value();
-			img_mag(c,r) = sqrt(sq1 + sq2);
+			sq1 = pDx[c].value() * pDx[c].value();
+			sq2 = pDy[c].value() * pDy[c].value();
+			pMag[c] = sqrt(sq1 + sq2);
 		}
   }
 	
@@ -537,14 +386,19 @@ void magnitude_x_y2(const GrayImage &img_dx, const GrayImage &img_dy,
    * Allocate an image to store the magnitude of the gradient.
    ***********************************************************************/
 	/* initialize the magnitude image */
+	ImageView<GrayPixel> vdx = img_dx.view();
+	ImageView<GrayPixel> vdy = img_dy.view();
 	GrayImage tmp( img_dx );
 	img_mag = tmp;
 	
 	for(r=0;r<rows;r++){
+		const GrayPixel *pDx  = vdx.rowPtr(r);
+		const GrayPixel *pDy  = vdy.rowPtr(r);
+		GrayPixel       *pMag = img_mag.rowPtr(r);
 		for(c=0;c<cols;c++){
-			sq1 = img_dx(c,r).value() * img_dx(c,r).value();
-			sq2 = img_dy(c,r).value() * img_dy(c,r).value();
-			img_mag(c,r) = (sq1 + sq2);
+			sq1 = pDx[c].value() * pDx[c].value();
+			sq2 = pDy[c].value() * pDy[c].value();
+			pMag[c] = (sq1 + sq2);
 		}
   }
 	
@@ -582,18 +436,23 @@ void radian_direction( const GrayImage &img_dx, const GrayImage &img_dy,
    * Allocate an image to store the direction of the gradient.
    ***********************************************************************/
 	/* initialize the direction image */
+	ImageView<GrayPixel> vdx = img_dx.view();
+	ImageView<GrayPixel> vdy = img_dy.view();
 	GrayImage tmp( img_dx );
 	img_dir = tmp;
 	
 	for(r=0;r<rows;r++){
+		const GrayPixel *pDx  = vdx.rowPtr(r);
+		const GrayPixel *pDy  = vdy.rowPtr(r);
+		GrayPixel       *pDir = img_dir.rowPtr(r);
 		for(c=0;c<cols;c++){
-			dx = (double) img_dx(c,r).value(); 
-			dy = (double) img_dy(c,r).value(); 
+			dx = (double) pDx[c].value(); 
+			dy = (double) pDy[c].value(); 
 			
 			if(xdirtag == 1) dx = -dx;
 			if(ydirtag == -1) dy = -dy;
 			
-			img_dir(c,r) = (float)angle_radians(dx, dy);
+			pDir[c] = (float)angle_radians(dx, dy);
 		}
 	}
 }
@@ -0,0 +1,370 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         fastgaussbank.cc                                     */
+/*                                                                   */
+/* CONTENT      Filter bank for the separable Gaussian derivatives   */
+/*              of fastgauss.cc. Takes a list of requests (sigma and */
+/*              the desired outputs), smoothes the image only once   */
+/*              per sigma, and computes all requested derivatives,   */
+/*              gradient magnitudes and directions from the shared   */
+/*              smoothing pass. The convolutions run on float rows   */
+/*              in loops the compiler can vectorize.                 */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "gaussderiv.hh"
+#include "fastgaussbank.hh"
+
+/******************/
+/*   Prototypes   */
+/******************/
+/* in fastgauss.cc */
+void   make_gaussian_kernel( float sigma, float **kernel, int *windowsize );
+double angle_radians       ( double x, double y );
+
+
+/*===================================================================*/
+/*                         Class FastGaussBank                       */
+/*===================================================================*/
+
+FastGaussBank::FastGaussBank( bool bCascade )
+  /* standard constructor */
+{
+  m_bCascade = bCascade;
+  m_nRows    = 0;
+  m_nCols    = 0;
+}
+
+
+int FastGaussBank::addRequest( float dSigma, int nOutputs,
+                               float dBoostFactor )
+  /*******************************************************************/
+  /* Add a request for the given outputs (an or'ed combination of    */
+  /* the FGB_... flags) at scale dSigma. Requests with the same      */
+  /* sigma and boost factor share all computations. Returns the      */
+  /* index that is passed to getResult().                            */
+  /*******************************************************************/
+{
+  assert( dSigma > 0.0 );
+
+  int nLevel = -1;
+  for( unsigned i=0; i<m_vLevels.size() && nLevel<0; i++ )
+    if( m_vLevels[i].dSigma == dSigma &&
+        m_vLevels[i].dBoostFactor == dBoostFactor )
+      nLevel = (int)i;
+
+  if( nLevel < 0 ) {
+    FGBLevel level;
+    level.dSigma       = dSigma;
+    level.dBoostFactor = dBoostFactor;
+    level.nOutputs     = 0;
+    m_vLevels.push_back( level );
+    nLevel = (int)m_vLevels.size() - 1;
+  }
+  m_vLevels[nLevel].nOutputs |= nOutputs;
+
+  m_vRequests.push_back( nLevel );
+  return (int)m_vRequests.size() - 1;
+}
+
+
+void FastGaussBank::clear()
+  /* remove all requests and results (the work buffers are kept) */
+{
+  m_vLevels.clear();
+  m_vRequests.clear();
+}
+
+
+void FastGaussBank::apply( const GrayImage &image )
+  /*******************************************************************/
+  /* Compute all requested outputs for the given image. The image is */
+  /* converted to float once; each sigma is smoothed once, either    */
+  /* from the source image or, when cascading, from the result of    */
+  /* the next smaller sigma.                                         */
+  /*******************************************************************/
+{
+  m_nRows = image.height();
+  m_nCols = image.width();
+  int nPixels = m_nRows*m_nCols;
+
+  /* (the derivatives need at least 2 pixels in each direction) */
+  bool bNeedDeriv = false;
+  for( unsigned i=0; i<m_vLevels.size(); i++ )
+    if( m_vLevels[i].nOutputs & ~FGB_GAUSS )
+      bNeedDeriv = true;
+  if( nPixels > 0 && bNeedDeriv && (m_nRows < 2 || m_nCols < 2) )
+    throw GrayImage::OutOfBoundaryException();
+
+  /*-----------------------------*/
+  /* Convert the source to float */
+  /*-----------------------------*/
+  m_vSource.resize( nPixels );
+  m_vSmoothed.resize( nPixels );
+  m_vTemp.resize( nPixels );
+  m_vRowBuf.resize( m_nCols );
+  m_vRowBuf2.resize( m_nCols );
+  if( m_bCascade )
+    m_vPrevSmoothed.resize( nPixels );
+
+  ImageView<GrayPixel> src = image.view();
+  for( int r=0; r<m_nRows; r++ ) {
+    const GrayPixel *pSrc = src.rowPtr(r);
+    float           *pDst = &m_vSource[0] + r*m_nCols;
+    for( int c=0; c<m_nCols; c++ )
+      pDst[c] = pSrc[c].value();
+  }
+
+  /*--------------------*/
+  /* Process the levels */
+  /*--------------------*/
+  /* (sorted by sigma if they are to be cascaded) */
+  vector< pair<float,int> > vOrder;
+  for( unsigned i=0; i<m_vLevels.size(); i++ )
+    vOrder.push_back( pair<float,int>( m_vLevels[i].dSigma, i ) );
+  if( m_bCascade )
+    stable_sort( vOrder.begin(), vOrder.end() );
+
+  bool  bHavePrev   = false;
+  float dPrevSigma  = 0.0;
+  float dPrevBoost  = 1.0;
+  for( unsigned i=0; i<vOrder.size(); i++ ) {
+    FGBLevel &level = m_vLevels[vOrder[i].second];
+    if( nPixels == 0 ) {
+      GrayImage imgEmpty;
+      level.imgGauss = level.imgDx = level.imgDy = imgEmpty;
+      level.imgMag   = level.imgMag2 = level.imgDir = imgEmpty;
+      continue;
+    }
+
+    float dInc2 = level.dSigma*level.dSigma - dPrevSigma*dPrevSigma;
+    if( bHavePrev &&
+        dInc2 >= FGB_MIN_CASCADE_SIGMA*FGB_MIN_CASCADE_SIGMA )
+      smoothLevel( &m_vPrevSmoothed[0], sqrt(dInc2),
+                   level.dBoostFactor/dPrevBoost, &m_vSmoothed[0] );
+    else
+      smoothLevel( &m_vSource[0], level.dSigma, level.dBoostFactor,
+                   &m_vSmoothed[0] );
+    computeLevel( &m_vSmoothed[0], level );
+
+    if( m_bCascade ) {
+      m_vPrevSmoothed.swap( m_vSmoothed );
+      dPrevSigma = level.dSigma;
+      dPrevBoost = level.dBoostFactor;
+      bHavePrev  = true;
+    }
+  }
+}
+
+
+const GrayImage& FastGaussBank::getResult( int nRequest, int nOutput ) const
+  /* returns an empty image if the output wasn't requested */
+{
+  assert( nRequest>=0 && nRequest<(int)m_vRequests.size() );
+  const FGBLevel &level = m_vLevels[m_vRequests[nRequest]];
+  if( !(level.nOutputs & nOutput) ) {
+    cerr << "Error in FastGaussBank::getResult(): "
+         << "Output " << nOutput << " wasn't requested for request "
+         << nRequest << "!" << endl;
+    return m_imgEmpty;
+  }
+
+  switch( nOutput ) {
+  case FGB_GAUSS: return level.imgGauss;
+  case FGB_DX:    return level.imgDx;
+  case FGB_DY:    return level.imgDy;
+  case FGB_MAG:   return level.imgMag;
+  case FGB_MAG2:  return level.imgMag2;
+  case FGB_DIR:   return level.imgDir;
+  default:
+    cerr << "Error in FastGaussBank::getResult(): "
+         << "Unknown output " << nOutput << "!" << endl;
+    return m_imgEmpty;
+  }
+}
+
+
+void FastGaussBank::smoothLevel( const float *pSrc, float dSigma,
+                                 float dScale, float *pDst )
+  /*******************************************************************/
+  /* Blur the float image pSrc with a Gaussian of the given sigma    */
+  /* and multiply it by dScale (the boost factor). The inner loops   */
+  /* run over consecutive pixels of a row (for one kernel tap after  */
+  /* the other), so that they can be vectorized. Every pixel still   */
+  /* sums up its kernel taps in the same order as a per-pixel loop,  */
+  /* so the result is the same. The kernel is only clipped (and      */
+  /* renormalized) within 'center' pixels of the border.             */
+  /*******************************************************************/
+{
+  int    rows = m_nRows;
+  int    cols = m_nCols;
+  float *kernel;
+  int    windowsize;
+  make_gaussian_kernel( dSigma, &kernel, &windowsize );
+  int    center = windowsize / 2;
+
+  float ksum = 0.0;
+  for( int k=0; k<windowsize; k++ )
+    ksum += kernel[k];
+
+  /*---------------------*/
+  /* Blur in x direction */
+  /*---------------------*/
+  int cBegin = min( center, cols );
+  int cEnd   = max( cols-center, cBegin );
+  for( int r=0; r<rows; r++ ) {
+    const float *pRow = pSrc + r*cols;
+    float       *pTmp = &m_vTemp[0] + r*cols;
+
+    /* interior: all kernel taps inside the row */
+    for( int c=cBegin; c<cEnd; c++ )
+      pTmp[c] = 0.0;
+    for( int k=0; k<windowsize; k++ ) {
+      const float  w = kernel[k];
+      const float *p = pRow + k - center;
+      for( int c=cBegin; c<cEnd; c++ )
+        pTmp[c] += p[c] * w;
+    }
+    for( int c=cBegin; c<cEnd; c++ )
+      pTmp[c] = pTmp[c]/ksum;
+
+    /* border: clip the kernel */
+    for( int c=0; c<cols; c++ ) {
+      if( c >= cBegin && c < cEnd )
+        continue;
+      float dot = 0.0;
+      float sum = 0.0;
+      for( int cc=(-center); cc<=center; cc++ )
+        if( (c+cc) >= 0 && (c+cc) < cols ) {
+          dot += pRow[c+cc] * kernel[center+cc];
+          sum += kernel[center+cc];
+        }
+      pTmp[c] = dot/sum;
+    }
+  }
+
+  /*---------------------*/
+  /* Blur in y direction */
+  /*---------------------*/
+  float *rowdot = &m_vRowBuf[0];
+  for( int r=0; r<rows; r++ ) {
+    float sum = 0.0;
+    for( int c=0; c<cols; c++ )
+      rowdot[c] = 0.0;
+    for( int rr=(-center); rr<=center; rr++ )
+      if( (r+rr) >= 0 && (r+rr) < rows ) {
+        const float *pTmp = &m_vTemp[0] + (r+rr)*cols;
+        const float  k    = kernel[center+rr];
+        for( int c=0; c<cols; c++ )
+          rowdot[c] += pTmp[c] * k;
+        sum += k;
+      }
+
+    float *pRes = pDst + r*cols;
+    for( int c=0; c<cols; c++ )
+      pRes[c] = rowdot[c]*dScale/sum;
+  }
+
+  free( kernel );
+}
+
+
+void FastGaussBank::computeLevel( const float *pSmoothed, FGBLevel &level )
+  /*******************************************************************/
+  /* Compute the requested outputs of one level from the smoothed    */
+  /* image. The derivatives are the central differences of           */
+  /* derivative_x_y() (one-sided at the border); magnitude and       */
+  /* direction are computed from them row by row, without storing    */
+  /* the derivative images unless they were requested.               */
+  /*******************************************************************/
+{
+  int rows     = m_nRows;
+  int cols     = m_nCols;
+  int nOutputs = level.nOutputs;
+
+  /*----------------*/
+  /* Smoothed image */
+  /*----------------*/
+  if( nOutputs & FGB_GAUSS ) {
+    GrayImage img( cols, rows );
+    for( int r=0; r<rows; r++ ) {
+      const float *pSrc = pSmoothed + r*cols;
+      GrayPixel   *pDst = img.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        pDst[c] = pSrc[c];
+    }
+    level.imgGauss = img;
+  }
+  if( !(nOutputs & ~FGB_GAUSS) )
+    return;
+
+  /*-------------*/
+  /* Derivatives */
+  /*-------------*/
+  GrayImage imgDx, imgDy, imgMag, imgMag2, imgDir;
+  if( nOutputs & FGB_DX )   imgDx   = GrayImage( cols, rows );
+  if( nOutputs & FGB_DY )   imgDy   = GrayImage( cols, rows );
+  if( nOutputs & FGB_MAG )  imgMag  = GrayImage( cols, rows );
+  if( nOutputs & FGB_MAG2 ) imgMag2 = GrayImage( cols, rows );
+  if( nOutputs & FGB_DIR )  imgDir  = GrayImage( cols, rows );
+
+  float *dx = &m_vRowBuf[0];
+  float *dy = &m_vRowBuf2[0];
+  for( int r=0; r<rows; r++ ) {
+    const float *pRow  = pSmoothed + r*cols;
+    const float *pUp   = pSmoothed + ((r > 0) ? r-1 : r)*cols;
+    const float *pDown = pSmoothed + ((r < rows-1) ? r+1 : r)*cols;
+
+    dx[0] = pRow[1] - pRow[0];
+    for( int c=1; c<cols-1; c++ )
+      dx[c] = pRow[c+1] - pRow[c-1];
+    dx[cols-1] = pRow[cols-1] - pRow[cols-2];
+    for( int c=0; c<cols; c++ )
+      dy[c] = pDown[c] - pUp[c];
+
+    if( nOutputs & FGB_DX ) {
+      GrayPixel *p = imgDx.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        p[c] = dx[c];
+    }
+    if( nOutputs & FGB_DY ) {
+      GrayPixel *p = imgDy.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        p[c] = dy[c];
+    }
+    if( nOutputs & FGB_MAG ) {
+      GrayPixel *p = imgMag.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        p[c] = sqrtf( dx[c]*dx[c] + dy[c]*dy[c] );
+    }
+    if( nOutputs & FGB_MAG2 ) {
+      GrayPixel *p = imgMag2.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        p[c] = dx[c]*dx[c] + dy[c]*dy[c];
+    }
+    if( nOutputs & FGB_DIR ) {
+      /* (angle "up the gradient", as radian_direction() with -1,-1) */
+      GrayPixel *p = imgDir.rowPtr(r);
+      for( int c=0; c<cols; c++ )
+        p[c] = (float)angle_radians( (double)dx[c], -(double)dy[c] );
+    }
+  }
+
+  level.imgDx   = imgDx;
+  level.imgDy   = imgDy;
+  level.imgMag  = imgMag;
+  level.imgMag2 = imgMag2;
+  level.imgDir  = imgDir;
+}
@@ -0,0 +1,131 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         fastgaussbank.hh                                     */
+/*                                                                   */
+/* CONTENT      Filter bank for the separable Gaussian derivatives   */
+/*              of fastgauss.cc. Takes a list of requests (sigma and */
+/*              the desired outputs), smoothes the image only once   */
+/*              per sigma, and computes all requested derivatives,   */
+/*              gradient magnitudes and directions from the shared   */
+/*              smoothing pass. The convolutions run on float rows   */
+/*              in loops the compiler can vectorize.                 */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef LEIBE_FASTGAUSSBANK_HH
+#define LEIBE_FASTGAUSSBANK_HH
+
+using namespace std;
+
+#ifdef _USE_PERSONAL_NAMESPACES
+//namespace Leibe {
+#endif
+
+/****************/
+/*   Includes   */
+/****************/
+#include <vector>
+
+#include <grayimage.hh>
+
+/*******************/
+/*   Definitions   */
+/*******************/
+/* outputs of a filter bank request (can be or'ed together) */
+const int FGB_GAUSS = 0x01;   // smoothed image
+const int FGB_DX    = 0x02;   // derivative in x direction
+const int FGB_DY    = 0x04;   // derivative in y direction
+const int FGB_MAG   = 0x08;   // gradient magnitude
+const int FGB_MAG2  = 0x10;   // squared gradient magnitude
+const int FGB_DIR   = 0x20;   // gradient direction (radians)
+
+/* smallest sigma increment for which a cascaded pass is used */
+const float FGB_MIN_CASCADE_SIGMA = 0.5;
+
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+/*===================================================================*/
+/*                         Class FastGaussBank                       */
+/*===================================================================*/
+/* Usage:                                                            */
+/*   FastGaussBank fgb;                                              */
+/*   int n1 = fgb.addRequest( 1.0, FGB_DX | FGB_DY | FGB_MAG );      */
+/*   int n2 = fgb.addRequest( 2.0, FGB_GAUSS );                      */
+/*   fgb.apply( img );                                               */
+/*   const GrayImage &imgMag = fgb.getResult( n1, FGB_MAG );         */
+/*                                                                   */
+/* Without cascading, every output is identical to the one of the    */
+/* corresponding FastGauss...() function. With cascading, each sigma */
+/* is smoothed from the next smaller one (with the incremental sigma */
+/* sqrt(s1^2-s0^2)), which is faster for dense scale sequences, but  */
+/* only an approximation because of the truncated kernels and the    */
+/* border normalization.                                             */
+class FastGaussBank
+{
+public:
+  FastGaussBank( bool bCascade=false );
+
+public:
+  /*************************/
+  /*   Request Functions   */
+  /*************************/
+  int  addRequest( float dSigma, int nOutputs, float dBoostFactor=1.0 );
+  void clear();
+
+  int  numRequests() const { return (int)m_vRequests.size(); }
+  void setCascade ( bool bCascade ) { m_bCascade = bCascade; }
+
+  /***************************/
+  /*   Filtering Functions   */
+  /***************************/
+  void apply( const GrayImage &image );
+
+  const GrayImage& getResult( int nRequest, int nOutput ) const;
+
+protected:
+  struct FGBLevel
+  {
+    float     dSigma;
+    float     dBoostFactor;
+    int       nOutputs;
+    GrayImage imgGauss;
+    GrayImage imgDx;
+    GrayImage imgDy;
+    GrayImage imgMag;
+    GrayImage imgMag2;
+    GrayImage imgDir;
+  };
+
+  void smoothLevel ( const float *pSrc, float dSigma, float dScale,
+                     float *pDst );
+  void computeLevel( const float *pSmoothed, FGBLevel &level );
+
+protected:
+  bool               m_bCascade;
+  int                m_nRows;
+  int                m_nCols;
+  vector<FGBLevel>   m_vLevels;
+  vector<int>        m_vRequests;  // level index for each request
+  GrayImage          m_imgEmpty;
+
+  /* work buffers (kept between calls) */
+  vector<float>      m_vSource;
+  vector<float>      m_vSmoothed;
+  vector<float>      m_vPrevSmoothed;
+  vector<float>      m_vTemp;
+  vector<float>      m_vRowBuf;
+  vector<float>      m_vRowBuf2;
+};
+
+
+#ifdef _USE_PERSONAL_NAMESPACES
+//}
+#endif
+
+#endif // LEIBE_FASTGAUSSBANK_HH
@@ -45,6 +45,9 @@ bool ApplyGaussMag( const GrayImage &image, double sigma, GrayImage &res );
 bool ApplyGaussMag2( const GrayImage &image, double sigma, GrayImage &res );
 bool ApplyGaussLap( const GrayImage &image, double sigma, GrayImage &res );
 
+/* DC gain of ApplyGauss() for sigma */
+double GetGaussGain( double sigma );
+
 bool ApplyAllGaussFilters( const GrayImage &image, double sigma,
 			   GrayImage &g_out, 
 			   GrayImage &gx_out, GrayImage gy_out,
@@ -16,8 +16,10 @@ INCLUDEPATH += . $(HOME)/code/include
 
 # Input
 HEADERS += gaussderiv.hh \
+           fastgaussbank.hh
 
 SOURCES += fastgauss.cc \
+           fastgaussbank.cc \
            gaussderiv.cc
 
 IMAGE_LIBS   = -limage2
@@ -106,6 +106,48 @@ GaussPyramid::GaussPyramid(const OpGrayImage& source, int level)
 }
 
 
+GaussPyramid::GaussPyramid(ScaleSpaceCache& cache, int level) 
+  /*******************************************************************/
+  /* Build up the same pyramid from a shared scale space cache. With */
+  /* sigma0=1 and 2 levels per octave, levels 1 and 2 of each cache  */
+  /* octave have the scales sqrt(2) and 2 relative to the octave's   */
+  /* base, and the next octave's base is level 2 subsampled by 2,    */
+  /* as below. (The cache smoothes each level from the one below it, */
+  /* so the levels differ slightly from those of the constructor     */
+  /* above because of the truncated kernels.)                        */
+  /*******************************************************************/
+{
+  cout << "GaussPyramid::GaussPyramid called." << endl;
+  if (level < 0) {
+    data = 0;
+    return;
+  }
+  data = new PyramidData(level);
+  cout << "  Generating pyramid from scale space cache" << endl;
+
+  data->scaledImage[0] = cache.getLevel(1.0, 2, 0, 0);
+  data->scales[0] = 1.0;
+
+  for (int z = 1; z < data->levels; z+=2) {
+    int octave = (z-1)/2;
+    const OpGrayImage &base = cache.getLevel(1.0, 2, octave, 0);
+    if (base.width() <= minImageSize || base.height() <= minImageSize ||
+        octave+1 >= cache.getMaxOctaves(1)) {
+      data->levels = z - 1;
+      break;
+    }
+
+    data->scaledImage[z]   = resampleDown15(cache.getLevel(1.0, 2, octave, 1));
+    data->scaledImage[z+1] = cache.getLevel(1.0, 2, octave+1, 0);
+  }
+
+  for (int i=1; i<data->levels; i++) {
+    data->scales[i] = data->scales[i-1] * sqrt(2.0);
+  }
+  cout << "GaussPyramid::GaussPyramid exit." << endl;
+}
+
+
 GaussPyramid::~GaussPyramid() 
 {
   if (data != 0) {
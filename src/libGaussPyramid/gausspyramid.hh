@@ -19,6 +19,7 @@
 /*   Includes   */
 /****************/
 #include "pyramiddata.hh"
+#include <scalespacecache.hh>
 
 
 /*************************/
@@ -36,6 +37,7 @@ public:
   GaussPyramid();
   GaussPyramid(const GaussPyramid& source);
   GaussPyramid(const OpGrayImage& source, int level);
+  GaussPyramid(ScaleSpaceCache& cache, int level);
   ~GaussPyramid();
   
 public:
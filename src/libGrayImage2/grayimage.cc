@@ -41,7 +41,7 @@ namespace Leibe {
 /*                      Constructors                       */
 /***********************************************************/
 
-GrayImage& GrayImage::operator=( GrayImage other )
+GrayImage& GrayImage::operator=( const GrayImage &other )
   /* assignment operator */
 {
   Image<GrayPixel>::operator=( other );
@@ -49,10 +49,11 @@ GrayImage& GrayImage::operator=( GrayImage other )
 }
 
 
-GrayImage& GrayImage::operator=( RGBImage other )
+GrayImage& GrayImage::operator=( const RGBImage &other )
   /* assignment operator */
 {
-  *this = getIntensityImage( other );
+  GrayImage imgIntensity( getIntensityImage( other ) );
+  swap( imgIntensity );
   return *this;
 }
 
@@ -586,7 +587,7 @@ GrayImage GrayImage::flipVertical() const
 /*                  Conversion Functions                   */
 /***********************************************************/
 
-GrayImage getIntensityImage( RGBImage &rgbImg )
+GrayImage getIntensityImage( const RGBImage &rgbImg )
   /*******************************************************************/
   /* Get an intensity image out of an RGB image.                     */
   /*******************************************************************/
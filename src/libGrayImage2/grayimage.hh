@@ -86,8 +86,8 @@ public:
 		: Image<GrayPixel>(width, height) {}
   GrayImage( const GrayImage& other ) : Image<GrayPixel>(other) {}
 
-  GrayImage& operator=( GrayImage other );
-  GrayImage& operator=( RGBImage other );
+  GrayImage& operator=( const GrayImage &other );
+  GrayImage& operator=( const RGBImage &other );
 
   std::vector<float> getData();
 	void loadFromData( int w, int h, float data[] );
@@ -147,7 +147,7 @@ protected:
 // Conversion Functions
 //-----------------------------------------------------------------------------
 
-GrayImage getIntensityImage( RGBImage &rgbimg );
+GrayImage getIntensityImage( const RGBImage &rgbimg );
   /*******************************************************************/
   /* Get an intensity image out of an RGB image.                     */
   /*******************************************************************/
@@ -51,7 +51,7 @@ OpGrayImage::OpGrayImage( const QImage& src )
 }
 
 
-OpGrayImage& OpGrayImage::operator=( OpGrayImage other )
+OpGrayImage& OpGrayImage::operator=( const OpGrayImage &other )
   /* assignment operator */
 {
   GrayImage::operator=( other );
@@ -533,7 +533,7 @@ void OpGrayImage::opFastGaussMagDir( double sigma,
 																		 float multfactor )
   /* calculate the gradient magnitude and direction */
 {
-  FastGaussDxDy( *this, sigma, img_mag, img_dir, multfactor );
+  FastGaussMagDir( *this, sigma, img_mag, img_dir, multfactor );
 }
 
 
@@ -590,7 +590,8 @@ OpGrayImage cannyEdgesDxDy( const OpGrayImage &imgDx, const OpGrayImage &imgDy,
   assert( imgDx.width() == imgDy.width() );
   assert( imgDx.height() == imgDy.height() );
 
-  OpGrayImage img_edges( imgDx.width(), imgDx.height() );	
+  /* (the edge image is allocated by canny()) */
+  OpGrayImage img_edges;
 	canny( imgDx, imgDy, tlow, thigh, img_edges );
 	return img_edges;
 }
@@ -1214,14 +1215,21 @@ OpGrayImage OpGrayImage::opNonMaximumSuppression( float suppressval )
 
   // Run through the window and compare pixel with neighbours.
   // If it is not a maximum, set it to suppressval,
-  // otherwise leave it as it is.
-  for (int i=1; i<w-1; i++) {
-    for (int j=1; j<h-1; j++) {
-      try {
-        if (!isMaximum(*this, i, j)) {
-          result(i,j) = suppressval;
-        }
-      } catch(OutOfBoundaryException) { }
+  // otherwise leave it as it is. (Same test as isMaximum(), but on
+  // the raw rows, since all neighbours are inside the image.)
+  ImageView<GrayPixel> img = view();
+  for (int j=1; j<h-1; j++) {
+    const GrayPixel *pAbove = img.rowPtr(j-1);
+    const GrayPixel *pRow   = img.rowPtr(j);
+    const GrayPixel *pBelow = img.rowPtr(j+1);
+    GrayPixel       *pRes   = result.rowPtr(j);
+    for (int i=1; i<w-1; i++) {
+      float center = pRow[i].value();
+      if( !( pAbove[i-1].value() < center && pRow[i-1].value()   < center &&
+             pBelow[i-1].value() < center && pBelow[i].value()   < center &&
+             pBelow[i+1].value() < center && pRow[i+1].value()   < center &&
+             pAbove[i+1].value() < center && pAbove[i].value()   < center ) )
+        pRes[i] = suppressval;
     }
   }
   return result;
@@ -1238,14 +1246,32 @@ OpGrayImage OpGrayImage::opNonMaximumSuppression( int windowSize,
 
   // Run through the window and compare pixel with neighbours.
   // If it is not a maximum, set it to suppressval,
-  // otherwise leave it as it is.
-  for (int i=0; i<w; i++) {
-    for (int j=0; j<h; j++) {
-      try {
-        if (!isMaximum(*this, i, j, windowSize)) {
-          result(i,j) = suppressval;
-        }
-      } catch(OutOfBoundaryException) { }
+  // otherwise leave it as it is. (Same test as isMaximum(), with the
+  // window clipped to the image instead of catching the exceptions.)
+  if ((windowSize % 2) == 0) {
+    windowSize++;
+  }
+  int winrad = (windowSize-1)/2;
+  ImageView<GrayPixel> img = view();
+  for (int j=0; j<h; j++) {
+    GrayPixel *pRes = result.rowPtr(j);
+    int y0 = max( 0, j-winrad );
+    int y1 = min( h-1, j+winrad );
+    for (int i=0; i<w; i++) {
+      float center = img(i,j).value();
+      int x0 = max( 0, i-winrad );
+      int x1 = min( w-1, i+winrad );
+      bool bMax = true;
+      for (int y=y0; y<=y1 && bMax; y++) {
+        const GrayPixel *pRow = img.rowPtr(y);
+        for (int x=x0; x<=x1; x++)
+          if ( pRow[x].value() >= center && !(x == i && y == j) ) {
+            bMax = false;
+            break;
+          }
+      }
+      if (!bMax)
+        pRes[i] = suppressval;
     }
   }
   return result;
@@ -45,7 +45,7 @@ public:
   OpGrayImage( const GrayImage& other ) : GrayImage(other) {}
   OpGrayImage( const QImage& src );
 
-  OpGrayImage& operator=( OpGrayImage other );
+  OpGrayImage& operator=( const OpGrayImage &other );
 
 private:
   void copyFrom( const QImage& src );
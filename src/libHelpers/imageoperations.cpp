@@ -8,6 +8,8 @@
 #include "imageoperations.h"
 #include <math.h>
 #include <cassert>
+#include <vector>
+#include <algorithm>
 
 //===========================================================================//
 // void ImageOperations::distanceTransform(QImage image, QImage* ret)        //
@@ -22,66 +24,94 @@
 //            point to the nearest feature point. The values in the masks    //
 //            are taken from Borgefors. The return image contains a visuali- //
 //            sation of the distances.                                       //
+//            The matrix is kept column by column on the heap. Within a      //
+//            column, all mask entries that don't refer to the same column   //
+//            are applied in one vectorizable pass, and only the in-column   //
+//            neighbor is propagated sequentially. This gives exactly the    //
+//            same distances as sliding the full 3x3 masks, in O(w*h).       //
 //===========================================================================//
 void ImageOperations::distanceTransform( const OpGrayImage& img,
     OpGrayImage& imgResult )
 {
-  double dist[img.width()+2][img.height()+2];           //
+  const int w = img.width();
+  const int h = img.height();
+  const int H = h+2;                                        // column length
   double a = 0.95509;                                       //
   double b = 1.36930;                                       //
   double max_dist = 255;                                    //
 
-  double fwd_mask[3][3] = {{ b,        a,        b       }, // Local distance
-                           { a,        max_dist, max_dist}, //  maps for
-                           { max_dist, max_dist, max_dist}};//  forward and
-  double bwd_mask[3][3] = {{ max_dist, max_dist, max_dist}, //  backward pass.
-                           { max_dist, max_dist, a       }, //
-                           { b,        a,        b       }};//
+  // Local distance maps for forward and backward pass (as in Borgefors):
+  //   fwd_mask = {{ b, a, b }, { a, max, max }, { max, max, max }}
+  //   bwd_mask = {{ max, max, max }, { max, max, a }, { b, a, b }}
+  // indexed by [x_m+1][y_m+1].
 
-  // init dist matrix //
-  for (int x=0; x<img.width()+2; x++)
-  {
-    dist[x][0] = max_dist;
-    dist[x][img.height()+1] = max_dist;
-  }
-  for (int y=0; y<img.height()+2; y++)
-  {
-    dist[0][y] = max_dist;
-    dist[img.width()+1][y] = max_dist;
-  }
+  // init dist matrix (column x starts at dist[x*H]) //
+  vector<double> vDist( (w+2)*H, max_dist );
+  vector<double> vTmp( H );
+  double *dist = &vDist[0];
+  double *t    = &vTmp[0];
 
   // init distance matrix with image features //
-  for (int y=0; y<img.height(); y++)                  // Initialize
-    for (int x=0; x<img.width(); x++)
-    {             //  distance matrix
-      dist[x+1][y+1] = img(x,y).value();          //  with features
-    }                                                 //  from image.
+  ImageView<GrayPixel> src = img.view();
+  for (int y=0; y<h; y++)                             // Initialize
+  {                                                   //  distance matrix
+    const GrayPixel *pRow = src.rowPtr(y);            //  with features
+    for (int x=0; x<w; x++)                           //  from image.
+      dist[(x+1)*H + y+1] = pRow[x].value();
+  }
 
   // Forward pass //
-  for (int x=1; x<img.width()+1; x++)
-    for (int y=1; y<img.height()+1; y++)
-      for (int y_m=-1; y_m<=1; y_m++)
-        for (int x_m=-1; x_m<=1; x_m++)
-          dist[x][y] = min( dist[x][y],
-                            dist[x+x_m][y+y_m] + fwd_mask[x_m+1][y_m+1] );
+  for (int x=1; x<w+1; x++)
+  {
+    const double *l = dist + (x-1)*H;                 // left column (final)
+    double       *c = dist + x*H;                     // current column
+    const double *r = dist + (x+1)*H;                 // right column (input)
+    for (int y=1; y<h+1; y++)
+    {
+      double d = c[y];
+      d = min( d, l[y-1] + b );
+      d = min( d, l[y]   + a );
+      d = min( d, l[y+1] + b );
+      d = min( d, c[y+1] + max_dist );
+      d = min( d, r[y-1] + max_dist );
+      d = min( d, r[y]   + max_dist );
+      d = min( d, r[y+1] + max_dist );
+      t[y] = d;
+    }
+    for (int y=1; y<h+1; y++)
+      c[y] = min( t[y], c[y-1] + a );
+  }
 
   // Backward pass //
-  for (int x=img.width(); x>0; x--)
-    for (int y=img.height(); y>0; y--)
-      for (int y_m=-1; y_m<=1; y_m++)
-        for (int x_m=-1; x_m<=1; x_m++)
-          dist[x][y] = min( dist[x][y],
-                            dist[x+x_m][y+y_m] + bwd_mask[x_m+1][y_m+1] );
+  for (int x=w; x>0; x--)
+  {
+    const double *l = dist + (x-1)*H;                 // left column (fwd)
+    double       *c = dist + x*H;                     // current column
+    const double *r = dist + (x+1)*H;                 // right column (final)
+    for (int y=1; y<h+1; y++)
+    {
+      double d = c[y];
+      d = min( d, r[y-1] + b );
+      d = min( d, r[y]   + a );
+      d = min( d, r[y+1] + b );
+      d = min( d, c[y-1] + max_dist );
+      d = min( d, l[y-1] + max_dist );
+      d = min( d, l[y]   + max_dist );
+      d = min( d, l[y+1] + max_dist );
+      t[y] = d;
+    }
+    for (int y=h; y>0; y--)
+      c[y] = min( t[y], c[y+1] + a );
+  }
 
   // create and fill return image //
-  OpGrayImage imgDt(img.width(), img.height());
-  for (int y=1; y<=img.height(); y++)                 // Determine
-    for (int x=1; x<=img.width(); x++)
-    {              //  color of each
-      float col_r = int(15*dist[x][y]);                 //  pixel depending
-
-      imgDt(x-1,y-1) = col_r;
-    }
+  OpGrayImage imgDt(w, h);
+  for (int y=0; y<h; y++)                             // Determine
+  {                                                   //  color of each
+    GrayPixel *pRow = imgDt.rowPtr(y);                //  pixel depending
+    for (int x=0; x<w; x++)                           //  on its distance.
+      pRow[x] = float( int(15*dist[(x+1)*H + y+1]) );
+  }
 
   imgResult = imgDt;
 }
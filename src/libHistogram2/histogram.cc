@@ -24,7 +24,7 @@
 #include <iomanip>
 #include <math.h>
 #include <values.h>   // for FLT_MAX
-#include <stdlib.h>   // for system()
+#include <stdlib.h>
 
 #include <qimage.h>
 
@@ -825,7 +825,7 @@ bool  Histogram::save( string filename )
 }
 
 
-void  Histogram::writeHeader( ofstream &ofile )
+void  Histogram::writeHeader( ostream &ofile )
 {
   /* write the number of dimensions */
   ofile << "Dimensions:" << endl;
@@ -842,7 +842,7 @@ void  Histogram::writeHeader( ofstream &ofile )
 }
 
 
-void  Histogram::writeData( ofstream &ofile )
+void  Histogram::writeData( ostream &ofile )
 {
   /* write the data key word */
   //ofile << "Data:" << endl;
@@ -900,7 +900,7 @@ bool  Histogram::load( string filename, bool verbose )
 }
 
 
-bool  Histogram::readHeader( ifstream &ifile, bool &isAscii, 
+bool  Histogram::readHeader( istream &ifile, bool &isAscii, 
 			     bool verbose )
 {
   /* read the next line => must be key word 'Dimensions:' */
@@ -961,7 +961,7 @@ bool  Histogram::readHeader( ifstream &ifile, bool &isAscii,
 }
 
 
-bool  Histogram::readData( ifstream &ifile, bool isAscii )
+bool  Histogram::readData( istream &ifile, bool isAscii )
 {
   /* read the next line => must be key word 'Data:' */
   string line;
@@ -1608,8 +1608,9 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
   /* Save the given vector of histograms to disk in text file format.*/
   /* The histograms will be saved under the given file name. If a    */
   /* file with this name already exists, it will be overwritten.     */
-  /* The parameter gzip specifies if the file shall be gzipped       */
-  /* after saving.                                                   */
+  /* The parameter gzip specifies if the file shall be gzipped. The  */
+  /* data is compressed in-process while writing; gzipped lists get  */
+  /* the extension .hlz (other names get an additional .gz).         */
   /*******************************************************************/
 {
   assert( vHistograms.size() > 0 );
@@ -1617,7 +1618,7 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
     assert( vHistograms[i].isValid() );
   }
 
-  ofstream ofile;
+  GzOutputStream ofile;
 
   /* check for the .hlz extension and change it into .hls */
   int pos;
@@ -1631,12 +1632,23 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
     if ( (pos=filename.rfind( ".gz" )) != string::npos )
       filename = filename.substr(0, pos);
 
+  if ( gzip )
+    filename = filename + ".gz";
+
+  /* check for the .hls.gz file extension and change it into .hlz */
+  if ( (pos=filename.rfind( ".hls.gz" )) != string::npos ) {
+    if ( verbose )
+      cout << "  shortening extension .hls.gz into .hlz..." << endl;
+    filename = filename.substr(0, pos) + ".hlz";
+  }
+
   /* try to open the file */
-  ofile.open( filename.c_str() );
+  ofile.open( filename, gzip );
   if ( !ofile ) {
     /* try to compensate for broken network connections */
     cerr << "Couldn't open output file, trying again... ";
-    ofile.open( filename.c_str() );
+    ofile.clear();
+    ofile.open( filename, gzip );
     if ( ofile )
       cerr << "SUCCESS!" << endl;
     else {
@@ -1646,6 +1658,8 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
       return false;
     }
   }
+  if ( verbose && gzip )
+    cout << "  writing gzipped..." << endl;
  
   /* write the key word 'HistogramList' */
   ofile << "HistogramList" << endl;
@@ -1678,21 +1692,10 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
 
   /* close the file */
   ofile.close();
-
-  if ( gzip ) {
-    /* gzip the file */
-    if ( verbose )
-      cout << "  gzipping..." << endl;
-    system( string("gzip -f " + filename).c_str() );
-    filename = filename + ".gz";
-  }
-
-  /* check for the .hls.gz file extension and change it into .hlz */
-  if ( (pos=filename.rfind( ".hls.gz" )) != string::npos ) {
-    if ( verbose )
-      cout << "  shortening extension .hls.gz into .hlz..." << endl;
-    filename = filename.substr(0, pos);
-    system( string("mv " + filename+".hls.gz " + filename+".hlz").c_str() );
+  if ( !ofile ) {
+    cerr << "Error in saveHistogramList(): Couldn't write file '" 
+         << filename << "'!" << endl;
+    return false;
   }
 
   return true;
@@ -1708,40 +1711,19 @@ bool loadHistogramList( string filename, vector<Histogram> &vHistograms,
   /* case of success, otherwise 'false'.                             */
   /*******************************************************************/
 {
- ifstream ifile;
+  /* compressed (.hlz, .gz) and plain files are read the same way */
+  GzInputStream ifile;
 
   /* clear this histogram */
   vHistograms.clear();
 
-  /* check for the .hlz file extension and change it into .hls.gz */
-  bool shortname = false;
-  string originalname = filename;
-  int  pos;
-  if ( (pos=filename.rfind( ".hlz" )) != string::npos ) {
-    if ( verbose )
-      cout << "  found suffix .hlz: changing into .hls.gz..." << endl;
-    system( string("mv " + filename + " " + filename.substr(0,pos) + 
-		   ".hls.gz").c_str() );
-    shortname = true;
-    filename = filename.substr(0, pos) + ".hls.gz";
-  }
-
-  /* check for the .gz file extension and gunzip the file if it's there */
-  bool gunzipped = false;
-  if ( (pos=filename.rfind( ".gz" )) != string::npos ) {
-    if ( verbose )
-      cout << "  found suffix .gz: gunzipping..." << endl;
-    system( string("gunzip -f " + filename).c_str() );
-    gunzipped = true;
-    filename = filename.substr(0, pos);
-  }
-
   /* try to open the file */
-  ifile.open( filename.c_str() );
+  ifile.open( filename );
   if ( !ifile ) {
     /* try to compensate for broken network connections */
     cerr << "Couldn't open input file, trying again... ";
-    ifile.open( filename.c_str() );
+    ifile.clear();
+    ifile.open( filename );
     if ( ifile )
       cout << "SUCCESS!" << endl;
     else {
@@ -1845,21 +1827,6 @@ bool loadHistogramList( string filename, vector<Histogram> &vHistograms,
 
   /* close the file */
   ifile.close();
-  
-  if ( gunzipped ) {
-    /* gzip the file */
-    if ( verbose )
-      cout << "  gzipping again..." << endl;
-    system( string("gzip -f " + filename).c_str() );
-  }
-
-  if ( shortname ) {
-    /* change the filename from .hls.gz to .hlz */
-    if ( verbose )
-      cout << "  restoring the original filename with extension .hlz..." 
-	   << endl;
-    system( string("mv " + filename + ".gz " + originalname).c_str() );
-  }
 
   return success;
 }
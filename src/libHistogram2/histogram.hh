@@ -139,10 +139,10 @@ public:
   bool  save( string filename );
   bool  load( string filename, bool verbose=false );
 
-  void  writeHeader( ofstream &ofile );
-  void  writeData( ofstream &ofile );
-  bool  readHeader( ifstream &ifile, bool &isAscii, bool verbose=false );
-  bool  readData( ifstream &ifile, bool isAscii=true );
+  void  writeHeader( ostream &ofile );
+  void  writeData( ostream &ofile );
+  bool  readHeader( istream &ifile, bool &isAscii, bool verbose=false );
+  bool  readData( istream &ifile, bool isAscii=true );
 
 public:
   /******************************************/
@@ -217,7 +217,7 @@ bool saveHistogramList( string filename, vector<Histogram> &vHistograms,
 bool loadHistogramList( string filename, vector<Histogram> &vHistograms, 
 			bool verbose=false );
 
-extern bool readKeyWord( ifstream &ifile, string KeyWords );
+extern bool readKeyWord( istream &ifile, string KeyWords );
 extern vector<string> extractWords( string WordList );
 
 void computeHistogramStatistics( vector<Histogram> vHistograms, 
@@ -0,0 +1,257 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         copybench.cc                                         */
+/*                                                                   */
+/* CONTENT      Allocation benchmark for the per-frame data flow of  */
+/*              the recognition. Loads a real codebook and its       */
+/*              occurrences, then runs the per-frame calls on them:  */
+/*              Codebook::getFeatures(), the codebook matching,      */
+/*              ISM::getOccurrences() and getOccMaps() for the       */
+/*              votes, and one Segmentation per hypothesis. Counts   */
+/*              the heap allocations per frame once with the copies  */
+/*              the former by-value accessors made, and once with    */
+/*              the current const-reference accessors.               */
+/*                                                                   */
+/*              Not part of the library; compile with                */
+/*                g++ -O3 -I. -I$(HOME)/code/include copybench.cc \  */
+/*                    -lISM2 -lCodebook2 -lFeatures -lGrayImage \    */
+/*                    -lqt -o copybench                              */
+/*              and run as                                           */
+/*                copybench <codebook> <occurrences> [#features] \   */
+/*                          [#hypos] [corr]                          */
+/*              The features of a frame are drawn from the codebook  */
+/*              features with added noise. With "corr", they are     */
+/*              matched by correlation (patch features), otherwise   */
+/*              by Euclidean distance.                               */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <featurevector.hh>
+#include <opgrayimage.hh>
+#include <codebook.hh>
+#include "ism.hh"
+#include "segmentation.hh"
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const int   NUM_FRAMES      = 20;
+const int   OCCS_PER_HYPO   = 200;   // votes that contribute to a hypothesis
+const float REJECT_THRESH   = 0.7;   // MatchingGUI defaults
+const float FEATURE_SIMFACT = 800.0;
+const float FEATURE_NOISE   = 0.05;
+
+
+/*---------------------------------------------------------*/
+/*                   Allocation Counting                   */
+/*---------------------------------------------------------*/
+static unsigned long g_nAllocs = 0;
+static unsigned long g_nBytes  = 0;
+
+void* operator new( size_t nSize ) throw( std::bad_alloc )
+{
+  g_nAllocs++;
+  g_nBytes += nSize;
+  void *p = malloc( nSize>0 ? nSize : 1 );
+  if( p == 0 )
+    throw std::bad_alloc();
+  return p;
+}
+
+
+void operator delete( void *p ) throw()
+{
+  free( p );
+}
+
+
+double getTime()
+{
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+/*---------------------------------------------------------*/
+/*                      Frame Workload                     */
+/*---------------------------------------------------------*/
+vector<FeatureVector> makeFrameFeatures( const Codebook &cbCodebook,
+                                         int nFeatures )
+  /* codebook features with some noise, so that they match */
+{
+  const vector<FeatureVector> &vCBFeatures = cbCodebook.getFeatures();
+  vector<FeatureVector> vFeatures;
+  for( int i=0; i<nFeatures; i++ ) {
+    FeatureVector fvFeature( vCBFeatures[rand() % vCBFeatures.size()] );
+    for( int d=0; d<fvFeature.numDims(); d++ )
+      fvFeature.at(d) += FEATURE_NOISE*( 2.0*rand()/(float)RAND_MAX - 1.0 );
+    vFeatures.push_back( fvFeature );
+  }
+  return vFeatures;
+}
+
+
+float processFrame( const Codebook &cbCodebook, const ISM &ismReco,
+                    const vector<FeatureVector> &vFeatures,
+                    int nHypos, bool bCorr, bool bCopy )
+  /*******************************************************************/
+  /* One recognition frame: match the extracted features against the */
+  /* codebook, collect the occurrences of the matched clusters, and  */
+  /* build one segmentation per hypothesis from the occurrence maps  */
+  /* of its votes. With bCopy=true, every accessor result is copied  */
+  /* into a local container, as the former by-value accessors did.   */
+  /*******************************************************************/
+{
+  float dResult = 0.0;
+
+  /* codebook features (the display and the statistics read them) */
+  vector<FeatureVector> vCopiedFeatures;
+  if( bCopy )
+    vCopiedFeatures = cbCodebook.getFeatures();
+  const vector<FeatureVector> &vCBFeatures = ( bCopy ? vCopiedFeatures :
+                                               cbCodebook.getFeatures() );
+  dResult += vCBFeatures.size();
+
+  /* codebook matching */
+  vector<int>            vNN;
+  vector<float>          vNNSim;
+  vector<vector<int> >   vvAllNeighbors;
+  vector<vector<float> > vvAllNeighborsSim;
+  if( bCorr )
+    cbCodebook.matchToCodebookCorr( vFeatures, REJECT_THRESH,
+                                    vNN, vNNSim,
+                                    vvAllNeighbors, vvAllNeighborsSim );
+  else {
+    float dDistFact = FEATURE_SIMFACT*vFeatures.front().numDims();
+    cbCodebook.matchToCodebookEuclid( vFeatures, REJECT_THRESH, dDistFact,
+                                      vNN, vNNSim,
+                                      vvAllNeighbors, vvAllNeighborsSim );
+  }
+
+  /* votes: the occurrences of all activated clusters */
+  VecVecOccurrence vvCopiedOccs;
+  if( bCopy )
+    vvCopiedOccs = ismReco.getOccurrences();
+  const VecVecOccurrence &vvOccurrences = ( bCopy ? vvCopiedOccs :
+                                            ismReco.getOccurrences() );
+  vector<int> vVoteMaps;
+  for( unsigned i=0; i<vvAllNeighbors.size(); i++ )
+    for( unsigned j=0; j<vvAllNeighbors[i].size(); j++ ) {
+      const vector<ClusterOccurrence> &vOccs =
+        vvOccurrences[vvAllNeighbors[i][j]];
+      for( unsigned k=0; k<vOccs.size(); k++ ) {
+        dResult += vvAllNeighborsSim[i][j]*vOccs[k].dWeight;
+        vVoteMaps.push_back( vOccs[k].nOccMapIdx );
+      }
+    }
+
+  /* segmentations from the occurrence maps of the votes */
+  for( int h=0; h<nHypos; h++ ) {
+    vector<OpGrayImage> vCopiedMaps;
+    if( bCopy )
+      vCopiedMaps = ismReco.getOccMaps();
+    const vector<OpGrayImage> &vOccMaps = ( bCopy ? vCopiedMaps :
+                                            ismReco.getOccMaps() );
+
+    int nSize = ( vOccMaps.empty() ? 1 : vOccMaps.front().width() );
+    OpGrayImage imgPFig( 3*nSize, 3*nSize );
+    for( int k=0; k<OCCS_PER_HYPO && !vVoteMaps.empty(); k++ ) {
+      int nMapIdx = vVoteMaps[(h*OCCS_PER_HYPO+k) % vVoteMaps.size()];
+      if( nMapIdx>=0 && nMapIdx<(int)vOccMaps.size() )
+        dResult += vOccMaps[nMapIdx].view()( 0, 0 ).value();
+    }
+    OpGrayImage imgPGnd = imgPFig;
+    OpGrayImage imgSeg  = imgPFig;
+
+    Segmentation segHypo( imgPFig, imgPGnd, imgSeg );
+    if( bCopy ) {
+      OpGrayImage imgFig = segHypo.getImgPFig();
+      OpGrayImage imgRes = segHypo.getImgSeg();
+      dResult += imgFig.width() + imgRes.width();
+    } else
+      dResult += ( segHypo.getImgPFig().width() +
+                   segHypo.getImgSeg().width() );
+  }
+
+  return dResult;
+}
+
+
+/*---------------------------------------------------------*/
+/*                       Main Program                      */
+/*---------------------------------------------------------*/
+int main( int argc, char **argv )
+{
+  if( argc<3 ) {
+    cerr << "Usage: " << argv[0] << " <codebook> <occurrences> "
+         << "[#features] [#hypos] [corr]" << endl;
+    return 1;
+  }
+  string sCodebook    = argv[1];
+  string sOccurrences = argv[2];
+  int    nFeatures    = ( argc>3 ? atoi( argv[3] ) : 1000 );
+  int    nHypos       = ( argc>4 ? atoi( argv[4] ) : 10 );
+  bool   bCorr        = ( argc>5 && strcmp( argv[5], "corr" )==0 );
+
+  double t0 = getTime();
+  Codebook cbCodebook;
+  cbCodebook.loadCodebook( sCodebook, false, false );
+  double t1 = getTime();
+  ISM ismReco( 0 );
+  ismReco.loadOccurrences( sOccurrences, cbCodebook.getNumClusters(), false );
+  double t2 = getTime();
+
+  if( cbCodebook.getNumClusters()<=0 || cbCodebook.getFeatures().empty() ) {
+    cerr << "Error: no clusters or features in " << sCodebook << "." << endl;
+    return 1;
+  }
+
+  cout << cbCodebook.getNumClusters() << " clusters ("
+       << fixed << setprecision(1) << 1000.0*(t1-t0) << " ms), "
+       << ismReco.getNumOccs() << " occurrences ("
+       << 1000.0*(t2-t1) << " ms), " << nFeatures << " features and "
+       << nHypos << " hypotheses per frame." << endl;
+
+  srand( 42 );
+  vector<FeatureVector> vFeatures = makeFrameFeatures( cbCodebook, nFeatures );
+
+  float dCheck[2] = { 0.0, 0.0 };
+  for( int nRun=0; nRun<2; nRun++ ) {
+    bool bCopy = ( nRun==0 );
+    unsigned long nAllocs = g_nAllocs;
+    unsigned long nBytes  = g_nBytes;
+    double tStart = getTime();
+    for( int f=0; f<NUM_FRAMES; f++ )
+      dCheck[nRun] += processFrame( cbCodebook, ismReco, vFeatures, nHypos,
+                                    bCorr, bCopy );
+    double tTotal = getTime() - tStart;
+
+    cout << ( bCopy ? "  by-value copies: " : "  const references:" )
+         << setw(9) << (g_nAllocs - nAllocs)/NUM_FRAMES << " allocs/frame, "
+         << setw(9) << (g_nBytes - nBytes)/NUM_FRAMES/1024 << " KB/frame, "
+         << setw(7) << setprecision(2) << 1000.0*tTotal/NUM_FRAMES
+         << " ms/frame" << endl;
+  }
+  cout << "  results " << ( dCheck[0]==dCheck[1] ? "identical." : "DIFFER!" )
+       << endl;
+
+  return 0;
+}
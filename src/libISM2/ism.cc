@@ -65,6 +65,8 @@
 #include <math.h>
 #include <algorithm>
 
+#include <parallelfor.hh>
+
 #include "occurrences.hh"
 #include "ism.hh"
 /*===================================================================*/
@@ -215,8 +217,15 @@ void ISM::finishOccurrences()
 void ISM::loadOccurrences( string sFileName, int nNumClusters, bool bVerbose )
 {
   m_nNumOccs = 0;
-  int nResult = ::loadOccurrences( sFileName, nNumClusters, 
-                                   m_vvOccurrences, bVerbose );
+  bool bBinary = isModelFile( sFileName );
+  int nResult;
+  if( bBinary )
+    nResult = ::loadOccurrencesBinary( sFileName, nNumClusters, 
+                                       m_vvOccurrences, m_vOccMaps, 
+                                       bVerbose );
+  else
+    nResult = ::loadOccurrences( sFileName, nNumClusters, 
+                                 m_vvOccurrences, bVerbose );
   if( nResult > 0 )
     m_nNumOccs = nResult;
 
@@ -229,8 +238,9 @@ void ISM::loadOccurrences( string sFileName, int nNumClusters, bool bVerbose )
       m_vOccSumWeights[i] += m_vvOccurrences[i][j].dWeight;
   }
 
-  /* try to load occurrence maps */
-  ::loadOccurrenceMaps( sFileName, m_vOccMaps, bVerbose );
+  /* try to load occurrence maps (already contained in binary files) */
+  if( !bBinary )
+    ::loadOccurrenceMaps( sFileName, m_vOccMaps, bVerbose );
 }
 
 
@@ -249,6 +259,12 @@ void ISM::saveOccurrencesMatlab( string sFileName, bool bVerbose )
 }
 
 
+void ISM::saveOccurrencesBinary( string sFileName, bool bVerbose )
+{
+  ::saveOccurrencesBinary( sFileName, m_vvOccurrences, m_vOccMaps, bVerbose );
+}
+
+
 void ISM::removeOccurrences( const vector<bool> &vIdzs )
 {
   if( vIdzs.size()!=m_vvOccurrences.size() ) {
@@ -288,9 +304,14 @@ void ISM::createVotingSpace  ( int nImgWidth, int nImgHeight, int nStepSize,
   /****************************************/
   /*   Initialize VotingSpace structure   */
   /****************************************/
+  int nStorageMode = ( m_parReco.params()->m_bSparseVotes ?
+                       VotingSpace::STORAGE_SPARSE :
+                       VotingSpace::STORAGE_DENSE );
+
   m_vsHoughVotes.clear();
   VotingSpace vsTemp( nImgWidth/nStepSize,  0.0, (float) nImgWidth,
-                      nImgHeight/nStepSize, 0.0, (float) nImgHeight );
+                      nImgHeight/nStepSize, 0.0, (float) nImgHeight,
+                      nStorageMode );
   m_vsHoughVotes = vsTemp;
 
   if( bVerbose ) {
@@ -329,10 +350,14 @@ void ISM::createVotingSpace  ( int nImgWidth, int nImgHeight, int nStepSize,
   if( nScaleSteps == 0 )
     nScaleSteps = 1;
 
+  int nStorageMode = ( m_parReco.params()->m_bSparseVotes ?
+                       VotingSpace::STORAGE_SPARSE :
+                       VotingSpace::STORAGE_DENSE );
+
   m_vsHoughVotes.clear();
   VotingSpace vsTemp2( nImgWidth/nStepSize,  0.0, (float) nImgWidth,
                        nImgHeight/nStepSize, 0.0, (float) nImgHeight,
-                       nScaleSteps, dScaleMin, dScaleMax );
+                       nScaleSteps, dScaleMin, dScaleMax, nStorageMode );
   m_vsHoughVotes = vsTemp2;
 
   if( bVerbose ) {
@@ -480,6 +505,84 @@ void ISM::doPatchVoting  ( VotingSpace &vsHoughVotes,
 }
 
 
+/*---------------------------------------------------------*/
+/* Thread task for the parallel patch voting: every thread */
+/* casts the votes of one contiguous block of interest     */
+/* points into its own buffer.                             */
+/*---------------------------------------------------------*/
+struct PatchVotingTask
+{
+  ISM                           *pISM;
+  int                            nVoteDims;
+  const PointVector             *pPoints;
+  const vector< vector<int> >   *pAllNeighbors;
+  const vector< vector<float> > *pAllNeighborsSim;
+  float                          dPrior;
+  float                          dRejectionThresh;
+  float                          dScaleMin;
+  float                          dScaleMax;
+  float                          dScaleCellSize;
+
+  vector< vector<HoughVote> >    vvVotes;
+  vector< PatchVotingStats >     vStats;
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    if( nVoteDims == 2 )
+      pISM->castPatchVotes2D( *pPoints, *pAllNeighbors, *pAllNeighborsSim,
+                              dPrior, dRejectionThresh, nBegin, nEnd,
+                              vvVotes[nThread], vStats[nThread] );
+    else
+      pISM->castPatchVotes3D( *pPoints, *pAllNeighbors, *pAllNeighborsSim,
+                              dPrior, dRejectionThresh, 
+                              dScaleMin, dScaleMax, dScaleCellSize,
+                              nBegin, nEnd, 
+                              vvVotes[nThread], vStats[nThread] );
+  }
+};
+
+
+bool ISM::runPatchVoting( VotingSpace                   &vsHoughVotes,
+                         PatchVotingTask               &task,
+                         PatchVotingStats              &stats )
+  /*******************************************************************/
+  /* Distribute the interest points over the voting threads and in-  */
+  /* sert the collected votes into the voting space in point order.  */
+  /* The resulting voting space is thus identical to the one of the  */
+  /* serial loop, independent of the number of threads. Returns      */
+  /* false if voting was aborted because of an invalid occurrence.   */
+  /*******************************************************************/
+{
+  int nPoints  = (int)task.pAllNeighbors->size();
+  int nThreads = getNumThreads( m_parReco.params()->m_nNumThreads, 
+                                nPoints );
+  task.vvVotes.clear();
+  task.vvVotes.resize( nThreads );
+  task.vStats.assign( nThreads, PatchVotingStats() );
+
+  nThreads = parallelFor( 0, nPoints, nThreads, task );
+
+  /* merge the thread-local vote buffers */
+  bool bAborted = false;
+  for( int t=0; t<nThreads && !bAborted; t++ ) {
+    vector<HoughVote> &vVotes = task.vvVotes[t];
+    for( int i=0; i<(int)vVotes.size(); i++ )
+      vsHoughVotes.insertVote( vVotes[i] );
+    vector<HoughVote>().swap( vVotes );
+
+    stats.nCountMatched += task.vStats[t].nCountMatched;
+    stats.nCountAll     += task.vStats[t].nCountAll;
+    stats.nCountWeights += task.vStats[t].nCountWeights;
+    stats.nCountVotes   += task.vStats[t].nCountVotes;
+    
+    /* stop at the same point as the serial loop would */
+    bAborted = task.vStats[t].bAborted;
+  }
+
+  return !bAborted;
+}
+
+
 void ISM::doPatchVoting2D( VotingSpace                   &vsHoughVotes, 
                            const PointVector             &vPoints,
                            const vector< vector<int> >   &vvAllNeighbors, 
@@ -490,12 +593,52 @@ void ISM::doPatchVoting2D( VotingSpace                   &vsHoughVotes,
   /* Collect all the patch votes for voting based on occurrences of  */
   /* codebook entries.                                               */
   /*******************************************************************/
+{
+  PatchVotingTask task;
+  task.pISM             = this;
+  task.nVoteDims        = 2;
+  task.pPoints          = &vPoints;
+  task.pAllNeighbors    = &vvAllNeighbors;
+  task.pAllNeighborsSim = &vvAllNeighborsSim;
+  task.dPrior           = dPrior;
+  task.dRejectionThresh = dRejectionThresh;
+  task.dScaleMin        = 0.0;
+  task.dScaleMax        = 0.0;
+  task.dScaleCellSize   = 0.0;
+
+  PatchVotingStats stats;
+  if( !runPatchVoting( vsHoughVotes, task, stats ) )
+    return;
+
+  if( bVerbose )
+    cout << "  done." << endl;
+
+  if( bVerbose ) {
+    cout << "  Debugging info for VotingSpace vsHoughVotes:" << endl;
+    vsHoughVotes.print();
+    vsHoughVotes.printContent();
+  }
+}
+
+
+void ISM::castPatchVotes2D( const PointVector             &vPoints,
+                            const vector< vector<int> >   &vvAllNeighbors, 
+                            const vector< vector<float> > &vvAllNeighborsSim,
+                            float dPrior, float dRejectionThresh,
+                            int nFirstPoint, int nLastPoint,
+                            vector<HoughVote>             &vVotes,
+                            PatchVotingStats              &stats )
+  /*******************************************************************/
+  /* Cast the 2D votes of the interest points in the range [nFirst-  */
+  /* Point,nLastPoint) into the vote buffer. This function only      */
+  /* reads the ISM, so it may be called from several threads.        */
+  /*******************************************************************/
 {
   /*******************************************/
   /*   Create hypotheses for object center   */
   /*******************************************/
   /* always use all matches */
-  for( int j=0; j<(int)vvAllNeighbors.size(); j++ ) 
+  for( int j=nFirstPoint; j<nLastPoint; j++ ) 
     for( int k=0; k<(int)vvAllNeighbors[j].size(); k++ ) 
       if( vvAllNeighborsSim[j][k] > dRejectionThresh ) {
         /* for all activated clusters */
@@ -510,6 +653,7 @@ void ISM::doPatchVoting2D( VotingSpace                   &vsHoughVotes,
             cerr << "  Warning: occurrence " << k << " of cluster " 
                  << clusterId << " has scale zero!" << endl;
             cerr << "  Patch voting aborted." << endl;
+            stats.bAborted = true;
             return;
           }
 
@@ -521,24 +665,16 @@ void ISM::doPatchVoting2D( VotingSpace                   &vsHoughVotes,
           int posY = (int) floor( vPoints[j].y - 
                                   m_vvOccurrences[clusterId][kk].dPosY*scale );
           int nOccMapIdx = m_vvOccurrences[clusterId][kk].nOccMapIdx;
-          vsHoughVotes.insertVote( HoughVote( (float)posX,
-                                              (float)posY,
-                                              (dWeight * dVoteWeight *
-                                               dOccWeight * dPrior),
-                                              (float)1.0,
-                                              j, clusterId, kk, nOccMapIdx,
-                                              m_nCue ) );
+          vVotes.push_back( HoughVote( (float)posX,
+                                       (float)posY,
+                                       (dWeight * dVoteWeight *
+                                        dOccWeight * dPrior),
+                                       (float)1.0,
+                                       j, clusterId, kk, nOccMapIdx,
+                                       m_nCue ) );
           
         }
       }
-  if( bVerbose )
-    cout << "  done." << endl;
-
-  if( bVerbose ) {
-    cout << "  Debugging info for VotingSpace vsHoughVotes:" << endl;
-    vsHoughVotes.print();
-    vsHoughVotes.printContent();
-  }
 }
 
 
@@ -569,22 +705,65 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
     dScaleRange = 1.0;
   float dScaleCellSize = dScaleRange / ((float)nScaleSteps);  
 
-  float dGibbsConst = -1.0 / ( m_parReco.params()->m_dGibbsConst*
-                               log(dRejectionThresh) );
-
   /* always use all matches */
   if( bVerbose )
     cout << "  Filling in the voting space..." << endl;
-  long nCountMatched = 0;
-  long nCountVotes = 0;
-  long nCountWeights = 0;
-  long nCountAll = 0;
-  for( unsigned j=0; j<vvAllNeighbors.size(); j++ ) {
+
+  PatchVotingTask task;
+  task.pISM             = this;
+  task.nVoteDims        = 3;
+  task.pPoints          = &vPoints;
+  task.pAllNeighbors    = &vvAllNeighbors;
+  task.pAllNeighborsSim = &vvAllNeighborsSim;
+  task.dPrior           = dPrior;
+  task.dRejectionThresh = dRejectionThresh;
+  task.dScaleMin        = dScaleMin;
+  task.dScaleMax        = dScaleMax;
+  task.dScaleCellSize   = dScaleCellSize;
+
+  PatchVotingStats stats;
+  if( !runPatchVoting( vsHoughVotes, task, stats ) )
+    return;
+  
+  if( bVerbose ) {
+    cout << "    Generated " << stats.nCountVotes << " votes." << endl;
+    cout << "      from " << stats.nCountMatched 
+         << " matched codebook entries." << endl;
+    if( m_parReco.params()->m_bRestrictScale )
+      cout << "      (discarded " << stats.nCountAll - stats.nCountWeights 
+           << " votes as outside of scale range)." << endl; 
+    cout << "      (discarded " << stats.nCountWeights - stats.nCountVotes
+         << " votes because of insufficient weight)." << endl; 
+    cout << "  done." << endl;
+  }
+}
+
+
+void ISM::castPatchVotes3D( const PointVector             &vPoints,
+                            const vector< vector<int> >   &vvAllNeighbors, 
+                            const vector< vector<float> > &vvAllNeighborsSim,
+                            float dPrior, float dRejectionThresh,
+                            float dScaleMin, float dScaleMax, 
+                            float dScaleCellSize,
+                            int nFirstPoint, int nLastPoint,
+                            vector<HoughVote>             &vVotes,
+                            PatchVotingStats              &stats )
+  /*******************************************************************/
+  /* Cast the 3D (x,y,scale) votes of the interest points in the     */
+  /* range [nFirstPoint,nLastPoint) into the vote buffer. This func- */
+  /* tion only reads the ISM, so it may be called from several       */
+  /* threads.                                                        */
+  /*******************************************************************/
+{
+  float dGibbsConst = -1.0 / ( m_parReco.params()->m_dGibbsConst*
+                               log(dRejectionThresh) );
+
+  for( int j=nFirstPoint; j<nLastPoint; j++ ) {
      
     if(vvAllNeighbors[j].size()==0)
 	continue;
     float dMatchWeight = 1.0 / (float)vvAllNeighbors[j].size();
-    vector<float> vMatchWeight( vvAllNeighbors.size(), dMatchWeight );
+    vector<float> vMatchWeight( vvAllNeighbors[j].size(), dMatchWeight );
     
     /*----------------------------------------*/
     /* Prepare the Gibbs distribution weights */
@@ -607,7 +786,7 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
       if( vvAllNeighborsSim[j][k] > dRejectionThresh ) {
         /* for all activated clusters */
         int clusterId = vvAllNeighbors[j][k];
-        nCountMatched++;
+        stats.nCountMatched++;
 
         /* process all valid hypotheses for this cluster */
         int nNumHypos = (int)( m_vvOccurrences[clusterId].size() );
@@ -628,6 +807,7 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
             cerr << "  Warning: occurrence " << kk << " of cluster " 
                  << clusterId << " has scale zero!" << endl;
             cerr << "  Patch voting aborted." << endl;
+            stats.bAborted = true;
             return;
           }
           
@@ -638,7 +818,7 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
           float dOccWeight = m_vvOccurrences[clusterId][kk].dWeight;
           int   nOccMapIdx = m_vvOccurrences[clusterId][kk].nOccMapIdx;
 
-          nCountAll++;
+          stats.nCountAll++;
           if( m_parReco.params()->m_bRestrictScale )
             /* if scale is out of range, don't store the vote */
             if( (dScale < dScaleMin - dScaleCellSize) || 
@@ -665,7 +845,7 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
           float dWeight = (vMatchWeight[k] * dOccWeight*dOccWeightNorm * 
                            dPrior);
 
-          nCountWeights++;
+          stats.nCountWeights++;
           /* if vote weight is too small, don't store the vote */
           if(dWeight < m_parReco.params()->m_dMinVoteWeight)
             continue;
@@ -674,14 +854,14 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
           if( dWeight > m_parReco.params()->m_dMaxVoteWeight||!(dWeight ==dWeight ))
             dWeight = m_parReco.params()->m_dMaxVoteWeight;
 
-          vsHoughVotes.insertVote( HoughVote( dPosX, dPosY, dScale,
-                                              dWeight, 1.0, (int)j, 
-                                              clusterId, kk, nOccMapIdx,
-                                            m_nCue ) );
+          vVotes.push_back( HoughVote( dPosX, dPosY, dScale,
+                                       dWeight, 1.0, j, 
+                                       clusterId, kk, nOccMapIdx,
+                                       m_nCue ) );
           if(dWeight < 0){
 	    cout<<"   err: nagtive dWeight detected!" <<endl; 
 	  }
-          nCountVotes++;
+          stats.nCountVotes++;
         }
       } else {
         cerr << "    WARNING in ISM::doPatchVoting3D(): "
@@ -689,18 +869,6 @@ void ISM::doPatchVoting3D( VotingSpace                   &vsHoughVotes,
              << endl;
       }
   }
-  
-  if( bVerbose ) {
-    cout << "    Generated " << nCountVotes << " votes." << endl;
-    cout << "      from " << nCountMatched << " matched codebook entries." 
-         << endl;
-    if( m_parReco.params()->m_bRestrictScale )
-      cout << "      (discarded " << nCountAll - nCountWeights 
-           << " votes as outside of scale range)." << endl; 
-    cout << "      (discarded " << nCountWeights - nCountVotes
-         << " votes because of insufficient weight)." << endl; 
-    cout << "  done." << endl;
-  }
 }
 
 
@@ -883,6 +1051,98 @@ HypoVec ISM::getPatchHypotheses2D( const PointVector &vPoints,
 }
   
 
+/*---------------------------------------------------------*/
+/* Thread task for the parallel MSME search: every thread  */
+/* refines one contiguous block of start points.           */
+/*---------------------------------------------------------*/
+struct MSMESeedTask
+{
+  VotingSpace                 *pVotingSpace;
+  const vector<FeatureVector> *pSeeds;
+  const vector<FeatureVector> *pModes;
+  FeatureVector                fvWindowSize;
+  bool                         bAdaptiveScale;
+  float                        dAdaptMinScale;
+  bool                         bUseFastMSME;
+  float                        dBasinSize;
+
+  vector<FeatureVector>       *pResults;
+  vector<float>               *pScores;
+  vector<int>                 *pModeIdzs;
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    for( int i=nBegin; i<nEnd; i++ )
+      pVotingSpace->applyMSME( (*pSeeds)[i], fvWindowSize, 
+                               (*pResults)[i], (*pScores)[i],
+                               bAdaptiveScale, dAdaptMinScale, bUseFastMSME,
+                               *pModes, dBasinSize, (*pModeIdzs)[i] );
+  }
+};
+
+
+void ISM::refineMaximaMSME( const vector<FeatureVector> &vSeeds,
+                            bool bAdaptiveScale, float dAdaptMinScale,
+                            vector<FeatureVector>       &vResults,
+                            vector<float>               &vScores )
+  /*******************************************************************/
+  /* Run the MSME search from every start point, using the window    */
+  /* size currently set in the voting space. The searches only read  */
+  /* the voting space and are distributed over m_nNumThreads threads */
+  /* (results are stored per start point, so they do not depend on   */
+  /* the number of threads).                                         */
+  /*                                                                 */
+  /* If m_bMSMEEarlyStop is set, the start points are processed in   */
+  /* waves of fixed size, and a search is stopped as soon as it      */
+  /* enters the basin of a mode found in one of the previous waves.  */
+  /* It then takes over the position and score of that mode.         */
+  /*******************************************************************/
+{
+  const int   MSME_WAVE_SIZE   = 64;
+  const float MSME_BASIN_SIZE  = 0.1;
+
+  int nSeeds = (int)vSeeds.size();
+  vResults.assign( nSeeds, FeatureVector() );
+  vScores.assign( nSeeds, 0.0 );
+  vector<int> vModeIdzs( nSeeds, -1 );
+
+  /* make the voting space safe for concurrent queries */
+  m_vsHoughVotes.finishVoting();
+
+  bool bEarlyStop = m_parReco.params()->m_bMSMEEarlyStop;
+  vector<FeatureVector> vModes;
+  vector<float>         vModeScores;
+
+  MSMESeedTask task;
+  task.pVotingSpace   = &m_vsHoughVotes;
+  task.pSeeds         = &vSeeds;
+  task.pModes         = &vModes;
+  task.fvWindowSize   = m_vsHoughVotes.getWindowSize();
+  task.bAdaptiveScale = bAdaptiveScale;
+  task.dAdaptMinScale = dAdaptMinScale;
+  task.bUseFastMSME   = false;
+  task.dBasinSize     = ( bEarlyStop ? MSME_BASIN_SIZE : 0.0 );
+  task.pResults       = &vResults;
+  task.pScores        = &vScores;
+  task.pModeIdzs      = &vModeIdzs;
+
+  int nWaveSize = ( bEarlyStop ? MSME_WAVE_SIZE : nSeeds );
+  for( int nFirst=0; nFirst<nSeeds; nFirst+=nWaveSize ) {
+    int nLast = min( nFirst+nWaveSize, nSeeds );
+    parallelFor( nFirst, nLast, m_parReco.params()->m_nNumThreads, task );
+
+    /* collect the modes found in this wave (in start point order) */
+    for( int i=nFirst; i<nLast; i++ )
+      if( vModeIdzs[i] >= 0 )
+        vScores[i] = vModeScores[vModeIdzs[i]];
+      else if( bEarlyStop ) {
+        vModes.push_back( vResults[i] );
+        vModeScores.push_back( vScores[i] );
+      }
+  }
+}
+
+
 HypoVec ISM::getPatchHypotheses3D( const PointVector &vPoints,
                                    int   nStepSize,
                                    bool  bExtendSearch, 
@@ -977,6 +1237,10 @@ HypoVec ISM::getPatchHypotheses3D( const PointVector &vPoints,
     if( m_parReco.params()->m_bUseFastMSME )
     cout << "    (using fast approximate MSME)" << endl;
   }
+  if( m_parReco.params()->m_bIntegralVotes )
+    /* precompute the summed-volume table for the window sums */
+    m_vsHoughVotes.buildIntegralTable();
+
   long nCountEmpty = 0;
   for( int y=miny, yy=0; y<maxy; y++, yy++ )
     for( int x=minx, xx=0; x<maxx; x++, xx++ )
@@ -1041,47 +1305,52 @@ HypoVec ISM::getPatchHypotheses3D( const PointVector &vPoints,
   HypoVec vHypotheses;
   float dThresh = m_parReco.params()->m_dScoreThreshSingle;
   m_vsHoughVotes.setWindowSize( dMSMESizeX, dMSMESizeY, dMSMESizeS );
+
+  /* collect the MSME start points */
+  vector<FeatureVector> vSeeds;
   for( int s=0; s<nScaleSteps; s++ )
     for( int y=0; y<vImgMaxima[s].height(); y++ )
       for( int x=0; x<vImgMaxima[s].width(); x++ )
         if( (vImgMaxima[s](x,y).value() >= 0.15*max) && 
             (vImgMaxima[s](x,y).value() >= 0.9*dThresh) ) {
-          /*-------------------------------*/
-          /* Refine the maximum using MSME */
-          /*-------------------------------*/
           FeatureVector fvStart( 3 );
           fvStart.setValue( 0, (x-nAddedRangeX/nStepSize+0.5)*dCellSizeX );
           fvStart.setValue( 1, (y-nAddedRangeY/nStepSize+0.5)*dCellSizeY );
           fvStart.setValue( 2, dScaleMin+(s+0.5)*dCellSizeS );
-          
-          FeatureVector fvResult( 3 );
-          float dScore;
-          
-          //m_vsHoughVotes.applyMSME( fvStart, fvResult, dScore, 
-          //                          bAdaptiveScale, dAdaptMinScale,
-          //                          m_parReco.params()->m_bUseFastMSME );
-          m_vsHoughVotes.applyMSME( fvStart, fvResult, dScore, 
-                                    bAdaptiveScale, dAdaptMinScale );
-
-          if( dScore >= 0.9*dThresh ) {
-            Hypothesis newHypo;
-            newHypo.x           = (int)fvResult.at(0);
-            newHypo.y           = (int)fvResult.at(1);
-            newHypo.dScale      = (float)fvResult.at(2);
-            newHypo.dScore      = dScore;
-            newHypo.nCategory   = m_nCategory;
-            newHypo.nPose       = -1;
-            newHypo.dAngle      = 0.0;
-            newHypo.dAspect     = -1.0;
-            newHypo.bPoseFlipped= false;
-            newHypo.nTemplateId = -1;
-            newHypo.dAreaFactor = 1.0;
-            newHypo.dRealDist   = -1.0;
-            newHypo.dRealSize   = -1.0;
-                    
-            vHypotheses.push_back( newHypo );
-          }
+          vSeeds.push_back( fvStart );
         }
+
+  /*-------------------------------*/
+  /* Refine the maxima using MSME  */
+  /*-------------------------------*/
+  vector<FeatureVector> vResults;
+  vector<float>         vScores;
+  refineMaximaMSME( vSeeds, bAdaptiveScale, dAdaptMinScale, 
+                    vResults, vScores );
+
+  for( int i=0; i<(int)vSeeds.size(); i++ ) {
+    FeatureVector &fvResult = vResults[i];
+    float          dScore   = vScores[i];
+
+    if( dScore >= 0.9*dThresh ) {
+      Hypothesis newHypo;
+      newHypo.x           = (int)fvResult.at(0);
+      newHypo.y           = (int)fvResult.at(1);
+      newHypo.dScale      = (float)fvResult.at(2);
+      newHypo.dScore      = dScore;
+      newHypo.nCategory   = m_nCategory;
+      newHypo.nPose       = -1;
+      newHypo.dAngle      = 0.0;
+      newHypo.dAspect     = -1.0;
+      newHypo.bPoseFlipped= false;
+      newHypo.nTemplateId = -1;
+      newHypo.dAreaFactor = 1.0;
+      newHypo.dRealDist   = -1.0;
+      newHypo.dRealSize   = -1.0;
+              
+      vHypotheses.push_back( newHypo );
+    }
+  }
   
   /*************************************/
   /*   Recover the dominant rotation   */
@@ -1926,6 +2195,74 @@ OpGrayImage ISM::drawVotePatches( /*const*/ list<HoughVote>  &vVotes,
 /***********************************************************/
 
 
+/*---------------------------------------------------------*/
+/* Helpers for drawSegmentation*(): accumulate the occur-  */
+/* rence maps and average them directly on the image rows. */
+/*---------------------------------------------------------*/
+static void addSegmentationPatch( const OpGrayImage &imgPatch, float dConf,
+                                  int minx, int miny, int maxx, int maxy,
+                                  int minxx, int minyy, int maxxx, int maxyy,
+                                  OpGrayImage &imgSeg, OpGrayImage &imgPFig,
+                                  OpGrayImage &imgPGnd, 
+                                  OpGrayImage &imgValsPerPixel )
+  /*******************************************************************/
+  /* Add the (rescaled) occurrence map imgPatch, whose region        */
+  /* [minxx,maxxx)x[minyy,maxyy) covers [minx,maxx)x[miny,maxy) in   */
+  /* the result images, to the segmentation accumulators. Patch      */
+  /* pixels < 0 are not part of the map.                             */
+  /*******************************************************************/
+{
+  ImageView<GrayPixel> patch = imgPatch.view();
+  maxyy = min( maxyy, patch.height() );
+  maxxx = min( maxxx, patch.width() );
+  if( minxx < 0 || minyy < 0 )
+    return;
+
+  for( int y=miny, yy=minyy; (y<maxy) && (yy<maxyy); y++, yy++ ) {
+    const GrayPixel *pPatch = patch.rowPtr( yy );
+    GrayPixel *pSeg  = imgSeg.rowPtr( y );
+    GrayPixel *pPFig = imgPFig.rowPtr( y );
+    GrayPixel *pPGnd = imgPGnd.rowPtr( y );
+    GrayPixel *pVals = imgValsPerPixel.rowPtr( y );
+    for( int x=minx, xx=minxx; (x<maxx) && (xx<maxxx); x++, xx++ ) {
+      float dPatchValRaw = pPatch[xx].value();
+      if( dPatchValRaw >= 0.0 ) {
+        float dPatchVal = dPatchValRaw/255.0;
+        pSeg[x]  = pSeg[x].value()  + dPatchValRaw;
+        pPFig[x] = pPFig[x].value() + dPatchVal*dConf;
+        pPGnd[x] = pPGnd[x].value() + (1.0-dPatchVal)*dConf;
+        pVals[x] = pVals[x].value() + 1.0;
+      }
+    }
+  }
+}
+
+
+static float normalizeSegmentation( OpGrayImage &imgSeg, 
+                                    const OpGrayImage &imgValsPerPixel,
+                                    bool bBackgroundZero )
+  /* average the accumulated patches; returns the max. count/pixel */
+{
+  float dMaxVal = 0.0;
+  ImageView<GrayPixel> vals = imgValsPerPixel.view();
+  for( int y=0; y<imgSeg.height(); y++ ) {
+    const GrayPixel *pVals = vals.rowPtr( y );
+    GrayPixel       *pSeg  = imgSeg.rowPtr( y );
+    for( int x=0; x<imgSeg.width(); x++ ) {
+      if( pVals[x].value() != 0.0 )
+        pSeg[x] = pSeg[x].value() / pVals[x].value();
+      else 
+        if( !bBackgroundZero )
+          pSeg[x] = 100.0;  
+
+      if( pVals[x].value() > dMaxVal )
+        dMaxVal = pVals[x].value();
+    }
+  }
+  return dMaxVal;
+}
+
+
 void ISM::drawSegmentation( const vector<HoughVote>    &vVotes,
                             const PointVector         &vPoints,
                             const FeatureCue          &parFeatures,
@@ -2071,34 +2408,14 @@ void ISM::drawSegmentation( const list<HoughVote>     &vVotes,
       int maxxx= min( nTargetSize, maxx-posx ); 
       int maxyy= min( nTargetSize, maxy-posy );
       float dConf = it->getValue();
-      for( int y=miny, yy=minyy; (y<maxy) && (yy<maxyy); y++, yy++ )
-        for( int x=minx, xx=minxx; (x<maxx) && (xx<maxxx); x++, xx++ ) {
-          float dPatchValRaw = imgPatch(xx,yy).value();
-          if( dPatchValRaw >= 0.0 ) {
-            float dPatchVal    = dPatchValRaw/255.0;
-            imgSeg(x,y)  = imgSeg(x,y).value()  + dPatchValRaw;
-            imgPFig(x,y) = imgPFig(x,y).value() + dPatchVal*dConf;
-            imgPGnd(x,y) = imgPGnd(x,y).value() + (1.0-dPatchVal)*dConf;
-            imgValsPerPixel(x,y) = imgValsPerPixel(x,y).value() + 1.0;
-            //int idx = y*w+x;
-            //fimgSegFast[idx] += dPatchValRaw;
-            //fimgPFigFast[idx] += dPatchVal*dConf;
-            //fimgPGndFast[idx] += (1.0-dPatchVal)*dConf;
-            //iimgValsPerPixel[idx]++;
-            
-          }
-        }
+      addSegmentationPatch( imgPatch, dConf, minx, miny, maxx, maxy,
+                            minxx, minyy, maxxx, maxyy,
+                            imgSeg, imgPFig, imgPGnd, imgValsPerPixel );
       
     }
   
   /* compute the average over all added patches */
-  for( int y=0; y<imgSeg.height(); y++ )
-    for( int x=0; x<imgSeg.width(); x++ )
-      if( imgValsPerPixel(x,y).value() != 0.0 )
-        imgSeg(x,y) = imgSeg(x,y).value() / imgValsPerPixel(x,y).value();
-      else 
-        if( !bBackgroundZero )
-          imgSeg(x,y) = 100.0;  
+  normalizeSegmentation( imgSeg, imgValsPerPixel, bBackgroundZero );
   //for( int y=0; y<h; y++ )
   //  for( int x=0; x<w; x++ ) {
   //    int idx = y*w+x;
@@ -2316,42 +2633,15 @@ void ISM::drawSegmentationOffset( const list<HoughVote>   &vVotes,
       int maxxx= min( nTargetSize, maxx-posx ); 
       int maxyy= min( nTargetSize, maxy-posy );
       float dConf = it->getValue();
-      for( int y=miny, yy=minyy; (y<maxy) && (yy<maxyy); y++, yy++ )
-        for( int x=minx, xx=minxx; (x<maxx) && (xx<maxxx); x++, xx++ ) {
-          float dPatchValRaw = imgPatch(xx,yy).value();
-          if( dPatchValRaw >= 0.0 ) {
-            float dPatchVal    = dPatchValRaw/255.0;
-            imgSeg(x,y)  = imgSeg(x,y).value()  + dPatchValRaw;
-            imgPFig(x,y) = imgPFig(x,y).value() + dPatchVal*dConf;
-            imgPGnd(x,y) = imgPGnd(x,y).value() + (1.0-dPatchVal)*dConf;
-            imgValsPerPixel(x,y) = imgValsPerPixel(x,y).value() + 1.0;
-          
-//         int idx1 = yy*imgsize + xx;
-//         int idx2 = y*fastsize + x;
-//         float dPatchValRaw = imgPatch(xx,yy).value();
-//         float dPatchVal    = dPatchValRaw/255.0;
-//         fimgSegFast[idx2]  += dPatchValRaw;
-//         fimgPFigFast[idx2] += dPatchVal*dConf;
-//         fimgPGndFast[idx2] += (1.0-dPatchVal)*dConf;
-//         imgValsPerPixel(x,y) = imgValsPerPixel(x,y).value() + 1.0;
-        }
-        }
+      addSegmentationPatch( imgPatch, dConf, minx, miny, maxx, maxy,
+                            minxx, minyy, maxxx, maxyy,
+                            imgSeg, imgPFig, imgPGnd, imgValsPerPixel );
       
     }
   
   /* compute the average over all added patches */
-  float dMaxVal = 0.0;
-  for( int y=0; y<imgSeg.height(); y++ )
-    for( int x=0; x<imgSeg.width(); x++ ) {
-      if( imgValsPerPixel(x,y).value() != 0.0 )
-        imgSeg(x,y) = imgSeg(x,y).value() / imgValsPerPixel(x,y).value();
-      else 
-        if( !bBackgroundZero )
-          imgSeg(x,y) = 100.0;  
-
-      if( imgValsPerPixel(x,y).value() > dMaxVal )
-        dMaxVal = imgValsPerPixel(x,y).value();
-    }
+  float dMaxVal = normalizeSegmentation( imgSeg, imgValsPerPixel, 
+                                         bBackgroundZero );
 
   if( bVerbose )
     cout << "        (max pixel val=" << dMaxVal << ")." << endl
@@ -2551,6 +2841,76 @@ OpGrayImage ISM::createAffinePatch ( OpGrayImage img, InterestPoint pt,
 /*                     MDL Verification                    */
 /***********************************************************/
 
+/*---------------------------------------------------------*/
+/* Segmentation of one hypothesis, cropped to the bounding */
+/* box of the pixels that can change its scores or those   */
+/* of other hypotheses (seg!=0, pfig!=0, or pgnd<0).       */
+/*---------------------------------------------------------*/
+struct MDLRegion
+{
+  int           nX0, nY0, nX1, nY1;  // bounding box (inclusive)
+  int           nWidth;              // 0 if the region is empty
+  vector<float> vSeg;
+  vector<float> vPFig;
+  vector<float> vPGnd;
+  bool          bChanged;
+};
+
+
+static void extractMDLRegion( const OpGrayImage &imgSeg, 
+                              const OpGrayImage &imgPFig,
+                              const OpGrayImage &imgPGnd,
+                              MDLRegion &rRegion )
+{
+  int w = imgPFig.width();
+  int h = imgPFig.height();
+  assert( imgSeg.width()==w  && imgPGnd.width()==w );
+  assert( imgSeg.height()==h && imgPGnd.height()==h );
+
+  /* find the bounding box */
+  rRegion.nX0 = w; rRegion.nY0 = h;
+  rRegion.nX1 = -1; rRegion.nY1 = -1;
+  for( int y=0; y<h; y++ )
+    for( int x=0; x<w; x++ )
+      if( imgSeg(x,y).value()!=0.0 || imgPFig(x,y).value()!=0.0 ||
+          imgPGnd(x,y).value()<0.0 ) {
+        rRegion.nX0 = min( rRegion.nX0, x );
+        rRegion.nY0 = min( rRegion.nY0, y );
+        rRegion.nX1 = max( rRegion.nX1, x );
+        rRegion.nY1 = max( rRegion.nY1, y );
+      }
+  rRegion.bChanged = false;
+  if( rRegion.nX1 < 0 ) {
+    rRegion.nX0 = rRegion.nY0 = 0;
+    rRegion.nWidth = 0;
+    return;
+  }
+
+  /* copy the contents */
+  rRegion.nWidth = rRegion.nX1 - rRegion.nX0 + 1;
+  int nHeight    = rRegion.nY1 - rRegion.nY0 + 1;
+  rRegion.vSeg.resize ( rRegion.nWidth*nHeight );
+  rRegion.vPFig.resize( rRegion.nWidth*nHeight );
+  rRegion.vPGnd.resize( rRegion.nWidth*nHeight );
+  for( int y=rRegion.nY0, i=0; y<=rRegion.nY1; y++ )
+    for( int x=rRegion.nX0; x<=rRegion.nX1; x++, i++ ) {
+      rRegion.vSeg[i]  = imgSeg(x,y).value();
+      rRegion.vPFig[i] = imgPFig(x,y).value();
+      rRegion.vPGnd[i] = imgPGnd(x,y).value();
+    }
+}
+
+
+static float sumMDLRegion( const vector<float> &vValues )
+  /* same summation order (and thus result) as OpGrayImage::getSum() */
+{
+  float sum = 0.0;
+  for( unsigned i=0; i<vValues.size(); i++ )
+    sum += vValues[i];
+  return sum;
+}
+
+
 vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
                                         vector<OpGrayImage> &vImgSegment,
                                         vector<OpGrayImage> &vImgPFig,
@@ -2583,6 +2943,11 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
                                         bool bVerbose )
   /*******************************************************************/
   /* Perform the MDL hypothesis selection step.                      */
+  /* The segmentations are only processed within the bounding box of */
+  /* their support, and after each selection only the hypotheses     */
+  /* that overlap the chosen one are updated. The scores (and thus   */
+  /* the rankings) are exactly the same as when processing the full  */
+  /* images.                                                         */
   /* WARNING: The contents of the image vectors WILL BE CHANGED!!!   */
   /*******************************************************************/
 {
@@ -2599,6 +2964,14 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
   float dAdaptMinMDLScale  = m_parReco.params()->m_dAdaptMinMDLScale;
   float dAdaptMinMDLScale2 = dAdaptMinMDLScale*dAdaptMinMDLScale;
 
+  /*-----------------------------------------*/
+  /* Crop the segmentations to their support */
+  /*-----------------------------------------*/
+  vector<MDLRegion> vRegions( vHypos.size() );
+  for( int k=0; k<(int)vHypos.size(); k++ )
+    extractMDLRegion( vImgSegment[k], vImgPFig[k], vImgPGnd[k], 
+                      vRegions[k] );
+
   /*----------------------------*/
   /* Compute the SumPFig values */
   /*----------------------------*/
@@ -2610,7 +2983,7 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
       printHypothesis( vHypos[k] );
     }
 
-    vFigArea[k] = vImgSegment[k].getSum()/255.0;
+    vFigArea[k] = sumMDLRegion( vRegions[k].vSeg )/255.0;
     vScore[k]   = dWeightPFig*vSumPFig[k] + (1.0-dWeightPFig)*vFigArea[k];
 
     if( bVerbose )
@@ -2647,6 +3020,12 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
   vRanks.clear();
   int nChosen = 0;
   bool bFinished = false;
+  vector<bool>  vUpdated( (int)vHypos.size(), false );
+  vector<float> vRawFigArea( (int)vHypos.size() );
+  vector<float> vRawSumPFig( (int)vHypos.size() );
+  vector<float> vRawScore  ( (int)vHypos.size() );
+  vector<float> vNormScore ( (int)vHypos.size() );
+  vector<char>  vMask;
   while( nChosen<(int)vHypos.size() && !bFinished ) {
     
     /*---------------------------------------*/
@@ -2678,6 +3057,25 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
       if( bVerbose )
         cout << "  Selected hypothesis " << nMaxIdx+1 << endl;
       
+      /*------------------------------------------------*/
+      /* Get the area claimed by the chosen hypothesis  */
+      /* (pfig > pgnd, inside the Hough space extent)   */
+      /*------------------------------------------------*/
+      const MDLRegion &rChosen = vRegions[nMaxIdx];
+      int nMinX = rChosen.nX0;
+      int nMinY = rChosen.nY0;
+      int nMaxX = min( rChosen.nX1, w-1 );
+      int nMaxY = min( rChosen.nY1, h-1 );
+      int nMaskW = max( nMaxX-nMinX+1, 0 );
+      int nMaskH = max( nMaxY-nMinY+1, 0 );
+      vMask.assign( nMaskW*nMaskH, 0 );
+      for( int y=0; y<nMaskH; y++ ) {
+        int nOff = (nMinY-rChosen.nY0+y)*rChosen.nWidth + nMinX-rChosen.nX0;
+        for( int x=0; x<nMaskW; x++ )
+          vMask[y*nMaskW+x] = ( rChosen.vPFig[nOff+x] > 
+                                rChosen.vPGnd[nOff+x] );
+      }
+
       /*---------------------------------*/
       /* Update the remaining hypotheses */
       /*---------------------------------*/
@@ -2685,41 +3083,43 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
         if( !vChosen[k] ) {
           
           /* remove the overlapping area */
-          for( int y=0; y<h; y++ )
-            for( int x=0; x<w; x++ ) //{
-              if( vImgPFig[nMaxIdx](x,y).value() > 
-                  vImgPGnd[nMaxIdx](x,y).value() ) {
-                vImgSegment[k](x,y) = 0.0;
-                vImgPFig[k](x,y)    = 0.0;
-              }
-          vFigArea[k] = vImgSegment[k].getSum()/255.0;
-
-          vSumPFig[k] = vImgPFig[k].getSum();
-          //float dSum = 0.0;
-          //for( int y=0; y<(int)vImgPFig[k].height(); y++ )
-          //  for( int x=0; x<(int)vImgPFig[k].width(); x++ ) {
-          //    float val = vImgPFig[k](x,y).value();
-          //    if( val > vImgPGnd[k](x,y).value() )
-          //      dSum += val;
-          //  }
-          //vSumPFig[k] = dSum;
-          vScore[k] = dWeightPFig*vSumPFig[k] + (1.0-dWeightPFig)*vFigArea[k];
+          MDLRegion &rOther = vRegions[k];
+          bool bChanged = false;
+          int minx, miny, maxx, maxy;
+          if( nMaskW>0 && nMaskH>0 && rOther.nWidth>0 &&
+              checkOverlap( nMinX, nMinY, nMaxX, nMaxY,
+                            rOther.nX0, rOther.nY0, rOther.nX1, rOther.nY1,
+                            minx, miny, maxx, maxy ) )
+            for( int y=miny; y<=maxy; y++ ) {
+              const char *pMask = &vMask[(y-nMinY)*nMaskW - nMinX];
+              int nOff = (y-rOther.nY0)*rOther.nWidth - rOther.nX0;
+              for( int x=minx; x<=maxx; x++ )
+                if( pMask[x] ) {
+                  rOther.vSeg [nOff+x] = 0.0;
+                  rOther.vPFig[nOff+x] = 0.0;
+                  bChanged = true;
+                }
+            }
+          if( bChanged )
+            rOther.bChanged = true;
+
+          /* the scores only need to be recomputed if the segmentation */
+          /* has changed (or if they still come from the caller)       */
+          if( bChanged || !vUpdated[k] ) {
+            vUpdated[k] = true;
+            vFigArea[k] = sumMDLRegion( rOther.vSeg )/255.0;
+            vSumPFig[k] = sumMDLRegion( rOther.vPFig );
+            vScore[k] = dWeightPFig*vSumPFig[k] + (1.0-dWeightPFig)*vFigArea[k];
+            vRawFigArea[k] = vFigArea[k];
+            vRawSumPFig[k] = vSumPFig[k];
+            vRawScore[k]   = vScore[k];
           
-          if( bVerbose ) {
-            cout << "  => " << setw(2) << k+1 << ". ";
-            printHypothesis( vHypos[k] );
-            cout << "             "
-                 << "FigArea=" << vFigArea[k] 
-                 << ", Sum(pfig)=" << vSumPFig[k]
-                 << ", Score=" << (int) vScore[k];
-          }
-
-          /* normalize the scores by scale */
-          if( bNormScalePFig2 ) {
-            if( (vHypos[k].dScale > dAdaptMinMDLScale) || bAlwaysAdapt ) {
-              float dScale2 = vHypos[k].dScale*vHypos[k].dScale;
-              vSumPFig[k]  /= dScale2;
-              vFigArea[k]  /= dScale2;
+            /* normalize the scores by scale */
+            if( bNormScalePFig2 ) {
+              if( (vHypos[k].dScale > dAdaptMinMDLScale) || bAlwaysAdapt ) {
+                float dScale2 = vHypos[k].dScale*vHypos[k].dScale;
+                vSumPFig[k]  /= dScale2;
+                vFigArea[k]  /= dScale2;
               
               } else {
                 vSumPFig[k] /= (dAdaptMinMDLScale*dAdaptMinMDLScale);
@@ -2727,22 +3127,45 @@ vector<Hypothesis> ISM::doMDLSelection( HypoVec             &vHypos,
               }
               vScore[k] = ( dWeightPFig*vSumPFig[k] + 
                             (1.0-dWeightPFig)*vFigArea[k] );
-              if( bVerbose )
-                cout << ", (norm.: Score=" << (int) vScore[k] << ")";
-          }
+            }
+            vNormScore[k] = vScore[k];
           
-          if( bVerbose )
-            cout << endl;
+            /* adapt the score by the area factor of the hypothesis */
+            if( vHypos[k].dAreaFactor!=1.0 )
+              vScore[k]  /= vHypos[k].dAreaFactor;
+          }
 
-          /* adapt the score by the area factor of the hypothesis */
-          if( vHypos[k].dAreaFactor!=1.0 )
-            vScore[k]  /= vHypos[k].dAreaFactor;
+          if( bVerbose ) {
+            cout << "  => " << setw(2) << k+1 << ". ";
+            printHypothesis( vHypos[k] );
+            cout << "             "
+                 << "FigArea=" << vRawFigArea[k] 
+                 << ", Sum(pfig)=" << vRawSumPFig[k]
+                 << ", Score=" << (int) vRawScore[k];
+            if( bNormScalePFig2 )
+              cout << ", (norm.: Score=" << (int) vNormScore[k] << ")";
+            cout << endl;
+          }
         }
     }
   }
   if( bVerbose )
     cout << "=======================================" << endl;
 
+  /*------------------------------------------------*/
+  /* Write the remaining segmentations back, as the */
+  /* callers may use the modified images            */
+  /*------------------------------------------------*/
+  for( int k=0; k<(int)vHypos.size(); k++ )
+    if( vRegions[k].bChanged ) {
+      const MDLRegion &rRegion = vRegions[k];
+      for( int y=rRegion.nY0, i=0; y<=rRegion.nY1; y++ )
+        for( int x=rRegion.nX0; x<=rRegion.nX1; x++, i++ ) {
+          vImgSegment[k](x,y) = rRegion.vSeg[i];
+          vImgPFig[k](x,y)    = rRegion.vPFig[i];
+        }
+    }
+
   return vResultHypos;
 }
 
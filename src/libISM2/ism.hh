@@ -127,6 +127,24 @@ void printHypothesisMDL         ( Hypothesis hypo );
 
 typedef vector<Hypothesis> HypoVec;
 
+/*-------------------*/
+/* Voting statistics */
+/*-------------------*/
+struct PatchVotingStats
+{
+  PatchVotingStats() 
+    : nCountMatched(0), nCountAll(0), nCountWeights(0), nCountVotes(0),
+      bAborted(false) {}
+
+  long nCountMatched;
+  long nCountAll;
+  long nCountWeights;
+  long nCountVotes;
+  bool bAborted;
+};
+
+struct PatchVotingTask;
+
 /*===================================================================*/
 /*                            Class ISM                              */
 /*===================================================================*/
@@ -161,11 +179,12 @@ public:
                               bool bVerbose=true );
   void saveOccurrences      ( string sFileName, bool bVerbose=true );
   void saveOccurrencesMatlab( string sFileName, bool bVerbose=true );
+  void saveOccurrencesBinary( string sFileName, bool bVerbose=true );
 
   unsigned            getNumOccs()     const { return m_nNumOccs; }
-  VecVecOccurrence    getOccurrences() const { return m_vvOccurrences; }
-  vector<float>       getOccWeights()  const { return m_vOccSumWeights; }
-  vector<OpGrayImage> getOccMaps()     const { return m_vOccMaps;      }
+  const VecVecOccurrence&    getOccurrences() const { return m_vvOccurrences; }
+  const vector<float>&       getOccWeights()  const { return m_vOccSumWeights;}
+  const vector<OpGrayImage>& getOccMaps()     const { return m_vOccMaps;      }
 
   void setOccurrences( const VecVecOccurrence & vvOcc ) 
                      { m_vvOccurrences = vvOcc; finishOccurrences(); }
@@ -227,6 +246,28 @@ protected:
                         float dPrior, float dRejectionThresh,
                         bool bVerbose=false );
 
+  bool runPatchVoting ( VotingSpace                   &vsHoughVotes,
+                        PatchVotingTask               &task,
+                        PatchVotingStats              &stats );
+
+  friend struct PatchVotingTask;
+  void castPatchVotes2D( const PointVector             &vPoints,
+                         const vector< vector<int> >   &vvAllNeighbors, 
+                         const vector< vector<float> > &vvAllNeighborsSim,
+                         float dPrior, float dRejectionThresh,
+                         int nFirstPoint, int nLastPoint,
+                         vector<HoughVote>             &vVotes,
+                         PatchVotingStats              &stats );
+  void castPatchVotes3D( const PointVector             &vPoints,
+                         const vector< vector<int> >   &vvAllNeighbors, 
+                         const vector< vector<float> > &vvAllNeighborsSim,
+                         float dPrior, float dRejectionThresh,
+                         float dScaleMin, float dScaleMax, 
+                         float dScaleCellSize,
+                         int nFirstPoint, int nLastPoint,
+                         vector<HoughVote>             &vVotes,
+                         PatchVotingStats              &stats );
+
 public:
   /*****************************/
   /*   Hypothesis Extraction   */
@@ -250,6 +291,11 @@ protected:
                                 int   nAddedRangeX, int   nAddedRangeY,
                                 vector<OpGrayImage> &vImgVotes,
                                 bool  bVerbose=false );
+
+  void    refineMaximaMSME    ( const vector<FeatureVector> &vSeeds,
+                                bool  bAdaptiveScale, float dAdaptMinScale,
+                                vector<FeatureVector>       &vResults,
+                                vector<float>               &vScores );
   
 public:
   /*****************************/
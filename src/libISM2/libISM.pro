@@ -14,6 +14,8 @@ CODE = $(HOME)/code
 
 INCLUDEPATH += . $${CODE}/include
 
+LIBS += -lpthread
+
 # Input
 HEADERS += occurrences.hh \
            segmentation.hh \
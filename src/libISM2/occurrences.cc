@@ -20,6 +20,7 @@
 #include <iomanip>
 #include <math.h>
 #include <algorithm>
+#include <cassert>
 
 #include "occurrences.hh"
 
@@ -226,6 +227,13 @@ int loadOccurrences( string sFileName, int nNumClusters,
   if( bVerbose )
     cout << "loadOccurrences() called." << endl;
 
+  /* binary model files contain the occurrence maps as well */
+  if( isModelFile( sFileName ) ) {
+    vector<OpGrayImage> vOccMaps;
+    return loadOccurrencesBinary( sFileName, nNumClusters, vvOccurrences,
+                                  vOccMaps, bVerbose );
+  }
+
   /********************************************************/
   /*   Load the occurrences as a list of featurevectors   */
   /********************************************************/
@@ -298,6 +306,133 @@ int loadOccurrences( string sFileName, int nNumClusters,
 }
 
 
+void saveOccurrencesBinary( string sFileName, 
+                            const VecVecOccurrence &vvOccurrences,
+                            const vector<OpGrayImage> &vOccMaps,
+                            bool bVerbose )
+  /*******************************************************************/
+  /* Save the occurrences together with their occurrence maps in the */
+  /* binary model file format. The occurrences are stored as one     */
+  /* packed array, grouped by cluster, with an offset table.         */
+  /*******************************************************************/
+{
+  if( bVerbose )
+    cout << "saveOccurrencesBinary() called." << endl;
+  assert( sizeof(ClusterOccurrence) == 12*sizeof(float) );
+
+  /*----------------------*/
+  /* Pack the occurrences */
+  /*----------------------*/
+  vector<unsigned>          vOffsets( vvOccurrences.size()+1, 0 );
+  for( unsigned i=0; i<vvOccurrences.size(); i++ )
+    vOffsets[i+1] = vOffsets[i] + vvOccurrences[i].size();
+
+  vector<ClusterOccurrence> vOccs;
+  vOccs.reserve( vOffsets.back() );
+  for( unsigned i=0; i<vvOccurrences.size(); i++ )
+    vOccs.insert( vOccs.end(), vvOccurrences[i].begin(), 
+                  vvOccurrences[i].end() );
+
+  /*--------------------------*/
+  /* Pack the occurrence maps */
+  /*--------------------------*/
+  vector<unsigned> vMapIndex;
+  vector<float>    vMapData;
+  for( unsigned i=0; i<vOccMaps.size(); i++ ) {
+    OpGrayImage img( vOccMaps[i] );
+    vMapIndex.push_back( img.width() );
+    vMapIndex.push_back( img.height() );
+    vMapIndex.push_back( vMapData.size() );
+    vector<float> vData( img.getData() );
+    vMapData.insert( vMapData.end(), vData.begin(), vData.end() );
+  }
+
+  /*----------------*/
+  /* Write the file */
+  /*----------------*/
+  ModelFileWriter mfWriter;
+  mfWriter.addSection( MODELSEC_OCC_OFFSETS, &vOffsets[0], 
+                       vOffsets.size()*sizeof(unsigned) );
+  mfWriter.addSection( MODELSEC_OCC_RECORDS, 
+                       ( vOccs.empty() ? 0 : &vOccs[0] ),
+                       vOccs.size()*sizeof(ClusterOccurrence) );
+  if( !vOccMaps.empty() ) {
+    mfWriter.addSection( MODELSEC_OCCMAP_INDEX, &vMapIndex[0],
+                         vMapIndex.size()*sizeof(unsigned) );
+    mfWriter.addSection( MODELSEC_OCCMAP_DATA, 
+                         ( vMapData.empty() ? 0 : &vMapData[0] ),
+                         vMapData.size()*sizeof(float) );
+  }
+
+  if( bVerbose )
+    cout << "  Saving " << vOccs.size() << " Occurrences and " 
+         << vOccMaps.size() << " Occurrence maps..." << endl;
+  if( !mfWriter.write( sFileName ) )
+    cerr << "Saving occurrences failed!" << endl;
+
+  if( bVerbose )
+    cout << "saveOccurrencesBinary() done." << endl;
+}
+
+
+int loadOccurrencesBinary( string sFileName, int nNumClusters,
+                           VecVecOccurrence &vvOccurrences,
+                           vector<OpGrayImage> &vOccMaps, bool bVerbose )
+  /*******************************************************************/
+  /* Load the occurrences and occurrence maps from a binary model    */
+  /* file. Returns the number of occurrences, or -1 if the file does */
+  /* not fit to the current clustering. The data is copied into      */
+  /* vvOccurrences and vOccMaps, the file is unmapped on return.     */
+  /*******************************************************************/
+{
+  if( bVerbose )
+    cout << "loadOccurrencesBinary() called." << endl;
+
+  MappedOccurrences moOccs;
+  if( !moOccs.open( sFileName, bVerbose ) )
+    return -1;
+
+  /* !!! The occurrences must fit to the current clustering!!! */
+  if( moOccs.numClusters() != nNumClusters ) {
+    cerr << "  Error loading Occurrences: file is for " 
+         << moOccs.numClusters() << " clusters instead of " 
+         << nNumClusters << "!" << endl;
+    return -1;
+  }
+
+  /*----------------------*/
+  /* Copy the occurrences */
+  /*----------------------*/
+  vvOccurrences.clear();
+  VecVecOccurrence tmp( nNumClusters );
+  vvOccurrences = tmp;
+  for( int i=0; i<nNumClusters; i++ )
+    vvOccurrences[i].assign( moOccs.occurrences(i), 
+                             moOccs.occurrences(i)+moOccs.numOccurrences(i) );
+  if( bVerbose )
+    cout << "  " << moOccs.numOccurrences() << " Occurrences loaded..." 
+         << endl;
+
+  /*--------------------------*/
+  /* Copy the occurrence maps */
+  /*--------------------------*/
+  vOccMaps.clear();
+  vOccMaps.resize( moOccs.numOccMaps() );
+  for( int i=0; i<moOccs.numOccMaps(); i++ ) {
+    int w, h;
+    const float *pData = moOccs.occMap( i, w, h );
+    vOccMaps[i].loadFromData( w, h, const_cast<float*>(pData) );
+  }
+  if( bVerbose )
+    cout << "  " << vOccMaps.size() << " Occurrence maps loaded..." << endl;
+
+  if( bVerbose )
+    cout << "loadOccurrencesBinary() done." << endl;
+
+  return moOccs.numOccurrences();
+}
+
+
 // void loadOccurrenceMaps( string sFileName, int nNumClusters,
 //                          VecVecOccurrence vvOccurrences,
 //                          vector< vector<OpGrayImage> > &vvOccMaps )
@@ -700,3 +835,97 @@ void loadCooccDistances( string sFileName, int nNumClusters,
 }
 
 
+/*===================================================================*/
+/*                       Class MappedOccurrences                     */
+/*===================================================================*/
+
+MappedOccurrences::MappedOccurrences()
+  /* standard constructor */
+{
+  m_nNumClusters = 0;
+  m_nNumOccs     = 0;
+  m_pOffsets     = 0;
+  m_pOccs        = 0;
+  m_nNumOccMaps  = 0;
+  m_pMapIndex    = 0;
+  m_pMapData     = 0;
+  m_nMapDataSize = 0;
+}
+
+
+bool MappedOccurrences::open( const string &sFileName, bool bVerbose )
+  /*******************************************************************/
+  /* Map the file and check that the offset table is consistent with */
+  /* the stored occurrences and occurrence maps.                     */
+  /*******************************************************************/
+{
+  close();
+  if( !m_mfFile.open( sFileName, bVerbose ) )
+    return false;
+
+  size_t nOffsetSize, nOccSize, nIndexSize;
+  m_pOffsets  = (const unsigned*) 
+    m_mfFile.section( MODELSEC_OCC_OFFSETS, nOffsetSize );
+  m_pOccs     = (const ClusterOccurrence*) 
+    m_mfFile.section( MODELSEC_OCC_RECORDS, nOccSize );
+  m_pMapIndex = (const unsigned*) 
+    m_mfFile.section( MODELSEC_OCCMAP_INDEX, nIndexSize );
+  m_pMapData  = (const float*) 
+    m_mfFile.section( MODELSEC_OCCMAP_DATA, m_nMapDataSize );
+
+  bool ok = ( m_pOffsets!=0 && m_pOccs!=0 && 
+              nOffsetSize>=sizeof(unsigned) &&
+              nOffsetSize%sizeof(unsigned)==0 &&
+              nOccSize%sizeof(ClusterOccurrence)==0 );
+  if( ok ) {
+    m_nNumClusters = nOffsetSize/sizeof(unsigned) - 1;
+    m_nNumOccs     = nOccSize/sizeof(ClusterOccurrence);
+    ok = ( m_pOffsets[0]==0 && (int)m_pOffsets[m_nNumClusters]==m_nNumOccs );
+    for( int i=0; i<m_nNumClusters && ok; i++ )
+      ok = ( m_pOffsets[i] <= m_pOffsets[i+1] );
+  }
+
+  if( ok && m_pMapIndex!=0 ) {
+    m_nNumOccMaps = nIndexSize/(3*sizeof(unsigned));
+    size_t nNumFloats = m_nMapDataSize/sizeof(float);
+    for( int i=0; i<m_nNumOccMaps && ok; i++ ) {
+      const unsigned *pEntry = m_pMapIndex + 3*i;
+      ok = ( pEntry[2] <= nNumFloats && 
+             (size_t)pEntry[0]*pEntry[1] <= nNumFloats - pEntry[2] );
+    }
+  }
+
+  if( !ok ) {
+    cerr << "Error in MappedOccurrences::open(): "
+         << "File '" << sFileName << "' contains no valid occurrences!" 
+         << endl;
+    close();
+    return false;
+  }
+  return true;
+}
+
+
+void MappedOccurrences::close()
+{
+  m_mfFile.close();
+  m_nNumClusters = 0;
+  m_nNumOccs     = 0;
+  m_pOffsets     = 0;
+  m_pOccs        = 0;
+  m_nNumOccMaps  = 0;
+  m_pMapIndex    = 0;
+  m_pMapData     = 0;
+  m_nMapDataSize = 0;
+}
+
+
+const float* MappedOccurrences::occMap( int nIdx, int &nWidth, 
+                                        int &nHeight ) const
+{
+  assert( nIdx>=0 && nIdx<m_nNumOccMaps );
+  const unsigned *pEntry = m_pMapIndex + 3*nIdx;
+  nWidth  = pEntry[0];
+  nHeight = pEntry[1];
+  return m_pMapData + pEntry[2];
+}
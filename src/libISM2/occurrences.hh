@@ -27,6 +27,7 @@ using namespace std;
 #include <fstream>
 
 #include <featurevector.hh>
+#include <modelfile.hh>
 #include <opgrayimage.hh>
 
 /*******************/
@@ -124,6 +125,48 @@ typedef vector< vector<ClusterCooccurrence> > VecVecCooccurrence;
 typedef vector< vector<float> >               VecVecCooccDistance;
 
 
+/*===================================================================*/
+/*                       Class MappedOccurrences                     */
+/*===================================================================*/
+/* Read-only view of the occurrences and occurrence maps stored in a */
+/* binary model file (see saveOccurrencesBinary()). The occurrences  */
+/* are kept as one packed array, grouped by cluster. The pointers    */
+/* point into the mapping and are only valid while the view is open; */
+/* loadOccurrencesBinary() copies everything out and closes it.      */
+class MappedOccurrences
+{
+public:
+  MappedOccurrences();
+
+public:
+  bool open ( const string &sFileName, bool bVerbose=true );
+  void close();
+
+  bool isOpen() const { return m_mfFile.isOpen(); }
+
+  int  numClusters   () const { return m_nNumClusters; }
+  int  numOccurrences() const { return m_nNumOccs; }
+  int  numOccurrences( int nCluster ) const
+  { return (int)(m_pOffsets[nCluster+1] - m_pOffsets[nCluster]); }
+  const ClusterOccurrence* occurrences( int nCluster ) const
+  { return m_pOccs + m_pOffsets[nCluster]; }
+
+  int          numOccMaps() const { return m_nNumOccMaps; }
+  const float* occMap    ( int nIdx, int &nWidth, int &nHeight ) const;
+
+protected:
+  MappedModelFile           m_mfFile;
+  int                       m_nNumClusters;
+  int                       m_nNumOccs;
+  const unsigned           *m_pOffsets;
+  const ClusterOccurrence  *m_pOccs;
+  int                       m_nNumOccMaps;
+  const unsigned           *m_pMapIndex;
+  const float              *m_pMapData;
+  size_t                    m_nMapDataSize;
+};
+
+
 /***************************/
 /*   Function Prototypes   */
 /***************************/
@@ -136,6 +179,15 @@ int  loadOccurrences      ( string sFileName, int nNumClusters,
                             VecVecOccurrence &vvOccurrences,
                             bool bVerbose=true );
 
+void saveOccurrencesBinary( string sFileName, 
+                            const VecVecOccurrence &vvOccurrences,
+                            const vector<OpGrayImage> &vOccMaps,
+                            bool bVerbose=true );
+int  loadOccurrencesBinary( string sFileName, int nNumClusters,
+                            VecVecOccurrence &vvOccurrences,
+                            vector<OpGrayImage> &vOccMaps,
+                            bool bVerbose=true );
+
 void saveOccurrenceMaps   ( string sFileName, 
                             /*const*/ vector<OpGrayImage> &vOccMaps,
                             bool bVerbose=true );
@@ -398,6 +398,59 @@ RecoGUI::RecoGUI( QWidget *parent, const char *name )
 
   tabpMisc->addWidget( chkUseFastMSME );
 
+  /*------------------------------------------*/
+  /* Checkbox 'Sparse voting space storage'   */
+  /*------------------------------------------*/
+  chkSparseVotes = new QCheckBox( "Sparse voting space", tabwMisc, 
+                                  "chkSparseVotes" );
+
+  chkSparseVotes->setChecked( false );
+  m_bSparseVotes = chkSparseVotes->isChecked();
+
+  QT_CONNECT_CHECKBOX( chkSparseVotes, SparseVotes );
+
+  tabpMisc->addWidget( chkSparseVotes );
+
+  /*------------------------------------------*/
+  /* Checkbox 'Early MSME termination'        */
+  /*------------------------------------------*/
+  chkMSMEEarlyStop = new QCheckBox( "Stop MSME in known modes", tabwMisc, 
+                                    "chkMSMEEarlyStop" );
+
+  chkMSMEEarlyStop->setChecked( false );
+  m_bMSMEEarlyStop = chkMSMEEarlyStop->isChecked();
+
+  QT_CONNECT_CHECKBOX( chkMSMEEarlyStop, MSMEEarlyStop );
+
+  tabpMisc->addWidget( chkMSMEEarlyStop );
+
+  /*------------------------------------------*/
+  /* Checkbox 'Summed-volume table'           */
+  /*------------------------------------------*/
+  chkIntegralVotes = new QCheckBox( "Integral vote table", tabwMisc, 
+                                    "chkIntegralVotes" );
+
+  chkIntegralVotes->setChecked( false );
+  m_bIntegralVotes = chkIntegralVotes->isChecked();
+
+  QT_CONNECT_CHECKBOX( chkIntegralVotes, IntegralVotes );
+
+  tabpMisc->addWidget( chkIntegralVotes );
+
+  /*------------------------------------------*/
+  /* Number of threads for voting (0: #CPUs)  */
+  /*------------------------------------------*/
+  QHBox *hbThreads = new QHBox( tabwMisc );
+  QLabel      *lbThreads = new QLabel( "Threads (0=all CPUs):", hbThreads );
+  QLineEdit   *edThreads = new QLineEdit( "0", hbThreads, "edThreads" );
+
+  edThreads->setMaximumWidth(50);
+  m_nNumThreads = atoi( edThreads->text() );
+
+  QT_CONNECT_LINEEDIT( edThreads, NumThreads ); 
+
+  tabpMisc->addWidget( hbThreads );
+
 
   /*****************************/
   /*  Group 'Misc2 Parameters' */
@@ -520,6 +573,10 @@ void RecoGUI::saveParams( string sFileName, bool bVerbose )
              << "m_dMinVoteWeight: " << m_dMinVoteWeight << "\n"
              << "m_dMaxVoteWeight: " << m_dMaxVoteWeight << "\n"
              << "m_bUseFastMSME: " << m_bUseFastMSME << "\n"
+             << "m_bSparseVotes: " << m_bSparseVotes << "\n"
+             << "m_nNumThreads: " << m_nNumThreads << "\n"
+             << "m_bMSMEEarlyStop: " << m_bMSMEEarlyStop << "\n"
+             << "m_bIntegralVotes: " << m_bIntegralVotes << "\n"
         //-- Recognition parameters --//
              << "m_dScoreThreshSingle: " << m_dScoreThreshSingle << "\n"
              << "m_nObjWidth: "  << m_nObjWidth << "\n"
@@ -653,6 +710,20 @@ void RecoGUI::loadParams( string sFileName, bool bVerbose )
           chkUseFastMSME->setChecked((bool)val.toInt());
           slotSetUseFastMSMEOnOff(val.toInt());
         }
+        else if (name.compare("m_bSparseVotes")==0) {
+          chkSparseVotes->setChecked((bool)val.toInt());
+          slotSetSparseVotesOnOff(val.toInt());
+        }
+        else if (name.compare("m_nNumThreads")==0)
+          emit sigNumThreadsChanged(val);
+        else if (name.compare("m_bMSMEEarlyStop")==0) {
+          chkMSMEEarlyStop->setChecked((bool)val.toInt());
+          slotSetMSMEEarlyStopOnOff(val.toInt());
+        }
+        else if (name.compare("m_bIntegralVotes")==0) {
+          chkIntegralVotes->setChecked((bool)val.toInt());
+          slotSetIntegralVotesOnOff(val.toInt());
+        }
         //-- Recognition parameters  --//
         else if (name.compare("m_dScoreThreshSingle")==0)
           emit sigScoreThreshSingleChanged(val);
@@ -762,6 +833,10 @@ QT_IMPLEMENT_LINEEDIT_FLOAT( RecoGUI::slot, AdaptMinScale, m_dAdaptMinScale, 1 )
 QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, NormScalePFig2, m_bNormScalePFig2 )
 QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, RestrictScale, m_bRestrictScale )
 QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, UseFastMSME, m_bUseFastMSME )
+QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, SparseVotes, m_bSparseVotes )
+QT_IMPLEMENT_LINEEDIT_INT( RecoGUI::slot, NumThreads, m_nNumThreads )
+QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, MSMEEarlyStop, m_bMSMEEarlyStop )
+QT_IMPLEMENT_CHECKBOX( RecoGUI::slot, IntegralVotes, m_bIntegralVotes )
 
 QT_IMPLEMENT_LINEEDIT_FLOAT( RecoGUI::slot, ScoreThreshSingle, m_dScoreThreshSingle, 2 )
 QT_IMPLEMENT_LINEEDIT_INT( RecoGUI::slot, ObjWidth, m_nObjWidth )
@@ -80,6 +80,7 @@ public slots:
   void slotSetAspMin            ( const QString &text );
   void slotSetAspMax            ( const QString &text );
   void slotSetGibbsConst        ( const QString &text );
+  void slotSetNumThreads        ( const QString &text );
   void slotUpdateMSMEx();
   void slotUpdateMSMEy();
   void slotUpdateMSMEs();
@@ -105,6 +106,7 @@ public slots:
   void slotUpdateAspMin();
   void slotUpdateAspMax();
   void slotUpdateGibbsConst();
+  void slotUpdateNumThreads();
 
   void slotSelectKernelType      ( int   id );
   void slotSelectFixObjDim       ( int   id );
@@ -114,6 +116,9 @@ public slots:
   void slotSetNormScalePFig2OnOff( int   state );
   void slotSetRestrictScaleOnOff ( int   state );
   void slotSetUseFastMSMEOnOff   ( int   state );
+  void slotSetSparseVotesOnOff   ( int   state );
+  void slotSetMSMEEarlyStopOnOff ( int   state );
+  void slotSetIntegralVotesOnOff ( int   state );
   void slotSetExtendSearchOnOff  ( int   state );
   void slotSetNormPatchOnOff     ( int   state );
   void slotSetNormPoseOnOff      ( int   state );
@@ -154,6 +159,7 @@ signals:
   void sigAspMinChanged            ( const QString& );
   void sigAspMaxChanged            ( const QString& );
   void sigGibbsConstChanged        ( const QString& );
+  void sigNumThreadsChanged        ( const QString& );
 
 public:
   void processEvents() { qApp->processEvents(); }
@@ -179,6 +185,9 @@ public:
   QCheckBox    *chkAdaptSc;
   QCheckBox    *chkNormScPFig2;
   QCheckBox    *chkUseFastMSME;
+  QCheckBox    *chkSparseVotes;
+  QCheckBox    *chkMSMEEarlyStop;
+  QCheckBox    *chkIntegralVotes;
   QCheckBox    *chkExtendSearch;
   QCheckBox    *chkMakeRotInv;
   QCheckBox    *chkRecoverRot;
@@ -212,6 +221,10 @@ public:
   bool   m_bNormScalePFig;
   bool   m_bNormScalePFig2;
   bool   m_bUseFastMSME;
+  bool   m_bSparseVotes;
+  bool   m_bMSMEEarlyStop;
+  bool   m_bIntegralVotes;
+  int    m_nNumThreads;
 
   /* Recognition parameters */
   float  m_dScoreThreshSingle;
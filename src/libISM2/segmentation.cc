@@ -45,8 +45,9 @@ Segmentation::Segmentation()
 }
 
 
-Segmentation::Segmentation( OpGrayImage imgPFig, OpGrayImage imgPGnd, 
-                            OpGrayImage imgSeg )
+Segmentation::Segmentation( const OpGrayImage &imgPFig, 
+                            const OpGrayImage &imgPGnd,
+                            const OpGrayImage &imgSeg )
 /* standard constructor for full-sized segmentations */
 {
   assert( (imgPFig.width() == imgPGnd.width()) && 
@@ -70,8 +71,9 @@ Segmentation::Segmentation( OpGrayImage imgPFig, OpGrayImage imgPGnd,
 }
 
 
-Segmentation::Segmentation( OpGrayImage imgPFig, OpGrayImage imgPGnd, 
-                            OpGrayImage imgSeg,
+Segmentation::Segmentation( const OpGrayImage &imgPFig, 
+                            const OpGrayImage &imgPGnd,
+                            const OpGrayImage &imgSeg,
                             int nOffX, int nOffY,
                             int nFullWidth, int nFullHeight )
 /* standard constructor for smaller segmentations */
@@ -134,7 +136,7 @@ void Segmentation::copyFrom( const Segmentation &other )
 /*                    Access Functions                     */
 /***********************************************************/
 
-void Segmentation::updateImgPFig( OpGrayImage imgPFig )
+void Segmentation::updateImgPFig( const OpGrayImage &imgPFig )
 {
   assert( (m_imgPFig.width()==imgPFig.width()) &&
           (m_imgPFig.height()==imgPFig.height()) );
@@ -144,7 +146,7 @@ void Segmentation::updateImgPFig( OpGrayImage imgPFig )
 }
 
 
-void Segmentation::updateImgPGnd( OpGrayImage imgPGnd )
+void Segmentation::updateImgPGnd( const OpGrayImage &imgPGnd )
 {
   assert( (m_imgPGnd.width()==imgPGnd.width()) &&
           (m_imgPGnd.height()==imgPGnd.height()) );
@@ -154,7 +156,7 @@ void Segmentation::updateImgPGnd( OpGrayImage imgPGnd )
 }
 
 
-void Segmentation::updateImgSeg ( OpGrayImage imgSeg  )
+void Segmentation::updateImgSeg ( const OpGrayImage &imgSeg  )
 {
   assert( (m_imgSeg.width()==imgSeg.width()) &&
           (m_imgSeg.height()==imgSeg.height()) );
@@ -193,7 +195,7 @@ float Segmentation::getSumSegArea()
 }
 
 
-OpGrayImage Segmentation::getFullImg( OpGrayImage imgSrc )
+OpGrayImage Segmentation::getFullImg( const OpGrayImage &imgSrc ) const
 {
   if( (m_nFullWidth<0) || (m_nFullHeight<0) ) {
     // image already has the full size
@@ -39,9 +39,10 @@ class Segmentation
 {
 public:
   Segmentation();
-  Segmentation( OpGrayImage imgPFig, OpGrayImage imgPGnd, OpGrayImage imgSeg );
-  Segmentation( OpGrayImage imgPFig, OpGrayImage imgPGnd, OpGrayImage imgSeg,
-                int nOffX, int nOffY, int nFullWidth, int nFullHeight );
+  Segmentation( const OpGrayImage &imgPFig, const OpGrayImage &imgPGnd,
+                const OpGrayImage &imgSeg );
+  Segmentation( const OpGrayImage &imgPFig, const OpGrayImage &imgPGnd,
+                const OpGrayImage &imgSeg, int nOffX, int nOffY, int nFullWidth, int nFullHeight );
   Segmentation( const Segmentation &other );
 
   Segmentation& operator=( const Segmentation &other );
@@ -53,26 +54,26 @@ public:
   /*******************************/
   /*   Content Access Operators  */
   /*******************************/
-  OpGrayImage getImgPFig()     { return m_imgPFig; }
-  OpGrayImage getImgPGnd()     { return m_imgPGnd; }
-  OpGrayImage getImgSeg ()     { return m_imgSeg; }
+  const OpGrayImage& getImgPFig() const { return m_imgPFig; }
+  const OpGrayImage& getImgPGnd() const { return m_imgPGnd; }
+  const OpGrayImage& getImgSeg () const { return m_imgSeg; }
   
-  OpGrayImage getFullImgPFig() { return getFullImg( m_imgPFig ); }
-  OpGrayImage getFullImgPGnd() { return getFullImg( m_imgPGnd ); }
-  OpGrayImage getFullImgSeg () { return getFullImg( m_imgSeg );  }
+  OpGrayImage getFullImgPFig() const { return getFullImg( m_imgPFig ); }
+  OpGrayImage getFullImgPGnd() const { return getFullImg( m_imgPGnd ); }
+  OpGrayImage getFullImgSeg () const { return getFullImg( m_imgSeg );  }
   
-  int   getOffsetX() { return m_nOffX; }
-  int   getOffsetY() { return m_nOffY; }
+  int   getOffsetX() const { return m_nOffX; }
+  int   getOffsetY() const { return m_nOffY; }
 
-  void  updateImgPFig( OpGrayImage imgPFig );
-  void  updateImgPGnd( OpGrayImage imgPGnd );
-  void  updateImgSeg ( OpGrayImage imgSeg  );
+  void  updateImgPFig( const OpGrayImage &imgPFig );
+  void  updateImgPGnd( const OpGrayImage &imgPGnd );
+  void  updateImgSeg ( const OpGrayImage &imgSeg  );
 
   float getSumPFig();
   float getSumSegArea();
 
 protected:
-  OpGrayImage getFullImg( OpGrayImage imgSrc );
+  OpGrayImage getFullImg( const OpGrayImage &imgSrc ) const;
   
 public:
   /****************************/
@@ -16,6 +16,9 @@
 /****************/
 #include <math.h>
 #include <iostream>
+#include <algorithm>
+
+#include <gaussderiv.hh>
 
 #include "polcoe.h"
 #include "dogscalespace.hh"
@@ -31,6 +34,8 @@
 
 DoGScaleSpace::DoGScaleSpace(){
   data = 0;
+  m_dSigmaStep = 1.0;
+  m_nNumLevels = 0;
 }
 
 
@@ -40,6 +45,8 @@ DoGScaleSpace::DoGScaleSpace(const DoGScaleSpace& source)
   if (source.data != 0) {
     data->refcount++;
   }
+  m_dSigmaStep = source.m_dSigmaStep;
+  m_nNumLevels = source.m_nNumLevels;
 }
 
 
@@ -161,6 +168,51 @@ DoGScaleSpace::DoGScaleSpace( /*const*/ OpGrayImage& imgSource,
 }
 
 
+DoGScaleSpace::DoGScaleSpace( ScaleSpaceCache& ssCache, int nNumOctaves, 
+                              int nLevelsPerOctave, float dSigma0 ) 
+  /*******************************************************************/
+  /* Build the DoG levels from a shared scale space cache instead of */
+  /* smoothing the source image again for every level. The differen- */
+  /* ces are taken at the resolution of each octave and are then     */
+  /* upsampled to the source size. The cache uses normalized kernels,*/
+  /* while opGauss() (used above) has a sigma-dependent gain, so the */
+  /* cached levels are multiplied by that gain before the difference */
+  /* is taken. The result only approximates the direct DoG: coarse  */
+  /* octaves are smoothed at reduced resolution and come out up to   */
+  /* 15% weaker, so the same threshold yields different maxima.      */
+  /*******************************************************************/
+{
+  /* (the cache can't provide octaves smaller than one pixel) */
+  nNumOctaves  = min( nNumOctaves, ssCache.getMaxOctaves( 1 ) );
+  m_nNumLevels = nLevelsPerOctave * nNumOctaves + 1;
+  m_dSigmaStep = pow( 2.0, 1.0/(float)nLevelsPerOctave );
+  data = new ScaleSpaceData( m_nNumLevels );
+  data->sourceImage = ssCache.getSourceImage();
+
+  for( int i=0; i<m_nNumLevels; i++ ) {
+    /* (the last level lies at the end of the last octave) */
+    int nOctave = min( i/nLevelsPerOctave, nNumOctaves-1 );
+    int nLevel  = i - nOctave*nLevelsPerOctave;
+
+    float dScale0 = ssCache.getScale( dSigma0, nLevelsPerOctave, 
+                                      nOctave, nLevel );
+    float dScale1 = ssCache.getScale( dSigma0, nLevelsPerOctave, 
+                                      nOctave, nLevel+1 );
+    OpGrayImage imgDiff( ssCache.getLevel( dSigma0, nLevelsPerOctave,
+                                           nOctave, nLevel+1 ) );
+    imgDiff = imgDiff*GetGaussGain( dScale1 );
+    imgDiff = imgDiff - ssCache.getLevel( dSigma0, nLevelsPerOctave,
+                                          nOctave, nLevel ) * 
+      GetGaussGain( dScale0 );
+    if( nOctave > 0 )
+      data->scaledImage[i] = ssCache.upsample( imgDiff, 1 << nOctave );
+    else
+      data->scaledImage[i] = imgDiff;
+    data->scales[i] = dScale0;
+  }
+}
+
+
 DoGScaleSpace::~DoGScaleSpace() {
   if (data != 0) {
     if (data->refcount > 1) {
@@ -641,6 +693,8 @@ DoGScaleSpace& DoGScaleSpace::operator=( const DoGScaleSpace &other )
   if (data != 0) {
     data->refcount++;
   }
+  m_dSigmaStep = other.m_dSigmaStep;
+  m_nNumLevels = other.m_nNumLevels;
   return *this;
 }
 
@@ -21,6 +21,7 @@
 #include <opgrayimage.hh>
 #include "opinterestimage.hh"
 #include <scalespacedata.hh>
+#include <scalespacecache.hh>
 
 
 /*************************/
@@ -37,6 +38,8 @@ public:
   DoGScaleSpace( const DoGScaleSpace& source );
   DoGScaleSpace( /*const*/ OpGrayImage& imgSource, int nNumOctaves, 
                  int nLevelsPerOctave, float dSigma0 );
+  DoGScaleSpace( ScaleSpaceCache& ssCache, int nNumOctaves, 
+                 int nLevelsPerOctave, float dSigma0 );
   ~DoGScaleSpace();
   
 public:
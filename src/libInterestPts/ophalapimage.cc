@@ -54,10 +54,14 @@
 OpHalapResult OpHalapImage::opHarrisLaplacian( double sigma0, 
                                                float scaleChange,
                                                int level, double sigma2, 
-                                               double alpha, double threshold)
+                                               double alpha, double threshold,
+                                               ScaleSpaceCache *pCache)
+  /* (the Gaussian levels are taken from pCache if it's given) */
 {
   cout << "OpHalapImage::opHarrisLaplacian called." << endl;
-  ScaleSpace harrisSS(*this, sigma0, scaleChange, level);
+  ScaleSpace harrisSS = ((pCache != 0 && pCache->isCompatible(*this)) ?
+                         ScaleSpace(*pCache, sigma0, scaleChange, level) :
+                         ScaleSpace(*this, sigma0, scaleChange, level));
   ScaleSpace laplacian(harrisSS);
   laplacian.opLaplacian();
   
@@ -164,10 +168,14 @@ OpHalapResult OpHalapImage::opFastHarrisLaplacian( int level, double sigma2,
 
 OpHalapResult OpHalapImage::opDoGHarrisLaplacian( double sigma0, int level, 
                                                   double sigma2, double alpha, 
-                                                  double threshold)
+                                                  double threshold,
+                                                  ScaleSpaceCache *pCache)
+  /* (the Gaussian levels are taken from pCache if it's given) */
 {
   cout << "OpHalapImage::opFastHarrisLaplacian called." << endl;
-  ScaleSpace harrisSS(*this, sigma0, sqrt(2.0), level);
+  ScaleSpace harrisSS = ((pCache != 0 && pCache->isCompatible(*this)) ?
+                         ScaleSpace(*pCache, sigma0, sqrt(2.0), level) :
+                         ScaleSpace(*this, sigma0, sqrt(2.0), level));
   ScaleSpace laplacian(harrisSS);
   laplacian.opDifferenceOfGaussian();
   laplacian.opNormalize(2);
@@ -28,6 +28,7 @@
 /****************/
 #include "opinterestimage.hh"
 #include "oplindebergimage.hh"
+#include <scalespacecache.hh>
 
 
 /*************************/
@@ -78,13 +79,15 @@ public:
                                       int level=25, 
                                       double sigma2=2.0, 
                                       double alpha=0.06, 
-                                      double threshold=0.0);
+                                      double threshold=0.0,
+                                      ScaleSpaceCache *pCache=0);
   
   OpHalapResult opDoGHarrisLaplacian (double sigma0=1.0, 
                                       int level=25,
                                       double sigma2=2.0, 
                                       double alpha=0.06, 
-                                      double threshold=0.0);
+                                      double threshold=0.0,
+                                      ScaleSpaceCache *pCache=0);
   
   OpHalapResult opFastHarrisLaplacian(int level=15,
                                       double sigma2=2.0, 
@@ -26,10 +26,13 @@
 #include <iostream>
 #include <iomanip>
 #include <math.h>
+#include <float.h>
 #include <algorithm>
 #include <queue>
 
 #include <clsimilarity.hh>
+#include <parallelfor.hh>
+#include <distkernels.hh>
 
 #include "balltree.hh"
 
@@ -440,12 +443,14 @@ BallTree::BallTree()
   m_vActive.clear();
   m_pbnRoot = NULL;
   m_bIsValid = false;
+  m_bFrozen  = false;
   clearStats();
 }
 
 
 BallTree::BallTree( const vector<FeatureVector> &vData, unsigned nMaxNumOwned )
 {
+  m_bFrozen = false;
   build( vData, nMaxNumOwned );
   clearStats();
 }
@@ -477,6 +482,7 @@ void BallTree::clear()
   m_vActive.clear();
   m_pbnRoot = NULL;
   m_bIsValid = false;
+  unfreeze();
   clearStats();
 }
 
@@ -492,6 +498,7 @@ void BallTree::clearPoints()
   m_vPenalties.clear();
   m_vpInNode.clear();
   m_vActive.clear();
+  unfreeze();
   clearStats();
 }
 
@@ -537,6 +544,7 @@ void BallTree::build( const vector<FeatureVector> &vData,
   /*******************************************************************/
 {
   assert( !vData.empty() );
+  unfreeze();
 
   /*----------------------*/
   /* Copy the data points */
@@ -562,6 +570,7 @@ void BallTree::build( const vector<FeatureVector> &vData,
   createAnchorTree( vIdzs, nMaxNumOwned, m_pbnRoot );
 
   m_bIsValid = true;
+  freeze();
   if( bVerbose ) {
     cout << "  done." << endl;
     cout << "    (root radius: " << m_pbnRoot->dRadius << ")" << endl;
@@ -584,6 +593,7 @@ void BallTree::rebuild( unsigned nMaxNumOwned, bool bVerbose )
   delete m_pbnRoot;
   m_pbnRoot  = NULL;
   m_bIsValid = false;
+  unfreeze();
 
   /*----------------------------*/
   /* Initialize the data points */
@@ -623,6 +633,7 @@ void BallTree::rebuild( unsigned nMaxNumOwned, bool bVerbose )
   createAnchorTree( vIdzs, nMaxNumOwned, m_pbnRoot );
 
   m_bIsValid = true;
+  freeze();
   if( bVerbose ) {
     cout << "  done." << endl;
     cout << "    (root radius: " << m_pbnRoot->dRadius << ")" << endl;
@@ -1099,6 +1110,7 @@ void BallTree::updateRadii( float dQuantile )
 /* Update the radii of all nodes in the tree */
 {
   //cout << "  BallTree::updateRadii() called..." << endl;
+  unfreeze();
   cout << endl
        << "    Updating radii of all nodes in the balltree... " << flush;
   if( m_pbnRoot )
@@ -1519,6 +1531,8 @@ void BallTree::buildFromClusterTrace( const vector<FeatureVector> &vFeatures,
     /* add the node as root */
     m_pbnRoot = pbnNode;    
   }
+
+  freeze();
 }
 
 
@@ -1637,6 +1651,8 @@ void BallTree::insertPoint( const FeatureVector &fvPoint )
   /* structure.                                                      */
   /*******************************************************************/
 {
+  unfreeze();
+
   /* insert the point into the data structures */
   m_vData.push_back( fvPoint );
   m_vPenalties.push_back( 0.0 );
@@ -1695,6 +1711,7 @@ void BallTree::updatePoint( unsigned nIdx, const FeatureVector &fvPoint,
   /*******************************************************************/
 {
   assert( nIdx < m_vData.size() );
+  unfreeze();
 
   m_vData[nIdx]      = fvPoint;
   m_vPenalties[nIdx] = dPenalty;
@@ -1721,6 +1738,7 @@ void BallTree::mergePoints( unsigned nIdx1, unsigned nIdx2, unsigned nNewIdx,
   assert( (nNewIdx==nIdx1) || (nNewIdx==nIdx2) );
   assert( m_vpInNode[nIdx1] );
   assert( m_vpInNode[nIdx2] );
+  unfreeze();
 
   /*--------------------------------*/
   /* Retrieve the two storage nodes */
@@ -1981,6 +1999,87 @@ void BallTree::removeNode( BallTreeNode *pbnNode )
 }
 
 
+/***********************************************************/
+/*                      Frozen Tree                        */
+/***********************************************************/
+
+void BallTree::freeze()
+  /*******************************************************************/
+  /* Create a read-only copy of the tree in a flat layout: the nodes */
+  /* in one array in depth-first order, their centers in one matrix, */
+  /* and the owned points (indices, center distances, and data) in   */
+  /* contiguous ranges. All queries except findNN(nQueryIdx) then    */
+  /* run on this copy.                                               */
+  /*******************************************************************/
+{
+  unfreeze();
+  if( m_pbnRoot == NULL || m_vData.empty() )
+    return;
+
+  /*-------------------------------*/
+  /* Collect the nodes in DFS order */
+  /*-------------------------------*/
+  vector<const BallTreeNode*> vpOrder;
+  flattenNode( m_pbnRoot, vpOrder );
+
+  /*---------------------------*/
+  /* Copy the centers and data */
+  /*---------------------------*/
+  int nDims = m_vData[0].numDims();
+  m_fmCenters.resize( (int)vpOrder.size(), nDims );
+  for( unsigned i=0; i<vpOrder.size(); i++ )
+    if( vpOrder[i]->hasPivot() )
+      m_fmCenters.setRow( i, m_vData[vpOrder[i]->nPivot].getDataPtr() );
+    else
+      m_fmCenters.setRow( i, vpOrder[i]->fvMean.getDataPtr() );
+
+  m_fmFlatPoints.resize( (int)m_vFlatOwned.size(), nDims );
+  for( unsigned i=0; i<m_vFlatOwned.size(); i++ )
+    m_fmFlatPoints.setRow( i, m_vData[m_vFlatOwned[i]].getDataPtr() );
+
+  m_bFrozen = true;
+}
+
+
+void BallTree::unfreeze()
+  /* drop the frozen copy (the queries use the original nodes again) */
+{
+  m_bFrozen = false;
+  m_vFlatNodes.clear();
+  m_vFlatOwned.clear();
+  m_vFlatDist.clear();
+  m_fmCenters.clear();
+  m_fmFlatPoints.clear();
+}
+
+
+void BallTree::flattenNode( const BallTreeNode *pbnNode,
+                            vector<const BallTreeNode*> &vpOrder )
+  /* append the node and (recursively) its subtree in DFS order */
+{
+  int nIdx = (int)m_vFlatNodes.size();
+  vpOrder.push_back( pbnNode );
+
+  FlatBallTreeNode fbnNode;
+  fbnNode.nPivot      = ( pbnNode->hasPivot() ? (int)pbnNode->nPivot : -1 );
+  fbnNode.dRadius     = pbnNode->dRadius;
+  fbnNode.nFirstOwned = m_vFlatOwned.size();
+  m_vFlatOwned.insert( m_vFlatOwned.end(), pbnNode->vOwned.begin(), 
+                       pbnNode->vOwned.end() );
+  m_vFlatDist.insert ( m_vFlatDist.end(), pbnNode->vDist.begin(), 
+                       pbnNode->vDist.end() );
+  assert( m_vFlatOwned.size() == m_vFlatDist.size() );
+  fbnNode.nEndOwned   = m_vFlatOwned.size();
+  fbnNode.nSubtreeEnd = nIdx+1;
+  m_vFlatNodes.push_back( fbnNode );
+
+  for( int i=0; i<pbnNode->nNumChildren; i++ )
+    if( pbnNode->vpbnChild[i] )
+      flattenNode( pbnNode->vpbnChild[i], vpOrder );
+  m_vFlatNodes[nIdx].nSubtreeEnd = (int)m_vFlatNodes.size();
+}
+
+
 /***********************************************************/
 /*                       NN Search                         */
 /***********************************************************/
@@ -1992,6 +2091,20 @@ bool BallTree::findNN( const FeatureVector &fvQuery, float dMaxDist,
   /* tree, if there is one within a search radius of dMaxDist.       */
   /*******************************************************************/
 {
+  if( m_bFrozen ) {
+    /* search the frozen tree */
+    BallTreeSearchState bsState;
+    int   nIdx;
+    float dBestDist;
+    if( findKNN( fvQuery, 1, dMaxDist, &nIdx, &dBestDist, bsState ) == 0 ) {
+      dDist = dMaxDist;
+      return false;
+    }
+    nResult = (unsigned)nIdx;
+    dDist   = dBestDist;
+    return true;
+  }
+
   /* call the recursive search function */
   float dMaxDist2 = dMaxDist;
   dMaxDist = sqrt( dMaxDist2 );
@@ -2314,38 +2427,66 @@ vector<unsigned> BallTree::findNeighbors( const FeatureVector &fvQuery,
   vector<unsigned> vResult;
   vResult.reserve( 20 );
 
-  /* call the recursive search function */
+  BallTreeSearchState bsState;
+  findNeighbors( fvQuery, dMaxDist, vResult, bsState );
+
+  /* update the statistics */
+  m_nCntChecked += bsState.nCntChecked;
+  m_nCntVisited += bsState.nCntVisited;
+  m_nCntDists   += bsState.nCntDists;
+
+  return vResult;
+}
+
+
+void BallTree::findNeighbors( const FeatureVector &fvQuery, float dMaxDist,
+                              vector<unsigned> &vResult,
+                              BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Find all neighbors within a search radius of dMaxDist and       */
+  /* append them to vResult. Thread-safe variant: the search only    */
+  /* reads the tree and keeps all statistics in bsState.             */
+  /*******************************************************************/
+{
+  if( m_pbnRoot == NULL )
+    return;
+
   float dMaxDist2 = dMaxDist;
   dMaxDist = sqrt( dMaxDist2 );
 
+  if( m_bFrozen ) {
+    findNeighborsFlat( fvQuery, dMaxDist, dMaxDist2, vResult, bsState );
+    return;
+  }
+
   /*-------------------*/
   /* Start at the root */
   /*-------------------*/
   if( m_pbnRoot->bHasPivot || m_pbnRoot->nNumOwned>0 )
     /* If the root owns points itself, start checking there */
-    findNeighbors( m_pbnRoot, fvQuery, dMaxDist, dMaxDist2, vResult );
+    findNeighbors( m_pbnRoot, fvQuery, dMaxDist, dMaxDist2, vResult, 
+                   bsState );
   else 
     /* Else, start directly at the root's children nodes */
     for( int i=0; i<m_pbnRoot->nNumChildren; i++ )
       if( m_pbnRoot->vpbnChild[i] )
         findNeighbors( m_pbnRoot->vpbnChild[i], fvQuery, 
-                       dMaxDist, dMaxDist2, vResult );
-
-  return vResult;
+                       dMaxDist, dMaxDist2, vResult, bsState );
 }
 
  
-void BallTree::findNeighbors( BallTreeNode *pbnNode, 
+void BallTree::findNeighbors( const BallTreeNode *pbnNode, 
                               const FeatureVector &fvQuery,
-                              float &dMaxDist, float &dMaxDist2,
-                              vector<unsigned> &vResult )
+                              float dMaxDist, float dMaxDist2,
+                              vector<unsigned> &vResult,
+                              BallTreeSearchState &bsState ) const
   /*******************************************************************/
   /* Find all neighbors for the given query point in the balltree    */
   /* that are within a search radius of dMaxDist.                    */
   /*******************************************************************/
 {
   assert( pbnNode );
-  m_nCntChecked++;
+  bsState.nCntChecked++;
 
   /*--------------------------------------------------------*/
   /* Check if the current node intersects the search volume */
@@ -2362,9 +2503,7 @@ void BallTree::findNeighbors( BallTreeNode *pbnNode,
   float d = (dMaxDist+pbnNode->dRadius);
   if( dDistCenter2 > d*d )
     return;
-//   else if( dDistCenter + pbnNode->dRadius <= dMaxDist )
-//     takeAllChildPoints( pbnNode, vResult );
-  m_nCntVisited++;
+  bsState.nCntVisited++;
 
   /*-----------------------------------------------*/
   /* If it is an anchor node, also check the pivot */
@@ -2381,8 +2520,8 @@ void BallTree::findNeighbors( BallTreeNode *pbnNode,
   /*------------------------------------------------*/
   bool bSkipRest = false;
   bool bTakeRest = false;
-  list<unsigned>::iterator itIdx;
-  list<float>::iterator    itDist;
+  list<unsigned>::const_iterator itIdx;
+  list<float>::const_iterator    itDist;
   for( itIdx=pbnNode->vOwned.begin(), itDist=pbnNode->vDist.begin();
        ( itIdx!=pbnNode->vOwned.end() && itDist!=pbnNode->vDist.end() && 
          !bSkipRest ); itIdx++, itDist++ )
@@ -2390,29 +2529,11 @@ void BallTree::findNeighbors( BallTreeNode *pbnNode,
       if( bTakeRest )
         vResult.push_back( *itIdx );
       else {
-//         float d = dDistCenter - (*itDist);
-//         /* check if the point needs to be checked */
-//         if( d > dMaxDist )
-//           // skip all further points
-//           bSkipRest = true;
-//         else if( d < -dMaxDist )
-//           // skip this point
-//           continue;
-//         else if( dDistCenter + (*itDist) <= dMaxDist ) {
-        //float d1 = ((*itDist) - dMaxDist)*((*itDist) - dMaxDist);
         float d2  = ((*itDist) + dMaxDist); d2 = d2*d2;
         /* check if the point needs to be checked */
         if( dDistCenter2 > d2 )
           // skip all further points
           bSkipRest = true;
-//         else if( dDistCenter2 < d1 )
-//           // skip this point
-//           continue;
-//         else if( dDistCenter + (*itDist) <= dMaxDist ) {
-//           // take all further points without checking
-//           vResult.push_back( *itIdx );
-//           bTakeRest = true;
-//         } else {
         else {
           // use the non-squared distance to enforce further restrictions
           if( dDistCenter<0 )
@@ -2426,9 +2547,8 @@ void BallTree::findNeighbors( BallTreeNode *pbnNode,
             bTakeRest = true;
           } else {
             // check the point
-            FeatureVector &fvPoint = m_vData[*itIdx];
-            float dDistPoint2 = fvQuery.compSSD( fvPoint );
-            m_nCntDists++;
+            float dDistPoint2 = fvQuery.compSSD( m_vData[*itIdx] );
+            bsState.nCntDists++;
             if( dDistPoint2 <= dMaxDist2 ) {
               /* add the point to the neighbor list */
               vResult.push_back( *itIdx );
@@ -2444,7 +2564,571 @@ void BallTree::findNeighbors( BallTreeNode *pbnNode,
     if( pbnNode->vpbnChild[i] )
       /* check if the child needs to be checked */
       findNeighbors( pbnNode->vpbnChild[i], fvQuery, 
-                     dMaxDist, dMaxDist2, vResult );
+                     dMaxDist, dMaxDist2, vResult, bsState );
+}
+
+
+/*---------------------------------------------------------*/
+/*                    k-NN Search                          */
+/*---------------------------------------------------------*/
+
+static inline void addKNNCandidate( BallTreeSearchState &bsState, 
+                                    unsigned nIdx, float dDist2,
+                                    float &dMaxDist, float &dMaxDist2 )
+  /*******************************************************************/
+  /* Insert a candidate into the heap of the k best points found so  */
+  /* far. Once the heap is full, the search radius shrinks to the    */
+  /* distance of the k-th best point (for k=1 this is the same       */
+  /* radius update as in findNN()).                                  */
+  /*******************************************************************/
+{
+  if( !(dDist2 < dMaxDist2) )
+    return;
+
+  vector<ValuePair> &vBest = bsState.vBest;
+  if( vBest.size() >= bsState.nK ) {
+    pop_heap( vBest.begin(), vBest.end() );
+    vBest.pop_back();
+  }
+  vBest.push_back( ValuePair( dDist2, nIdx ) );
+  push_heap( vBest.begin(), vBest.end() );
+
+  if( vBest.size() >= bsState.nK ) {
+    dMaxDist2 = vBest.front().first;
+    dMaxDist  = sqrt( dMaxDist2 );
+  }
+}
+
+
+int BallTree::findKNN( const FeatureVector &fvQuery, unsigned nK, 
+                       float dMaxDist, int *pResults, float *pDists,
+                       BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Find the nK nearest neighbors of the query point within a       */
+  /* search radius of dMaxDist (squared distance, including the      */
+  /* point penalties as in findNN()). The results are written to     */
+  /* pResults[0..nK-1] and pDists[0..nK-1] in order of increasing    */
+  /* distance; unused entries are set to -1. Returns the number of   */
+  /* neighbors found. Thread-safe: the search only reads the tree.   */
+  /*******************************************************************/
+{
+  assert( nK > 0 );
+  bsState.nK = nK;
+  bsState.vBest.clear();
+
+  float dMaxDist2 = dMaxDist;
+  dMaxDist = sqrt( dMaxDist2 );
+  if( m_bFrozen )
+    findKNNFlat( fvQuery, dMaxDist, dMaxDist2, bsState );
+  else if( m_pbnRoot != NULL )
+    findKNN( m_pbnRoot, fvQuery, dMaxDist, dMaxDist2, bsState );
+
+  /* sort by increasing distance */
+  vector<ValuePair> &vBest = bsState.vBest;
+  sort_heap( vBest.begin(), vBest.end() );
+  for( unsigned i=0; i<nK; i++ )
+    if( i < vBest.size() ) {
+      pResults[i] = (int)vBest[i].second;
+      pDists[i]   = vBest[i].first;
+    } else {
+      pResults[i] = -1;
+      pDists[i]   = -1.0;
+    }
+
+  return (int)vBest.size();
+}
+
+
+void BallTree::findKNN( const BallTreeNode *pbnNode, 
+                        const FeatureVector &fvQuery,
+                        float &dMaxDist, float &dMaxDist2,
+                        BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Recursive part of the k-NN search (same traversal as findNN()). */
+  /*******************************************************************/
+{
+  bsState.nCntChecked++;
+
+  /*--------------------------------------------------------*/
+  /* Check if the current node intersects the search volume */
+  /*--------------------------------------------------------*/
+  float dDistCenter2;
+  if( pbnNode->hasPivot() ) // compare with pivot element
+    dDistCenter2 = fvQuery.compSSD(m_vData[pbnNode->nPivot] );
+  else                      // compare with node mean
+    dDistCenter2 = fvQuery.compSSD( pbnNode->fvMean );
+
+  float d = (dMaxDist+pbnNode->dRadius);
+  if( dDistCenter2 > d*d )
+    return;
+  bsState.nCntVisited++;
+
+  /*-----------------------------------------------*/
+  /* If it is an anchor node, also check the pivot */
+  /*-----------------------------------------------*/
+  if( pbnNode->hasPivot() && m_vActive[pbnNode->nPivot] )
+    addKNNCandidate( bsState, pbnNode->nPivot, 
+                     dDistCenter2 + m_vPenalties[pbnNode->nPivot],
+                     dMaxDist, dMaxDist2 );
+
+  /*------------------------------------------------*/
+  /* If the node owns points, check their distances */
+  /*------------------------------------------------*/
+  list<unsigned>::const_iterator itIdx;
+  list<float>::const_iterator    itDist;
+  for( itIdx=pbnNode->vOwned.begin(), itDist=pbnNode->vDist.begin(); 
+       itIdx!=pbnNode->vOwned.end() && itDist!=pbnNode->vDist.end(); 
+       itIdx++, itDist++ )
+    if( m_vActive[*itIdx] ) {
+      /* the points are sorted by decreasing distance to the center */
+      float d2 = ((*itDist) + dMaxDist)*((*itDist) + dMaxDist);
+      if( dDistCenter2 > d2 )
+        break;
+
+      float dDistPoint2 = fvQuery.compSSD( m_vData[*itIdx] );
+      bsState.nCntDists++;
+      addKNNCandidate( bsState, *itIdx, dDistPoint2 + m_vPenalties[*itIdx],
+                       dMaxDist, dMaxDist2 );
+    }
+  
+  /*--------------------------*/
+  /* Check the children nodes */
+  /*--------------------------*/
+  for( int i=0; i<pbnNode->nNumChildren; i++ )
+    if( pbnNode->vpbnChild[i] )
+      findKNN( pbnNode->vpbnChild[i], fvQuery, dMaxDist, dMaxDist2, 
+               bsState );
+}
+
+
+void BallTree::findKNNFlat( const FeatureVector &fvQuery,
+                            float &dMaxDist, float &dMaxDist2,
+                            BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* k-NN search on the frozen tree. The nodes are visited in the    */
+  /* same order as by the recursive findKNN(), so the results are    */
+  /* identical; pruning a node simply jumps over its subtree.        */
+  /*******************************************************************/
+{
+  int          nDims   = m_fmCenters.numDims();
+  int          nNodes  = (int)m_vFlatNodes.size();
+  const float *pQuery  = fvQuery.getDataPtr();
+  assert( fvQuery.numDims() == nDims );
+
+  int i = 0;
+  while( i < nNodes ) {
+    const FlatBallTreeNode &fbnNode = m_vFlatNodes[i];
+    bsState.nCntChecked++;
+
+    /* check if the current node intersects the search volume */
+    float dDistCenter2 = distSSD( pQuery, m_fmCenters.row(i), nDims );
+    float d = (dMaxDist + fbnNode.dRadius);
+    if( dDistCenter2 > d*d ) {
+      i = fbnNode.nSubtreeEnd;
+      continue;
+    }
+    bsState.nCntVisited++;
+
+    /* check the pivot */
+    if( fbnNode.nPivot>=0 && m_vActive[fbnNode.nPivot] )
+      addKNNCandidate( bsState, fbnNode.nPivot, 
+                       dDistCenter2 + m_vPenalties[fbnNode.nPivot],
+                       dMaxDist, dMaxDist2 );
+
+    /* check the owned points (sorted by decreasing center distance) */
+    for( unsigned j=fbnNode.nFirstOwned; j<fbnNode.nEndOwned; j++ ) {
+      unsigned nIdx = m_vFlatOwned[j];
+      if( !m_vActive[nIdx] )
+        continue;
+
+      float d2 = (m_vFlatDist[j] + dMaxDist)*(m_vFlatDist[j] + dMaxDist);
+      if( dDistCenter2 > d2 )
+        break;
+
+      float dDistPoint2 = distSSD( pQuery, m_fmFlatPoints.row(j), nDims );
+      bsState.nCntDists++;
+      addKNNCandidate( bsState, nIdx, dDistPoint2 + m_vPenalties[nIdx],
+                       dMaxDist, dMaxDist2 );
+    }
+
+    /* continue with the children */
+    i++;
+  }
+}
+
+
+void BallTree::findNeighborsFlat( const FeatureVector &fvQuery,
+                                  float dMaxDist, float dMaxDist2,
+                                  vector<unsigned> &vResult,
+                                  BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Range search on the frozen tree (same results and order as the  */
+  /* recursive findNeighbors()).                                     */
+  /*******************************************************************/
+{
+  int          nDims   = m_fmCenters.numDims();
+  int          nNodes  = (int)m_vFlatNodes.size();
+  const float *pQuery  = fvQuery.getDataPtr();
+  assert( fvQuery.numDims() == nDims );
+  if( nNodes == 0 )
+    return;
+
+  /* if the root owns no points itself, start at its children */
+  int i = 0;
+  if( m_vFlatNodes[0].nPivot<0 && 
+      m_vFlatNodes[0].nEndOwned == m_vFlatNodes[0].nFirstOwned )
+    i = 1;
+
+  while( i < nNodes ) {
+    const FlatBallTreeNode &fbnNode = m_vFlatNodes[i];
+    bsState.nCntChecked++;
+
+    /* check if the current node intersects the search volume */
+    float dDistCenter2 = distSSD( pQuery, m_fmCenters.row(i), nDims );
+    float dDistCenter  = -1.0;
+    float d = (dMaxDist + fbnNode.dRadius);
+    if( dDistCenter2 > d*d ) {
+      i = fbnNode.nSubtreeEnd;
+      continue;
+    }
+    bsState.nCntVisited++;
+
+    /* check the pivot */
+    if( fbnNode.nPivot>=0 && m_vActive[fbnNode.nPivot] && 
+        dDistCenter2 <= dMaxDist2 )
+      vResult.push_back( fbnNode.nPivot );
+
+    /* check the owned points (sorted by decreasing center distance) */
+    bool bTakeRest = false;
+    for( unsigned j=fbnNode.nFirstOwned; j<fbnNode.nEndOwned; j++ ) {
+      unsigned nIdx = m_vFlatOwned[j];
+      if( !m_vActive[nIdx] )
+        continue;
+      if( bTakeRest ) {
+        vResult.push_back( nIdx );
+        continue;
+      }
+
+      float d2 = (m_vFlatDist[j] + dMaxDist)*(m_vFlatDist[j] + dMaxDist);
+      if( dDistCenter2 > d2 )
+        break;
+
+      // use the non-squared distance to enforce further restrictions
+      if( dDistCenter<0 )
+        dDistCenter = sqrt( dDistCenter2 );
+      if( dDistCenter - m_vFlatDist[j] < -dMaxDist )
+        // skip this point
+        continue;
+      else if( dDistCenter + m_vFlatDist[j] <= dMaxDist ) {
+        // take all further points without checking
+        vResult.push_back( nIdx );
+        bTakeRest = true;
+      } else {
+        float dDistPoint2 = distSSD( pQuery, m_fmFlatPoints.row(j), nDims );
+        bsState.nCntDists++;
+        if( dDistPoint2 <= dMaxDist2 )
+          vResult.push_back( nIdx );
+      }
+    }
+
+    /* continue with the children */
+    i++;
+  }
+}
+
+
+/*---------------------------------------------------------*/
+/*                  Approximate Search                     */
+/*---------------------------------------------------------*/
+
+int BallTree::findKNNApprox( const FeatureVector &fvQuery, unsigned nK, 
+                             float dMaxDist, int nMaxChecks, 
+                             int *pResults, float *pDists,
+                             BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Approximate version of findKNN(): the nodes of the frozen tree  */
+  /* are searched in order of increasing distance bound, and the     */
+  /* search stops after nMaxChecks point distances. The output is    */
+  /* the same as for findKNN().                                      */
+  /*******************************************************************/
+{
+  assert( nK > 0 );
+  bsState.nK = nK;
+  if( !m_bFrozen ) {
+    cerr << "Error in BallTree::findKNNApprox(): "
+         << "The tree has to be frozen first!" << endl;
+    bsState.vBest.clear();
+  } else
+    searchBestBinFirst( fvQuery, dMaxDist, 0.0, nMaxChecks, NULL, NULL, 
+                        bsState );
+
+  const vector<ValuePair> &vBest = bsState.vBest;
+  for( unsigned i=0; i<nK; i++ )
+    if( i < vBest.size() ) {
+      pResults[i] = (int)vBest[i].second;
+      pDists[i]   = vBest[i].first;
+    } else {
+      pResults[i] = -1;
+      pDists[i]   = -1.0;
+    }
+
+  return (int)vBest.size();
+}
+
+
+void BallTree::findNeighborsApprox( const FeatureVector &fvQuery, 
+                                    float dMaxDist, int nMaxChecks,
+                                    vector<unsigned> &vResult, 
+                                    vector<float>    &vDists,
+                                    BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Approximate version of findNeighbors(): append the points with- */
+  /* in dMaxDist that are found in the first nMaxChecks distance     */
+  /* computations to vResult (in order of discovery) and their       */
+  /* squared distances to vDists. The search also keeps track of the */
+  /* bsState.nK nearest points (with penalties, but regardless of    */
+  /* dMaxDist), which are afterwards in bsState.vBest, sorted by     */
+  /* increasing distance.                                            */
+  /*******************************************************************/
+{
+  if( !m_bFrozen ) {
+    cerr << "Error in BallTree::findNeighborsApprox(): "
+         << "The tree has to be frozen first!" << endl;
+    bsState.vBest.clear();
+    return;
+  }
+  searchBestBinFirst( fvQuery, FLT_MAX, dMaxDist, nMaxChecks, 
+                      &vResult, &vDists, bsState );
+}
+
+
+void BallTree::searchBestBinFirst( const FeatureVector &fvQuery,
+                                   float dMaxDist2, float dRange2, 
+                                   int nMaxChecks,
+                                   vector<unsigned> *pvResult, 
+                                   vector<float>    *pvDists,
+                                   BallTreeSearchState &bsState ) const
+  /*******************************************************************/
+  /* Best-bin-first search on the frozen tree. The nodes wait in a   */
+  /* priority queue ordered by the lower bound max(0,|q-c|-r) on the */
+  /* distance to their points. A node is expanded when it reaches    */
+  /* the front of the queue; the search ends when the front cannot   */
+  /* contain a point that is closer than the current bound (=> exact */
+  /* result) or when nMaxChecks point distances have been computed.  */
+  /*                                                                 */
+  /* Two kinds of results are collected: the bsState.nK nearest      */
+  /* points within dMaxDist2 (shrinking radius, with penalties), and */
+  /* if pvResult is given, all points within dRange2 (fixed radius,  */
+  /* without penalties). The effective pruning radius is the larger  */
+  /* of the two.                                                     */
+  /*******************************************************************/
+{
+  int          nDims  = m_fmCenters.numDims();
+  const float *pQuery = fvQuery.getDataPtr();
+  assert( fvQuery.numDims() == nDims );
+
+  vector<ValuePair>          &vBest  = bsState.vBest;
+  vector<BallTreeQueueEntry> &vQueue = bsState.vQueue;
+  vBest.clear();
+  vQueue.clear();
+  if( m_vFlatNodes.empty() )
+    return;
+
+  float dMaxDist = sqrt( dMaxDist2 );
+  float dRange   = sqrt( dRange2 );
+  long  nStopAt  = bsState.nCntDists + nMaxChecks;
+
+  /*---------------------*/
+  /* Start with the root */
+  /*---------------------*/
+  BallTreeQueueEntry qeEntry;
+  qeEntry.nNode        = 0;
+  qeEntry.dDistCenter2 = distSSD( pQuery, m_fmCenters.row(0), nDims );
+  qeEntry.dBound2      = 0.0;
+  vQueue.push_back( qeEntry );
+  bsState.nCntChecked++;
+
+  while( !vQueue.empty() ) {
+    if( nMaxChecks>0 && bsState.nCntDists >= nStopAt )
+      break;
+
+    /*-----------------------*/
+    /* Take the closest node */
+    /*-----------------------*/
+    pop_heap( vQueue.begin(), vQueue.end() );
+    qeEntry = vQueue.back();
+    vQueue.pop_back();
+
+    float dBound = max( dMaxDist, dRange );
+    if( qeEntry.dBound2 > dBound*dBound )
+      break;  // all remaining nodes are even farther away
+    bsState.nCntVisited++;
+
+    const FlatBallTreeNode &fbnNode = m_vFlatNodes[qeEntry.nNode];
+    float dDistCenter2 = qeEntry.dDistCenter2;
+    float dDistCenter  = sqrt( dDistCenter2 );
+
+    /* check the pivot */
+    if( fbnNode.nPivot>=0 && m_vActive[fbnNode.nPivot] ) {
+      addKNNCandidate( bsState, fbnNode.nPivot, 
+                       dDistCenter2 + m_vPenalties[fbnNode.nPivot],
+                       dMaxDist, dMaxDist2 );
+      if( pvResult && dDistCenter2 <= dRange2 ) {
+        pvResult->push_back( fbnNode.nPivot );
+        pvDists->push_back( dDistCenter2 );
+      }
+    }
+
+    /* check the owned points (sorted by decreasing center distance) */
+    for( unsigned j=fbnNode.nFirstOwned; j<fbnNode.nEndOwned; j++ ) {
+      unsigned nIdx = m_vFlatOwned[j];
+      if( !m_vActive[nIdx] )
+        continue;
+
+      dBound = max( dMaxDist, dRange );
+      if( dDistCenter > m_vFlatDist[j] + dBound )
+        break;
+      if( m_vFlatDist[j] - dDistCenter > dBound )
+        continue;
+
+      float dDistPoint2 = distSSD( pQuery, m_fmFlatPoints.row(j), nDims );
+      bsState.nCntDists++;
+      addKNNCandidate( bsState, nIdx, dDistPoint2 + m_vPenalties[nIdx],
+                       dMaxDist, dMaxDist2 );
+      if( pvResult && dDistPoint2 <= dRange2 ) {
+        pvResult->push_back( nIdx );
+        pvDists->push_back( dDistPoint2 );
+      }
+    }
+
+    /* queue the children */
+    dBound = max( dMaxDist, dRange );
+    for( int c=qeEntry.nNode+1; c<fbnNode.nSubtreeEnd; 
+         c=m_vFlatNodes[c].nSubtreeEnd ) {
+      bsState.nCntChecked++;
+      float dChildDist2 = distSSD( pQuery, m_fmCenters.row(c), nDims );
+      float dLowBound   = sqrt( dChildDist2 ) - m_vFlatNodes[c].dRadius;
+      if( dLowBound > dBound )
+        continue;
+
+      qeEntry.nNode        = c;
+      qeEntry.dDistCenter2 = dChildDist2;
+      qeEntry.dBound2      = ( dLowBound>0.0 ? dLowBound*dLowBound : 0.0 );
+      vQueue.push_back( qeEntry );
+      push_heap( vQueue.begin(), vQueue.end() );
+    }
+  }
+
+  /* sort the nearest points by increasing distance */
+  sort_heap( vBest.begin(), vBest.end() );
+}
+
+
+/*---------------------------------------------------------*/
+/*                    Batch Queries                        */
+/*---------------------------------------------------------*/
+
+struct BallTreeKNNTask
+{
+  const BallTree              *pTree;
+  const vector<FeatureVector> *pQueries;
+  unsigned                     nK;
+  float                        dMaxDist;
+  int                         *pResults;
+  float                       *pDists;
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    BallTreeSearchState bsState;
+    for( int q=nBegin; q<nEnd; q++ )
+      pTree->findKNN( (*pQueries)[q], nK, dMaxDist, 
+                      pResults + (long)q*nK, pDists + (long)q*nK, bsState );
+  }
+};
+
+
+struct BallTreeRangeTask
+{
+  const BallTree              *pTree;
+  const vector<FeatureVector> *pQueries;
+  float                        dMaxDist;
+  vector<int>                  vCounts;         // results per query
+  vector< vector<unsigned> >   vThreadResults;  // results per thread
+
+  void operator()( int nThread, int nBegin, int nEnd )
+  {
+    BallTreeSearchState bsState;
+    vector<unsigned>   &vResults = vThreadResults[nThread];
+    for( int q=nBegin; q<nEnd; q++ ) {
+      int nOld = (int)vResults.size();
+      pTree->findNeighbors( (*pQueries)[q], dMaxDist, vResults, bsState );
+      vCounts[q] = (int)vResults.size() - nOld;
+    }
+  }
+};
+
+
+void BallTree::findKNN( const vector<FeatureVector> &vQueries, 
+                        unsigned nK, float dMaxDist,
+                        vector<int>   &vResults, vector<float> &vDists,
+                        int nThreads ) const
+  /*******************************************************************/
+  /* Find the nK nearest neighbors (within dMaxDist) for all queries */
+  /* in parallel. The results of query q are stored in the flat      */
+  /* arrays at positions [q*nK, (q+1)*nK), sorted by increasing dis- */
+  /* tance and padded with -1. nThreads<=0 uses all processors.      */
+  /*******************************************************************/
+{
+  assert( nK > 0 );
+  vResults.assign( vQueries.size()*nK, -1 );
+  vDists.assign  ( vQueries.size()*nK, -1.0 );
+  if( vQueries.empty() )
+    return;
+
+  BallTreeKNNTask task;
+  task.pTree    = this;
+  task.pQueries = &vQueries;
+  task.nK       = nK;
+  task.dMaxDist = dMaxDist;
+  task.pResults = &vResults[0];
+  task.pDists   = &vDists[0];
+  parallelFor( 0, (int)vQueries.size(), nThreads, task );
+}
+
+
+void BallTree::findNeighbors( const vector<FeatureVector> &vQueries,
+                              float dMaxDist,
+                              vector<int>      &vOffsets, 
+                              vector<unsigned> &vResults,
+                              int nThreads ) const
+  /*******************************************************************/
+  /* Find all neighbors within dMaxDist for all queries in parallel. */
+  /* The neighbors of query q are vResults[vOffsets[q]] ...          */
+  /* vResults[vOffsets[q+1]-1], in the same order as returned by the */
+  /* single-query version. nThreads<=0 uses all processors.          */
+  /*******************************************************************/
+{
+  int nQueries = (int)vQueries.size();
+  vOffsets.assign( nQueries+1, 0 );
+  vResults.clear();
+  if( nQueries == 0 )
+    return;
+
+  BallTreeRangeTask task;
+  task.pTree    = this;
+  task.pQueries = &vQueries;
+  task.dMaxDist = dMaxDist;
+  task.vCounts.assign( nQueries, 0 );
+  task.vThreadResults.resize( getNumThreads( nThreads, nQueries ) );
+  int nUsed = parallelFor( 0, nQueries, nThreads, task );
+
+  /* concatenate the per-thread results (in query order) */
+  for( int q=0; q<nQueries; q++ )
+    vOffsets[q+1] = vOffsets[q] + task.vCounts[q];
+  vResults.reserve( vOffsets[nQueries] );
+  for( int t=0; t<nUsed; t++ )
+    vResults.insert( vResults.end(), task.vThreadResults[t].begin(),
+                     task.vThreadResults[t].end() );
 }
 
 
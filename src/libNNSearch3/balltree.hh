@@ -31,6 +31,7 @@
 #include <string>
 #include <cassert>
 #include <featurevector.hh>
+#include <featurematrix.hh>
 #include <clstep.hh>
 
 /*******************/
@@ -43,6 +44,55 @@ const unsigned DEF_MAXNUMOWNED = 200;
 /*************************/
 typedef pair<float,unsigned> ValuePair;
 
+/* entry of the node queue for the best-bin-first search */
+struct BallTreeQueueEntry
+{
+  float dBound2;       // squared lower bound on the distance to the node
+  float dDistCenter2;  // squared distance to the node center
+  int   nNode;         // index in the frozen node array
+
+  /* reversed, so that the STL heap yields the closest node first */
+  bool operator<( const BallTreeQueueEntry &other ) const
+  { return dBound2 > other.dBound2; }
+};
+
+/*===================================================================*/
+/*                      Struct BallTreeSearchState                   */
+/*===================================================================*/
+/* Per-query search state. It is kept off the tree nodes, so that    */
+/* several queries can run concurrently on the same (unmodified)     */
+/* tree, each with its own state object.                             */
+struct BallTreeSearchState
+{
+  BallTreeSearchState() 
+  { nK=1; nCntChecked=0; nCntVisited=0; nCntDists=0; }
+
+  unsigned          nK;          // number of neighbors searched for
+  vector<ValuePair> vBest;       // max-heap of the nK best (dist,idx)
+  vector<BallTreeQueueEntry> vQueue; // nodes to visit (best-bin-first)
+
+  long              nCntChecked;
+  long              nCntVisited;
+  long              nCntDists;
+};
+
+/*===================================================================*/
+/*                       Struct FlatBallTreeNode                     */
+/*===================================================================*/
+/* Node of the frozen (read-only) balltree. All nodes are stored in  */
+/* one array in depth-first order, so that the subtree of node i     */
+/* occupies the entries i...nSubtreeEnd-1 and a pruned subtree can   */
+/* be skipped by a single jump. The node center is row i of the      */
+/* center matrix; the owned points are a contiguous range.           */
+struct FlatBallTreeNode
+{
+  int      nPivot;       // pivot point index (-1 if none)
+  float    dRadius;
+  int      nSubtreeEnd;  // index behind the last node of the subtree
+  unsigned nFirstOwned;  // owned points: [nFirstOwned, nEndOwned)
+  unsigned nEndOwned;
+};
+
 /*===================================================================*/
 /*                         Class BallTreeNode                        */
 /*===================================================================*/
@@ -121,7 +171,8 @@ public:
   /**********************/
   /*   Content Access   */
   /**********************/
-  bool isValid() { return m_bIsValid; }
+  bool     isValid() { return m_bIsValid; }
+  unsigned numPoints() const { return m_vData.size(); }
 
   void init( const vector<FeatureVector> &vData, bool bVerbose=false );
 
@@ -200,6 +251,20 @@ public:
 
   void updateRadii ( float dQuantile=1.0 );
 
+  /*-------------------------------------------------------*/
+  /* The queries run on a frozen copy of the tree in a     */
+  /* flat, contiguous layout. Any change to the structure  */
+  /* (insertPoint, updatePoint, mergePoints, updateRadii)  */
+  /* drops the frozen copy and the queries fall back to    */
+  /* the pointer-based nodes until freeze() is called      */
+  /* again. build() and buildFromClusterTrace() freeze the */
+  /* tree automatically. Penalties and active flags may    */
+  /* be changed without unfreezing.                        */
+  /*-------------------------------------------------------*/
+  void freeze      ();
+  void unfreeze    ();
+  bool isFrozen    () const { return m_bFrozen; }
+
   void clearStats  () 
   { m_nCntChecked=0; m_nCntVisited=0; m_nCntDists=0; }
   void getStats    ( long &nCntChecked, long &nCntVisited, long &nCntDists )
@@ -217,6 +282,9 @@ protected:
 
   void updateRadii ( BallTreeNode *pbnNode, float dQuantile=1.0 );
 
+  void flattenNode ( const BallTreeNode *pbnNode, 
+                     vector<const BallTreeNode*> &vpOrder );
+
 public:
   /*****************/
   /*   NN Search   */
@@ -228,6 +296,44 @@ public:
   vector<unsigned> findNeighbors( const FeatureVector &fvQuery,
                                   float dMaxDist );
 
+  /*-------------------------------------------------------*/
+  /* Thread-safe queries (the tree must not be modified    */
+  /* meanwhile). All distances are squared distances.      */
+  /*-------------------------------------------------------*/
+  int  findKNN      ( const FeatureVector &fvQuery, unsigned nK, 
+                      float dMaxDist, int *pResults, float *pDists,
+                      BallTreeSearchState &bsState ) const;
+  void findNeighbors( const FeatureVector &fvQuery, float dMaxDist,
+                      vector<unsigned> &vResult,
+                      BallTreeSearchState &bsState ) const;
+
+  void findKNN      ( const vector<FeatureVector> &vQueries, 
+                      unsigned nK, float dMaxDist,
+                      vector<int>   &vResults, vector<float> &vDists,
+                      int nThreads=0 ) const;
+  void findNeighbors( const vector<FeatureVector> &vQueries,
+                      float dMaxDist,
+                      vector<int>      &vOffsets, 
+                      vector<unsigned> &vResults,
+                      int nThreads=0 ) const;
+
+  /*-------------------------------------------------------*/
+  /* Approximate queries (best-bin-first on the frozen     */
+  /* tree). The nodes are visited in order of their lower  */
+  /* distance bound until the node in which the nMaxChecks */
+  /* -th point distance was computed is finished;          */
+  /* nMaxChecks<=0 gives the exact result.                 */
+  /*-------------------------------------------------------*/
+  int  findKNNApprox      ( const FeatureVector &fvQuery, unsigned nK, 
+                            float dMaxDist, int nMaxChecks,
+                            int *pResults, float *pDists,
+                            BallTreeSearchState &bsState ) const;
+  void findNeighborsApprox( const FeatureVector &fvQuery, float dMaxDist,
+                            int nMaxChecks,
+                            vector<unsigned> &vResult, 
+                            vector<float>    &vDists,
+                            BallTreeSearchState &bsState ) const;
+
 protected:
   bool findNN       ( BallTreeNode *pbnNode, 
                       const FeatureVector &fvQuery, 
@@ -242,10 +348,26 @@ protected:
                       unsigned &nResult,
                       BallTreeNode *pbnStopAt=NULL,
                       bool bVerbose=false );
-  void findNeighbors( BallTreeNode *pbnNode, 
+  void findKNN      ( const BallTreeNode *pbnNode, 
                       const FeatureVector &fvQuery, 
                       float &dMaxDist, float &dMaxDist2,
-                      vector<unsigned> &vResult );
+                      BallTreeSearchState &bsState ) const;
+  void findNeighbors( const BallTreeNode *pbnNode, 
+                      const FeatureVector &fvQuery, 
+                      float dMaxDist, float dMaxDist2,
+                      vector<unsigned> &vResult,
+                      BallTreeSearchState &bsState ) const;
+  void findKNNFlat  ( const FeatureVector &fvQuery, 
+                      float &dMaxDist, float &dMaxDist2,
+                      BallTreeSearchState &bsState ) const;
+  void findNeighborsFlat( const FeatureVector &fvQuery, 
+                          float dMaxDist, float dMaxDist2,
+                          vector<unsigned> &vResult,
+                          BallTreeSearchState &bsState ) const;
+  void searchBestBinFirst( const FeatureVector &fvQuery,
+                          float dMaxDist2, float dRange2, int nMaxChecks,
+                          vector<unsigned> *pvResult, vector<float> *pvDists,
+                          BallTreeSearchState &bsState ) const;
   void takeAllChildPoints( BallTreeNode *pbnNode,
                            vector<unsigned> &vResult );
 
@@ -284,6 +406,14 @@ protected:
 
   bool m_bIsValid;
 
+  /* frozen tree */
+  bool                     m_bFrozen;
+  vector<FlatBallTreeNode> m_vFlatNodes;
+  FeatureMatrix            m_fmCenters;    // node centers (pivot or mean)
+  vector<unsigned>         m_vFlatOwned;   // owned point indices
+  vector<float>            m_vFlatDist;    // their distances to the center
+  FeatureMatrix            m_fmFlatPoints; // their data, in the same order
+
   long m_nCntVisited;
   long m_nCntChecked;
   long m_nCntDists;
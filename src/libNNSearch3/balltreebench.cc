@@ -0,0 +1,176 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         balltreebench.cc                                     */
+/*                                                                   */
+/* CONTENT      Benchmark for the frozen balltree layout. Builds a   */
+/*              balltree on random data, runs the same range and     */
+/*              k-NN queries on the pointer-based nodes and on the   */
+/*              frozen copy, and reports the getStats() counts, the  */
+/*              wall time, and whether the results are identical.    */
+/*                                                                   */
+/*              Not part of the library; compile with                */
+/*                g++ -O3 -I. -I$(HOME)/code/include \               */
+/*                    balltreebench.cc balltree.cc -lFeatures \      */
+/*                    -lpthread -o balltreebench                     */
+/*              and run as                                           */
+/*                balltreebench [#points] [#dims] [#queries]         */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "balltree.hh"
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const unsigned NUM_NEIGHBORS   = 10;
+const float    RANGE_QUANTILE  = 0.001;  // fraction of points in range
+
+
+double getTime()
+{
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+void makeRandomData( int nPoints, int nDims, vector<FeatureVector> &vData )
+  /* clustered random data (the tree is of little use on uniform data) */
+{
+  int nClusters = max( nPoints/200, 1 );
+  vector<FeatureVector> vCenters;
+  for( int c=0; c<nClusters; c++ ) {
+    vector<float> vCenter( nDims );
+    for( int d=0; d<nDims; d++ )
+      vCenter[d] = rand()/(float)RAND_MAX;
+    vCenters.push_back( FeatureVector( vCenter ) );
+  }
+
+  vData.clear();
+  for( int i=0; i<nPoints; i++ ) {
+    const FeatureVector &fvCenter = vCenters[rand()%nClusters];
+    vector<float> vPoint( nDims );
+    for( int d=0; d<nDims; d++ )
+      vPoint[d] = fvCenter.at(d) + 0.1*(rand()/(float)RAND_MAX - 0.5);
+    vData.push_back( FeatureVector( vPoint ) );
+  }
+}
+
+
+void runQueries( BallTree &btTree, const vector<FeatureVector> &vQueries,
+                 float dRange, vector< vector<unsigned> > &vRangeRes,
+                 vector<int> &vKNNRes, double &dRangeTime,
+                 double &dKNNTime )
+{
+  /*---------------*/
+  /* Range queries */
+  /*---------------*/
+  btTree.clearStats();
+  vRangeRes.resize( vQueries.size() );
+  double dStart = getTime();
+  for( unsigned q=0; q<vQueries.size(); q++ )
+    vRangeRes[q] = btTree.findNeighbors( vQueries[q], dRange );
+  dRangeTime = getTime() - dStart;
+
+  long nCntChecked, nCntVisited, nCntDists;
+  btTree.getStats( nCntChecked, nCntVisited, nCntDists );
+  cout << "      range: " << setw(9) << setprecision(2) << fixed
+       << 1e3*dRangeTime << " ms"
+       << "   checked " << setw(10) << nCntChecked
+       << "   visited " << setw(10) << nCntVisited
+       << "   dists " << setw(10) << nCntDists << endl;
+
+  /*--------------*/
+  /* k-NN queries */
+  /*--------------*/
+  BallTreeSearchState bsState;
+  vector<float> vDists( NUM_NEIGHBORS );
+  vKNNRes.resize( vQueries.size()*NUM_NEIGHBORS );
+  dStart = getTime();
+  for( unsigned q=0; q<vQueries.size(); q++ )
+    btTree.findKNN( vQueries[q], NUM_NEIGHBORS, 1e30,
+                    &vKNNRes[q*NUM_NEIGHBORS], &vDists[0], bsState );
+  dKNNTime = getTime() - dStart;
+
+  cout << "      " << NUM_NEIGHBORS << "-NN : " << setw(9) << 1e3*dKNNTime
+       << " ms"
+       << "   checked " << setw(10) << bsState.nCntChecked
+       << "   visited " << setw(10) << bsState.nCntVisited
+       << "   dists " << setw(10) << bsState.nCntDists << endl;
+}
+
+
+int main( int argc, char **argv )
+{
+  int nPoints  = ( argc>1 ? atoi(argv[1]) : 50000 );
+  int nDims    = ( argc>2 ? atoi(argv[2]) : 64 );
+  int nQueries = ( argc>3 ? atoi(argv[3]) : 1000 );
+
+  srand( 42 );
+  vector<FeatureVector> vData, vQueries;
+  makeRandomData( nPoints,  nDims, vData );
+  makeRandomData( nQueries, nDims, vQueries );
+
+  cout << "Balltree layout benchmark (" << nPoints << " points, " << nDims
+       << " dims, " << nQueries << " queries)" << endl;
+  cout << "  Building the tree... " << flush;
+  double dStart = getTime();
+  BallTree btTree;
+  btTree.build( vData );
+  cout << "done (" << setprecision(2) << fixed << getTime()-dStart
+       << "s)." << endl;
+
+  /* pick the range such that a few points fall inside on average */
+  vector<float> vSample;
+  for( int i=0; i<1000; i++ )
+    vSample.push_back( vQueries[i%nQueries].compSSD(vData[rand()%nPoints]) );
+  sort( vSample.begin(), vSample.end() );
+  float dRange = vSample[ (int)(RANGE_QUANTILE*vSample.size()) ];
+
+  /*----------------------*/
+  /* Pointer-based layout */
+  /*----------------------*/
+  vector< vector<unsigned> > vRangeRes1, vRangeRes2;
+  vector<int>                vKNNRes1,   vKNNRes2;
+  double dRangeTime1, dKNNTime1, dRangeTime2, dKNNTime2;
+
+  btTree.unfreeze();
+  cout << "    pointer-based nodes:" << endl;
+  runQueries( btTree, vQueries, dRange, vRangeRes1, vKNNRes1,
+              dRangeTime1, dKNNTime1 );
+
+  /*---------------*/
+  /* Frozen layout */
+  /*---------------*/
+  dStart = getTime();
+  btTree.freeze();
+  double dFreezeTime = getTime() - dStart;
+  cout << "    frozen nodes (freeze: " << 1e3*dFreezeTime << " ms):" << endl;
+  runQueries( btTree, vQueries, dRange, vRangeRes2, vKNNRes2,
+              dRangeTime2, dKNNTime2 );
+
+  /*---------*/
+  /* Summary */
+  /*---------*/
+  bool bIdentical = ( vRangeRes1 == vRangeRes2 && vKNNRes1 == vKNNRes2 );
+  cout << "  speedup: range " << dRangeTime1/dRangeTime2 << "x, "
+       << NUM_NEIGHBORS << "-NN " << dKNNTime1/dKNNTime2 << "x; results "
+       << ( bIdentical ? "identical." : "DIFFER!" ) << endl;
+
+  return ( bIdentical ? 0 : 1 );
+}
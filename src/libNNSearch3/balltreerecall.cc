@@ -0,0 +1,164 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         balltreerecall.cc                                    */
+/*                                                                   */
+/* CONTENT      Recall vs. speed report for the approximate balltree */
+/*              search, used to choose the maximal number of checks  */
+/*              (MatchingGUI::m_nMaxLeafChecks) for a codebook. The  */
+/*              codebook clusters and a set of query features are    */
+/*              read from feature vector lists; the matching radius  */
+/*              is derived from the rejection threshold and the sim  */
+/*              factor in the same way as in Codebook::matchTo-      */
+/*              CodebookEuclid(). For an increasing number of checks */
+/*              it reports the NN recall, the fraction of the        */
+/*              neighbors within the radius that were found, and the */
+/*              time per query relative to brute-force matching.     */
+/*                                                                   */
+/*              Not part of the library; compile with                */
+/*                g++ -O3 -I. -I$(HOME)/code/include \               */
+/*                    balltreerecall.cc balltree.cc -lFeatures \     */
+/*                    -lpthread -o balltreerecall                    */
+/*              and run as                                           */
+/*                balltreerecall <clusters> <queries> [rej.thresh]   */
+/*                               [sim.fact]                          */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <sys/time.h>
+
+#include "balltree.hh"
+
+using namespace std;
+
+/*******************/
+/*   Definitions   */
+/*******************/
+const float DEF_REJECTION_THRESH = 0.7;
+const float DEF_FEATURE_SIM_FACT = 800.0;
+
+
+double getTime()
+{
+  struct timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+
+int main( int argc, char **argv )
+{
+  if( argc < 3 ) {
+    cerr << "Usage: " << argv[0] << " <clusters> <queries> "
+         << "[rej.thresh=" << DEF_REJECTION_THRESH << "] "
+         << "[sim.fact=" << DEF_FEATURE_SIM_FACT << "]" << endl;
+    return 1;
+  }
+  float dRejectionThresh = ( argc>3 ? atof(argv[3]) : DEF_REJECTION_THRESH );
+  float dFeatureSimFact  = ( argc>4 ? atof(argv[4]) : DEF_FEATURE_SIM_FACT );
+
+  vector<FeatureVector> vClusters, vQueries;
+  if( !loadFeatureVectorList( argv[1], vClusters ) || vClusters.empty() ||
+      !loadFeatureVectorList( argv[2], vQueries )  || vQueries.empty() ) {
+    cerr << "Error: Couldn't load the feature vectors!" << endl;
+    return 1;
+  }
+  int nClusters = (int)vClusters.size();
+  int nQueries  = (int)vQueries.size();
+  int nDims     = vClusters.front().numDims();
+
+  /* sim = exp(-dist/dDistFact) > dRejectionThresh */
+  float dDistFact = dFeatureSimFact*nDims;
+  float dMaxDist  = -dDistFact*log( dRejectionThresh );
+
+  cout << "Approximate balltree search: " << nClusters << " clusters, "
+       << nQueries << " queries, " << nDims << " dims, max. dist "
+       << dMaxDist << endl;
+
+  /*------------------------------*/
+  /* Brute-force reference result */
+  /*------------------------------*/
+  vector<int> vExactNN( nQueries, -1 );
+  vector<int> vNumInRange( nQueries, 0 );
+  long        nTotalInRange = 0;
+  double dStart = getTime();
+  for( int q=0; q<nQueries; q++ ) {
+    float dMinDist = FLT_MAX;
+    for( int c=0; c<nClusters; c++ ) {
+      float dDist = vQueries[q].compSSD( vClusters[c] );
+      if( dDist < dMinDist ) {
+        dMinDist    = dDist;
+        vExactNN[q] = c;
+      }
+      if( dDist <= dMaxDist )
+        vNumInRange[q]++;
+    }
+    nTotalInRange += vNumInRange[q];
+  }
+  double dBruteTime = (getTime() - dStart)/nQueries;
+
+  dStart = getTime();
+  BallTree btTree;
+  btTree.build( vClusters );
+  cout << "  tree built in " << setprecision(2) << fixed
+       << getTime()-dStart << "s; brute force: " << 1e6*dBruteTime
+       << " us/query, " << nTotalInRange/(double)nQueries
+       << " neighbors/query" << endl << endl;
+
+  /*-----------------------------*/
+  /* Increasing number of checks */
+  /*-----------------------------*/
+  cout << setw(10) << "checks" << setw(12) << "dists/q" << setw(12)
+       << "NN recall" << setw(14) << "range recall" << setw(12) << "us/q"
+       << setw(10) << "speedup" << endl;
+
+  vector<int> vChecks;
+  for( int n=16; n<nClusters; n*=2 )
+    vChecks.push_back( n );
+  vChecks.push_back( 0 );  // exact
+
+  for( unsigned i=0; i<vChecks.size(); i++ ) {
+    BallTreeSearchState bsState;
+    vector<unsigned>    vResult;
+    vector<float>       vDists;
+    int  nNNCorrect = 0;
+    long nFound     = 0;
+
+    dStart = getTime();
+    for( int q=0; q<nQueries; q++ ) {
+      vResult.clear();
+      vDists.clear();
+      btTree.findNeighborsApprox( vQueries[q], dMaxDist, vChecks[i],
+                                  vResult, vDists, bsState );
+      if( !bsState.vBest.empty() &&
+          (int)bsState.vBest.front().second == vExactNN[q] )
+        nNNCorrect++;
+      nFound += vResult.size();
+    }
+    double dTime = (getTime() - dStart)/nQueries;
+
+    if( vChecks[i] > 0 )
+      cout << setw(10) << vChecks[i];
+    else
+      cout << setw(10) << "exact";
+    cout << setw(12) << setprecision(1) << bsState.nCntDists/(double)nQueries
+         << setw(12) << setprecision(3) << nNNCorrect/(double)nQueries
+         << setw(14) << ( nTotalInRange>0 ? nFound/(double)nTotalInRange
+                                          : 1.0 )
+         << setw(12) << setprecision(1) << 1e6*dTime
+         << setw(9)  << setprecision(2) << dBruteTime/dTime << "x" << endl;
+  }
+
+  return 0;
+}
@@ -47,6 +47,7 @@
 FeatureCue::FeatureCue()
 {
   m_guiParams=0;
+  m_pScaleCache=0;
   
   /* seed the random number generator */
   timeval time;
@@ -760,11 +761,20 @@ void FeatureCue::applyExactDoG( bool bVerbose )
 /* (without a Gaussian pyramid, but with scale interpolation).     */
 /*******************************************************************/
 {
-  /* compute the scale space */
-  DoGScaleSpace dogscale( m_imgSrc,
-                          m_guiParams->m_nScaleOctaves,
-                          m_guiParams->m_nLevsPerOctave,
-                          m_guiParams->m_dScaleSigma0 );
+  /* compute the scale space (from the shared cache only if that is */
+  /* enabled; it approximates the direct DoG, see DoGScaleSpace)     */
+  DoGScaleSpace dogscale;
+  if( m_guiParams->m_bUseScaleCache &&
+      m_pScaleCache!=0 && m_pScaleCache->isCompatible( m_imgSrc ) )
+    dogscale = DoGScaleSpace( *m_pScaleCache,
+                              m_guiParams->m_nScaleOctaves,
+                              m_guiParams->m_nLevsPerOctave,
+                              m_guiParams->m_dScaleSigma0 );
+  else
+    dogscale = DoGScaleSpace( m_imgSrc,
+                              m_guiParams->m_nScaleOctaves,
+                              m_guiParams->m_nLevsPerOctave,
+                              m_guiParams->m_dScaleSigma0 );
   
   /* extract the interest points */
   PointVector vPoints = dogscale.getScaleMaxima3D( m_guiParams->m_dThreshEdog,
@@ -29,6 +29,7 @@ using namespace std;
 #include <oprgbimage.hh>
 #include <opgrayimage.hh>
 #include <opinterestimage.hh>
+#include <scalespacecache.hh>
 
 #include "featuregui.hh"
 
@@ -66,6 +67,10 @@ public:
   /*********************/
   FeatureGUI* createGUI( QWidget *parent=0, const char* name=0 );
   void        setGUI   ( FeatureGUI* pGUI ) { m_guiParams = pGUI; }
+
+  /* share the scale space of the current frame with the other cues */
+  void        setScaleSpaceCache( ScaleSpaceCache* pCache ) 
+  { m_pScaleCache = pCache; }
   
 public:
   /**************************/
@@ -237,6 +242,8 @@ protected:
   vector<OpGrayImage>   m_vPatches;
   vector<FeatureVector> m_vFeatures;
   vector<int>           m_vPtIdzs; // the index of interet points inside the bounding box in m_vPoints, same length with m_vPonitsInside
+
+  ScaleSpaceCache*      m_pScaleCache;
   
 public:
   FeatureGUI* m_guiParams;
@@ -146,6 +146,15 @@ FeatureGUI::FeatureGUI( QWidget *parent, const char *name )
 	tabpExtract->addWidget( chkExtractFromWholeImage );
 	QT_CONNECT_CHECKBOX( chkExtractFromWholeImage, ExtractFromWholeImage);
 
+    /* the shared scale space is faster, but only approximates the */
+    /* Exact DoG (other points for the same threshold), so it is off */
+    chkUseScaleCache = new QCheckBox( "Exact DoG from shared scale space",
+                                      tabwExtract, "chkusescalecache" );
+    chkUseScaleCache->setChecked(false);
+    m_bUseScaleCache = chkUseScaleCache->isChecked();
+    tabpExtract->addWidget( chkUseScaleCache );
+    QT_CONNECT_CHECKBOX( chkUseScaleCache, UseScaleCache );
+
 
     /*****************************************/
     /*   make parameter fields for Features  */
@@ -402,6 +411,7 @@ void FeatureGUI::saveParams( string sFileName, bool bVerbose )
              << "m_nPatchExtMethod: " << m_nPatchExtMethod << "\n"
              << "m_nStepSize: " << m_nStepSize << "\n"
              << "m_bUseFigureOnly: " << m_bUseFigureOnly << "\n"
+             << "m_bUseScaleCache: " << m_bUseScaleCache << "\n"
         //--- Features tab ---//
              << "m_nFeatureType: " << m_nFeatureType << "\n"
              << "m_bMakeRotInv: " << m_bMakeRotInv << "\n"
@@ -525,6 +535,11 @@ void FeatureGUI::loadParams( string sFileName, bool bVerbose )
             chkUseFigureOnly->setChecked((bool)val.toInt());
             slotSetUseFigureOnlyOnOff(val.toInt());
           }
+        else if (name.compare("m_bUseScaleCache")==0)
+          {
+            chkUseScaleCache->setChecked((bool)val.toInt());
+            slotSetUseScaleCacheOnOff(val.toInt());
+          }
         //--------------------//
         //--- Features tab ---//
         //--------------------//
@@ -664,4 +679,5 @@ QT_IMPLEMENT_RADIOBUTTON( FeatureGUI::slot, PatchExtMethod, m_nPatchExtMethod )
 QT_IMPLEMENT_RADIOBUTTON( FeatureGUI::slot, FeatureType, m_nFeatureType )
 QT_IMPLEMENT_CHECKBOX( FeatureGUI::slot, UseFigureOnly, m_bUseFigureOnly )
 QT_IMPLEMENT_CHECKBOX( FeatureGUI::slot, ExtractFromWholeImage, m_bExtractFromWholeImage )
+QT_IMPLEMENT_CHECKBOX( FeatureGUI::slot, UseScaleCache, m_bUseScaleCache )
 QT_IMPLEMENT_RADIOBUTTON( FeatureGUI::slot, NormalizeMethod, m_nNormalizeMethod)
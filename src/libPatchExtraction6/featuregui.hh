@@ -126,6 +126,7 @@ public slots:
 
   void slotSetUseFigureOnlyOnOff    ( int   state );
   void slotSetExtractFromWholeImageOnOff ( int   state );
+  void slotSetUseScaleCacheOnOff    ( int   state );
   void slotSetFilterPatchesOnOff    ( int   state );
   void slotSetMakeRotInvOnOff       ( int   state );
 
@@ -171,6 +172,7 @@ private:
 
 	QCheckBox*    chkUseFigureOnly;
     QCheckBox*    chkExtractFromWholeImage;
+  QCheckBox*    chkUseScaleCache;
   QCheckBox*    chkFilterPatches;
 	QCheckBox*    chkRotInv;
 	QCheckBox*    chkColorCanny;
@@ -221,6 +223,7 @@ public:
   
   bool   m_bUseFigureOnly;
   bool   m_bExtractFromWholeImage;
+  bool   m_bUseScaleCache;   // Exact DoG from the shared (approx.) scale space
   bool   m_bMakeRotInv;
 
   int    m_nMinFigurePixels;
@@ -0,0 +1,478 @@
+/********************************************************************/
+/*																	*/
+/*FILE         	compiledforest.cc									*/
+/*																	*/
+/*CONTENT		Flat array copy of a trained random forest			*/
+/*																	*/
+/*BEGIN			SAT OCT 17	 2026									*/
+/*LAST CHANGE	SAT OCT 17	 2026									*/
+/*																	*/
+/********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <map>
+
+#include <parallelfor.hh>
+
+#include "compiledforest.hh"
+
+/*******************/
+/*   Definitions   */
+/*******************/
+// Number of patches that are pushed through one tree before going on
+// to the next tree (the nodes of a tree stay in the cache)
+const uint32_t TEST_BLOCK_SIZE = 64;
+
+/*===================================================================*/
+/*                         Struct CFTestTask                         */
+/*===================================================================*/
+struct CFTestTask
+{
+	const CompiledForest*	pForest;
+	const uint8_t*			pBytes;
+	const float*			pFloats;
+	size_t					nSampleSize;
+	const vector<int>*		pOffsets;
+	uint32_t*				pLeaves;
+
+	void operator()(int nThread, int nBegin, int nEnd)
+	{
+		if(pBytes)
+			pForest->testBlock(pBytes, nSampleSize, *pOffsets, nBegin, nEnd, pLeaves);
+		else
+			pForest->testBlock(pFloats, nSampleSize, *pOffsets, nBegin, nEnd, pLeaves);
+	}
+};
+
+/*===================================================================*/
+/*                         Class CompiledForest                      */
+/*===================================================================*/
+/********************/
+/*   Constructor    */
+/********************/
+CompiledForest::CompiledForest()
+{
+	m_nThreads = 0;
+	clear();
+}
+
+/********************/
+/*   Creation       */
+/********************/
+void CompiledForest::clear()
+{
+	m_nTrees = 0;
+	m_nClasses = 0;
+	m_vNodes.clear();
+	m_vRoots.clear();
+	m_vLeafKeys.clear();
+	m_vLeafTrees.clear();
+	m_vProportions.clear();
+	m_vValidPatches.clear();
+	m_vCoefficients.clear();
+	m_vCoordStart.assign(1, 0);
+	m_vCoords.clear();
+}
+
+bool CompiledForest::compile(RandomForest& rfForest)
+/*==================================================================*/
+/* Copy the split tests and the leaf data of all trees. The nodes   */
+/* of a tree are numbered in key order first, then the children of  */
+/* the split nodes are looked up.                                   */
+/*==================================================================*/
+{
+	clear();
+	m_nClasses = rfForest.getTotalClasses();
+	int nTrees = rfForest.getNumTrees();
+	for(int t=0;t<nTrees;t++)
+	{
+		map<uint32_t, RandomNode>& mNodes = rfForest.getTree(t).m_rnNodes;
+		if(mNodes.count(1) == 0)
+		{
+			cerr<< "Error in CompiledForest::compile: tree "<< t <<" has no root"<<endl;
+			clear();
+			return false;
+		}
+		// Index (or ~leaf) of each key
+		map<uint32_t, int32_t> mIndex;
+		for(map<uint32_t, RandomNode>::iterator itr=mNodes.begin(); itr!=mNodes.end(); itr++)
+		{
+			RandomNode& rnNode = itr->second;
+			if(rnNode.getLeft()==0 && rnNode.getRight()==0)
+			{
+				mIndex[itr->first] = ~(int32_t)m_vLeafKeys.size();
+				addLeaf(rnNode, t);
+			}
+			else
+			{
+				mIndex[itr->first] = m_vNodes.size();
+				Node node;
+				node.nChannel = rnNode.getChannel();
+				node.p = rnNode.getp();
+				node.q = rnNode.getq();
+				node.r = rnNode.getr();
+				node.s = rnNode.gets();
+				node.t = rnNode.gett();
+				node.nLeft = 0;
+				node.nRight = 0;
+				m_vNodes.push_back(node);
+			}
+		}
+		// Link the children
+		for(map<uint32_t, RandomNode>::iterator itr=mNodes.begin(); itr!=mNodes.end(); itr++)
+		{
+			int32_t nIndex = mIndex[itr->first];
+			if(nIndex < 0)
+				continue;
+			RandomNode& rnNode = itr->second;
+			if(mIndex.count(rnNode.getLeft())==0 || mIndex.count(rnNode.getRight())==0)
+			{
+				cerr<< "Error in CompiledForest::compile: node "<< itr->first <<
+					" of tree "<< t <<" has a missing child"<<endl;
+				clear();
+				return false;
+			}
+			m_vNodes[nIndex].nLeft = mIndex[rnNode.getLeft()];
+			m_vNodes[nIndex].nRight = mIndex[rnNode.getRight()];
+		}
+		m_vRoots.push_back(mIndex[1]);
+	}
+	m_nTrees = nTrees;
+	// Coef = 1/T * Proportion / Valid Patches (as in testRandomForest*)
+	m_vCoefficients.assign(m_vProportions.size(), 0);
+	for(uint32_t i=0;i<m_vProportions.size();i++)
+		if(m_vValidPatches[i] != 0)
+			m_vCoefficients[i] = m_vProportions[i]/m_vValidPatches[i]/m_nTrees;
+	cout<< "Compiled forest: "<< m_nTrees <<" trees, "<< numNodes() <<" split nodes, "
+		<< numLeaves() <<" leaves"<<endl;
+	return true;
+}
+
+void CompiledForest::addLeaf(RandomNode& rnNode, int nTree)
+{
+	m_vLeafKeys.push_back(rnNode.getKey());
+	m_vLeafTrees.push_back(nTree);
+	for(int c=0;c<m_nClasses;c++)
+	{
+		float dProportion = c<(int)rnNode.m_dProportion.size() ? rnNode.m_dProportion[c] : 0;
+		uint32_t nValid = c<(int)rnNode.m_nValidPatches.size() ? rnNode.m_nValidPatches[c] : 0;
+		m_vProportions.push_back(dProportion);
+		m_vValidPatches.push_back(nValid);
+		if(c<(int)rnNode.m_vCoords.size())
+		{
+			const vector<FeatureVector>& vCoords = rnNode.m_vCoords[c];
+			for(uint32_t j=0;j<vCoords.size();j++)
+			{
+				m_vCoords.push_back(vCoords[j].at(0));
+				m_vCoords.push_back(vCoords[j].at(1));
+			}
+		}
+		m_vCoordStart.push_back(m_vCoords.size()/2);
+	}
+}
+
+/********************/
+/*   Save & Load    */
+/********************/
+template<class T>
+static void addVectorSection(ModelFileWriter& mfWriter, unsigned nType, const vector<T>& v)
+{
+	mfWriter.addSection(nType, v.empty() ? 0 : &v[0], v.size()*sizeof(T));
+}
+
+template<class T>
+static bool loadVectorSection(const MappedModelFile& mfFile, unsigned nType, vector<T>& v)
+{
+	size_t nSize;
+	const T* pData = (const T*)mfFile.section(nType, nSize);
+	if(pData == 0 || nSize%sizeof(T) != 0)
+		return false;
+	v.assign(pData, pData + nSize/sizeof(T));
+	return true;
+}
+
+void CompiledForest::addSections(ModelFileWriter& mfWriter) const
+{
+	addVectorSection(mfWriter, MODELSEC_CRF_NODES,      m_vNodes);
+	addVectorSection(mfWriter, MODELSEC_CRF_ROOTS,      m_vRoots);
+	addVectorSection(mfWriter, MODELSEC_CRF_LEAFKEYS,   m_vLeafKeys);
+	addVectorSection(mfWriter, MODELSEC_CRF_LEAFTREES,  m_vLeafTrees);
+	addVectorSection(mfWriter, MODELSEC_CRF_PROPORTION, m_vProportions);
+	addVectorSection(mfWriter, MODELSEC_CRF_VALID,      m_vValidPatches);
+	addVectorSection(mfWriter, MODELSEC_CRF_COEFF,      m_vCoefficients);
+	addVectorSection(mfWriter, MODELSEC_CRF_COORDSTART, m_vCoordStart);
+	addVectorSection(mfWriter, MODELSEC_CRF_COORDS,     m_vCoords);
+}
+
+bool CompiledForest::loadSections(const MappedModelFile& mfFile)
+/*==================================================================*/
+/* Copy the arrays out of the mapped file and check that all        */
+/* indices are in range (the tree walk does no checks).             */
+/*==================================================================*/
+{
+	clear();
+	bool ok =	loadVectorSection(mfFile, MODELSEC_CRF_NODES,      m_vNodes) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_ROOTS,      m_vRoots) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_LEAFKEYS,   m_vLeafKeys) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_LEAFTREES,  m_vLeafTrees) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_PROPORTION, m_vProportions) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_VALID,      m_vValidPatches) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_COEFF,      m_vCoefficients) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_COORDSTART, m_vCoordStart) &&
+				loadVectorSection(mfFile, MODELSEC_CRF_COORDS,     m_vCoords);
+	uint32_t nLeaves = m_vLeafKeys.size();
+	uint32_t nNodes = m_vNodes.size();
+	ok = ok && nLeaves>0 && m_vLeafTrees.size()==nLeaves &&
+		 m_vProportions.size()%nLeaves==0;
+	if(ok)
+	{
+		m_nClasses = m_vProportions.size()/nLeaves;
+		ok = m_vValidPatches.size()==m_vProportions.size() &&
+			 m_vCoefficients.size()==m_vProportions.size() &&
+			 m_vCoordStart.size()==m_vProportions.size()+1 &&
+			 m_vCoordStart[0]==0 && m_vCoordStart.back()==m_vCoords.size()/2;
+	}
+	for(uint32_t i=1;ok && i<m_vCoordStart.size();i++)
+		ok = m_vCoordStart[i-1]<=m_vCoordStart[i];
+	// Children have to be leaves or nodes further down the array, so
+	// that every walk ends in a leaf
+	for(uint32_t i=0;ok && i<nNodes;i++)
+	{
+		const Node& node = m_vNodes[i];
+		ok = node.nChannel>=0 && node.p>=0 && node.q>=0 && node.r>=0 && node.s>=0 &&
+			 (node.nLeft<0 ? (uint32_t)~node.nLeft<nLeaves : (uint32_t)node.nLeft>i && (uint32_t)node.nLeft<nNodes) &&
+			 (node.nRight<0 ? (uint32_t)~node.nRight<nLeaves : (uint32_t)node.nRight>i && (uint32_t)node.nRight<nNodes);
+	}
+	for(uint32_t t=0;ok && t<m_vRoots.size();t++)
+		ok = m_vRoots[t]<0 ? (uint32_t)~m_vRoots[t]<nLeaves : (uint32_t)m_vRoots[t]<nNodes;
+	if(!ok)
+	{
+		cerr<< "Error in CompiledForest::loadSections: no valid compiled forest"<<endl;
+		clear();
+		return false;
+	}
+	m_nTrees = m_vRoots.size();
+	return true;
+}
+
+bool CompiledForest::loadCompiledForest(const char* uri)
+{
+	MappedModelFile mfFile;
+	if(!mfFile.open(uri))
+	{
+		clear();
+		return false;
+	}
+	return loadSections(mfFile);
+}
+
+/********************/
+/*   Access         */
+/********************/
+uint32_t CompiledForest::getNumCoords(uint32_t nLeaf, int c) const
+{
+	uint32_t i = nLeaf*m_nClasses + c;
+	return m_vCoordStart[i+1] - m_vCoordStart[i];
+}
+
+const float* CompiledForest::getCoords(uint32_t nLeaf, int c) const
+{
+	return m_vCoords.empty() ? 0 : &m_vCoords[0] + 2*m_vCoordStart[nLeaf*m_nClasses + c];
+}
+
+/************/
+/*	Test	*/
+/************/
+void CompiledForest::testPatch(const PatchSample& psPatch, vector<uint32_t>& vLeaves) const
+{
+	vLeaves.resize(m_nTrees);
+	for(int t=0;t<m_nTrees;t++)
+	{
+		int32_t nCode = m_vRoots[t];
+		while(nCode >= 0)
+		{
+			const Node& node = m_vNodes[nCode];
+			const OpGrayImage& img = psPatch.vChannels[node.nChannel];
+			if(img(node.p, node.q).value() - img(node.r, node.s).value() > node.t)
+				nCode = node.nLeft;
+			else
+				nCode = node.nRight;
+		}
+		vLeaves[t] = ~nCode;
+	}
+}
+
+void CompiledForest::testPatches(const vector<PatchSample>& vPatches, vector<uint32_t>& vLeaves) const
+{
+	vLeaves.clear();
+	if(vPatches.size() == 0)
+		return;
+	PatchTensor ptPatches;
+	bool bBytes = true;
+	for(uint32_t i=0;i<vPatches.size() && bBytes;i++)
+		bBytes = PatchTensor::isByteData(vPatches[i].vChannels);
+	ptPatches.create(vPatches.size(), vPatches[0].vChannels.size(),
+					 vPatches[0].vChannels[0].width(), vPatches[0].vChannels[0].height(), bBytes);
+	for(uint32_t i=0;i<vPatches.size();i++)
+		if(!ptPatches.setPatch(i, vPatches[i].vChannels))
+			return;
+	testPatches(ptPatches, vLeaves);
+}
+
+void CompiledForest::testPatches(const PatchTensor& ptPatches, vector<uint32_t>& vLeaves) const
+/*==================================================================*/
+/* The patches are tested in blocks of TEST_BLOCK_SIZE, tree by     */
+/* tree. Each thread handles a range of the patches.                */
+/*==================================================================*/
+{
+	vLeaves.assign((size_t)ptPatches.size()*m_nTrees, 0);
+	if(ptPatches.size() == 0 || m_nTrees == 0)
+		return;
+	// Offsets of the two pixels of each test in a sample of ptPatches
+	vector<int> vOffsets(2*m_vNodes.size());
+	for(uint32_t i=0;i<m_vNodes.size();i++)
+	{
+		const Node& node = m_vNodes[i];
+		if(node.nChannel>=ptPatches.channels() ||
+		   max(node.p, node.r)>=ptPatches.width() || max(node.q, node.s)>=ptPatches.height())
+		{
+			cerr<< "Error in CompiledForest::testPatches: "<<
+				"the patches are smaller than the training patches"<<endl;
+			vLeaves.clear();
+			return;
+		}
+		vOffsets[2*i]   = ptPatches.offset(node.nChannel, node.p, node.q);
+		vOffsets[2*i+1] = ptPatches.offset(node.nChannel, node.r, node.s);
+	}
+	CFTestTask task;
+	task.pForest		= this;
+	task.pBytes			= ptPatches.isBytes() ? ptPatches.bytePtr() : 0;
+	task.pFloats		= ptPatches.floatPtr();
+	task.nSampleSize	= ptPatches.sampleSize();
+	task.pOffsets		= &vOffsets;
+	task.pLeaves		= &vLeaves[0];
+	int nThreads = ::getNumThreads(m_nThreads, (ptPatches.size()+TEST_BLOCK_SIZE-1)/TEST_BLOCK_SIZE);
+	parallelFor(0, ptPatches.size(), nThreads, task);
+}
+
+template<class T>
+void CompiledForest::testBlock(	const T* pData, size_t nSampleSize, const vector<int>& vOffsets,
+								uint32_t nBegin, uint32_t nEnd, uint32_t* pLeaves) const
+{
+	const Node* pNodes = &m_vNodes[0];
+	const int* pOffsets = &vOffsets[0];
+	for(uint32_t nBlock=nBegin; nBlock<nEnd; nBlock+=TEST_BLOCK_SIZE)
+	{
+		uint32_t nBlockEnd = min(nEnd, nBlock+TEST_BLOCK_SIZE);
+		for(int t=0;t<m_nTrees;t++)
+		{
+			for(uint32_t n=nBlock; n<nBlockEnd; n++)
+			{
+				const T* pSample = pData + n*nSampleSize;
+				int32_t nCode = m_vRoots[t];
+				while(nCode >= 0)
+				{
+					const Node& node = pNodes[nCode];
+					if((float)pSample[pOffsets[2*nCode]] - (float)pSample[pOffsets[2*nCode+1]] > node.t)
+						nCode = node.nLeft;
+					else
+						nCode = node.nRight;
+				}
+				pLeaves[(size_t)n*m_nTrees + t] = ~nCode;
+			}
+		}
+	}
+}
+
+/************/
+/*	Votes	*/
+/************/
+void CompiledForest::getVotesSingleClass(	const uint32_t*			pLeaves,
+											const float 			dThres,
+											vector<FeatureVector>&	vfvCoords,
+											vector<float>&			vValue,
+											vector<uint32_t>&		vnLeafNodes,
+											vector<float>&			vdConfidence,
+											int						nClass) const
+{
+	vfvCoords.clear();
+	vValue.clear();
+	vnLeafNodes.clear();
+	vdConfidence.clear();
+	FeatureVector coord(2);
+	for(int t=0;t<m_nTrees;t++)
+	{
+		uint32_t nLeaf = pLeaves[t];
+		vnLeafNodes.push_back(m_vLeafKeys[nLeaf]);
+		float dProportion = getProportion(nLeaf, nClass);
+		vdConfidence.push_back(dProportion);
+		if(getValidPatches(nLeaf, nClass) == 0)
+		{
+			cout<<" No valid patches in the leaf node in Tree:"<< t
+				<<" Key:"<<m_vLeafKeys[nLeaf]<<endl;
+		}
+		else if(dProportion>dThres)
+		{
+			uint32_t nCoords = getNumCoords(nLeaf, nClass);
+			const float* pCoords = getCoords(nLeaf, nClass);
+			float dCoeff = getCoefficient(nLeaf, nClass);
+			for(uint32_t j=0;j<nCoords;j++)
+			{
+				coord.setValue(0, pCoords[2*j]);
+				coord.setValue(1, pCoords[2*j+1]);
+				vValue.push_back(dCoeff);
+				vfvCoords.push_back(coord);
+			}
+		}
+	}
+}
+
+void CompiledForest::getVotesMultiClass(	const uint32_t*						pLeaves,
+											const float 						dThres,
+											vector< vector<FeatureVector> >&	vvfvCoords,
+											vector< vector<float> >&			vvValues,
+											vector<uint32_t>&					vnLeafNodes,
+											vector< vector<float> >&			vvdConfidence) const
+/*==================================================================*/
+/* As testRandomForestMultiClass(), the entries of class 0 are left */
+/* empty.                                                           */
+/*==================================================================*/
+{
+	vvfvCoords.assign(1, vector<FeatureVector>());
+	vvValues.assign(1, vector<float>());
+	vvdConfidence.assign(1, vector<float>());
+	vnLeafNodes.clear();
+	for(int t=0;t<m_nTrees;t++)
+		vnLeafNodes.push_back(m_vLeafKeys[pLeaves[t]]);
+	FeatureVector coord(2);
+	for(int c=1;c<m_nClasses;c++)
+	{
+		vvfvCoords.push_back(vector<FeatureVector>());
+		vvValues.push_back(vector<float>());
+		vvdConfidence.push_back(vector<float>());
+		vector<FeatureVector>& vfvCoords = vvfvCoords.back();
+		vector<float>& vValues = vvValues.back();
+		for(int t=0;t<m_nTrees;t++)
+		{
+			uint32_t nLeaf = pLeaves[t];
+			float dProportion = getProportion(nLeaf, c);
+			if(getValidPatches(nLeaf, c) != 0 && dProportion>dThres)
+			{
+				uint32_t nCoords = getNumCoords(nLeaf, c);
+				const float* pCoords = getCoords(nLeaf, c);
+				float dCoeff = getCoefficient(nLeaf, c);
+				for(uint32_t j=0;j<nCoords;j++)
+				{
+					coord.setValue(0, pCoords[2*j]);
+					coord.setValue(1, pCoords[2*j+1]);
+					vValues.push_back(dCoeff);
+					vfvCoords.push_back(coord);
+				}
+			}
+			vvdConfidence.back().push_back(dProportion);
+		}
+	}
+}
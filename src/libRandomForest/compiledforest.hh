@@ -0,0 +1,158 @@
+/*******************************************************************/
+/*                                                                 */
+/*FILE         	compiledforest.hh                                  */
+/*                                                                 */
+/*CONTENT	Read-only, flat array copy of a trained random forest      */
+/*		for fast testing of many patches                           */
+/*                                                                 */
+/*BEGIN		SAT OCT 17 2026                                        */
+/*LAST CHANGE	SAT OCT 17 2026                                    */
+/*                                                                 */
+/*******************************************************************/
+
+#ifndef COMPILEDFOREST_HH
+#define COMPILEDFOREST_HH
+
+using namespace std;
+
+/****************/
+/*	Includes	*/
+/****************/
+#include <stdint.h>
+#include <vector>
+
+#include <featurevector.hh>
+#include <modelfile.hh>
+
+#include "randomforest.hh"
+#include "patchtensor.hh"
+
+/************************/
+/*	Class Defination	*/
+/************************/
+/*==========================================*/
+/*				Class CompiledForest		*/
+/*==========================================*/
+/* The split nodes of all trees are stored in one array (tree by tree, in
+ * the key order of the tree, i.e. level by level), the leaves in a
+ * separate table holding the class proportions, valid patches, vote
+ * coefficients and offset vectors. A compiled forest gives the same
+ * results as RandomForest::testRandomForest*(), but needs no map lookups
+ * and no copies of RandomNodes.
+ *
+ * Leaves are numbered over the whole forest; getLeafKey() returns the
+ * key of a leaf in its tree.
+ *
+ * Usage:
+ *	CompiledForest cfForest;
+ *	cfForest.compile(rfForest);
+ *	vector<uint32_t> vLeaves;
+ *	cfForest.testPatches(vPatches, vLeaves);	// vLeaves[n*numTrees()+t]
+ *	cfForest.getVotesMultiClass(&vLeaves[n*cfForest.numTrees()], ...);	*/
+class CompiledForest
+{
+public:
+	CompiledForest();
+public:
+	/****************/
+	/*	Creation	*/
+	/****************/
+	bool compile(RandomForest& rfForest);
+	void clear();
+	// Number of threads for testPatches() (<=0: one per processor)
+	void setNumThreads(int nThreads){m_nThreads = nThreads;}
+	int  getNumThreads() const {return m_nThreads;}
+public:
+	/****************/
+	/*	Save & Load	*/
+	/****************/
+	// Add the arrays as sections of a binary model file. They are not
+	// copied and have to stay valid until mfWriter.write() has returned.
+	void addSections(ModelFileWriter& mfWriter) const;
+	bool loadSections(const MappedModelFile& mfFile);
+	// Load the compiled forest stored by RandomForest::saveRandomForestBinary()
+	bool loadCompiledForest(const char* uri);
+public:
+	/****************/
+	/*	Access		*/
+	/****************/
+	bool		isEmpty()		const {return m_nTrees==0;}
+	int			numTrees()		const {return m_nTrees;}
+	int			numClasses()	const {return m_nClasses;}
+	uint32_t	numNodes()		const {return m_vNodes.size();}
+	uint32_t	numLeaves()		const {return m_vLeafKeys.size();}
+
+	uint32_t	getLeafKey(uint32_t nLeaf)	const {return m_vLeafKeys[nLeaf];}
+	int			getLeafTree(uint32_t nLeaf)	const {return m_vLeafTrees[nLeaf];}
+	float		getProportion(uint32_t nLeaf, int c)	const {return m_vProportions[nLeaf*m_nClasses+c];}
+	uint32_t	getValidPatches(uint32_t nLeaf, int c)	const {return m_vValidPatches[nLeaf*m_nClasses+c];}
+	// Coefficient of a vote: proportion / valid patches / number of trees
+	float		getCoefficient(uint32_t nLeaf, int c)	const {return m_vCoefficients[nLeaf*m_nClasses+c];}
+	// Offset vectors of class c: getNumCoords() pairs (x,y)
+	uint32_t	getNumCoords(uint32_t nLeaf, int c) const;
+	const float* getCoords(uint32_t nLeaf, int c) const;
+public:
+	/************/
+	/*	Test	*/
+	/************/
+	// Leaves reached by one patch, one per tree
+	void testPatch(const PatchSample& psPatch, vector<uint32_t>& vLeaves) const;
+	// Leaves reached by all patches, vLeaves[n*numTrees()+t]
+	void testPatches(const vector<PatchSample>& vPatches, vector<uint32_t>& vLeaves) const;
+	void testPatches(const PatchTensor& ptPatches, vector<uint32_t>& vLeaves) const;
+	// Same results as RandomForest::testRandomForestSingleClass() and
+	// RandomForest::testRandomForestMultiClass(), for the leaves pLeaves
+	// (numTrees() entries) reached by one patch
+	void getVotesSingleClass(	const uint32_t*				pLeaves,
+								const float 				dThres,
+								vector<FeatureVector>&		vfvCoords,
+								vector<float>&				vValue,
+								vector<uint32_t>&			vnLeafNodes,
+								vector<float>&				vdConfidence,
+								int							nClass = 1) const;
+	void getVotesMultiClass(	const uint32_t*						pLeaves,
+								const float 						dThres,
+								vector< vector<FeatureVector> >&	vvfvCoords,
+								vector< vector<float> >&			vvValues,
+								vector<uint32_t>&					vnLeafNodes,
+								vector< vector<float> >&			vvdConfidence) const;
+public:
+	/*==========================================*/
+	/* A split node. The children are indices   */
+	/* into the node array, or ~nLeaf (<0) for  */
+	/* leaves. The test is the one of           */
+	/* RandomNode::testNode():                  */
+	/*  v(c,p,q) - v(c,r,s) > t  -> left        */
+	/*==========================================*/
+	struct Node
+	{
+		int16_t	nChannel;
+		int16_t	p, q, r, s;
+		float	t;
+		int32_t	nLeft;
+		int32_t	nRight;
+	};
+private:
+	friend struct CFTestTask;
+	template<class T>
+	void testBlock(	const T* pData, size_t nSampleSize, const vector<int>& vOffsets,
+					uint32_t nBegin, uint32_t nEnd, uint32_t* pLeaves) const;
+	void addLeaf(RandomNode& rnNode, int nTree);
+private:
+	int m_nTrees;
+	int m_nClasses;
+	int m_nThreads;
+	// Split nodes; the root of tree t is m_vRoots[t] (~nLeaf if the
+	// tree is a single leaf)
+	vector<Node>		m_vNodes;
+	vector<int32_t>		m_vRoots;
+	// Leaf table
+	vector<uint32_t>	m_vLeafKeys;
+	vector<int>			m_vLeafTrees;
+	vector<float>		m_vProportions;		// nLeaves x nClasses
+	vector<uint32_t>	m_vValidPatches;	// nLeaves x nClasses
+	vector<float>		m_vCoefficients;	// nLeaves x nClasses
+	vector<uint32_t>	m_vCoordStart;		// nLeaves x nClasses + 1
+	vector<float>		m_vCoords;			// (x,y) pairs
+};
+#endif
@@ -14,10 +14,12 @@ CODE = $(HOME)/code
 
 INCLUDEPATH += . $${CODE}/include
 
+LIBS += -lpthread
+
 # Input
-HEADERS +=  randomforestgui.hh randomforest.hh
+HEADERS +=  randomforestgui.hh randomforest.hh patchtensor.hh compiledforest.hh
 
-SOURCES +=  randomforestgui.cc randomforest.cc
+SOURCES +=  randomforestgui.cc randomforest.cc patchtensor.cc compiledforest.cc
 
 # make install
 target.path = ~/code/lib/i686
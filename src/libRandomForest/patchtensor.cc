@@ -0,0 +1,235 @@
+/********************************************************************/
+/*																	*/
+/*FILE         	patchtensor.cc										*/
+/*																	*/
+/*CONTENT		Contiguous storage of training patches				*/
+/*																	*/
+/*BEGIN			SAT OCT 17	 2026									*/
+/*LAST CHANGE	SAT OCT 17	 2026									*/
+/*																	*/
+/********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <algorithm>
+
+#include "patchtensor.hh"
+
+/*******************/
+/*   Definitions   */
+/*******************/
+// Number of samples whose test results are computed in one batch
+const int SPLIT_BATCH_SIZE = 256;
+
+/*===================================================================*/
+/*                          Class PatchTensor                        */
+/*===================================================================*/
+/********************/
+/*   Constructor    */
+/********************/
+PatchTensor::PatchTensor()
+{
+	clear();
+}
+
+/********************/
+/*   Creation       */
+/********************/
+void PatchTensor::create(uint32_t nSamples, int nChannels, int nWidth, int nHeight, bool bBytes)
+{
+	m_nSamples = nSamples;
+	m_nChannels = nChannels;
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+	m_nSampleSize = (size_t)nChannels*nWidth*nHeight;
+	m_bBytes = bBytes;
+	m_vBytes.clear();
+	m_vFloats.clear();
+	if(bBytes)
+		m_vBytes.assign(nSamples*m_nSampleSize, 0);
+	else
+		m_vFloats.assign(nSamples*m_nSampleSize, 0);
+}
+
+void PatchTensor::clear()
+{
+	m_nSamples = 0;
+	m_nChannels = 0;
+	m_nWidth = 0;
+	m_nHeight = 0;
+	m_nSampleSize = 0;
+	m_bBytes = false;
+	// (swap to really release the memory)
+	vector<uint8_t>().swap(m_vBytes);
+	vector<float>().swap(m_vFloats);
+}
+
+bool PatchTensor::setPatch(uint32_t n, const vector<OpGrayImage>& vChannels)
+{
+	if(n >= m_nSamples || (int)vChannels.size() < m_nChannels)
+	{
+		cerr<< "Error in PatchTensor::setPatch: "<<
+			"sample "<< n <<" does not exist or has too few channels"<<endl;
+		return false;
+	}
+	for(int c=0;c<m_nChannels;c++)
+	{
+		const OpGrayImage& img = vChannels[c];
+		if(img.width()!=m_nWidth || img.height()!=m_nHeight)
+		{
+			cerr<< "Error in PatchTensor::setPatch: "<<
+				"channel "<< c <<" of sample "<< n <<" has the wrong size"<<endl;
+			return false;
+		}
+		ImageView<GrayPixel> view = img.view();
+		for(int y=0;y<m_nHeight;y++)
+		{
+			const GrayPixel *pSrc = view.rowPtr(y);
+			size_t idx = n*m_nSampleSize + offset(c, 0, y);
+			if(m_bBytes)
+			{
+				for(int x=0;x<m_nWidth;x++)
+				{
+					float v = pSrc[x].value();
+					if(!(v>=0 && v<=255) || v!=(float)(int)v)
+					{
+						cerr<< "Error in PatchTensor::setPatch: "<<
+							"sample "<< n <<" can't be stored as bytes"<<endl;
+						return false;
+					}
+					m_vBytes[idx+x] = (uint8_t)v;
+				}
+			}
+			else
+			{
+				for(int x=0;x<m_nWidth;x++)
+					m_vFloats[idx+x] = pSrc[x].value();
+			}
+		}
+	}
+	return true;
+}
+
+bool PatchTensor::setPatch(uint32_t n, const PatchTensor& ptOther, uint32_t m)
+{
+	if(n >= m_nSamples || m >= ptOther.m_nSamples ||
+	   ptOther.m_nChannels != m_nChannels || ptOther.m_nWidth != m_nWidth ||
+	   ptOther.m_nHeight != m_nHeight || (m_bBytes && !ptOther.m_bBytes))
+	{
+		cerr<< "Error in PatchTensor::setPatch: "<<
+			"sample "<< m <<" of the other tensor doesn't fit into sample "<< n <<endl;
+		return false;
+	}
+	size_t nDst = n*m_nSampleSize;
+	size_t nSrc = m*m_nSampleSize;
+	if(m_bBytes)
+		copy(ptOther.m_vBytes.begin()+nSrc, ptOther.m_vBytes.begin()+nSrc+m_nSampleSize,
+			 m_vBytes.begin()+nDst);
+	else if(ptOther.m_bBytes)
+		for(size_t i=0;i<m_nSampleSize;i++)
+			m_vFloats[nDst+i] = (float)ptOther.m_vBytes[nSrc+i];
+	else
+		copy(ptOther.m_vFloats.begin()+nSrc, ptOther.m_vFloats.begin()+nSrc+m_nSampleSize,
+			 m_vFloats.begin()+nDst);
+	return true;
+}
+
+void PatchTensor::swap(PatchTensor& other)
+{
+	std::swap(m_nSamples, other.m_nSamples);
+	std::swap(m_nChannels, other.m_nChannels);
+	std::swap(m_nWidth, other.m_nWidth);
+	std::swap(m_nHeight, other.m_nHeight);
+	std::swap(m_nSampleSize, other.m_nSampleSize);
+	std::swap(m_bBytes, other.m_bBytes);
+	m_vBytes.swap(other.m_vBytes);
+	m_vFloats.swap(other.m_vFloats);
+}
+
+bool PatchTensor::isByteData(const vector<OpGrayImage>& vChannels)
+{
+	for(uint32_t c=0;c<vChannels.size();c++)
+	{
+		ImageView<GrayPixel> view = vChannels[c].view();
+		for(int y=0;y<vChannels[c].height();y++)
+		{
+			const GrayPixel *pSrc = view.rowPtr(y);
+			for(int x=0;x<vChannels[c].width();x++)
+			{
+				float v = pSrc[x].value();
+				if(!(v>=0 && v<=255) || v!=(float)(int)v)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+/********************/
+/*   Access         */
+/********************/
+OpGrayImage PatchTensor::getChannel(uint32_t n, int c) const
+{
+	OpGrayImage img(m_nWidth, m_nHeight);
+	for(int y=0;y<m_nHeight;y++)
+	{
+		GrayPixel *pDst = img.rowPtr(y);
+		for(int x=0;x<m_nWidth;x++)
+			pDst[x] = value(n, c, x, y);
+	}
+	return img;
+}
+
+/********************/
+/*   Split Tests    */
+/********************/
+template<class T>
+static void splitSamplesT(	const T* pData, size_t nSampleSize,
+							const vector<uint32_t>& vIndex,
+							int nOffsetA, int nOffsetB, float t,
+							vector<uint32_t>& vIndex4Left,
+							vector<uint32_t>& vIndex4Right)
+/*==================================================================*/
+/* The test results of a batch of samples are gathered first (this  */
+/* loop has no branches), then the samples are distributed.         */
+/*==================================================================*/
+{
+	uint8_t bLeft[SPLIT_BATCH_SIZE];
+	const T* pA = pData + nOffsetA;
+	const T* pB = pData + nOffsetB;
+	uint32_t nSize = vIndex.size();
+	for(uint32_t nBegin=0; nBegin<nSize; nBegin+=SPLIT_BATCH_SIZE)
+	{
+		int nBatch = (int)min<uint32_t>(SPLIT_BATCH_SIZE, nSize-nBegin);
+		const uint32_t* pIndex = &vIndex[nBegin];
+		for(int i=0;i<nBatch;i++)
+		{
+			size_t base = pIndex[i]*nSampleSize;
+			bLeft[i] = ((float)pA[base] - (float)pB[base] > t);
+		}
+		for(int i=0;i<nBatch;i++)
+		{
+			if(bLeft[i])
+				vIndex4Left.push_back(pIndex[i]);
+			else
+				vIndex4Right.push_back(pIndex[i]);
+		}
+	}
+}
+
+void PatchTensor::splitSamples(	const vector<uint32_t>& vIndex,
+								int c, int p, int q, int r, int s, int t,
+								vector<uint32_t>& vIndex4Left,
+								vector<uint32_t>& vIndex4Right) const
+{
+	int nOffsetA = offset(c, p, q);
+	int nOffsetB = offset(c, r, s);
+	if(m_bBytes)
+		splitSamplesT(&m_vBytes[0], m_nSampleSize, vIndex, nOffsetA, nOffsetB,
+					  (float)t, vIndex4Left, vIndex4Right);
+	else
+		splitSamplesT(&m_vFloats[0], m_nSampleSize, vIndex, nOffsetA, nOffsetB,
+					  (float)t, vIndex4Left, vIndex4Right);
+}
@@ -0,0 +1,107 @@
+/*******************************************************************/
+/*                                                                 */
+/*FILE         	patchtensor.hh                                     */
+/*                                                                 */
+/*CONTENT	Contiguous (sample, channel, y, x) storage of training     */
+/*		patches for the random forest                              */
+/*                                                                 */
+/*BEGIN		SAT OCT 17 2026                                        */
+/*LAST CHANGE	SAT OCT 17 2026                                    */
+/*                                                                 */
+/*******************************************************************/
+
+#ifndef PATCHTENSOR_HH
+#define PATCHTENSOR_HH
+
+using namespace std;
+
+/****************/
+/*	Includes	*/
+/****************/
+#include <stdint.h>
+#include <vector>
+
+#include <opgrayimage.hh>
+
+/************************/
+/*	Class Defination	*/
+/************************/
+/*==========================================*/
+/*				Class PatchTensor			*/
+/*==========================================*/
+/* All patches of a training set in one block of memory, sample by sample,
+ * channel by channel and row by row. If all pixel values are integers in
+ * [0,255] (e.g. gray value patches), they are stored as bytes, otherwise
+ * as floats. Both give exactly the same values as the original images.
+ * RandomForest keeps its training samples only here; a byte tensor needs
+ * a quarter of the memory of the images, a float tensor the same.
+ *
+ * Usage:
+ *	PatchTensor ptPatches;
+ *	ptPatches.create(nSamples, nChannels, nWidth, nHeight);
+ *	for each sample n:  ptPatches.setPatch(n, vChannels);
+ *	float v = ptPatches.value(n, c, x, y);								*/
+class PatchTensor
+{
+public:
+	PatchTensor();
+public:
+	/****************/
+	/*	Creation	*/
+	/****************/
+	void create(uint32_t nSamples, int nChannels, int nWidth, int nHeight, bool bBytes = false);
+	void clear();
+	// Store the channels of sample n. Returns false if the channels don't fit
+	// (wrong number or size, or non-byte values in a byte tensor).
+	bool setPatch(uint32_t n, const vector<OpGrayImage>& vChannels);
+	// Copy sample m of another tensor of the same patch size into sample n
+	bool setPatch(uint32_t n, const PatchTensor& ptOther, uint32_t m);
+	void swap(PatchTensor& other);
+	// Check whether all pixel values of the channels can be stored as bytes
+	static bool isByteData(const vector<OpGrayImage>& vChannels);
+public:
+	/****************/
+	/*	Access		*/
+	/****************/
+	uint32_t	size()			const {return m_nSamples;}
+	int			channels()		const {return m_nChannels;}
+	int			width()			const {return m_nWidth;}
+	int			height()		const {return m_nHeight;}
+	bool		isBytes()		const {return m_bBytes;}
+	size_t		memorySize()	const {return m_vBytes.size() + m_vFloats.size()*sizeof(float);}
+
+	// Offset of pixel (x,y) of channel c within a sample
+	int			offset(int c, int x, int y) const {return (c*m_nHeight + y)*m_nWidth + x;}
+	float		value(uint32_t n, int c, int x, int y) const
+	{
+		size_t idx = n*m_nSampleSize + offset(c, x, y);
+		return m_bBytes ? (float)m_vBytes[idx] : m_vFloats[idx];
+	}
+	OpGrayImage	getChannel(uint32_t n, int c) const;
+	// Raw data (only one of them is valid, see isBytes()) and the number
+	// of values per sample
+	const uint8_t*	bytePtr()	const {return m_vBytes.empty() ? 0 : &m_vBytes[0];}
+	const float*	floatPtr()	const {return m_vFloats.empty() ? 0 : &m_vFloats[0];}
+	size_t			sampleSize()	const {return m_nSampleSize;}
+public:
+	/********************/
+	/*	Split Tests		*/
+	/********************/
+	// Split the samples in vIndex by the test
+	//		value(n,c,p,q) - value(n,c,r,s) > t
+	// as RandomNode::calculateSplit(). The order of the samples is kept.
+	void splitSamples(	const vector<uint32_t>& vIndex,
+						int c, int p, int q, int r, int s, int t,
+						vector<uint32_t>& vIndex4Left,
+						vector<uint32_t>& vIndex4Right) const;
+private:
+	uint32_t m_nSamples;
+	int m_nChannels;
+	int m_nWidth;
+	int m_nHeight;
+	size_t m_nSampleSize;
+	bool m_bBytes;
+	vector<uint8_t> m_vBytes;
+	vector<float> m_vFloats;
+};
+#endif
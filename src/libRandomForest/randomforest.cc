@@ -17,6 +17,8 @@
 /****************/
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <time.h>
 #include <iostream>
@@ -28,7 +30,11 @@
 #include <libxml/encoding.h>
 #include <libxml/xmlwriter.h>
 
+#include <parallelfor.hh>
+#include <modelfile.hh>
+
 #include "randomforest.hh"
+#include "compiledforest.hh"
 
 /*******************/
 /*   Definitions   */
@@ -38,6 +44,38 @@ typedef struct _floatint{
   float dvalue;
   uint32_t   nvalue;
 } FloatInt;
+/*------------------------------------------*/
+/* Records of the binary random forest file */
+/*------------------------------------------*/
+struct RFFileParams
+{
+	int32_t nTrees;
+	int32_t nTreeDepth;
+	int32_t nWeekClassifier;
+	int32_t nMinSample;
+	int32_t nTotalClasses;
+	int32_t nReserved[3];
+};
+struct RFFileNode
+{
+	uint32_t nTree;
+	uint32_t nKey;
+	uint32_t nParent;
+	uint32_t nLeft;
+	uint32_t nRight;
+	int32_t  nLevel;
+	int32_t  nChannel;
+	int32_t  p, q, r, s, t;
+	uint32_t nClassStart;		// into the RFFileClass records
+	uint32_t nNumClasses;
+};
+struct RFFileClass
+{
+	float    dProportion;
+	uint32_t nValidPatches;
+	uint32_t nCoordStart;		// into the (x,y) pairs
+	uint32_t nNumCoords;
+};
 
 /********************************/
 /*	Global Functions	*/
@@ -58,10 +96,71 @@ float calculateHellingerDistance(const vector<float>& distribution1, const vecto
 vector<float> normalizeProportions(const vector<float>& original_proportions);
 float calculateEntropy(const vector<float>& proportions);
 bool IsInVector(uint32_t thevalue, vector<uint32_t> thevector);
+double getWallTime();
+void appendTheonesleft(vector<uint32_t>& train_validationSampleIndex, uint32_t numofsample);
 /*************************/
 /*   Class Definitions   */
 /*************************/
 
+/*===================================================================*/
+/*                          Class RFRandom                           */
+/*===================================================================*/
+void RFRandom::setSeed(uint64_t seed)
+{
+	// Scramble the seed (splitmix64), so that neighbouring seeds such as
+	// the tree indexes give unrelated streams.
+	uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	m_state = z ^ (z >> 31);
+}
+
+uint32_t RFRandom::next()
+{
+	// 64 bit linear congruential generator (Knuth's MMIX constants),
+	// returning the high bits
+	m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return static_cast<uint32_t>(m_state >> 32);
+}
+
+/*===================================================================*/
+/*                        Struct RFSplitTask                         */
+/*===================================================================*/
+/* Evaluates the candidate tests [nBegin,nEnd) of a node. Each thread
+ * reuses its own index buffers; only the entropies are kept.		*/
+struct RFSplitTask
+{
+	RandomNode*					pNode;
+	const vector<PatchSample>*	pFeatures;
+	const PatchTensor*			pTensor;
+	const vector<uint32_t>*		pIndex;
+	const vector<int>*			pChannel;
+	const vector<int>*			pP;
+	const vector<int>*			pQ;
+	const vector<int>*			pR;
+	const vector<int>*			pS;
+	const vector<int>*			pT;
+	int							nEntropy;
+	vector<float>*				pEntropy;
+
+	void operator()(int nThread, int nBegin, int nEnd)
+	{
+		vector<uint32_t> vLeft;
+		vector<uint32_t> vRight;
+		vLeft.reserve(pIndex->size());
+		vRight.reserve(pIndex->size());
+		for(int i=nBegin; i<nEnd; i++)
+		{
+			vLeft.clear();
+			vRight.clear();
+			pNode->calculateSplit(*pFeatures, *pIndex,
+					(*pChannel)[i], (*pP)[i], (*pQ)[i], (*pR)[i], (*pS)[i], (*pT)[i],
+					nEntropy, (*pEntropy)[i], vLeft, vRight, pTensor);
+		}
+	}
+};
+
+
 /*===================================================================*/
 /*                          Class RandomNode                         */
 /*===================================================================*/
@@ -168,7 +267,10 @@ RandomNode& RandomNode::operator=(const RandomNode& rhs)
 bool RandomNode::trainNode(	const vector<PatchSample>& vFeatures,
 				const vector<uint32_t>& vIndex,
 				vector<uint32_t>& vIndex4Left,
-				vector<uint32_t>& vIndex4Right)
+				vector<uint32_t>& vIndex4Right,
+				RFRandom* pRandom,
+				int nThreads,
+				const PatchTensor* pTensor)
 {
 	if(vIndex.size()<m_nMinSample || m_nLevel>=m_nMaxLevel)
 	{
@@ -216,11 +318,7 @@ bool RandomNode::trainNode(	const vector<PatchSample>& vFeatures,
 	vector<int>	r;
 	vector<int>	t;
 
-	vector<float> vdEntropy;
-	vector<vector<uint32_t> >	vIndex1;
-	vector<vector<uint32_t> >	vIndex2;
-
-	int imageSize = vFeatures[0].vChannels[0].width();
+	int imageSize = pTensor ? pTensor->width() : vFeatures[0].vChannels[0].width();
 	int nChannels = vFeatures[0].nChannels;
 	
 	int nEntropy = OBJ_BKG_ENTROPY;
@@ -229,26 +327,42 @@ bool RandomNode::trainNode(	const vector<PatchSample>& vFeatures,
 	//	nEntropy = POS_ENTROPY;
 	
 	// Generate a series of week classifiers. The number of the classifiers is ?
+	// The tests are drawn first (in a fixed order), then evaluated in parallel.
 	for(int i=0;i<m_nWeekClassifier;i++){
-		vector<uint32_t> tmp_index_1;
-		vector<uint32_t> tmp_index_2;
-		// For test
-	//	tmp_index_1.push_back(1);
-		float entropy;
 		// Generate the random split
-		channel.push_back(static_cast<int>((double)rand()/(RAND_MAX)*nChannels));
-		p.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
-		q.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
-		r.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
-		s.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
-		t.push_back(static_cast<int>((double)rand()/(RAND_MAX)*255*2-255));	
+		if(pRandom){
+			channel.push_back(static_cast<int>(pRandom->uniform()*nChannels));
+			p.push_back(static_cast<int>(pRandom->uniform()*imageSize));
+			q.push_back(static_cast<int>(pRandom->uniform()*imageSize));
+			r.push_back(static_cast<int>(pRandom->uniform()*imageSize));
+			s.push_back(static_cast<int>(pRandom->uniform()*imageSize));
+			t.push_back(static_cast<int>(pRandom->uniform()*255*2-255));
+		}
+		else{
+			channel.push_back(static_cast<int>((double)rand()/(RAND_MAX)*nChannels));
+			p.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
+			q.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
+			r.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
+			s.push_back(static_cast<int>((double)rand()/(RAND_MAX)*imageSize));
+			t.push_back(static_cast<int>((double)rand()/(RAND_MAX)*255*2-255));	
+		}
+	}
+	vector<float> vdEntropy(m_nWeekClassifier, 0);
+	RFSplitTask task;
+	task.pNode		= this;
+	task.pFeatures	= &vFeatures;
+	task.pTensor	= pTensor;
+	task.pIndex		= &vIndex;
+	task.pChannel	= &channel;
+	task.pP			= &p;
+	task.pQ			= &q;
+	task.pR			= &r;
+	task.pS			= &s;
+	task.pT			= &t;
+	task.nEntropy	= nEntropy;
+	task.pEntropy	= &vdEntropy;
+	parallelFor(0, m_nWeekClassifier, nThreads, task);
 
-		calculateSplit(vFeatures, vIndex, channel.back(), p.back(), q.back(), r.back(), s.back(), t.back(), nEntropy, entropy, tmp_index_1,tmp_index_2);
-
-		vdEntropy.push_back(entropy);
-		vIndex1.push_back(tmp_index_1);
-		vIndex2.push_back(tmp_index_2);
-	}
 	// Select the split with the largest information gain.
 	int minEtpIndex = (int)(min_element(vdEntropy.begin(), vdEntropy.end())-vdEntropy.begin());
 	m_channel = channel[minEtpIndex];
@@ -260,17 +374,22 @@ bool RandomNode::trainNode(	const vector<PatchSample>& vFeatures,
 	// If the samples contained in each node is less than the minimal threhold, claim it to be a leaf node by assigning the children as 0.
 	m_leftkey = m_key * 2;
 	m_rightkey = m_key * 2 + 1;
-	vIndex4Left = vIndex1[minEtpIndex];
-	vIndex4Right = vIndex2[minEtpIndex];	
+	// Split the samples again with the selected test
+	float entropy;
+	vector<uint32_t> vLeft;
+	vector<uint32_t> vRight;
+	calculateSplit(vFeatures, vIndex, m_channel, m_p, m_q, m_r, m_s, m_t, nEntropy, entropy, vLeft, vRight, pTensor);
+	vIndex4Left = vLeft;
+	vIndex4Right = vRight;
 	m_vLeftIndex = vIndex4Left;
 	m_vRightIndex = vIndex4Right;
 	return true;
 	}
 }
 
-void RandomNode::trainNode(const vector<PatchSample>& vFeatures, const vector<uint32_t>& vIndex)
+void RandomNode::trainNode(const vector<PatchSample>& vFeatures, const vector<uint32_t>& vIndex, RFRandom* pRandom, int nThreads, const PatchTensor* pTensor)
 {
-	trainNode(vFeatures, vIndex, m_vLeftIndex, m_vRightIndex);
+	trainNode(vFeatures, vIndex, m_vLeftIndex, m_vRightIndex, pRandom, nThreads, pTensor);
 
 }
 
@@ -305,15 +424,19 @@ void RandomNode::calculateSplit(const vector<PatchSample>& vFeatures,
 				int entropyType,
 				float& entropy,
 				vector<uint32_t>& vIndex4Left,
-				vector<uint32_t>& vIndex4Right)
+				vector<uint32_t>& vIndex4Right,
+				const PatchTensor* pTensor)
 {
 	// Traverse all the samples assigned to this node
-	for(vector<uint32_t>::const_iterator itr=vIndex.begin();itr!=vIndex.end();++itr){
-		if(vFeatures[*itr].vChannels[c](p, q).value() - vFeatures[*itr].vChannels[c](r, s).value() > t)
-			vIndex4Left.push_back(*itr);
-		else
-			vIndex4Right.push_back(*itr);
-
+	if(pTensor)
+		pTensor->splitSamples(vIndex, c, p, q, r, s, t, vIndex4Left, vIndex4Right);
+	else{
+		for(vector<uint32_t>::const_iterator itr=vIndex.begin();itr!=vIndex.end();++itr){
+			if(vFeatures[*itr].vChannels[c](p, q).value() - vFeatures[*itr].vChannels[c](r, s).value() > t)
+				vIndex4Left.push_back(*itr);
+			else
+				vIndex4Right.push_back(*itr);
+		}
 	}
 
 	// Calculate the entropy of class or offset
@@ -475,6 +598,15 @@ uint32_t RandomNode::testNode(const PatchSample& feature)
 	else return m_rightkey;
 }
 
+uint32_t RandomNode::testNode(const PatchTensor& ptPatches, uint32_t n)
+{
+	if(m_leftkey == 0&& m_rightkey ==0) return -1;
+	if(ptPatches.value(n, m_channel, m_p, m_q) - ptPatches.value(n, m_channel, m_r, m_s)>m_t){
+		return m_leftkey;
+	}
+	else return m_rightkey;
+}
+
 void RandomNode::calculateGeneralizedOOBError()
 {
 	if(fabs(sumFloatVector(m_dProportion) - 1) > SMALL_ENOUGH_PROPORTION || fabs(sumFloatVector(m_dProportion_Validation) - 1) > SMALL_ENOUGH_PROPORTION)
@@ -515,9 +647,9 @@ float RandomNode::entropyofObjectClasses()
 /********************/
 /*   Constructor    */
 /********************/
-RandomTree::RandomTree():m_nTreeDepth(10), m_nMinSample(20), m_nWeekClassifier(50){}
+RandomTree::RandomTree():m_nTreeDepth(10), m_nMinSample(20), m_nWeekClassifier(50), m_pRandom(0), m_nThreads(1), m_pTensor(0){}
 
-RandomTree::RandomTree(int nTreeDepth, int nMinSample, int nWeekClassifier): m_nTreeDepth(nTreeDepth), m_nMinSample(nMinSample), m_nWeekClassifier(nWeekClassifier)
+RandomTree::RandomTree(int nTreeDepth, int nMinSample, int nWeekClassifier): m_nTreeDepth(nTreeDepth), m_nMinSample(nMinSample), m_nWeekClassifier(nWeekClassifier), m_pRandom(0), m_nThreads(1), m_pTensor(0)
 {}
 
 RandomTree::~RandomTree(){}
@@ -543,7 +675,12 @@ void RandomTree::trainTree(const vector<PatchSample>& vFeatures, const vector<ui
 	// Train the root node
 	vector<uint32_t> vTmp_Index4Left;
 	vector<uint32_t> vTmp_Index4Right;
-	rdRoot.trainNode(vFeatures, vIndex,vTmp_Index4Left, vTmp_Index4Right);
+	m_vLevelNodes.clear();
+	m_vLevelSamples.clear();
+	m_vLevelTimes.clear();
+	double dStart = getWallTime();
+	rdRoot.trainNode(vFeatures, vIndex,vTmp_Index4Left, vTmp_Index4Right, m_pRandom, m_nThreads, m_pTensor);
+	addLevelStatistics(0, vIndex.size(), getWallTime() - dStart);
 	m_rnNodes.insert(make_pair<uint32_t, RandomNode>(rdRoot.getKey(), rdRoot));
 	map<uint32_t, RandomNode>::iterator it;	
 	it = m_rnNodes.find(1);
@@ -561,7 +698,9 @@ void RandomTree::trainTree(const vector<PatchSample>& vFeatures, const vector<ui
 		RandomNode rnNode(m_nWeekClassifier, m_nMinSample, it->second.getLeft(), it->second.getKey(), it->second.getLevel()+1, m_nTreeDepth);
 		vector<uint32_t> vLIndex;
 		it->second.loadLeftPatches(vLIndex);
-		rnNode.trainNode(vFeatures, vLIndex);
+		double dStart = getWallTime();
+		rnNode.trainNode(vFeatures, vLIndex, m_pRandom, m_nThreads, m_pTensor);
+		addLevelStatistics(rnNode.getLevel(), vLIndex.size(), getWallTime() - dStart);
 		m_rnNodes.insert(make_pair<uint32_t, RandomNode>(rnNode.getKey(), rnNode));
 		}
 		else if(it->second.getRight()!=0 && m_rnNodes.count(it->second.getRight()) == 0)
@@ -570,7 +709,9 @@ void RandomTree::trainTree(const vector<PatchSample>& vFeatures, const vector<ui
 		RandomNode rnNode(m_nWeekClassifier, m_nMinSample, it->second.getRight(), it->second.getKey(), it->second.getLevel()+1, m_nTreeDepth);
 		vector<uint32_t> vRIndex;
 	 	it->second.loadRightPatches(vRIndex);
-		rnNode.trainNode(vFeatures, vRIndex);
+		double dStart = getWallTime();
+		rnNode.trainNode(vFeatures, vRIndex, m_pRandom, m_nThreads, m_pTensor);
+		addLevelStatistics(rnNode.getLevel(), vRIndex.size(), getWallTime() - dStart);
 		m_rnNodes.insert(make_pair<uint32_t, RandomNode>(rnNode.getKey(), rnNode));	
 		}
 		else
@@ -584,6 +725,19 @@ void RandomTree::trainTree(const vector<PatchSample>& vFeatures, const vector<ui
 	
 }
 
+void RandomTree::addLevelStatistics(int level, uint32_t samples, double time)
+{
+	if((int)m_vLevelNodes.size() <= level)
+	{
+		m_vLevelNodes.resize(level+1, 0);
+		m_vLevelSamples.resize(level+1, 0);
+		m_vLevelTimes.resize(level+1, 0);
+	}
+	m_vLevelNodes[level]++;
+	m_vLevelSamples[level] += samples;
+	m_vLevelTimes[level] += time;
+}
+
 void RandomTree::validateTree(const vector<PatchSample>& vFeatures, const vector<uint32_t>& validationSampleIndex)
 {
 	clearandinitiateValidationData(vFeatures[0].nTotalClasses);
@@ -606,7 +760,7 @@ void RandomTree::validateWithValidationSamples(const vector<PatchSample>& vFeatu
 {
 	for(vector<uint32_t>::const_iterator itr = vIndex.begin(); itr != vIndex.end(); itr++)
 	{
-		uint32_t reachedNodeKey = testTree(vFeatures[*itr]);
+		uint32_t reachedNodeKey = m_pTensor ? testTree(*m_pTensor, *itr) : testTree(vFeatures[*itr]);
 		map<uint32_t, RandomNode>::iterator leafnodeitr= m_rnNodes.find(reachedNodeKey);
 		int classlabel = vFeatures[*itr].nClassLabel;
 		leafnodeitr->second.m_nValidPatches_Validation[classlabel]++;
@@ -647,6 +801,18 @@ uint32_t RandomTree::testTree(const PatchSample& feature)
 	
 }
 
+uint32_t RandomTree::testTree(const PatchTensor& ptPatches, uint32_t n)
+{
+	uint32_t result_key = 1;
+	uint32_t tmp_key = 1;
+	while(tmp_key!=-1)
+	{
+		result_key = tmp_key;
+		tmp_key = m_rnNodes[tmp_key].testNode(ptPatches, n);
+	}
+	return result_key;
+}
+
 map<uint32_t, RandomNode> RandomTree::getLeafNode()
 /*---------------------------------------------------------------------------------------*/
 /* Function to return the leaf nodes of this tree, in a map storing the key and the node */
@@ -670,6 +836,24 @@ void RandomTree::insertNode(uint32_t key, RandomNode node)
 {
 	m_rnNodes.insert(pair<uint32_t, RandomNode>(key, node));
 }
+/*===================================================================*/
+/*                         Struct RFTreeTask                         */
+/*===================================================================*/
+struct RFTreeTask
+{
+	RandomForest*				pForest;
+	const vector<PatchSample>*	pFeatures;
+	const PatchTensor*			pTensor;
+	vector<RandomTree>*			pTrees;
+	int							nNodeThreads;
+
+	void operator()(int nThread, int nBegin, int nEnd)
+	{
+		for(int i=nBegin; i<nEnd; i++)
+			pForest->trainOneTree(*pFeatures, *pTensor, (*pTrees)[i], i, nNodeThreads);
+	}
+};
+
 /*===================================================================*/
 /*                          Class RandomForest                       */
 /*===================================================================*/
@@ -685,11 +869,17 @@ RandomForest::RandomForest()
 	m_gui = 0;
 	m_bClustersValid = false;
 	m_eta = 0.8;
+	m_nThreads = 0;
+	m_nSeed = 0;
+	m_bFixedSeed = false;
 }
 
 RandomForest::RandomForest(int nTreeNumber, int nTreeDepth, int nWeekClassifiers, int nMinSample):m_nTreeNumber(nTreeNumber),m_nTreeDepth(nTreeDepth), m_nMinSample(nMinSample), m_nWeekClassifier(nWeekClassifiers), m_gui(0)
 {
 	m_eta = 0.8;
+	m_nThreads = 0;
+	m_nSeed = 0;
+	m_bFixedSeed = false;
 }
 
 RandomForest::~RandomForest(){};
@@ -769,26 +959,156 @@ void RandomForest::trainRandomForest(const vector<PatchSample>& vFeatures)
 		cerr<< "Errors in the parameter setting!"<<endl;
 		return;
 	}
+	if(vFeatures.size()==0){
+		cerr<< "Error in RandomForest::trainRandomForest: no training samples"<<endl;
+		return;
+	}
 	// Clean the original tree
 	m_vTrees.clear();
-	// Derive m_vImagePatches from vFeatures
-	// If the forest is trained for the first time, assign the samples to the members
-	m_vImagePatches.clear();
-	if(m_vPatchSample.size() == 0)
+	/*------------------------------------------------------*/
+	/*  Pack the patches of all samples into one block. The */
+	/*  forest keeps no images: the split tests, the        */
+	/*  clustering and getPatchSample() read this block.    */
+	/*------------------------------------------------------*/
+	if(!storePatches(vFeatures))
+		return;
+	// If the forest is trained for the first time (or with another set of
+	// samples), assign the samples to the members
+	if(m_vPatchSample.size() != vFeatures.size())
 	{
 		m_vPatchSample = vFeatures;
+		releasePatchImages(m_vPatchSample);
+	}
+	/*------------------------------------------*/
+	/*  Seed the random streams of the trees    */
+	/*------------------------------------------*/
+	if(!m_bFixedSeed)
+	{
+		timeval time;
+		gettimeofday(&time, NULL);
+		m_nSeed = static_cast<uint32_t>(time.tv_sec) * 1000003u + static_cast<uint32_t>(time.tv_usec);
+	}
+	cout<< "seed: "<< m_nSeed <<endl;
+	cout<< "patches: "<< m_ptPatches.memorySize()/(1024*1024) <<" MB"<<
+		(m_ptPatches.isBytes() ? " (bytes)" : " (floats)") <<endl;
+	/*------------------------------------------------------*/
+	/*  Train the trees in parallel. If there are fewer     */
+	/*  trees than threads, the remaining threads are used  */
+	/*  to evaluate the split candidates of each node.      */
+	/*------------------------------------------------------*/
+	int nThreads = ::getNumThreads(m_nThreads, INT_MAX);
+	int nTreeThreads = max(1, min(nThreads, m_nTreeNumber));
+	int nNodeThreads = max(1, nThreads / nTreeThreads);
+	cout<< "threads: "<< nTreeThreads <<" x "<< nNodeThreads <<endl;
+	vector<RandomTree> vTrees(m_nTreeNumber, RandomTree(m_nTreeDepth, m_nMinSample, m_nWeekClassifier));
+	RFTreeTask task;
+	task.pForest		= this;
+	task.pFeatures		= &vFeatures;
+	task.pTensor		= &m_ptPatches;
+	task.pTrees			= &vTrees;
+	task.nNodeThreads	= nNodeThreads;
+	double dStart = getWallTime();
+	parallelFor(0, m_nTreeNumber, nTreeThreads, task);
+	cout<<"time for training the forest: "<< getWallTime() - dStart <<endl;
+	/*----------------------------*/
+	/*     Save the leaf nodes    */
+	/*----------------------------*/
+	for(int i=0;i<m_nTreeNumber;i++){
+	m_vTrees.push_back(vTrees[i]);
+ 	map<uint32_t, RandomNode> leafNodes = vTrees[i].getLeafNode();
+	m_vmClusters.push_back(leafNodes);
 	}
-	if(m_vImagePatches.size() == 0)
+	printLevelStatistics();
+	cout<<"Done"<<endl;
+}
+
+bool RandomForest::storePatches(const vector<PatchSample>& vFeatures)
+/*==================================================================*/
+/* Store the patch of sample i as patch i of m_ptPatches. Samples   */
+/* without channels are copied from patch nPatchIndex of the old    */
+/* m_ptPatches, which is kept as it is if all samples are its       */
+/* patches in their order (e.g. for m_vPatchSample itself).         */
+/*==================================================================*/
+{
+	uint32_t nSamples = vFeatures.size();
+	bool bSame = (nSamples == m_ptPatches.size());
+	bool bBytes = true;
+	for(uint32_t i=0;i<nSamples;i++)
 	{
-		for(vector<PatchSample>::const_iterator itr = vFeatures.begin(); itr!=vFeatures.end(); itr++){
-			m_vImagePatches.push_back(itr->vChannels[0]);
+		const PatchSample& psSample = vFeatures[i];
+		if(!psSample.vChannels.empty())
+		{
+			bSame = false;
+			bBytes = bBytes && PatchTensor::isByteData(psSample.vChannels);
+		}
+		else if(psSample.nPatchIndex < m_ptPatches.size())
+		{
+			bSame = bSame && psSample.nPatchIndex == i;
+			bBytes = bBytes && m_ptPatches.isBytes();
 		}
+		else
+		{
+			cerr<< "Error in RandomForest::trainRandomForest: "<<
+				"sample "<< i <<" has neither images nor a stored patch"<<endl;
+			return false;
+		}
+	}
+	if(bSame)
+		return true;
 
+	const PatchSample& psFirst = vFeatures[0];
+	PatchTensor ptPatches;
+	if(psFirst.vChannels.empty())
+		ptPatches.create(nSamples, m_ptPatches.channels(),
+						 m_ptPatches.width(), m_ptPatches.height(), bBytes);
+	else
+		ptPatches.create(nSamples, psFirst.nChannels,
+						 psFirst.vChannels[0].width(), psFirst.vChannels[0].height(), bBytes);
+	for(uint32_t i=0;i<nSamples;i++)
+	{
+		bool ok = vFeatures[i].vChannels.empty() ?
+			ptPatches.setPatch(i, m_ptPatches, vFeatures[i].nPatchIndex) :
+			ptPatches.setPatch(i, vFeatures[i].vChannels);
+		if(!ok)
+		{
+			cerr<< "Error in RandomForest::trainRandomForest: "<<
+				"the patches of the samples differ in size"<<endl;
+			return false;
+		}
+	}
+	m_ptPatches.swap(ptPatches);
+	return true;
+}
+
+void RandomForest::releasePatchImages(vector<PatchSample>& vFeatures)
+/*==================================================================*/
+/* Sample i of the last training set is patch i of m_ptPatches.     */
+/*==================================================================*/
+{
+	if(vFeatures.size() != m_ptPatches.size())
+	{
+		cerr<< "Error in RandomForest::releasePatchImages: "<<
+			"the samples are not the ones of the last training"<<endl;
+		return;
+	}
+	for(uint32_t i=0;i<vFeatures.size();i++)
+	{
+		// (swap to really release the images)
+		vector<OpGrayImage>().swap(vFeatures[i].vChannels);
+		vFeatures[i].nPatchIndex = i;
 	}
+}
+
+void RandomForest::trainOneTree(const vector<PatchSample>& vFeatures, const PatchTensor& ptPatches, RandomTree& rtRandomTree, int i, int nThreads)
+/*==================================================================*/
+/* Bootstrap the samples of tree i, train and validate it. The tree */
+/* uses its own random stream, derived from the seed and i.         */
+/*==================================================================*/
+{
+	RFRandom random(static_cast<uint64_t>(m_nSeed) * 0x100000000ULL + i);
 	/*----------------------*/
 	/*  Bootstrap sampling  */
 	/*----------------------*/
-	for(int i=0;i<m_nTreeNumber;i++){
 	// Randomly select a set of training samples. The size of selected samlele is now set as 1/nTreeNumber. MIGHT NEED REVISE!
 	//int nSampleperTree = vFeatures.size()/m_nTreeNumber;
 	//int nSampleperTree = static_cast<uint32_t>(vFeatures.size() * 0.67);
@@ -796,37 +1116,54 @@ void RandomForest::trainRandomForest(const vector<PatchSample>& vFeatures)
 	vector<uint32_t> trainSampleIndex;
 	vector<uint32_t> validationSampleIndex;
 	vector<uint32_t> train_validationSampleIndex;
-	clock_t start, end;
-	start = clock();
-	train_validationSampleIndex = bootstrapSamplesandTheonesleft(vFeatures.size(), numoftrainigsample);
+	train_validationSampleIndex = bootstrapSamplesandTheonesleft(vFeatures.size(), numoftrainigsample, random);
 	trainSampleIndex.assign(train_validationSampleIndex.begin(), train_validationSampleIndex.begin() + numoftrainigsample);	
 	validationSampleIndex.assign(train_validationSampleIndex.begin() + numoftrainigsample + 1, train_validationSampleIndex.end());
-	end = clock();
-	cout<<"time for bootstraping samples: "<<static_cast<float>(end - start)/CLOCKS_PER_SEC<<endl;
 	/*------------------------*/
 	/*     Train each tree    */
 	/*------------------------*/	
-	start = clock();
-	RandomTree rtRandomTree(m_nTreeDepth, m_nMinSample, m_nWeekClassifier);
-	cout<< "Training tree "<<i<<"..."<<endl;
+	rtRandomTree.setTrainingContext(&random, nThreads, &ptPatches);
 	rtRandomTree.trainTree(vFeatures, trainSampleIndex);
-	end = clock();
-	cout<<"time for training tree: "<<static_cast<float>(end - start)/CLOCKS_PER_SEC<<endl;
-	start = clock();
 	rtRandomTree.validateTree(vFeatures, validationSampleIndex);
-	end = clock();
-	cout<<"time for validating trees: "<<static_cast<float>(end - start)/CLOCKS_PER_SEC<<endl;
-	// Save the trained tree
-	m_vTrees.push_back(rtRandomTree);
+	rtRandomTree.setTrainingContext(0, 1);
+}
 
-	/*----------------------------*/
-	/*     Save the leaf nodes    */
-	/*----------------------------*/
- 	map<uint32_t, RandomNode> leafNodes = rtRandomTree.getLeafNode();
-	m_vmClusters.push_back(leafNodes);
-	cout<<"Done"<<endl;
+void RandomForest::printLevelStatistics()
+/*==================================================================*/
+/* Print the number of nodes and samples and the training time of  */
+/* each tree level, summed over all trees (the time is the sum of   */
+/* the wall times of all nodes, i.e. thread seconds).                */
+/*==================================================================*/
+{
+	vector<uint32_t> vNodes;
+	vector<uint32_t> vSamples;
+	vector<double> vTimes;
+	for(uint32_t i=0;i<m_vTrees.size();i++)
+	{
+		const vector<uint32_t>& nodes = m_vTrees[i].getLevelNodes();
+		const vector<uint32_t>& samples = m_vTrees[i].getLevelSamples();
+		const vector<double>& times = m_vTrees[i].getLevelTimes();
+		if(vNodes.size() < nodes.size())
+		{
+			vNodes.resize(nodes.size(), 0);
+			vSamples.resize(nodes.size(), 0);
+			vTimes.resize(nodes.size(), 0);
+		}
+		for(uint32_t l=0;l<nodes.size();l++)
+		{
+			vNodes[l] += nodes[l];
+			vSamples[l] += samples[l];
+			vTimes[l] += times[l];
+		}
+	}
+	cout<< "Training time per level (all trees):"<<endl;
+	cout<< "  level    nodes    samples    time[s]"<<endl;
+	for(uint32_t l=0;l<vNodes.size();l++)
+	{
+		printf("  %5u %8u %10u %10.3f\n", l, vNodes[l], vSamples[l], vTimes[l]);
 	}
 }
+
 vector<uint32_t> RandomForest::bootstrapSamplesandTheonesleft(uint32_t numofbase, float proportion)
 {
 	uint32_t numofsample = numofbase * proportion;
@@ -840,20 +1177,27 @@ vector<uint32_t> RandomForest::bootstrapSamplesandTheonesleft(uint32_t numofbase
 {
 	vector<uint32_t> train_validationSampleIndex; 
 	train_validationSampleIndex = bootstrapSamples(numofbase, numofsample);
-	sort(train_validationSampleIndex.begin(), train_validationSampleIndex.end());
-	uint32_t currentSampleNumber = 0;
-	uint32_t nextSampleNumber = 0;
-	for(uint32_t j = 0; j < numofsample; j++)
-	{
-		currentSampleNumber = nextSampleNumber;
-		nextSampleNumber = train_validationSampleIndex[j];
-		for(int offset = 1; (currentSampleNumber+offset)< nextSampleNumber; offset++)
-		{
-			train_validationSampleIndex.push_back(currentSampleNumber + offset);
-		}
-	}
+	appendTheonesleft(train_validationSampleIndex, numofsample);
 	return  train_validationSampleIndex;
 }
+vector<uint32_t> RandomForest::bootstrapSamplesandTheonesleft(uint32_t numofbase, uint32_t numofsample, RFRandom& random)
+/*============================================================*/
+/* Same as above, drawing from the given random stream        */
+/*============================================================*/
+{
+	vector<uint32_t> train_validationSampleIndex; 
+	train_validationSampleIndex = bootstrapSamples(numofbase, numofsample, random);
+	appendTheonesleft(train_validationSampleIndex, numofsample);
+	return  train_validationSampleIndex;
+}
+vector<uint32_t> RandomForest::bootstrapSamples(uint32_t numofbase, long numofsample, RFRandom& random)
+{
+	vector<uint32_t> sampledIndex;
+	for(uint32_t j=0;j<numofsample;j++){
+		sampledIndex.push_back(static_cast<uint32_t>(random.uniform()*numofbase));
+	}
+	return sampledIndex;
+}
 vector<uint32_t> RandomForest::bootstrapSamples(uint32_t numofbase, long numofsample)
 {
 	vector<uint32_t> sampledIndex;
@@ -1273,7 +1617,7 @@ void RandomForest::testRandomForestMultiClass(	const PatchSample&					patch,
 	vvdConfidence.push_back(vConfidence);
 
 	//each class
-	for(int c=1; c<m_vPatchSample[0].nTotalClasses;c++)
+	for(int c=1; c<getTotalClasses();c++)
 	{
 		//each tree(leaf node)
 		for(uint32_t i=0;i<resultKeys.size();i++)
@@ -1350,20 +1694,15 @@ vector<vector<int> > RandomForest::getClusterAssignment()
 		nTreeIndex++;
 	}
 
-	int nImgIndex = 0;
 	// Test each patch
-	for(vector<OpGrayImage>::iterator itr = m_vImagePatches.begin();
-		itr != m_vImagePatches.end();
-		itr++){
+	for(uint32_t nImgIndex = 0; nImgIndex < m_ptPatches.size(); nImgIndex++){
 		vector<uint32_t> resultKeys;
-		PatchSample psTest;
-		psTest.vChannels.push_back(*itr);
-		testRandomForest( psTest, resultKeys);
+		for(int i=0;i<m_nTreeNumber;i++)
+			resultKeys.push_back(m_vTrees[i].testTree(m_ptPatches, nImgIndex));
 	    m_vvFullResult.push_back(resultKeys);
 		for(uint32_t i = 0; i < resultKeys.size(); i++){
 		vCluserAssignment[m_vmKey2Index[i][resultKeys[i]]].push_back(nImgIndex);
 		}
-		nImgIndex++;
 	}
 /*
 	int nTreeIndex = 0;
@@ -1424,11 +1763,11 @@ void RandomForest::computeClusterCenters_HF()
 	vector<vector<int> > vvAssignment = getClusterAssignment();
 	// Fake a m_vClusterAssignment
 	m_vClusterAssignment.clear();
-	m_vClusterAssignment.assign(m_vImagePatches.size(),0);
+	m_vClusterAssignment.assign(m_ptPatches.size(),0);
 	
 	// Calculate average Patch in every leaf node and store in m_vClusterPatches
-	OpGrayImage imgTmp( m_vImagePatches.front().width(),
-                            m_vImagePatches.front().height() );
+	OpGrayImage imgTmp( m_ptPatches.width(),
+                            m_ptPatches.height() );
    	vector<OpGrayImage> vTmpImg( vvAssignment.size(), imgTmp );
    	m_vClusterPatches = vTmpImg;
 	int currentIndex = 1;
@@ -1436,7 +1775,7 @@ void RandomForest::computeClusterCenters_HF()
 		
 		for(vector<int>::iterator itr_2 = itr_1->begin(); itr_2!=itr_1->end();itr_2++){
 			m_vClusterAssignment[*itr_2] = currentIndex;
-			m_vClusterPatches[currentIndex - 1] = m_vClusterPatches[currentIndex-1].add(m_vImagePatches[*itr_2].div(itr_1->size()));
+			m_vClusterPatches[currentIndex - 1] = m_vClusterPatches[currentIndex-1].add(m_ptPatches.getChannel(*itr_2, 0).div(itr_1->size()));
 		}
 		m_vClusterPatches[currentIndex-1] = m_vClusterPatches[currentIndex-1];
 		currentIndex++;
@@ -1448,8 +1787,12 @@ void RandomForest::drawClusters(QtClusterView *qClassView)
 {
 	if(!m_bClustersValid)
 		computeClusterCenters_HF();
+	// (the images only exist while the view is filled)
+	vector<OpGrayImage> vImagePatches;
+	for(uint32_t n=0;n<m_ptPatches.size();n++)
+		vImagePatches.push_back(m_ptPatches.getChannel(n, 0));
 	qClassView->loadImageSets( m_vClusterPatches, "cl",
-							   m_vImagePatches, m_vvClusterAssignment,
+							   vImagePatches, m_vvClusterAssignment,
 							   m_vClusterInfo);
 }
 
@@ -1462,8 +1805,14 @@ RandomNode RandomForest::getNode(int nTree, uint32_t nKey)
 }
 
 PatchSample RandomForest::getPatchSample(uint32_t nIndex)
+/*----------------------------------------------------------*/
+/* The sample with its channels rebuilt from m_ptPatches.	*/
+/*----------------------------------------------------------*/
 {
-	return m_vPatchSample[nIndex];
+	PatchSample psSample = m_vPatchSample[nIndex];
+	for(int c=0;c<m_ptPatches.channels();c++)
+		psSample.vChannels.push_back(m_ptPatches.getChannel(psSample.nPatchIndex, c));
+	return psSample;
 }
 
 OpGrayImage RandomForest::getMeanPatchOfLeafNode(int tree, uint32_t key)
@@ -1751,18 +2100,206 @@ void RandomForest::saveRandomForest(const char* uri)
 	xmlFreeTextWriter(writer);
 }
 
+bool RandomForest::saveRandomForestBinary(const char* uri, bool bWithCompiled)
+/*========================================================================*/
+/* Save the same parts as saveRandomForest() to a binary model file: the  */
+/* parameters, all nodes with their tests, and the proportions, valid     */
+/* patches and offset vectors of each class. With bWithCompiled, the      */
+/* compiled forest is stored as well, so that it can be loaded directly   */
+/* with CompiledForest::loadCompiledForest().                             */
+/*========================================================================*/
+{
+	/*----------------------*/
+	/* Pack the trees       */
+	/*----------------------*/
+	RFFileParams params;
+	memset(&params, 0, sizeof(params));
+	params.nTrees = m_vTrees.size();
+	params.nTreeDepth = m_nTreeDepth;
+	params.nWeekClassifier = m_nWeekClassifier;
+	params.nMinSample = m_nMinSample;
+	params.nTotalClasses = getTotalClasses();
+
+	vector<RFFileNode> vNodes;
+	vector<RFFileClass> vClasses;
+	vector<float> vCoords;
+	for(uint32_t t=0;t<m_vTrees.size();t++)
+	{
+		for(map<uint32_t, RandomNode>::iterator nitr = m_vTrees[t].m_rnNodes.begin();
+			nitr!=m_vTrees[t].m_rnNodes.end();
+			nitr++)
+		{
+			RandomNode& node = nitr->second;
+			RFFileNode fnode;
+			fnode.nTree = t;
+			fnode.nKey = node.getKey();
+			fnode.nParent = node.getParent();
+			fnode.nLeft = node.getLeft();
+			fnode.nRight = node.getRight();
+			fnode.nLevel = node.getLevel();
+			fnode.nChannel = node.getChannel();
+			fnode.p = node.getp();
+			fnode.q = node.getq();
+			fnode.r = node.getr();
+			fnode.s = node.gets();
+			fnode.t = node.gett();
+			fnode.nClassStart = vClasses.size();
+			fnode.nNumClasses = node.m_dProportion.size();
+			for(uint32_t c=0;c<node.m_dProportion.size();c++)
+			{
+				RFFileClass fclass;
+				fclass.dProportion = node.m_dProportion[c];
+				fclass.nValidPatches = c<node.m_nValidPatches.size() ? node.m_nValidPatches[c] : 0;
+				fclass.nCoordStart = vCoords.size()/2;
+				fclass.nNumCoords = 0;
+				if(c<node.m_vCoords.size())
+				{
+					for(uint32_t j=0;j<node.m_vCoords[c].size();j++)
+					{
+						vCoords.push_back(node.m_vCoords[c][j].at(0));
+						vCoords.push_back(node.m_vCoords[c][j].at(1));
+					}
+					fclass.nNumCoords = node.m_vCoords[c].size();
+				}
+				vClasses.push_back(fclass);
+			}
+			vNodes.push_back(fnode);
+		}
+	}
+
+	/*----------------*/
+	/* Write the file */
+	/*----------------*/
+	ModelFileWriter mfWriter;
+	mfWriter.addSection(MODELSEC_RF_PARAMS, &params, sizeof(params));
+	mfWriter.addSection(MODELSEC_RF_NODES, vNodes.empty() ? 0 : &vNodes[0], vNodes.size()*sizeof(RFFileNode));
+	mfWriter.addSection(MODELSEC_RF_CLASSES, vClasses.empty() ? 0 : &vClasses[0], vClasses.size()*sizeof(RFFileClass));
+	mfWriter.addSection(MODELSEC_RF_COORDS, vCoords.empty() ? 0 : &vCoords[0], vCoords.size()*sizeof(float));
+	CompiledForest cfForest;
+	if(bWithCompiled && cfForest.compile(*this))
+		cfForest.addSections(mfWriter);
+	cout<<"saveRandomForestBinary: "<<vNodes.size()<<" nodes, "<<vCoords.size()/2<<" offset vectors"<<endl;
+	if(!mfWriter.write(uri))
+	{
+		cout<<"saveRandomForestBinary: Error "<<uri<<" can not be written"<<endl;
+		return false;
+	}
+	return true;
+}
+
+bool RandomForest::loadRandomForestBinary(const char* uri)
+/*========================================================================*/
+/* Load a forest saved with saveRandomForestBinary(). Unlike the xml      */
+/* loader, this also restores the leaf nodes (m_vmClusters), so that the  */
+/* testRandomForest*() functions work.                                    */
+/*========================================================================*/
+{
+	MappedModelFile mfFile;
+	if(!mfFile.open(uri))
+		return false;
+	size_t nParamSize, nNodeSize, nClassSize, nCoordSize;
+	const RFFileParams* pParams = (const RFFileParams*)mfFile.section(MODELSEC_RF_PARAMS, nParamSize);
+	const RFFileNode* pNodes = (const RFFileNode*)mfFile.section(MODELSEC_RF_NODES, nNodeSize);
+	const RFFileClass* pClasses = (const RFFileClass*)mfFile.section(MODELSEC_RF_CLASSES, nClassSize);
+	const float* pCoords = (const float*)mfFile.section(MODELSEC_RF_COORDS, nCoordSize);
+	/*------------------------------*/
+	/* Check the sizes and indices  */
+	/*------------------------------*/
+	bool ok = pParams!=0 && pNodes!=0 && pClasses!=0 && pCoords!=0 &&
+			  nParamSize==sizeof(RFFileParams) && nNodeSize%sizeof(RFFileNode)==0 &&
+			  nClassSize%sizeof(RFFileClass)==0 && nCoordSize%(2*sizeof(float))==0 &&
+			  pParams->nTrees>=0;
+	uint32_t nNodes = ok ? nNodeSize/sizeof(RFFileNode) : 0;
+	uint32_t nClasses = ok ? nClassSize/sizeof(RFFileClass) : 0;
+	uint32_t nCoords = ok ? nCoordSize/(2*sizeof(float)) : 0;
+	for(uint32_t i=0;ok && i<nNodes;i++)
+		ok = pNodes[i].nTree<(uint32_t)pParams->nTrees &&
+			 pNodes[i].nClassStart<=nClasses && pNodes[i].nNumClasses<=nClasses-pNodes[i].nClassStart;
+	for(uint32_t i=0;ok && i<nClasses;i++)
+		ok = pClasses[i].nCoordStart<=nCoords && pClasses[i].nNumCoords<=nCoords-pClasses[i].nCoordStart;
+	if(!ok)
+	{
+		cout<<"loadRandomForestBinary: Error "<<uri<<" contains no valid random forest"<<endl;
+		return false;
+	}
+	/*---------------------------------*/
+	/* Clear the original RandomForest */
+	/*---------------------------------*/
+	m_vPatchSample.clear();
+	m_ptPatches.clear();
+	m_vClusterPatches.clear();
+	m_vClusterAssignment.clear();
+
+	m_vTrees.clear();
+	m_vmClusters.clear();
+	m_vmKey2Index.clear();
+	m_vvClusterAssignment.clear();
+	/*------------------------*/
+	/* Rebuild trees and nodes */
+	/*------------------------*/
+	m_nTreeNumber = pParams->nTrees;
+	m_nTreeDepth = pParams->nTreeDepth;
+	m_nWeekClassifier = pParams->nWeekClassifier;
+	m_nMinSample = pParams->nMinSample;
+	m_nTotalClasses = pParams->nTotalClasses;
+	m_vTrees.assign(m_nTreeNumber, RandomTree(m_nTreeDepth, m_nMinSample, m_nWeekClassifier));
+	FeatureVector coord(2);
+	for(uint32_t i=0;i<nNodes;i++)
+	{
+		const RFFileNode& fnode = pNodes[i];
+		map<uint32_t, RandomNode>& mNodes = m_vTrees[fnode.nTree].m_rnNodes;
+		// The nodes are stored in key order, so they are appended
+		RandomNode& node = mNodes.insert(mNodes.end(), pairNode(fnode.nKey, RandomNode()))->second;
+		node.setKey(fnode.nKey);
+		node.setParent(fnode.nParent);
+		node.setLeft(fnode.nLeft);
+		node.setRight(fnode.nRight);
+		node.setLevel(fnode.nLevel);
+		node.setChannel(fnode.nChannel);
+		node.setp(fnode.p);
+		node.setq(fnode.q);
+		node.setr(fnode.r);
+		node.sets(fnode.s);
+		node.sett(fnode.t);
+		node.m_vCoords.assign(fnode.nNumClasses, vector<FeatureVector>());
+		for(uint32_t c=0;c<fnode.nNumClasses;c++)
+		{
+			const RFFileClass& fclass = pClasses[fnode.nClassStart + c];
+			node.m_dProportion.push_back(fclass.dProportion);
+			node.m_nValidPatches.push_back(fclass.nValidPatches);
+			node.m_vCoords[c].reserve(fclass.nNumCoords);
+			for(uint32_t j=0;j<fclass.nNumCoords;j++)
+			{
+				coord.setValue(0, pCoords[2*(fclass.nCoordStart+j)]);
+				coord.setValue(1, pCoords[2*(fclass.nCoordStart+j)+1]);
+				node.m_vCoords[c].push_back(coord);
+			}
+		}
+	}
+	for(uint32_t t=0;t<m_vTrees.size();t++)
+		m_vmClusters.push_back(m_vTrees[t].getLeafNode());
+	return true;
+}
+
 void RandomForest::loadRandomForest(const char* uri)
 /*=============================================================*/
 /* Load the RandomForest from xml file. Note that not all parts*/
 /* of the RandomForest are loaded. Only the test function is   */
 /* guranteed to work, other parts may or may not work.         */
+/* Binary files (see saveRandomForestBinary()) are recognized  */
+/* and read with loadRandomForestBinary().                     */
 /*=============================================================*/
 {
+	if(isModelFile(uri))
+	{
+		loadRandomForestBinary(uri);
+		return;
+	}
 	/*---------------------------------*/
 	/* Clear the original RandomForest */
 	/*---------------------------------*/
 	m_vPatchSample.clear();
-	m_vImagePatches.clear();
+	m_ptPatches.clear();
 	m_vClusterPatches.clear();
 	m_vClusterAssignment.clear();
 
@@ -2077,6 +2614,33 @@ void poolFromIndex(const vector<uint32_t>& vIndex, uint32_t percent, vector<uint
 	}	
 }
 
+void appendTheonesleft(vector<uint32_t>& train_validationSampleIndex, uint32_t numofsample)
+/*============================================================*/
+/* Sort the bootstrap samples and append the indexes that lie */
+/* between them                                               */
+/*============================================================*/
+{
+	sort(train_validationSampleIndex.begin(), train_validationSampleIndex.end());
+	uint32_t currentSampleNumber = 0;
+	uint32_t nextSampleNumber = 0;
+	for(uint32_t j = 0; j < numofsample; j++)
+	{
+		currentSampleNumber = nextSampleNumber;
+		nextSampleNumber = train_validationSampleIndex[j];
+		for(int offset = 1; (currentSampleNumber+offset)< nextSampleNumber; offset++)
+		{
+			train_validationSampleIndex.push_back(currentSampleNumber + offset);
+		}
+	}
+}
+
+double getWallTime()
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+	return time.tv_sec + time.tv_usec * 1e-6;
+}
+
 bool cmpFloatInt(FloatInt a, FloatInt b)
 {
   return (a.dvalue < b.dvalue);
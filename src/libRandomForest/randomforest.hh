@@ -31,6 +31,7 @@ using namespace std;
 #include <opinterestimage.hh>
 
 #include "randomforestgui.hh"
+#include "patchtensor.hh"
 /************************/
 /*	Struct Defination	*/
 /************************/
@@ -41,7 +42,9 @@ typedef struct _PatchSample{
 	int nTotalClasses;
 	int nClassLabel;
 	uint32_t nImageIndex;
-	//int nPatchIndex;
+	// Index of the patch in the PatchTensor of a RandomForest. Only used
+	// if vChannels is empty (see RandomForest::releasePatchImages()).
+	uint32_t nPatchIndex;
 }PatchSample;
 
 typedef struct _LeafNodeIndex{
@@ -75,6 +78,26 @@ const float SMALL_ENOUGH_PROPORTION = 0.0001;
 /************************/
 /*	Class Defination	*/
 /************************/
+/*==========================================*/
+/*				Class RFRandom				*/
+/*==========================================*/
+/* Random number stream for the training. Every tree draws its bootstrap
+ * samples and split tests from its own stream, which is derived from the
+ * forest seed and the tree index. A trained forest therefore only depends
+ * on the seed, not on the number of threads or the order in which the
+ * trees are trained.														*/
+class RFRandom
+{
+public:
+	RFRandom(uint64_t seed = 1){setSeed(seed);}
+	void		setSeed(uint64_t seed);
+	uint32_t	next();
+	// Uniformly distributed in [0,1)
+	double		uniform(){return next() * (1.0/4294967296.0);}
+private:
+	uint64_t m_state;
+};
+
 /*==========================================*/
 /*				Class RandomNode			*/
 /*==========================================*/
@@ -136,12 +159,21 @@ public:
 	/****************/
 	/*	Train	*/
 	/****************/
+	// Without a random stream, the split tests are drawn with rand().
+	// The candidate tests are evaluated with nThreads threads. If pTensor
+	// holds the patches of vFeatures, the tests read the pixels from it.
 	void 	trainNode(const vector<PatchSample>& vFeatures,
-			const vector<uint32_t>& vIndex);
+			const vector<uint32_t>& vIndex,
+			RFRandom* pRandom = 0,
+			int nThreads = 1,
+			const PatchTensor* pTensor = 0);
 	bool 	trainNode(const vector<PatchSample>& vFeatures,
 			const vector<uint32_t>& vIndex,
 			vector<uint32_t>& vIndex4Left,
-			vector<uint32_t>& vIndex4Right);
+			vector<uint32_t>& vIndex4Right,
+			RFRandom* pRandom = 0,
+			int nThreads = 1,
+			const PatchTensor* pTensor = 0);
 	void 	trainLeafNode(	const vector<PatchSample>& vFeatures,
 				const vector<uint32_t>& vIndex,
 				RandomNode& rnLeftNode,
@@ -151,6 +183,7 @@ public:
 	/*	Test	*/
 	/****************/
 	uint32_t 	testNode(const PatchSample& feature);
+	uint32_t 	testNode(const PatchTensor& ptPatches, uint32_t n);
 /*	bool 	testNode(const vector<PatchSample>& vFeatures,
 			vector<PatchSample>& vFeatures4Left,
 			vector<PatchSample>& vFeatures4Right);*/
@@ -170,7 +203,9 @@ private:
 				int 	entropyType,
 				float& 	entropy,
 				vector<uint32_t>& vIndex4Left,
-				vector<uint32_t>& vIndex4Right );
+				vector<uint32_t>& vIndex4Right,
+				const PatchTensor* pTensor = 0 );
+	friend struct RFSplitTask;
 	uint32_t getnumberofOBJPatch(const vector<PatchSample>& vFeatures, const vector<uint32_t>& index);
 	uint32_t getnumberofBKGPatch(const vector<PatchSample>& vFeatures, const vector<uint32_t>& index);
 	//void 	calculateFilter(const PatchSample)
@@ -243,6 +278,10 @@ public:
 	/*	Train	*/
 	/************/
 	void trainTree(const vector<PatchSample>& vFeatures, const vector<uint32_t>& vIndex);
+	// Random stream and number of threads for the split evaluation, and
+	// the packed patches of the training samples (optional)
+	void setTrainingContext(RFRandom* pRandom, int nThreads, const PatchTensor* pTensor = 0)
+		{m_pRandom = pRandom; m_nThreads = nThreads; m_pTensor = pTensor;}
 	void validateTree(const vector<PatchSample>& vFeatures, const vector<uint32_t>& validationSampleIndex);
 	void clearandinitiateValidationData(int numofclasses);
 	void validateWithValidationSamples(const vector<PatchSample>& vFeatures, const vector<uint32_t>& vIndex);
@@ -251,12 +290,22 @@ public:
 	/*	Test	*/
 	/************/
 	uint32_t testTree(const PatchSample& feature);
+	uint32_t testTree(const PatchTensor& ptPatches, uint32_t n);
 	/****************/
 	/* 	Leaf Nodes	*/
 	/****************/
 	map<uint32_t, RandomNode> getLeafNode();
 	void clearNodes();
 	void insertNode(uint32_t key, RandomNode node);
+	/************************/
+	/* 	Training Statistics	*/
+	/************************/
+	// Per level: number of trained nodes, samples and wall time [s]
+	const vector<uint32_t>&	getLevelNodes()		{return m_vLevelNodes;}
+	const vector<uint32_t>&	getLevelSamples()	{return m_vLevelSamples;}
+	const vector<double>&	getLevelTimes()		{return m_vLevelTimes;}
+private:
+	void addLevelStatistics(int level, uint32_t samples, double time);
 private:
 	/************************/
 	/*	Parameters	*/
@@ -268,6 +317,15 @@ private:
 	int m_nWeekClassifier;
 	int m_nMinSample;
 	/************************/
+	/*	Training context	*/
+	/************************/
+	RFRandom* m_pRandom;
+	int m_nThreads;
+	const PatchTensor* m_pTensor;
+	vector<uint32_t> m_vLevelNodes;
+	vector<uint32_t> m_vLevelSamples;
+	vector<double> m_vLevelTimes;
+	/************************/
 	/*	RandomNodes	*/
 	/************************/
 public:
@@ -298,15 +356,29 @@ public:
 			int nWeekClassifier, 
 			int nMinSample);
 	int  getTotalClasses();
+	// Number of training threads (<=0: one per processor)
+	void setNumThreads(int nThreads){m_nThreads = nThreads;}
+	int  getNumThreads(){return m_nThreads;}
+	// Fix the seed of the training random streams (otherwise a new seed
+	// is taken from the clock and printed for every training run)
+	void setSeed(uint32_t nSeed){m_nSeed = nSeed; m_bFixedSeed = true;}
+	uint32_t getSeed(){return m_nSeed;}
 public:
 	/****************/
 	/*	Training	*/
 	/****************/
+	// Samples without channels refer to the patches the forest already
+	// keeps (nPatchIndex), all others are copied into the forest.
 	void trainRandomForest(const vector<PatchSample>& vFeatures);
 	void trainRandomForest();
+	// Drop the images of samples passed to trainRandomForest(), they then
+	// refer to the forest's copy of their patches.
+	void releasePatchImages(vector<PatchSample>& vFeatures);
 	vector<uint32_t> bootstrapSamplesandTheonesleft(uint32_t numofbase, float proportion);
 	vector<uint32_t> bootstrapSamplesandTheonesleft(uint32_t numofbase, uint32_t numofsample);
 	vector<uint32_t> bootstrapSamples(uint32_t numofbase, long numofsample);
+	vector<uint32_t> bootstrapSamplesandTheonesleft(uint32_t numofbase, uint32_t numofsample, RFRandom& random);
+	vector<uint32_t> bootstrapSamples(uint32_t numofbase, long numofsample, RFRandom& random);
 	void purifyTrainingSet(vector<uint32_t> &removedIndex, vector<uint32_t> &top100DiscriminantIndex);
 	vector<LeafNodeScore> rankLeafNodes();
 	void saveRankedLeafNodeandScore(const vector<LeafNodeScore>& rankedLeafNodeScore);
@@ -316,11 +388,17 @@ public:
 	vector< vector<Tuple_Sample_LeafNodeIndex> > getAverage5LeafNodePerImageCoverage(uint32_t totalimagenumber);
 private:
 	vector<LeafNodeScore> calculateLeafNodeScore();
+	friend struct RFTreeTask;
+	bool storePatches(const vector<PatchSample>& vFeatures);
+	void trainOneTree(const vector<PatchSample>& vFeatures, const PatchTensor& ptPatches, RandomTree& rtTree, int nTree, int nThreads);
+	void printLevelStatistics();
 public:
 	/*******************/
 	/*  Acquire Result */
 	/*******************/
 	RandomNode 				getNode(int nTree, uint32_t nKey);
+	int						getNumTrees(){return m_vTrees.size();}
+	RandomTree&				getTree(int nTree){return m_vTrees[nTree];}
 	PatchSample 			getPatchSample(uint32_t nIndex);
 	OpGrayImage				getMeanPatchOfLeafNode(int tree, uint32_t key);
 	void 					writeLeafNodetoFile( QString fileName );
@@ -352,6 +430,10 @@ public:
 	/***************/
 	void saveRandomForest(const char* uri);
 	void loadRandomForest(const char* uri);
+	// Binary model file (see modelfile.hh), optionally together with the
+	// compiled forest. loadRandomForest() reads both formats.
+	bool saveRandomForestBinary(const char* uri, bool bWithCompiled = true);
+	bool loadRandomForestBinary(const char* uri);
 	void streamXMLFile(const char* uri);
 	void processXMLNode(xmlTextReaderPtr reader);
 private:
@@ -365,11 +447,15 @@ private:
 	int m_nWeekClassifier;
 	int m_nMinSample;
 	int m_nTotalClasses;
+	int m_nThreads;
+	uint32_t m_nSeed;
+	bool m_bFixedSeed;
 	/***********************/
 	/*  Original Resource  */
 	/***********************/
+	// The training samples (without images) and their patches
     vector<PatchSample> m_vPatchSample;	
-	vector<OpGrayImage> m_vImagePatches;
+	PatchTensor m_ptPatches;
 	/****************/
 	/*	Cluster		*/
 	/****************/
@@ -0,0 +1,101 @@
+/********************************************************************/
+/*																	*/
+/*FILE         	rfconvert.cc										*/
+/*																	*/
+/*CONTENT		Converts random forests between the xml format		*/
+/*				(saveRandomForest) and the binary format			*/
+/*				(saveRandomForestBinary), and prints the load times	*/
+/*				of both files.										*/
+/*																	*/
+/*				Not part of the library; compile with				*/
+/*				  g++ -O3 -I. -I$(HOME)/code/include rfconvert.cc	*/
+/*				      -L$(HOME)/code/lib/i686 -lRandomForest		*/
+/*				      -lFeatures2 -lGrayImage2 -lQtTools2 -lqt -o rfconvert	*/
+/*				and run as											*/
+/*				  rfconvert forest.xml forest.rfb					*/
+/*				  rfconvert forest.rfb forest.xml					*/
+/*				The output format is binary unless the output name	*/
+/*				ends with .xml.										*/
+/*																	*/
+/*BEGIN			SAT OCT 17	 2026									*/
+/*LAST CHANGE	SAT OCT 17	 2026									*/
+/*																	*/
+/********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <iostream>
+#include <string>
+#include <strings.h>
+#include <sys/time.h>
+
+#include <modelfile.hh>
+
+#include "randomforest.hh"
+#include "compiledforest.hh"
+
+using namespace std;
+
+/********************************/
+/*	Global Functions	*/
+/********************************/
+static double now()
+{
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec*1e-6;
+}
+
+static bool isXMLName(const string& sName)
+{
+	return sName.size()>=4 && strcasecmp(sName.c_str()+sName.size()-4, ".xml")==0;
+}
+
+static double timeLoad(const char* uri)
+{
+	RandomForest rfForest;
+	double dStart = now();
+	rfForest.loadRandomForest(uri);
+	double dTime = now() - dStart;
+	cout<< "  "<< uri <<": "<< rfForest.getNumTrees() <<" trees loaded in "<< dTime <<"s"<<endl;
+	return dTime;
+}
+
+/****************/
+/*	Main		*/
+/****************/
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		cout<< "usage: "<< argv[0] <<" <input forest> <output forest>"<<endl;
+		return 1;
+	}
+	RandomForest rfForest;
+	cout<< "Loading "<< argv[1] <<" ("<< (isModelFile(argv[1]) ? "binary" : "xml") <<")..."<<endl;
+	rfForest.loadRandomForest(argv[1]);
+	if(rfForest.getNumTrees() == 0)
+	{
+		cerr<< "Error: "<< argv[1] <<" contains no trees"<<endl;
+		return 1;
+	}
+	cout<< "Saving "<< argv[2] <<"..."<<endl;
+	if(isXMLName(argv[2]))
+		rfForest.saveRandomForest(argv[2]);
+	else if(!rfForest.saveRandomForestBinary(argv[2]))
+		return 1;
+
+	cout<< "Load times:"<<endl;
+	timeLoad(argv[1]);
+	timeLoad(argv[2]);
+	if(isModelFile(argv[2]))
+	{
+		CompiledForest cfForest;
+		double dStart = now();
+		if(cfForest.loadCompiledForest(argv[2]))
+			cout<< "  "<< argv[2] <<": compiled forest ("<< cfForest.numNodes() <<" split nodes, "
+				<< cfForest.numLeaves() <<" leaves) loaded in "<< now() - dStart <<"s"<<endl;
+	}
+	return 0;
+}
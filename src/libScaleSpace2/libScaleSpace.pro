@@ -17,11 +17,13 @@ INCLUDEPATH += . $(HOME)/code/include
 # Input
 HEADERS += scalespacedata.hh \
            scalespace.hh \
-           pyramidscalespace.hh
+           pyramidscalespace.hh \
+           scalespacecache.hh
 
 SOURCES += scalespacedata.cc \
            scalespace.cc \
-           pyramidscalespace.cc
+           pyramidscalespace.cc \
+           scalespacecache.cc
 
 
 # make install
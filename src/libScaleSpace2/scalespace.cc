@@ -65,6 +65,39 @@ ScaleSpace::ScaleSpace(const OpGrayImage& source, float sigma0,
 }
 
 
+ScaleSpace::ScaleSpace(ScaleSpaceCache& cache, float sigma0, 
+                       float scaleChange, int level) 
+  /*******************************************************************/
+  /* Take the levels from a shared scale space cache. This is only   */
+  /* possible if the scale change is 2^(1/L) for an integer number   */
+  /* L of levels per octave; otherwise, the levels are computed from */
+  /* the cache's source image. Either way, the levels are smoothed   */
+  /* with normalized kernels (opFastGauss), so their gray values are */
+  /* not scaled by the sigma-dependent gain of opGauss().            */
+  /*******************************************************************/
+{
+  data = new ScaleSpaceData(level);
+  data->sourceImage = cache.getSourceImage();
+
+  int levelsPerOctave = (int) floor(log(2.0)/log((double)scaleChange) + 0.5);
+  bool bUseCache = ( levelsPerOctave >= 1 &&
+                     fabs(pow(2.0, 1.0/levelsPerOctave) - scaleChange) < 1e-4 &&
+                     level/levelsPerOctave < cache.getMaxOctaves(1) );
+  for (int i = 0; i <= level; i++) {
+    float sigma = sigma0 * (float) pow((double)scaleChange, i);
+    if (bUseCache) {
+      data->scaledImage[i] = cache.getFullResLevel(sigma0, levelsPerOctave,
+                                                   i / levelsPerOctave,
+                                                   i % levelsPerOctave);
+    } else {
+      data->scaledImage[i] = OpGrayImage(data->sourceImage);
+      data->scaledImage[i] = data->scaledImage[i].opFastGauss(sigma);
+    }
+    data->scales[i] = sigma;
+  }
+}
+
+
 ScaleSpace::~ScaleSpace() {
   if (data != 0) {
     if (data->refcount > 1) {
@@ -27,6 +27,7 @@
 /****************/
 #include <opgrayimage.hh>
 #include "scalespacedata.hh"
+#include "scalespacecache.hh"
 
 
 /*************************/
@@ -43,6 +44,8 @@ public:
   ScaleSpace(const ScaleSpace& source);
   ScaleSpace(const OpGrayImage& source, float sigma0, 
              float scaleChange, int level);
+  ScaleSpace(ScaleSpaceCache& cache, float sigma0, 
+             float scaleChange, int level);
   ~ScaleSpace();
   
 public:
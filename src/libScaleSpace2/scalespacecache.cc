@@ -0,0 +1,275 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         scalespacecache.cc                                   */
+/*                                                                   */
+/* CONTENT      Lazily populated Gaussian scale space of one image,  */
+/*              shared by the scale space consumers (ScaleSpace,     */
+/*              DoGScaleSpace, GaussPyramid, EdgeSIFT) that process  */
+/*              the same frame.                                      */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+/****************/
+/*   Includes   */
+/****************/
+#include <math.h>
+#include <iostream>
+#include <algorithm>
+
+#include "scalespacecache.hh"
+
+using namespace std;
+
+/*===================================================================*/
+/*                       Class ScaleSpaceCache                       */
+/*===================================================================*/
+
+/***********************************************************/
+/*                       Constructors                      */
+/***********************************************************/
+
+ScaleSpaceCache::ScaleSpaceCache()
+{
+  m_nFilterPasses = 0;
+}
+
+
+ScaleSpaceCache::ScaleSpaceCache(const OpGrayImage& source)
+{
+  m_nFilterPasses = 0;
+  setImage(source);
+}
+
+
+/***********************************************************/
+/*                  Image and Cache Setup                  */
+/***********************************************************/
+
+void ScaleSpaceCache::setImage(const OpGrayImage& source)
+  /* start a new frame: all cached levels are discarded */
+{
+  clear();
+  m_imgSource = source;
+}
+
+
+void ScaleSpaceCache::clear()
+{
+  m_dStacks.clear();
+  m_nFilterPasses = 0;
+}
+
+
+bool ScaleSpaceCache::isCompatible(const OpGrayImage& img) const
+  /*******************************************************************/
+  /* Check whether img is the image the cache was built for. Callers */
+  /* that are handed a cache together with an image use this to      */
+  /* fall back to their own computation if the two don't match.      */
+  /*******************************************************************/
+{
+  if (img.width() != m_imgSource.width() ||
+      img.height() != m_imgSource.height()) {
+    return false;
+  }
+  ImageView<GrayPixel> v1 = img.view();
+  ImageView<GrayPixel> v2 = m_imgSource.view();
+  for (int y=0; y<img.height(); y++) {
+    const GrayPixel *p1 = v1.rowPtr(y);
+    const GrayPixel *p2 = v2.rowPtr(y);
+    for (int x=0; x<img.width(); x++) {
+      if (p1[x].value() != p2[x].value()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+/***********************************************************/
+/*                   Data Access Methods                   */
+/***********************************************************/
+
+int ScaleSpaceCache::getMaxOctaves(int minSize) const
+  /* number of octaves whose images are at least minSize pixels wide */
+{
+  int w = m_imgSource.width();
+  int h = m_imgSource.height();
+  int octaves = 0;
+  while (w >= minSize && h >= minSize && w > 0 && h > 0) {
+    octaves++;
+    w /= 2;
+    h /= 2;
+  }
+  return octaves;
+}
+
+
+float ScaleSpaceCache::getScale(float sigma0, int levelsPerOctave,
+                                int octave, int level) const
+  /* scale of the level in source image pixels */
+{
+  return sigma0 * (float) pow(2.0, octave + level/(double)levelsPerOctave);
+}
+
+
+const OpGrayImage& ScaleSpaceCache::getLevel(float sigma0,
+                                             int levelsPerOctave,
+                                             int octave, int level)
+  /*******************************************************************/
+  /* Return the given level at the resolution of its octave. Missing */
+  /* octaves and levels are computed on the fly: level 0 of octave 0 */
+  /* by smoothing the source image with sigma0, level 0 of the other */
+  /* octaves by subsampling level L of the previous octave, and each */
+  /* further level from the one below it with the incremental sigma  */
+  /* sqrt(s_l^2 - s_(l-1)^2). The smoothing uses opFastGauss(),      */
+  /* whose kernels are normalized; the recursive filter of opGauss() */
+  /* has a gain that depends on sigma and would add up over levels.  */
+  /*******************************************************************/
+{
+  if (levelsPerOctave < 1 || octave < 0 || level < 0 ||
+      level > levelsPerOctave+2 || octave >= getMaxOctaves(1)) {
+    cerr << "Error in ScaleSpaceCache::getLevel(): "
+         << "Level (" << octave << "," << level << ") out of range!"
+         << endl;
+    throw OutOfBoundaryException();
+  }
+
+  SSCStack &stack = getStack(sigma0, levelsPerOctave);
+
+  /* create the octave (and all octaves below it) */
+  while ((int)stack.octaves.size() <= octave) {
+    int o = (int)stack.octaves.size();
+    OpGrayImage base;
+    if (o == 0) {
+      OpGrayImage source(m_imgSource);
+      base = source.opFastGauss(sigma0);
+      m_nFilterPasses++;
+    } else {
+      base = subsample(getLevel(sigma0, levelsPerOctave, o-1,
+                                levelsPerOctave));
+    }
+    stack.octaves.push_back(SSCOctave());
+    stack.octaves.back().levels.push_back(base);
+  }
+
+  /* finish the octave up to the requested level */
+  SSCOctave &oct = stack.octaves[octave];
+  while ((int)oct.levels.size() <= level) {
+    int    l     = (int)oct.levels.size();
+    double dPrev = sigma0 * pow(2.0, (l-1)/(double)levelsPerOctave);
+    double dCurr = sigma0 * pow(2.0, l/(double)levelsPerOctave);
+    OpGrayImage prev(oct.levels[l-1]);
+    oct.levels.push_back(prev.opFastGauss(sqrt(dCurr*dCurr - dPrev*dPrev)));
+    m_nFilterPasses++;
+  }
+
+  return oct.levels[level];
+}
+
+
+const OpGrayImage& ScaleSpaceCache::getFullResLevel(float sigma0,
+                                                    int levelsPerOctave,
+                                                    int octave, int level)
+  /* return the given level, bilinearly upsampled to the source size */
+{
+  const OpGrayImage &img = getLevel(sigma0, levelsPerOctave, octave, level);
+  if (octave == 0) {
+    return img;
+  }
+
+  SSCOctave &oct = getStack(sigma0, levelsPerOctave).octaves[octave];
+  map<int,OpGrayImage>::iterator it = oct.fullRes.find(level);
+  if (it == oct.fullRes.end()) {
+    it = oct.fullRes.insert(make_pair(level, upsample(img, 1 << octave))).first;
+  }
+  return it->second;
+}
+
+
+/***********************************************************/
+/*                    Service Functions                    */
+/***********************************************************/
+
+ScaleSpaceCache::SSCStack& ScaleSpaceCache::getStack(float sigma0,
+                                                     int levelsPerOctave)
+{
+  for (unsigned i=0; i<m_dStacks.size(); i++) {
+    if (m_dStacks[i].sigma0 == sigma0 &&
+        m_dStacks[i].levelsPerOctave == levelsPerOctave) {
+      return m_dStacks[i];
+    }
+  }
+  SSCStack stack;
+  stack.sigma0          = sigma0;
+  stack.levelsPerOctave = levelsPerOctave;
+  m_dStacks.push_back(stack);
+  return m_dStacks.back();
+}
+
+
+OpGrayImage ScaleSpaceCache::subsample(const OpGrayImage& source) const
+  /* take every second pixel (as GaussPyramid::resampleDown20()) */
+{
+  int width  = source.width()/2;
+  int height = source.height()/2;
+  OpGrayImage result(width, height);
+  ImageView<GrayPixel> src = source.view();
+  for (int y=0; y<height; y++) {
+    const GrayPixel *pSrc = src.rowPtr(2*y);
+    GrayPixel       *pDst = result.rowPtr(y);
+    for (int x=0; x<width; x++) {
+      pDst[x] = pSrc[2*x];
+    }
+  }
+  return result;
+}
+
+
+OpGrayImage ScaleSpaceCache::upsample(const OpGrayImage& source,
+                                      int factor) const
+  /*******************************************************************/
+  /* Bilinearly interpolate source to the size of the source image.  */
+  /* Pixel (x,y) of the octave corresponds to pixel (x,y)*factor of  */
+  /* the full resolution image; pixels beyond the last octave row or */
+  /* column are clamped.                                             */
+  /*******************************************************************/
+{
+  int width  = m_imgSource.width();
+  int height = m_imgSource.height();
+  int sw     = source.width();
+  int sh     = source.height();
+  OpGrayImage result(width, height);
+  ImageView<GrayPixel> src = source.view();
+
+  /* (the horizontal weights are the same for all rows) */
+  vector<int>   vX0(width), vX1(width);
+  vector<float> vWx(width);
+  for (int x=0; x<width; x++) {
+    float fx = x/(float)factor;
+    vX0[x] = min((int)fx, sw-1);
+    vX1[x] = min(vX0[x]+1, sw-1);
+    vWx[x] = min(fx - vX0[x], 1.0f);
+  }
+
+  for (int y=0; y<height; y++) {
+    float fy = y/(float)factor;
+    int   y0 = min((int)fy, sh-1);
+    int   y1 = min(y0+1, sh-1);
+    float wy = min(fy - y0, 1.0f);
+    const GrayPixel *pRow0 = src.rowPtr(y0);
+    const GrayPixel *pRow1 = src.rowPtr(y1);
+    GrayPixel       *pDst  = result.rowPtr(y);
+    for (int x=0; x<width; x++) {
+      float v0 = ((1.0f-vWx[x])*pRow0[vX0[x]].value() +
+                  vWx[x]*pRow0[vX1[x]].value());
+      float v1 = ((1.0f-vWx[x])*pRow1[vX0[x]].value() +
+                  vWx[x]*pRow1[vX1[x]].value());
+      pDst[x] = (1.0f-wy)*v0 + wy*v1;
+    }
+  }
+  return result;
+}
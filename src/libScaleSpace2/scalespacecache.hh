@@ -0,0 +1,114 @@
+/*********************************************************************/
+/*                                                                   */
+/* FILE         scalespacecache.hh                                   */
+/*                                                                   */
+/* CONTENT      Lazily populated Gaussian scale space of one image,  */
+/*              shared by the scale space consumers (ScaleSpace,     */
+/*              DoGScaleSpace, GaussPyramid, EdgeSIFT) that process  */
+/*              the same frame. Each octave is computed from the     */
+/*              previous one by downsampling, and each level from    */
+/*              the level below it by an incremental Gaussian, so    */
+/*              the image smoothing is only done once per frame.     */
+/*                                                                   */
+/* BEGIN        Sat Oct 17 2026                                      */
+/* LAST CHANGE  Sat Oct 17 2026                                      */
+/*                                                                   */
+/*********************************************************************/
+
+#ifndef SCALESPACECACHE_HH
+#define SCALESPACECACHE_HH
+
+//#ifdef _USE_PERSONAL_NAMESPACES
+//namespace Leibe {
+//#endif
+
+/****************/
+/*   Includes   */
+/****************/
+#include <deque>
+#include <map>
+
+#include <opgrayimage.hh>
+
+
+/*************************/
+/*   Class Definitions   */
+/*************************/
+
+/*===================================================================*/
+/*                       Class ScaleSpaceCache                       */
+/*===================================================================*/
+/* A scale space is identified by its base scale sigma0 and the      */
+/* number of levels per octave (i.e. the scale step 2^(1/L)). Level  */
+/* l of octave o has the scale sigma0 * 2^(o + l/L) in source image  */
+/* pixels and is stored with 1/2^o of the source resolution. Levels  */
+/* 0..L+2 exist in every octave; level 0 of octave o+1 is level L of */
+/* octave o, subsampled by 2.                                        */
+/*                                                                   */
+/* All returned references stay valid until setImage() or clear()    */
+/* is called.                                                        */
+class ScaleSpaceCache {
+public:
+  ScaleSpaceCache();
+  ScaleSpaceCache(const OpGrayImage& source);
+
+public:
+  /*****************************/
+  /*   Image and Cache Setup   */
+  /*****************************/
+  void setImage(const OpGrayImage& source);
+  void clear();
+
+  const OpGrayImage& getSourceImage() const { return m_imgSource; }
+  bool  isCompatible(const OpGrayImage& img) const;
+
+public:
+  /***************************/
+  /*   Data Access Methods   */
+  /***************************/
+  int   getMaxOctaves(int minSize=MIN_OCTAVE_SIZE) const;
+  float getScale(float sigma0, int levelsPerOctave,
+                 int octave, int level) const;
+
+  const OpGrayImage& getLevel       (float sigma0, int levelsPerOctave,
+                                     int octave, int level);
+  const OpGrayImage& getFullResLevel(float sigma0, int levelsPerOctave,
+                                     int octave, int level);
+
+  int   getNumFilterPasses() const { return m_nFilterPasses; }
+
+  OpGrayImage upsample(const OpGrayImage& source, int factor) const;
+
+public:
+  static const int MIN_OCTAVE_SIZE = 8;
+
+  class OutOfBoundaryException {};
+
+protected:
+  /*************************/
+  /*   Service Functions   */
+  /*************************/
+  struct SSCOctave {
+    std::deque<OpGrayImage>   levels;
+    std::map<int,OpGrayImage> fullRes;  // upsampled levels, by index
+  };
+  struct SSCStack {
+    float                  sigma0;
+    int                    levelsPerOctave;
+    std::deque<SSCOctave>  octaves;
+  };
+
+  SSCStack&   getStack  (float sigma0, int levelsPerOctave);
+  OpGrayImage subsample (const OpGrayImage& source) const;
+
+protected:
+  OpGrayImage           m_imgSource;
+  std::deque<SSCStack>  m_dStacks;
+  int                   m_nFilterPasses;
+};
+
+//#ifdef _USE_PERSONAL_NAMESPACES
+//}
+//#endif
+
+#endif
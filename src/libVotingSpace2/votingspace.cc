@@ -37,9 +37,9 @@ HoughVote::HoughVote( float x,
                       int nImgPointId, int nClusterId, int nOccNumber, 
                       int nOccMapId, int nCueId )
 {
-  FeatureVector fvCoords( 1 );
-  fvCoords.setValue( 0, x );
-  createHoughVote( fvCoords, dValue, dConfidence, 
+  m_nDims      = 1;
+  m_vCoords[0] = x;
+  createHoughVote( dValue, dConfidence, 
                    nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
@@ -49,10 +49,10 @@ HoughVote::HoughVote( float x, float y,
                       int nImgPointId, int nClusterId, int nOccNumber, 
                       int nOccMapId, int nCueId )
 {
-  FeatureVector fvCoords( 2 );
-  fvCoords.setValue( 0, x );
-  fvCoords.setValue( 1, y );
-  createHoughVote( fvCoords, dValue, dConfidence, 
+  m_nDims      = 2;
+  m_vCoords[0] = x;
+  m_vCoords[1] = y;
+  createHoughVote( dValue, dConfidence, 
                    nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
@@ -62,11 +62,11 @@ HoughVote::HoughVote( float x, float y, float z,
                       int nImgPointId, int nClusterId, int nOccNumber,
                       int nOccMapId, int nCueId )
 {
-  FeatureVector fvCoords( 3 );
-  fvCoords.setValue( 0, x );
-  fvCoords.setValue( 1, y );
-  fvCoords.setValue( 2, z );
-  createHoughVote( fvCoords, dValue, dConfidence, 
+  m_nDims      = 3;
+  m_vCoords[0] = x;
+  m_vCoords[1] = y;
+  m_vCoords[2] = z;
+  createHoughVote( dValue, dConfidence, 
                    nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
@@ -76,47 +76,50 @@ HoughVote::HoughVote( float x, float y, float z, float s,
                       int nImgPointId, int nClusterId, int nOccNumber, 
                       int nOccMapId, int nCueId )
 {
-  FeatureVector fvCoords( 4 );
-  fvCoords.setValue( 0, x );
-  fvCoords.setValue( 1, y );
-  fvCoords.setValue( 2, z );
-  fvCoords.setValue( 3, s );
-  createHoughVote( fvCoords, dValue, dConfidence, 
+  m_nDims      = 4;
+  m_vCoords[0] = x;
+  m_vCoords[1] = y;
+  m_vCoords[2] = z;
+  m_vCoords[3] = s;
+  createHoughVote( dValue, dConfidence, 
                    nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
 
-HoughVote::HoughVote( FeatureVector fvCoords, 
+HoughVote::HoughVote( const FeatureVector &fvCoords, 
                       float dValue, float dConfidence, 
                       int nImgPointId, int nClusterId, int nOccNumber,
                       int nOccMapId, int nCueId )
 {
-  createHoughVote( fvCoords, dValue, dConfidence, 
+  setCoords( fvCoords );
+  createHoughVote( dValue, dConfidence, 
                    nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
 
-HoughVote::HoughVote( const HoughVote &other )
-  /* copy constructor */
+HoughVote::HoughVote( const float *pCoords, int nDims,
+                      float dValue, float dConfidence, 
+                      int nImgPointId, int nClusterId, int nOccNumber,
+                      int nOccMapId, int nCueId )
 {
-  copyFromOther( other );
-} 
+  assert( nDims <= HOUGH_MAX_DIMS );
 
-
-HoughVote& HoughVote::operator=( const HoughVote &other )
-  /* assignment operator */
-{
-  copyFromOther( other );
-  return *this;
+  m_nDims = nDims;
+  for( int k=0; k<nDims; k++ )
+    m_vCoords[k] = pCoords[k];
+  createHoughVote( dValue, dConfidence, 
+                   nImgPointId, nClusterId, nOccNumber, nOccMapId, nCueId );
 }
 
 
-void HoughVote::createHoughVote( FeatureVector fvCoords, 
-                                 float dValue, float dConfidence, 
+void HoughVote::createHoughVote( float dValue, float dConfidence, 
                                  int nImgPointId, int nClusterId, 
                                  int nOccNumber, int nOccMapId, int nCueId )
 {
-  m_fvCoords    = fvCoords;
+  /* clear the unused coordinate entries */
+  for( int k=m_nDims; k<HOUGH_MAX_DIMS; k++ )
+    m_vCoords[k] = 0.0;
+
   m_dValue      = dValue;
   m_dConfidence = dConfidence;
   m_nImgPointId = nImgPointId;
@@ -127,16 +130,27 @@ void HoughVote::createHoughVote( FeatureVector fvCoords,
 }
 
 
-void HoughVote::copyFromOther( const HoughVote &other )
+/***********************************************************/
+/*                 Data Access Operators                   */
+/***********************************************************/
+
+FeatureVector HoughVote::getCoords() const
+  /* return the coordinates as a FeatureVector (allocates!) */
+{
+  FeatureVector fvCoords( m_nDims );
+  for( int k=0; k<m_nDims; k++ )
+    fvCoords.setValue( k, m_vCoords[k] );
+  return fvCoords;
+}
+
+
+void HoughVote::setCoords( const FeatureVector &fvCoords )
 {
-  m_fvCoords    = other.m_fvCoords;
-  m_dValue      = other.m_dValue;
-  m_dConfidence = other.m_dConfidence;
-  m_nImgPointId = other.m_nImgPointId;
-  m_nClusterId  = other.m_nClusterId;
-  m_nOccNumber  = other.m_nOccNumber;
-  m_nOccMapId   = other.m_nOccMapId;
-  m_nCueId      = other.m_nCueId;
+  assert( fvCoords.numDims() <= HOUGH_MAX_DIMS );
+
+  m_nDims = fvCoords.numDims();
+  for( int k=0; k<HOUGH_MAX_DIMS; k++ )
+    m_vCoords[k] = ( k<m_nDims ? fvCoords.at(k) : 0.0 );
 }
 
 
@@ -150,6 +164,7 @@ void HoughVote::copyFromOther( const HoughVote &other )
 VotingSpace::VotingSpace()
   /* standard constructor */
 {
+  m_nStorageMode = STORAGE_DENSE;
   clear();
   m_nDims = 0;
   m_bSizeDefined = false;
@@ -158,9 +173,11 @@ VotingSpace::VotingSpace()
 }
 
 
-VotingSpace::VotingSpace( int nBins, float min, float max )
+VotingSpace::VotingSpace( int nBins, float min, float max, 
+                          int nStorageMode )
   /* alternate constructor for 1D voting space */
 {
+  m_nStorageMode = nStorageMode;
   clear();
   m_nDims = 1;
   m_bSizeDefined = true;
@@ -179,9 +196,11 @@ VotingSpace::VotingSpace( int nBins, float min, float max )
 
 
 VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
-                          int nBins_y, float min_y, float max_y )
+                          int nBins_y, float min_y, float max_y,
+                          int nStorageMode )
   /* alternate constructor for 2D voting space */
 {
+  m_nStorageMode = nStorageMode;
   clear();
   m_nDims = 2;
   m_bSizeDefined = true;
@@ -202,9 +221,11 @@ VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
 
 VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
                           int nBins_y, float min_y, float max_y,
-                          int nBins_z, float min_z, float max_z )
+                          int nBins_z, float min_z, float max_z,
+                          int nStorageMode )
   /* alternate constructor for 3D voting space */
 {
+  m_nStorageMode = nStorageMode;
   clear();
   m_nDims = 3;
   m_bSizeDefined = true;
@@ -227,9 +248,11 @@ VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
 VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
                           int nBins_y, float min_y, float max_y,
                           int nBins_z, float min_z, float max_z,
-                          int nBins_s, float min_s, float max_s )
+                          int nBins_s, float min_s, float max_s,
+                          int nStorageMode )
   /* alternate constructor for 4D voting space */
 {
+  m_nStorageMode = nStorageMode;
   clear();
   m_nDims = 4;
   m_bSizeDefined = true;
@@ -251,13 +274,15 @@ VotingSpace::VotingSpace( int nBins_x, float min_x, float max_x,
 
 
 VotingSpace::VotingSpace( int nDims, vector<int> vNumBins, 
-                          vector<float> vMinValues, vector<float> vMaxValues )
+                          vector<float> vMinValues, vector<float> vMaxValues,
+                          int nStorageMode )
   /* alternate constructor for voting spaces of arbitrary dimension */
 {
   assert( (int)vNumBins.size()   == nDims );
   assert( (int)vMinValues.size() == nDims );
   assert( (int)vMaxValues.size() == nDims );
 
+  m_nStorageMode = nStorageMode;
   clear();
   m_nDims        = nDims;
   m_bSizeDefined = true;
@@ -324,6 +349,30 @@ void VotingSpace::copyFromOther( const VotingSpace &other )
   m_vBinScores   = other.m_vBinScores;
   m_vBinMeans    = other.m_vBinMeans;
 
+  m_nStorageMode     = other.m_nStorageMode;
+  m_vHashBins        = other.m_vHashBins;
+  m_vHashSlots       = other.m_vHashSlots;
+  m_vSlotBins        = other.m_vSlotBins;
+  m_vSlotScores      = other.m_vSlotScores;
+  m_vSlotMeans       = other.m_vSlotMeans;
+  m_vSlotNumVotes    = other.m_vSlotNumVotes;
+  m_vVoteCoords      = other.m_vVoteCoords;
+  m_vVoteValues      = other.m_vVoteValues;
+  m_vVoteConfs       = other.m_vVoteConfs;
+  m_vVoteImgPointIds = other.m_vVoteImgPointIds;
+  m_vVoteClusterIds  = other.m_vVoteClusterIds;
+  m_vVoteOccNumbers  = other.m_vVoteOccNumbers;
+  m_vVoteOccMapIds   = other.m_vVoteOccMapIds;
+  m_vVoteCueIds      = other.m_vVoteCueIds;
+  m_vVoteSlots       = other.m_vVoteSlots;
+  m_bSlotIdxValid    = other.m_bSlotIdxValid;
+  m_vSlotOffsets     = other.m_vSlotOffsets;
+  m_vSlotVotes       = other.m_vSlotVotes;
+
+  m_bIntegralValid   = other.m_bIntegralValid;
+  m_vIntegral        = other.m_vIntegral;
+  m_vIntegralStrides = other.m_vIntegralStrides;
+
   m_bAllDimensionsDefined = other.m_bAllDimensionsDefined;
 }
 
@@ -350,6 +399,9 @@ void VotingSpace::clear()
   m_vlVotes.clear();
   m_vBinScores.clear();
   m_vBinMeans.clear();
+
+  initSparseStorage();
+  clearIntegralTable();
 }
 
 
@@ -365,6 +417,8 @@ void  VotingSpace::print()
 
   else {
     cout << "    #Dimensions: " << m_nDims << endl;
+    cout << "    Storage    : " 
+         << (m_nStorageMode==STORAGE_SPARSE ? "sparse" : "dense") << endl;
     
     /* print information about every dimension */
     for( int i=0; i<m_nDims; i++ )
@@ -397,17 +451,22 @@ void  VotingSpace::printContent()
     return;
   }
 
+  FeatureVector fvDummy;
+  int   nNumVotes;
+  float dScore;
   if( m_nDims == 1 )
-    for( int x=0; x<m_vNumBins[0]; x++ )
+    for( int x=0; x<m_vNumBins[0]; x++ ) {
+      getBinContent( idx(x), fvDummy, nNumVotes, dScore );
       cout << "    Bin " << setw(2) << x << ": " << setw(4) 
-           << m_vBinScores[idx(x)] << "(" << m_vlVotes[idx(x)].size() 
-           << ")" << endl;
+           << dScore << "(" << nNumVotes << ")" << endl;
+    }
   else
     for( int y=0; y<m_vNumBins[1]; y++ ) {
       cout << "    Row " << setw(2) << y << ": ";
-      for( int x=0; x<m_vNumBins[0]; x++ )
-        cout << setw(4) << m_vBinScores[idx(x,y)] 
-             << "(" << m_vlVotes[idx(x,y)].size() << ")"<< "  ";
+      for( int x=0; x<m_vNumBins[0]; x++ ) {
+        getBinContent( idx(x,y), fvDummy, nNumVotes, dScore );
+        cout << setw(4) << dScore << "(" << nNumVotes << ")"<< "  ";
+      }
       cout << endl;
     }
   
@@ -450,6 +509,15 @@ void VotingSpace::initBins()
   for( int i=0; i<(int)m_vlVotes.size(); i++ )
     m_vlVotes[i].clear();
   m_vlVotes.clear();
+  m_vBinScores.clear();
+  m_vBinMeans.clear();
+  initSparseStorage();
+  clearIntegralTable();
+
+  /* the sparse storage doesn't need any per-bin memory */
+  if( m_nStorageMode == STORAGE_SPARSE )
+    return;
+
   vector< list<HoughVote> > vlTemp( nTotalBins );
   m_vlVotes = vlTemp;
   //for( int i=0; i<nTotalBins; i++ )
@@ -467,6 +535,40 @@ void VotingSpace::initBins()
 }
 
 
+void VotingSpace::initSparseStorage()
+  /*******************************************************************/
+  /* Reset the sparse vote storage. The hash table of occupied bins  */
+  /* starts out small and grows with the number of occupied bins, so */
+  /* that the memory requirements only depend on the number of votes */
+  /* and not on the voting space resolution.                         */
+  /*******************************************************************/
+{
+  const int INIT_HASH_SIZE = 1024;
+
+  m_vHashBins.assign( INIT_HASH_SIZE, -1 );
+  m_vHashSlots.assign( INIT_HASH_SIZE, -1 );
+
+  m_vSlotBins.clear();
+  m_vSlotScores.clear();
+  m_vSlotMeans.clear();
+  m_vSlotNumVotes.clear();
+
+  m_vVoteCoords.clear();
+  m_vVoteValues.clear();
+  m_vVoteConfs.clear();
+  m_vVoteImgPointIds.clear();
+  m_vVoteClusterIds.clear();
+  m_vVoteOccNumbers.clear();
+  m_vVoteOccMapIds.clear();
+  m_vVoteCueIds.clear();
+  m_vVoteSlots.clear();
+
+  m_bSlotIdxValid = true;
+  m_vSlotOffsets.assign( 1, 0 );
+  m_vSlotVotes.clear();
+}
+
+
 int VotingSpace::calcTotalNumBins()
   /*******************************************************************/
   /* Return the total number of bins in this voting space. Since     */
@@ -559,6 +661,47 @@ void  VotingSpace::setDimension( int dim, int nBins, float min, float max )
 }
 
 
+void  VotingSpace::setStorageMode( int nMode )
+  /*******************************************************************/
+  /* Select how the votes are stored. Allowed values are:            */
+  /*   STORAGE_DENSE : a vote list for every bin (default)           */
+  /*   STORAGE_SPARSE: one flat vote buffer plus a hash table of the */
+  /*                   occupied bins. Memory and time then scale     */
+  /*                   with the number of votes instead of the num-  */
+  /*                   ber of bins.                                  */
+  /* All data will be erased when this function is called!           */
+  /*******************************************************************/
+{
+  switch( nMode ) {
+  case STORAGE_DENSE:
+  case STORAGE_SPARSE:
+    m_nStorageMode = nMode;
+    if( isValid() )
+      initBins();
+    break;
+
+  default:
+    cerr << "Error in VotingSpace::setStorageMode(): "
+         << "Unknown storage mode (" << nMode << ")!" << endl;
+  }
+}
+
+
+int   VotingSpace::numVotes()
+  /*******************************************************************/
+  /* Return the total number of votes stored in the voting space.    */
+  /*******************************************************************/
+{
+  if( m_nStorageMode == STORAGE_SPARSE )
+    return (int)m_vVoteValues.size();
+
+  int nNumVotes = 0;
+  for( int i=0; i<(int)m_vlVotes.size(); i++ )
+    nNumVotes += (int)m_vlVotes[i].size();
+  return nNumVotes;
+}
+
+
 /***********************************************************/
 /*                  VotingSpace Creation                   */
 /***********************************************************/
@@ -571,39 +714,71 @@ void VotingSpace::insertVote( const HoughVote &vote )
   /*******************************************************************/
 {
   assert( isValid() );
-  assert( m_nDims == vote.getCoords().numDims() );
-
-  FeatureVector fvCoords( vote.getCoords() );
+  assert( m_nDims == vote.numDims() );
 
-  /* reserve space for the bin indizes */
-  vector<int> binidx( m_nDims );
+  const float *pCoords = vote.coords();
 
-  /* calculate the bin index */
-  bool bBorder = false;
+  /* calculate the bin index (directly as a cell index) */
+  bool bBorder     = false;
+  int  nIdx        = 0;
+  int  nMultFactor = 1;
   for ( int dim = 0; dim < m_nDims; dim++ ) {
-    float value = fvCoords.at(dim);
+    float value = pCoords[dim];
+    int   binidx;
 
     if ( value <= m_vMinValues[dim] ) {
-      binidx[dim] = 0;
+      binidx = 0;
       bBorder = true;
     } else if ( value >= m_vMaxValues[dim] ) {
-      binidx[dim] = m_vNumBins[dim] - 1;
+      binidx = m_vNumBins[dim] - 1;
       bBorder = true;
     } else
-      binidx[dim] = (int) floor( ((value - m_vMinValues[dim]) / m_vRes[dim]) );
+      binidx = (int) floor( ((value - m_vMinValues[dim]) / m_vRes[dim]) );
     
     /* compensate for round-off errors */
-    if( binidx[dim] == m_vNumBins[dim] )
-      binidx[dim] = m_vNumBins[dim] - 1;
+    if( binidx == m_vNumBins[dim] )
+      binidx = m_vNumBins[dim] - 1;
+
+    nIdx        += binidx*nMultFactor;
+    nMultFactor *= m_vNumBins[dim];
   }
   
   /* update the voting space */
-  int nIdx = idx(binidx);
+  m_bIntegralValid = false;
+
+  if( m_nStorageMode == STORAGE_SPARSE ) {
+    int nSlot = getSlot( nIdx );
+
+    /* append the vote to the flat vote buffer */
+    for( int dim = 0; dim < m_nDims; dim++ )
+      m_vVoteCoords.push_back( pCoords[dim] );
+    m_vVoteValues.push_back     ( vote.getValue() );
+    m_vVoteConfs.push_back      ( vote.getConfidence() );
+    m_vVoteImgPointIds.push_back( vote.getImgPointId() );
+    m_vVoteClusterIds.push_back ( vote.getClusterId() );
+    m_vVoteOccNumbers.push_back ( vote.getOccNumber() );
+    m_vVoteOccMapIds.push_back  ( vote.getOccMapId() );
+    m_vVoteCueIds.push_back     ( vote.getCueId() );
+    m_vVoteSlots.push_back      ( nSlot );
+    m_vSlotNumVotes[nSlot]++;
+    m_bSlotIdxValid = false;
+
+    if( !bBorder ) {
+      float dValue = vote.getValue();
+      m_vSlotScores[nSlot] += dValue;
+      for( int dim = 0; dim < m_nDims; dim++ )
+        m_vSlotMeans[nSlot*m_nDims + dim] += pCoords[dim]*dValue;
+    }
+    return;
+  }
 
   m_vlVotes[nIdx].push_back( vote );
   if( !bBorder ) {
-    m_vBinScores[nIdx] += vote.getValue();
-    m_vBinMeans[nIdx]  += fvCoords*vote.getValue();
+    float dValue = vote.getValue();
+    m_vBinScores[nIdx] += dValue;
+    FeatureVector &fvMean = m_vBinMeans[nIdx];
+    for( int dim = 0; dim < m_nDims; dim++ )
+      fvMean.at(dim) += pCoords[dim]*dValue;
     //FeatureVector fvContrib = fvCoords;
     //fvContrib.multFactor( vote.getValue() );
     //m_vBinMeans[nIdx] += fvContrib;
@@ -611,6 +786,116 @@ void VotingSpace::insertVote( const HoughVote &vote )
 }
 
 
+void VotingSpace::finishVoting()
+  /*******************************************************************/
+  /* Build the internal index structures that the query functions    */
+  /* would otherwise create on demand. After this call (and until    */
+  /* the next insertVote()), the voting space is only read by the    */
+  /* reentrant query functions (applyMSME() with an explicit window  */
+  /* size), so they may be called from several threads at once.      */
+  /*******************************************************************/
+{
+  if( m_nStorageMode == STORAGE_SPARSE )
+    buildSlotIndex();
+}
+
+
+void VotingSpace::buildIntegralTable()
+  /*******************************************************************/
+  /* Build a summed-area (2D) / summed-volume (nD) table of the bin  */
+  /* scores. As long as no new votes are inserted, the score sum of  */
+  /* any box of bins can then be computed with 2^d table lookups     */
+  /* (see getBoxScore()), which is used by getFastKernelVoteSum()    */
+  /* and by getVoteSum() for hypercube kernels.                      */
+  /*******************************************************************/
+{
+  assert( isValid() );
+
+  /* the table has one additional (zero) entry per dimension */
+  m_vIntegralStrides.resize( m_nDims );
+  int nTableSize = 1;
+  for( int i=0; i<m_nDims; i++ ) {
+    m_vIntegralStrides[i] = nTableSize;
+    nTableSize *= m_vNumBins[i] + 1;
+  }
+  m_vIntegral.assign( nTableSize, 0.0 );
+
+  /* enter the bin scores */
+  int nNumBins = ( m_nStorageMode==STORAGE_SPARSE ? 
+                   (int)m_vSlotBins.size() : calcTotalNumBins() );
+  for( int i=0; i<nNumBins; i++ ) {
+    int   nIdx   = ( m_nStorageMode==STORAGE_SPARSE ? m_vSlotBins[i] : i );
+    float dScore = ( m_nStorageMode==STORAGE_SPARSE ? m_vSlotScores[i] :
+                     m_vBinScores[i] );
+    if( dScore == 0.0 )
+      continue;
+
+    int nTableIdx = 0;
+    for( int k=0; k<m_nDims; k++ ) {
+      nTableIdx += (nIdx % m_vNumBins[k] + 1)*m_vIntegralStrides[k];
+      nIdx      /= m_vNumBins[k];
+    }
+    m_vIntegral[nTableIdx] = dScore;
+  }
+
+  /* compute the prefix sums along every dimension */
+  for( int k=0; k<m_nDims; k++ ) {
+    int nStride = m_vIntegralStrides[k];
+    int nSize   = m_vNumBins[k] + 1;
+    for( int i=0; i<nTableSize; i++ )
+      if( (i/nStride) % nSize > 0 )
+        m_vIntegral[i] += m_vIntegral[i-nStride];
+  }
+
+  m_bIntegralValid = true;
+}
+
+
+void VotingSpace::clearIntegralTable()
+  /* release the summed-volume table */
+{
+  m_bIntegralValid = false;
+  m_vIntegral.clear();
+  m_vIntegralStrides.clear();
+}
+
+
+float VotingSpace::getBoxScore( const vector<int> &vMin, 
+                                const vector<int> &vMax )
+  /*******************************************************************/
+  /* Get the sum of the bin scores in the box [vMin,vMax] (inclusive */
+  /* bin indices) from the summed-volume table by inclusion-exclu-   */
+  /* sion over the 2^d box corners. Empty boxes have score zero.     */
+  /*******************************************************************/
+{
+  assert( m_bIntegralValid );
+
+  for( int k=0; k<m_nDims; k++ )
+    if( vMax[k] < vMin[k] )
+      return 0.0;
+
+  double dSum = 0.0;
+  for( int c=0; c<(1<<m_nDims); c++ ) {
+    int  nTableIdx = 0;
+    bool bNegative = false;
+    for( int k=0; k<m_nDims; k++ )
+      if( c & (1<<k) )
+        nTableIdx += (vMax[k]+1)*m_vIntegralStrides[k];
+      else {
+        nTableIdx += vMin[k]*m_vIntegralStrides[k];
+        bNegative  = !bNegative;
+      }
+
+    if( bNegative )
+      dSum -= m_vIntegral[nTableIdx];
+    else
+      dSum += m_vIntegral[nTableIdx];
+  }
+
+  return (float)dSum;
+}
+
+
 int   VotingSpace::getBinNumber( int dim, double value )
   /*******************************************************************/
   /* Return the number of the bin along dimension dim in which this  */
@@ -732,7 +1017,7 @@ float VotingSpace::getBinVoteSum ( int idx_x )
 {
   assert( m_nDims == 1 );
 
-  return m_vBinScores[idx(idx_x)];
+  return getBinScore( idx(idx_x) );
 }
 
 
@@ -743,7 +1028,7 @@ float VotingSpace::getBinVoteSum ( int idx_x, int idx_y )
 {
   assert( m_nDims == 2 );
 
-  return m_vBinScores[idx(idx_x,idx_y)];
+  return getBinScore( idx(idx_x,idx_y) );
 }
 
 
@@ -754,7 +1039,7 @@ float VotingSpace::getBinVoteSum ( int idx_x, int idx_y, int idx_z )
 {
   assert( m_nDims == 3 );
 
-  return m_vBinScores[idx(idx_x,idx_y,idx_z)];
+  return getBinScore( idx(idx_x,idx_y,idx_z) );
 }
 
 
@@ -765,7 +1050,7 @@ float VotingSpace::getBinVoteSum ( int idx_x, int idx_y, int idx_z, int idx_s )
 {
   assert( m_nDims == 4 );
 
-  return m_vBinScores[idx(idx_x,idx_y,idx_z,idx_s)];
+  return getBinScore( idx(idx_x,idx_y,idx_z,idx_s) );
 }
 
 
@@ -776,7 +1061,7 @@ float VotingSpace::getBinVoteSum ( vector<int> vBinIdx )
 {
   assert( m_nDims == (int)vBinIdx.size() );
 
-  return m_vBinScores[idx(vBinIdx)];
+  return getBinScore( idx(vBinIdx) );
 }
 
 
@@ -891,6 +1176,28 @@ float VotingSpace::getVoteSum    ( const FeatureVector &fvCoords )
     vMax[i] = min(m_vNumBins[i]-1,vBinIdx[i]+nRange);
   }
 
+  /* For a hypercube kernel, the bins that lie completely inside the */
+  /* window can be taken from the summed-volume table. The outermost */
+  /* bins of the voting space are excluded, since they may contain   */
+  /* border votes that are not part of the bin scores. A safety mar- */
+  /* gin protects against round-off errors at the bin boundaries.    */
+  const float BIN_EPS = 0.001;
+  vector<int> vInMin( m_nDims );
+  vector<int> vInMax( m_nDims );
+  bool bUseTable = ( m_bIntegralValid && m_nKernelType==KERNEL_HCUBE );
+  for( int i=0; i<m_nDims && bUseTable; i++ ) {
+    float dLo = (fvCoords.at(i) - m_fvWindowSize.at(i) - m_vMinValues[i]) /
+      m_vRes[i];
+    float dHi = (fvCoords.at(i) + m_fvWindowSize.at(i) - m_vMinValues[i]) /
+      m_vRes[i];
+    vInMin[i] = max( 1, (int)ceil( dLo + BIN_EPS ) );
+    vInMax[i] = min( m_vNumBins[i]-2, (int)floor( dHi - BIN_EPS ) - 1 );
+    if( vInMax[i] < vInMin[i] )
+      bUseTable = false;
+  }
+  if( bUseTable )
+    dScore += getBoxScore( vInMin, vInMax );
+
   /* initialize the running index */
   vector<int> vNewIdx( m_nDims );
   for( int i=0; i<m_nDims; i++ )
@@ -898,7 +1205,11 @@ float VotingSpace::getVoteSum    ( const FeatureVector &fvCoords )
   
   /* add the scores for all adjacent bins */
   while( true ){
-    dScore += getVoteSumInWindow( vNewIdx, fvCoords );
+    bool bInside = bUseTable;
+    for( int i=0; i<m_nDims && bInside; i++ )
+      bInside = ( vNewIdx[i]>=vInMin[i] && vNewIdx[i]<=vInMax[i] );
+    if( !bInside )
+      dScore += getVoteSumInWindow( vNewIdx, fvCoords );
     
     /* increment the index */
     bool bStop = false;
@@ -993,6 +1304,19 @@ void VotingSpace::getMeanVote( const FeatureVector &fvCoords,
   /* position.                                                       */
   /* Version for a voting space of arbitrary dimension.              */
   /*******************************************************************/
+{
+  getMeanVote( fvCoords, m_fvWindowSize, fvMean, nNumVotes, dSumScore );
+}
+
+
+void VotingSpace::getMeanVote( const FeatureVector &fvCoords,
+                               const FeatureVector &fvWindowSize,
+                               FeatureVector &fvMean, int &nNumVotes, 
+                               float &dSumScore )
+  /*******************************************************************/
+  /* Version with an explicit window size (does not change the vot-  */
+  /* ing space).                                                     */
+  /*******************************************************************/
 {
   /* reserve space for the bin indizes */
   vector<int> vBinIdx( m_nDims );
@@ -1012,7 +1336,7 @@ void VotingSpace::getMeanVote( const FeatureVector &fvCoords,
   vector<int> vMin( m_nDims );
   vector<int> vMax( m_nDims );
   for( int i=0; i<m_nDims; i++ ) {
-    int nRange = (int) ceil(m_fvWindowSize.at(i) / m_vRes[i] );
+    int nRange = (int) ceil(fvWindowSize.at(i) / m_vRes[i] );
     vMin[i] = max(0,vBinIdx[i]-nRange);
     vMax[i] = min(m_vNumBins[i]-1,vBinIdx[i]+nRange);
   }
@@ -1028,7 +1352,7 @@ void VotingSpace::getMeanVote( const FeatureVector &fvCoords,
     FeatureVector fvBinMean;
     int   nBinNumVotes;
     float dBinSumScore;
-    getMeanVoteInWindow( vNewIdx, fvCoords, 
+    getMeanVoteInWindow( vNewIdx, fvCoords, fvWindowSize,
                          fvBinMean, nBinNumVotes, dBinSumScore );
 
     /* update the global mean using the new information */
@@ -1147,11 +1471,29 @@ void VotingSpace::getFastKernelVoteSum( int x, int y, int z,
   /*============================================*/
   /* Accumulate the fast approximate kernel sum */
   /*============================================*/
+  if( m_bIntegralValid ) {
+    /* The intersection weight below is computed from the geometry   */
+    /* of the center bin (x,y,z) and is thus the same for all bins,  */
+    /* so the sum reduces to a box sum over [vMin,vMax).             */
+    float dx = min( m_vMinValues[0] + m_vRes[0]*(x+1), maxx2 ) - 
+      max( m_vMinValues[0] + m_vRes[0]*x, minx2 );
+    float dy = min( m_vMinValues[1] + m_vRes[1]*(y+1), maxy2 ) - 
+      max( m_vMinValues[1] + m_vRes[1]*y, miny2 );
+    float dz = min( m_vMinValues[2] + m_vRes[2]*(z+1), maxz2 ) - 
+      max( m_vMinValues[2] + m_vRes[2]*z, minz2 );
+    if( (dx>0.0) && (dy>0.0) && (dz>0.0) ) {
+      for( int i=0; i<m_nDims; i++ )
+        vMax[i]--;
+      dSumScore = getBoxScore( vMin, vMax )*(dx*dy*dz)/dBinVol;
+    }
+    return;
+  }
+
   for(int zz=vMin[2]; zz<vMax[2]; zz++ )
     for(int yy=vMin[1]; yy<vMax[1]; yy++ )
       for(int xx=vMin[0]; xx<vMax[0]; xx++ ) {
         int   nNewIdx = idx(xx,yy,zz);
-        float dBinSumScore = m_vBinScores[nNewIdx];
+        float dBinSumScore = getBinScore( nNewIdx );
   
         /*------------------------------------*/
         /* Compute the volume of intersection */
@@ -1230,6 +1572,12 @@ void VotingSpace::getFastKernelVoteSum( const vector<int> &vBinIdx,
     vMax[i] = min(m_vNumBins[i]-1,vBinIdx[i]+nRange);
   }
 
+  /* use the summed-volume table if available */
+  if( m_bIntegralValid ) {
+    dSumScore = getBoxScore( vMin, vMax );
+    return;
+  }
+
   /* initialize the running index */
   vector<int> vNewIdx( m_nDims );
   for( int i=0; i<m_nDims; i++ )
@@ -1239,7 +1587,7 @@ void VotingSpace::getFastKernelVoteSum( const vector<int> &vBinIdx,
   while( true ){
     /* get sum and mean of votes in next bin */
     int   nNewIdx = idx(vNewIdx);
-    float dBinSumScore = m_vBinScores[nNewIdx];
+    float dBinSumScore = getBinScore( nNewIdx );
 
     dSumScore += dBinSumScore;
 
@@ -1291,6 +1639,19 @@ void VotingSpace::getFastMeanVote( const vector<int> &vBinIdx,
   /* (fast approximate computation using a binned accumulator array).*/
   /* Version for a voting space of arbitrary dimension.              */
   /*******************************************************************/
+{
+  getFastMeanVote( vBinIdx, m_fvWindowSize, fvMean, nNumVotes, dSumScore );
+}
+
+
+void VotingSpace::getFastMeanVote( const vector<int> &vBinIdx,
+                                   const FeatureVector &fvWindowSize,
+                                   FeatureVector &fvMean, int &nNumVotes,
+                                   float &dSumScore )
+  /*******************************************************************/
+  /* Version with an explicit window size (does not change the vot-  */
+  /* ing space).                                                     */
+  /*******************************************************************/
 {
   /* initialize the variables */
   FeatureVector tmp( m_nDims );
@@ -1303,7 +1664,7 @@ void VotingSpace::getFastMeanVote( const vector<int> &vBinIdx,
   vector<int> vMin( m_nDims );
   vector<int> vMax( m_nDims );
   for( int i=0; i<m_nDims; i++ ) {
-    int nRange = (int) ceil(m_fvWindowSize.at(i) / m_vRes[i] );
+    int nRange = (int) ceil(fvWindowSize.at(i) / m_vRes[i] );
     vMin[i] = max(0,vBinIdx[i]-nRange);
     vMax[i] = min(m_vNumBins[i]-1,vBinIdx[i]+nRange);
   }
@@ -1316,10 +1677,10 @@ void VotingSpace::getFastMeanVote( const vector<int> &vBinIdx,
   /* add the scores for all adjacent bins */
   while( true ){
     /* get sum and mean of votes in next bin */
-    int nNewIdx = idx(vNewIdx);
-    FeatureVector fvBinMean    = m_vBinMeans[nNewIdx];
-    int           nBinNumVotes = (int)m_vlVotes[nNewIdx].size();
-    float         dBinSumScore = m_vBinScores[nNewIdx];
+    FeatureVector fvBinMean;
+    int           nBinNumVotes;
+    float         dBinSumScore;
+    getBinContent( idx(vNewIdx), fvBinMean, nBinNumVotes, dBinSumScore );
 
     /* update the global mean using the new information */
     if( nBinNumVotes > 0 ) {
@@ -1548,12 +1909,43 @@ void VotingSpace::applyMSME( const FeatureVector &fvCoords,
   /* Version for a voting space of arbitrary dimension.              */
   /*******************************************************************/
 {
+  vector<FeatureVector> vNoModes;
+  int nModeIdx;
+  applyMSME( fvCoords, m_fvWindowSize, fvResult, dScore, 
+             bAdaptiveScale, dAdaptMinScale, bUseFastMSME,
+             vNoModes, 0.0, nModeIdx );
+}
+
+
+void VotingSpace::applyMSME( const FeatureVector &fvCoords, 
+                             const FeatureVector &fvWindowSize,
+                             FeatureVector &fvResult, float &dScore,
+                             bool bAdaptiveScale, float dAdaptMinScale,
+                             bool bUseFastMSME,
+                             const vector<FeatureVector> &vModes, 
+                             float dBasinSize, int &nModeIdx )
+  /*******************************************************************/
+  /* Reentrant version of the MSME search with an explicit window    */
+  /* size. The voting space is not changed, so several searches can  */
+  /* run in parallel (after finishVoting() has been called).         */
+  /*                                                                 */
+  /* If dBasinSize > 0, the search is stopped as soon as the current */
+  /* position comes within dBasinSize times the (adapted) window     */
+  /* size of one of the already converged modes in vModes. The index */
+  /* of that mode is returned in nModeIdx and the mode position in   */
+  /* fvResult; dScore then still holds the score of the last step,   */
+  /* so the caller should use the stored score of the mode instead.  */
+  /* Otherwise, nModeIdx is set to -1.                               */
+  /*******************************************************************/
+{
+  nModeIdx = -1;
+
   float dLastScore = 0.0;
   FeatureVector fvCurPos = fvCoords;
   FeatureVector fvNewMean( fvCurPos.numDims() );
 
-  /* save the original window size */
-  FeatureVector fvWindowSize = m_fvWindowSize;
+  /* the (possibly scale-adapted) window size */
+  FeatureVector fvCurWinSize = fvWindowSize;
   
   dScore = 2*EPS_MSME;
   //int   nIterations = 0;
@@ -1566,16 +1958,16 @@ void VotingSpace::applyMSME( const FeatureVector &fvCoords,
     if( bAdaptiveScale )
       if( fvCurPos.at(2) > dAdaptMinScale ) {
         /* adapt the window size to the current scale */
-        m_fvWindowSize.setValue(0, fvWindowSize.at(0)*fvCurPos.at(2) );
-        m_fvWindowSize.setValue(1, fvWindowSize.at(1)*fvCurPos.at(2) );
-        m_fvWindowSize.setValue(2, fvWindowSize.at(2)*fvCurPos.at(2) );
+        fvCurWinSize.setValue(0, fvWindowSize.at(0)*fvCurPos.at(2) );
+        fvCurWinSize.setValue(1, fvWindowSize.at(1)*fvCurPos.at(2) );
+        fvCurWinSize.setValue(2, fvWindowSize.at(2)*fvCurPos.at(2) );
         dNorm = fvCurPos.at(2)*fvCurPos.at(2);
 
       } else {
         /* adapt the window size to minimum current scale */
-        m_fvWindowSize.setValue(0, fvWindowSize.at(0)*dAdaptMinScale );
-        m_fvWindowSize.setValue(1, fvWindowSize.at(1)*dAdaptMinScale ); 
-        m_fvWindowSize.setValue(2, fvWindowSize.at(2)*dAdaptMinScale ); 
+        fvCurWinSize.setValue(0, fvWindowSize.at(0)*dAdaptMinScale );
+        fvCurWinSize.setValue(1, fvWindowSize.at(1)*dAdaptMinScale ); 
+        fvCurWinSize.setValue(2, fvWindowSize.at(2)*dAdaptMinScale ); 
         dNorm = dAdaptMinScale2;
       }
 
@@ -1583,9 +1975,12 @@ void VotingSpace::applyMSME( const FeatureVector &fvCoords,
     dScore = 0.0;
     int nCount = 0;
     if( !bUseFastMSME )
-      getMeanVote( fvCurPos, fvNewMean, nCount, dScore );
+      getMeanVote( fvCurPos, fvCurWinSize, fvNewMean, nCount, dScore );
     else {
-      getFastMeanVote( fvCurPos, fvNewMean, nCount, dScore );
+      vector<int> vBinIdx( m_nDims );
+      for ( int dim = 0; dim < m_nDims; dim++ )
+        vBinIdx[dim] = getBinNumber( dim, fvCurPos.at(dim) );
+      getFastMeanVote( vBinIdx, fvCurWinSize, fvNewMean, nCount, dScore );
       bStop = true;
     }
 
@@ -1596,10 +1991,21 @@ void VotingSpace::applyMSME( const FeatureVector &fvCoords,
     /* update the current position to the new mean */
     if( dScore > dLastScore )
       fvCurPos = fvNewMean;
-  }
 
-  /* restore the original window size */
-  m_fvWindowSize = fvWindowSize;
+    /* stop if we have entered the basin of a known mode */
+    if( dBasinSize > 0.0 && !bStop )
+      for( int m=0; m<(int)vModes.size() && nModeIdx<0; m++ ) {
+        bool bInside = true;
+        for( int k=0; k<m_nDims && bInside; k++ )
+          bInside = ( fabs(fvCurPos.at(k) - vModes[m].at(k)) <= 
+                      dBasinSize*fvCurWinSize.at(k) );
+        if( bInside ) {
+          nModeIdx = m;
+          fvCurPos = vModes[m];
+          bStop    = true;
+        }
+      }
+  }
 
   fvResult = fvCurPos;
 }
@@ -1611,7 +2017,7 @@ list<HoughVote> VotingSpace::getBinVotes( int idx_x )
   /* Version for a 1D voting space.                                  */
   /*******************************************************************/
 {
-  return m_vlVotes[idx(idx_x)];
+  return getBinVoteList( idx(idx_x) );
 }
 
 
@@ -1621,7 +2027,7 @@ list<HoughVote> VotingSpace::getBinVotes( int idx_x, int idx_y )
   /* Version for a 2D voting space.                                  */
   /*******************************************************************/
 {
-  return m_vlVotes[idx(idx_x,idx_y)];
+  return getBinVoteList( idx(idx_x,idx_y) );
 }
 
 
@@ -1631,7 +2037,7 @@ list<HoughVote> VotingSpace::getBinVotes( int idx_x, int idx_y, int idx_z )
   /* Version for a 3D voting space.                                  */
   /*******************************************************************/
 {
-  return m_vlVotes[idx(idx_x,idx_y,idx_z)];
+  return getBinVoteList( idx(idx_x,idx_y,idx_z) );
 }
 
 
@@ -1642,7 +2048,7 @@ list<HoughVote> VotingSpace::getBinVotes( int idx_x, int idx_y, int idx_z,
   /* Version for a 4D voting space.                                  */
   /*******************************************************************/
 {
-  return m_vlVotes[idx(idx_x,idx_y,idx_z,idx_s)];
+  return getBinVoteList( idx(idx_x,idx_y,idx_z,idx_s) );
 }
 
 
@@ -1652,7 +2058,7 @@ list<HoughVote> VotingSpace::getBinVotes( const vector<int> &vBinIdx )
   /* Version for a voting space of arbitrary dimension.              */
   /*******************************************************************/
 {
-  return m_vlVotes[idx(vBinIdx)];
+  return getBinVoteList( idx(vBinIdx) );
 }
 
 
@@ -1666,11 +2072,25 @@ float VotingSpace::getVoteSumInWindow( const vector<int> &vBinIdx,
   float dResult = 0.0;
 
   int nIdx = idx(vBinIdx);
+  if( m_nStorageMode == STORAGE_SPARSE ) {
+    int nSlot = findSlot( nIdx );
+    if( nSlot < 0 )
+      return 0.0;
+
+    buildSlotIndex();
+    for( int i=m_vSlotOffsets[nSlot]; i<m_vSlotOffsets[nSlot+1]; i++ ) {
+      int nVote = m_vSlotVotes[i];
+      if( isInsideKernel( &m_vVoteCoords[nVote*m_nDims], fvStart ) )
+        dResult += m_vVoteValues[nVote];
+    }
+    return dResult;
+  }
+
 //   for( int i=0; i<(int)m_vlVotes[nIdx].size(); i++ ) {
 //     if( isInsideKernel( m_vlVotes[nIdx][i].getCoords(), fvStart ) )
   for( list<HoughVote>::iterator it=m_vlVotes[nIdx].begin();
        it!=m_vlVotes[nIdx].end(); it++ ) {
-    if( isInsideKernel( it->getCoords(), fvStart ) )
+    if( isInsideKernel( it->coords(), fvStart ) )
       /* add the current vote to result score */
       dResult += it->getValue();
   }
@@ -1683,6 +2103,17 @@ void VotingSpace::getMeanVoteInWindow( const vector<int> &vBinIdx,
                                        const FeatureVector &fvStart,
                                        FeatureVector &fvMean, int &nNumVotes,
                                        float &dSumScore )
+{
+  getMeanVoteInWindow( vBinIdx, fvStart, m_fvWindowSize, 
+                       fvMean, nNumVotes, dSumScore );
+}
+
+
+void VotingSpace::getMeanVoteInWindow( const vector<int> &vBinIdx, 
+                                       const FeatureVector &fvStart,
+                                       const FeatureVector &fvWindowSize,
+                                       FeatureVector &fvMean, int &nNumVotes,
+                                       float &dSumScore )
 {
   FeatureVector tmp( m_nDims );
   fvMean    = tmp;
@@ -1690,18 +2121,42 @@ void VotingSpace::getMeanVoteInWindow( const vector<int> &vBinIdx,
   dSumScore = 0.0;
 
   int nIdx = idx(vBinIdx);
+  if( m_nStorageMode == STORAGE_SPARSE ) {
+    int nSlot = findSlot( nIdx );
+    if( nSlot < 0 )
+      return;
+
+    buildSlotIndex();
+    for( int i=m_vSlotOffsets[nSlot]; i<m_vSlotOffsets[nSlot+1]; i++ ) {
+      int          nVote   = m_vSlotVotes[i];
+      const float *pCoords = &m_vVoteCoords[nVote*m_nDims];
+      if( isInsideKernel( pCoords, fvStart, fvWindowSize ) ) {
+        /* add the current vote to result score */
+        float dValue = m_vVoteValues[nVote];
+        for( int k=0; k<m_nDims; k++ )
+          fvMean.at(k) += pCoords[k]*dValue;
+        dSumScore += dValue;
+        nNumVotes++;
+      }
+    }
+
+    if( dSumScore > 0.0 )
+      fvMean.multFactor( 1.0/dSumScore );
+    return;
+  }
+
 //   for( int i=0; i<(int)m_vlVotes[nIdx].size(); i++ )
 //    if( isInsideKernel( m_vlVotes[nIdx][i].getCoords(), fvStart ) ) {
   for( list<HoughVote>::iterator it=m_vlVotes[nIdx].begin();
        it!=m_vlVotes[nIdx].end(); it++ )
-    if( isInsideKernel( it->getCoords(), fvStart ) ) {
+    if( isInsideKernel( it->coords(), fvStart, fvWindowSize ) ) {
       /* add the current vote to result score */
       //HoughVote &vote = m_vlVotes[nIdx][i];
-      HoughVote &vote = *it;
-      FeatureVector fvWeightedCoords = vote.getCoords();
-      fvWeightedCoords.multFactor( vote.getValue() );
-      fvMean.addVector( fvWeightedCoords );
-      dSumScore += vote.getValue();
+      const HoughVote &vote = *it;
+      float dValue = vote.getValue();
+      for( int k=0; k<m_nDims; k++ )
+        fvMean.at(k) += vote.coord(k)*dValue;
+      dSumScore += dValue;
       nNumVotes++;
     }
   
@@ -1716,11 +2171,25 @@ list<HoughVote> VotingSpace::getVotesInWindow( const vector<int> &vBinIdx,
   list<HoughVote> vResult;
 
   int nIdx = idx(vBinIdx);
+  if( m_nStorageMode == STORAGE_SPARSE ) {
+    int nSlot = findSlot( nIdx );
+    if( nSlot < 0 )
+      return vResult;
+
+    buildSlotIndex();
+    for( int i=m_vSlotOffsets[nSlot]; i<m_vSlotOffsets[nSlot+1]; i++ ) {
+      int nVote = m_vSlotVotes[i];
+      if( isInsideKernel( &m_vVoteCoords[nVote*m_nDims], fvStart ) )
+        vResult.push_back( getSparseVote( nVote ) );
+    }
+    return vResult;
+  }
+
 //   for( int i=0; i<(int)m_vlVotes[nIdx].size(); i++ ) {
 //     if( isInsideKernel( m_vlVotes[nIdx][i].getCoords(), fvStart ) )
   for( list<HoughVote>::iterator it=m_vlVotes[nIdx].begin();
        it!=m_vlVotes[nIdx].end(); it++ )
-    if( isInsideKernel( it->getCoords(), fvStart ) ) {
+    if( isInsideKernel( it->coords(), fvStart ) ) {
       /* add the current vote to result score */
       //vResult.push_back( m_vlVotes[nIdx][i] );
       vResult.push_back( *it );
@@ -1730,6 +2199,189 @@ list<HoughVote> VotingSpace::getVotesInWindow( const vector<int> &vBinIdx,
 }
 
 
+list<HoughVote> VotingSpace::getBinVoteList( int nIdx )
+  /*******************************************************************/
+  /* Get all votes stored in the bin with the given cell index (in   */
+  /* the order in which they were inserted).                         */
+  /*******************************************************************/
+{
+  if( m_nStorageMode != STORAGE_SPARSE )
+    return m_vlVotes[nIdx];
+
+  list<HoughVote> vResult;
+  int nSlot = findSlot( nIdx );
+  if( nSlot < 0 )
+    return vResult;
+
+  buildSlotIndex();
+  for( int i=m_vSlotOffsets[nSlot]; i<m_vSlotOffsets[nSlot+1]; i++ )
+    vResult.push_back( getSparseVote( m_vSlotVotes[i] ) );
+
+  return vResult;
+}
+
+
+float VotingSpace::getBinScore( int nIdx )
+  /*******************************************************************/
+  /* Get the accumulated score of the bin with the given cell index. */
+  /*******************************************************************/
+{
+  if( m_nStorageMode != STORAGE_SPARSE )
+    return m_vBinScores[nIdx];
+
+  int nSlot = findSlot( nIdx );
+  return ( nSlot<0 ? 0.0 : m_vSlotScores[nSlot] );
+}
+
+
+void VotingSpace::getBinContent( int nIdx, FeatureVector &fvWeightedSum, 
+                                 int &nNumVotes, float &dSumScore )
+  /*******************************************************************/
+  /* Get the score-weighted coordinate sum, the number of votes, and */
+  /* the accumulated score of the bin with the given cell index.     */
+  /*******************************************************************/
+{
+  if( m_nStorageMode != STORAGE_SPARSE ) {
+    fvWeightedSum = m_vBinMeans[nIdx];
+    nNumVotes     = (int)m_vlVotes[nIdx].size();
+    dSumScore     = m_vBinScores[nIdx];
+    return;
+  }
+
+  FeatureVector tmp( m_nDims );
+  fvWeightedSum = tmp;
+  nNumVotes     = 0;
+  dSumScore     = 0.0;
+
+  int nSlot = findSlot( nIdx );
+  if( nSlot < 0 )
+    return;
+
+  for( int k=0; k<m_nDims; k++ )
+    fvWeightedSum.at(k) = m_vSlotMeans[nSlot*m_nDims + k];
+  nNumVotes = m_vSlotNumVotes[nSlot];
+  dSumScore = m_vSlotScores[nSlot];
+}
+
+
+/***********************************************************/
+/*                  Sparse Vote Storage                    */
+/***********************************************************/
+
+static inline int hashBinIdx( int nIdx, int nMask )
+{
+  /* multiplicative (Fibonacci) hashing of the cell index */
+  return (int)( ((unsigned)nIdx * 2654435761u) & (unsigned)nMask );
+}
+
+
+int VotingSpace::findSlot( int nIdx ) const
+  /*******************************************************************/
+  /* Look up the slot of an occupied bin in the hash table. Returns  */
+  /* -1 if the bin has not received any votes.                       */
+  /*******************************************************************/
+{
+  int nMask = (int)m_vHashBins.size() - 1;
+  for( int h=hashBinIdx( nIdx, nMask ); ; h=(h+1) & nMask ) {
+    if( m_vHashBins[h] == nIdx )
+      return m_vHashSlots[h];
+    if( m_vHashBins[h] < 0 )
+      return -1;
+  }
+}
+
+
+int VotingSpace::getSlot( int nIdx )
+  /*******************************************************************/
+  /* Return the slot of the given bin, creating a new slot if the    */
+  /* bin is not yet occupied.                                        */
+  /*******************************************************************/
+{
+  /* keep the hash table at most half full */
+  if( 2*((int)m_vSlotBins.size()+1) > (int)m_vHashBins.size() )
+    growHashTable();
+
+  int nMask = (int)m_vHashBins.size() - 1;
+  int h = hashBinIdx( nIdx, nMask );
+  while( m_vHashBins[h] >= 0 ) {
+    if( m_vHashBins[h] == nIdx )
+      return m_vHashSlots[h];
+    h = (h+1) & nMask;
+  }
+
+  /* bin not found -> open a new slot */
+  int nSlot = (int)m_vSlotBins.size();
+  m_vHashBins[h]  = nIdx;
+  m_vHashSlots[h] = nSlot;
+  m_vSlotBins.push_back( nIdx );
+  m_vSlotScores.push_back( 0.0 );
+  m_vSlotMeans.insert( m_vSlotMeans.end(), m_nDims, 0.0 );
+  m_vSlotNumVotes.push_back( 0 );
+
+  return nSlot;
+}
+
+
+void VotingSpace::growHashTable()
+  /*******************************************************************/
+  /* Double the size of the hash table and re-insert all slots.      */
+  /*******************************************************************/
+{
+  int nNewSize = 2*(int)m_vHashBins.size();
+  int nMask    = nNewSize - 1;
+
+  m_vHashBins.assign( nNewSize, -1 );
+  m_vHashSlots.assign( nNewSize, -1 );
+  for( int nSlot=0; nSlot<(int)m_vSlotBins.size(); nSlot++ ) {
+    int h = hashBinIdx( m_vSlotBins[nSlot], nMask );
+    while( m_vHashBins[h] >= 0 )
+      h = (h+1) & nMask;
+    m_vHashBins[h]  = m_vSlotBins[nSlot];
+    m_vHashSlots[h] = nSlot;
+  }
+}
+
+
+void VotingSpace::buildSlotIndex()
+  /*******************************************************************/
+  /* (Re-)build the per-slot offset index into the flat vote buffer  */
+  /* by a counting sort over the vote slots. The sort is stable, so  */
+  /* the votes of each bin keep their insertion order. The index is  */
+  /* only rebuilt if votes have been added since the last call.      */
+  /*******************************************************************/
+{
+  if( m_bSlotIdxValid )
+    return;
+
+  int nNumSlots = (int)m_vSlotBins.size();
+  int nNumVotes = (int)m_vVoteSlots.size();
+
+  m_vSlotOffsets.assign( nNumSlots+1, 0 );
+  for( int nSlot=0; nSlot<nNumSlots; nSlot++ )
+    m_vSlotOffsets[nSlot+1] = m_vSlotOffsets[nSlot] + m_vSlotNumVotes[nSlot];
+
+  vector<int> vFill( m_vSlotOffsets.begin(), m_vSlotOffsets.end()-1 );
+  m_vSlotVotes.resize( nNumVotes );
+  for( int nVote=0; nVote<nNumVotes; nVote++ )
+    m_vSlotVotes[ vFill[m_vVoteSlots[nVote]]++ ] = nVote;
+
+  m_bSlotIdxValid = true;
+}
+
+
+HoughVote VotingSpace::getSparseVote( int nVote ) const
+  /*******************************************************************/
+  /* Reassemble a HoughVote from the flat vote buffer.               */
+  /*******************************************************************/
+{
+  return HoughVote( &m_vVoteCoords[nVote*m_nDims], m_nDims, 
+                    m_vVoteValues[nVote], m_vVoteConfs[nVote],
+                    m_vVoteImgPointIds[nVote], m_vVoteClusterIds[nVote],
+                    m_vVoteOccNumbers[nVote], m_vVoteOccMapIds[nVote],
+                    m_vVoteCueIds[nVote] );
+}
+
+
 /***********************************************************/
 /*                    Service Functions                    */
 /***********************************************************/
@@ -1768,6 +2420,45 @@ bool  VotingSpace::isInsideKernel( const FeatureVector &fvCoords,
 }
 
 
+bool  VotingSpace::isInsideKernel( const float         *pCoords,
+                                   const FeatureVector &fvCenter )
+  /*******************************************************************/
+  /* Version for raw coordinate arrays (inline HoughVote coordinates */
+  /* or votes stored in the flat vote buffer).                       */
+  /*******************************************************************/
+{
+  return isInsideKernel( pCoords, fvCenter, m_fvWindowSize );
+}
+
+
+bool  VotingSpace::isInsideKernel( const float         *pCoords,
+                                   const FeatureVector &fvCenter,
+                                   const FeatureVector &fvWindowSize )
+{
+  switch( m_nKernelType ) {
+  case KERNEL_HCUBE: 
+    for( int k=0; k<m_nDims; k++ )
+      if( fabs(pCoords[k] - fvCenter.at(k)) > fvWindowSize.at(k) )
+        return false;
+    return true;
+
+  case KERNEL_HSPHERE: {
+    float dDist = 0.0;
+    for( int k=0; k<m_nDims; k++ ) {
+      float d = (pCoords[k] - fvCenter.at(k)) / fvWindowSize.at(k);
+      dDist += d*d;
+    }
+    return (dDist <= 1.0 );
+  }
+
+  default:
+    cerr << "Error in VotingSpace::isInsideKernel(): "
+         << "Unknown kernel type (" << m_nKernelType << ")!" << endl;
+    return false;
+  }
+}
+
+
 int VotingSpace::idx( int x )
   /*******************************************************************/
   /* Calculate the cell index for a 1D voting space.                 */
@@ -1827,7 +2518,7 @@ int VotingSpace::idx( int x, int y, int z, int s )
 }
 
 
-int VotingSpace::idx( vector<int> index )
+int VotingSpace::idx( const vector<int> &index )
   /*******************************************************************/
   /* Calculate the cell index for a voting space of arbitrary dimen- */
   /* sion.                                                           */
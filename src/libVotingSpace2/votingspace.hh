@@ -36,6 +36,8 @@ const float EPS_MSME       = 0.01;
 const int KERNEL_HCUBE     = 0;
 const int KERNEL_HSPHERE   = 1;
 
+const int HOUGH_MAX_DIMS   = 4;
+
 
 /*************************/
 /*   Class Definitions   */
@@ -44,6 +46,9 @@ const int KERNEL_HSPHERE   = 1;
 /*===================================================================*/
 /*                          Class HoughVote                          */
 /*===================================================================*/
+/* The coordinates (at most HOUGH_MAX_DIMS) are stored inline, so     */
+/* that a HoughVote is a plain record without heap storage and can    */
+/* be copied and sorted with the compiler-generated copy operations. */
 class HoughVote 
 {
 public:
@@ -63,26 +68,28 @@ public:
              float dValue, float dConfidence, 
              int nImgPointId, int nClusterId, int nOccNumber, int nOccMapId=-1,
              int nCueId=0 );
-  HoughVote( FeatureVector fvCoords, 
+  HoughVote( const FeatureVector &fvCoords, 
+             float dValue, float dConfidence, 
+             int nImgPointId, int nClusterId, int nOccNumber, int nOccMapId=-1,
+             int nCueId=0 );
+  HoughVote( const float *pCoords, int nDims,
              float dValue, float dConfidence, 
              int nImgPointId, int nClusterId, int nOccNumber, int nOccMapId=-1,
              int nCueId=0 );
-  HoughVote( const HoughVote &other );
-
-  HoughVote& operator=( const HoughVote &other );
 
 private:
-  void createHoughVote( FeatureVector fvCoords, 
-                        float dValue, float dConfidence, 
+  void createHoughVote( float dValue, float dConfidence, 
                         int nImgPointId, int nClusterId, int nOccNumber,
-                        int nOccMapId=-1, int nCueId=0 );
-  void copyFromOther  ( const HoughVote &other );
+                        int nOccMapId, int nCueId );
 
 public:
   /*****************************/
   /*   Data Access Operators   */
   /*****************************/
-  inline FeatureVector getCoords() const { return m_fvCoords; }
+  FeatureVector getCoords() const;
+  inline const float* coords()     const { return m_vCoords; }
+  inline float coord( int dim )    const { return m_vCoords[dim]; }
+  inline int   numDims()           const { return m_nDims; }
   inline float getValue()          const { return m_dValue; }
   inline float getConfidence()     const { return m_dConfidence; }
   inline int   getImgPointId()     const { return m_nImgPointId; }
@@ -91,7 +98,7 @@ public:
   inline int   getOccMapId()       const { return m_nOccMapId; } 
   inline int   getCueId()          const { return m_nCueId; }
 
-  inline void  setCoords    ( FeatureVector fvCoords ) { m_fvCoords=fvCoords; }
+  void         setCoords    ( const FeatureVector &fvCoords );
   inline void  setValue     ( float dValue )      { m_dValue=dValue; }
   inline void  setConfidence( float dConfidence ) { m_dConfidence=dConfidence;}
   inline void  setImgPointId( int nImgPointId )   { m_nImgPointId=nImgPointId;}
@@ -101,7 +108,8 @@ public:
   inline void  setCueId     ( int nCueId )        { m_nCueId=nCueId; }
 
 public:
-  FeatureVector m_fvCoords;
+  float m_vCoords[HOUGH_MAX_DIMS];
+  int   m_nDims;
   float m_dValue;
   float m_dConfidence;
 
@@ -117,37 +125,37 @@ public:
 /*-------------------------------------------------------------------*/
 struct compHoughValue
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getValue() > y.getValue()); }
 };
 
 struct compHoughCluster
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getClusterId() < y.getClusterId()); }
 };
 
 struct compHoughOcc
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getOccNumber() < y.getOccNumber()); }
 };
 
 struct compHoughOccMap
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getOccMapId() < y.getOccMapId()); }
 };
 
 struct compHoughPoint : public binary_function<HoughVote,HoughVote,bool>
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getImgPointId() < y.getImgPointId()); }
 };
 
 struct compHoughPointIsEqual
 {
-  bool operator()( HoughVote x, HoughVote y )
+  bool operator()( const HoughVote &x, const HoughVote &y ) const
   { return (x.getImgPointId() == y.getImgPointId()); }
 };
 
@@ -160,19 +168,28 @@ struct compHoughPointIsEqual
 class VotingSpace
 {
 public:
+  /* vote storage modes */
+  static const int   STORAGE_DENSE  = 0;  // one vote list per bin
+  static const int   STORAGE_SPARSE = 1;  // flat vote buffer, hashed bins
+
   VotingSpace();
-  VotingSpace( int nBins, float min, float max );
+  VotingSpace( int nBins, float min, float max, 
+               int nStorageMode=STORAGE_DENSE );
   VotingSpace( int nBins_x, float min_x, float max_x,
-               int nBins_y, float min_y, float max_y );
+               int nBins_y, float min_y, float max_y,
+               int nStorageMode=STORAGE_DENSE );
   VotingSpace( int nBins_x, float min_x, float max_x,
                int nBins_y, float min_y, float max_y,
-               int nBins_z, float min_z, float max_z );
+               int nBins_z, float min_z, float max_z,
+               int nStorageMode=STORAGE_DENSE );
   VotingSpace( int nBins_x, float min_x, float max_x,
                int nBins_y, float min_y, float max_y,
                int nBins_z, float min_z, float max_z,
-               int nBins_s, float min_s, float max_s );
+               int nBins_s, float min_s, float max_s,
+               int nStorageMode=STORAGE_DENSE );
   VotingSpace( int nDims, vector<int> vNumBins, 
-               vector<float> vMinValues, vector<float> vMaxValues );
+               vector<float> vMinValues, vector<float> vMaxValues,
+               int nStorageMode=STORAGE_DENSE );
   VotingSpace( const VotingSpace &other );
   ~VotingSpace();
 
@@ -183,6 +200,7 @@ private:
 
   void  initDimension ( int dim, int nBins, float min, float max );
   void  initBins();
+  void  initSparseStorage();
 
   int   calcTotalNumBins();
   
@@ -203,6 +221,10 @@ public:
   void  setNumDims  ( int nDims );
   void  setDimension( int dim, int nBins, float min, float max );
 
+  int   storageMode() const { return m_nStorageMode; }
+  void  setStorageMode( int nMode );
+  int   numVotes();
+
   void  clear();
 
   void  print();
@@ -214,6 +236,11 @@ public:
   /*****************************/
 
   void  insertVote    ( const HoughVote &vote );
+  void  finishVoting  ();
+
+  void  buildIntegralTable();
+  void  clearIntegralTable();
+  bool  hasIntegralTable() const { return m_bIntegralValid; }
 
 protected:
   int   getBinNumber  ( int dim, double value );
@@ -233,6 +260,7 @@ public:
   void  setWindowSize ( float wx, float wy, float wz );
   void  setWindowSize ( float wx, float wy, float wz, float ws );
   void  setWindowSize ( const FeatureVector &fvWindowSize );
+  FeatureVector getWindowSize() const { return m_fvWindowSize; }
 
   static const int   KERNEL_HCUBE   = 0;
   static const int   KERNEL_HSPHERE = 1;
@@ -259,6 +287,10 @@ public:
   void  getMeanVote   ( const FeatureVector &fvCoords,
                         FeatureVector &fvMean, int &nNumVotes, 
                         float &dSumScore );
+  void  getMeanVote   ( const FeatureVector &fvCoords,
+                        const FeatureVector &fvWindowSize,
+                        FeatureVector &fvMean, int &nNumVotes, 
+                        float &dSumScore );
 
   void getFastKernelVoteSum( int x,
                              float &dSumScore );
@@ -277,6 +309,10 @@ public:
   void getFastMeanVote     ( const vector<int> &vBinIdx,
                              FeatureVector &fvMean, int &nNumVotes, 
                              float &dSumScore );
+  void getFastMeanVote     ( const vector<int> &vBinIdx,
+                             const FeatureVector &fvWindowSize,
+                             FeatureVector &fvMean, int &nNumVotes, 
+                             float &dSumScore );
 
   list<HoughVote> getSupportingVotes( float x );
   list<HoughVote> getSupportingVotes( float x, float y );
@@ -302,6 +338,13 @@ public:
                   FeatureVector &fvResult, float &dScore,
                   bool bAdaptiveScale=false, float dAdaptMinScale=1.0,
                   bool bUseFastMSME=false );
+  void applyMSME( const FeatureVector &fvCoords, 
+                  const FeatureVector &fvWindowSize,
+                  FeatureVector &fvResult, float &dScore,
+                  bool bAdaptiveScale, float dAdaptMinScale,
+                  bool bUseFastMSME,
+                  const vector<FeatureVector> &vModes, float dBasinSize,
+                  int &nModeIdx );
 
   list<HoughVote> getBinVotes     ( int idx_x );
   list<HoughVote> getBinVotes     ( int idx_x, int idx_y );
@@ -318,18 +361,46 @@ public:
                                       const FeatureVector &fvStart,
                                       FeatureVector &fvMean, int &nNumVotes,
                                       float &dSumScore );
+  void  getMeanVoteInWindow         ( const vector<int> &vBinIdx, 
+                                      const FeatureVector &fvStart,
+                                      const FeatureVector &fvWindowSize,
+                                      FeatureVector &fvMean, int &nNumVotes,
+                                      float &dSumScore );
   list<HoughVote> getVotesInWindow( const vector<int> &vBinIdx, 
                                       const FeatureVector &fvStart );
 
   bool  isInsideKernel              ( const FeatureVector &fvCoords,
                                       const FeatureVector &fvCenter );
+  bool  isInsideKernel              ( const float         *pCoords,
+                                      const FeatureVector &fvCenter );
+  bool  isInsideKernel              ( const float         *pCoords,
+                                      const FeatureVector &fvCenter,
+                                      const FeatureVector &fvWindowSize );
 
 protected:
+  /*--------------------------*/
+  /* Bin content (both modes) */
+  /*--------------------------*/
+  float getBinScore   ( int nIdx );
+  list<HoughVote> getBinVoteList( int nIdx );
+  float getBoxScore   ( const vector<int> &vMin, const vector<int> &vMax );
+  void  getBinContent ( int nIdx, FeatureVector &fvWeightedSum, 
+                        int &nNumVotes, float &dSumScore );
+
+  /*----------------------*/
+  /* Sparse vote storage  */
+  /*----------------------*/
+  int   findSlot      ( int nIdx ) const;
+  int   getSlot       ( int nIdx );
+  void  growHashTable ();
+  void  buildSlotIndex();
+  HoughVote getSparseVote( int nVote ) const;
+
   int   idx( int x );
   int   idx( int x, int y );
   int   idx( int x, int y, int z );
   int   idx( int x, int y, int z, int s );
-  int   idx( vector<int> index );
+  int   idx( const vector<int> &index );
 
   vector<int> getNextIndex( const vector<int> &index, bool &endReached );
 
@@ -352,10 +423,43 @@ protected:
   vector<bool>   m_vDimDefined;
   bool           m_bAllDimensionsDefined;
 
+  int            m_nStorageMode;
+
+  /* dense storage: one entry per bin */
   vector< list<HoughVote> > m_vlVotes;
   vector<float>               m_vBinScores;
   vector<FeatureVector>       m_vBinMeans;
 
+  /* sparse storage: open-addressed hash of the occupied bins (slots) */
+  vector<int>    m_vHashBins;      // bin index per table entry (-1: empty)
+  vector<int>    m_vHashSlots;     // slot number per table entry
+  vector<int>    m_vSlotBins;      // bin index per slot
+  vector<float>  m_vSlotScores;    // vote sum per slot
+  vector<float>  m_vSlotMeans;     // weighted coord sums (m_nDims per slot)
+  vector<int>    m_vSlotNumVotes;  // #votes per slot
+
+  /* sparse storage: flat struct-of-arrays vote buffer */
+  vector<float>  m_vVoteCoords;    // m_nDims coordinates per vote
+  vector<float>  m_vVoteValues;
+  vector<float>  m_vVoteConfs;
+  vector<int>    m_vVoteImgPointIds;
+  vector<int>    m_vVoteClusterIds;
+  vector<int>    m_vVoteOccNumbers;
+  vector<int>    m_vVoteOccMapIds;
+  vector<int>    m_vVoteCueIds;
+  vector<int>    m_vVoteSlots;     // slot of each vote
+
+  /* sparse storage: per-slot offset index into m_vSlotVotes */
+  bool           m_bSlotIdxValid;
+  vector<int>    m_vSlotOffsets;
+  vector<int>    m_vSlotVotes;
+
+  /* summed-volume table of the bin scores (one extra zero border */
+  /* entry at the lower end of every dimension)                   */
+  bool           m_bIntegralValid;
+  vector<double> m_vIntegral;
+  vector<int>    m_vIntegralStrides;
+
   FeatureVector  m_fvWindowSize;
 };
 
@@ -32,6 +32,7 @@
 #include <qtimgbrowser.hh>
 #include <Candidate.h>
 #include <chamfermatching.h>
+#include <chamferengine.h>
 
 #include "mcmatcher.hh"
 
@@ -318,7 +319,8 @@ void ISMReco::verifyHyposTemplate( const vector<Hypothesis> &vInitHypos,
     QImage      qimgDT = ChamferMatching::drawDT( imgDT );
     vResultQImgs.push_back( qimgDT );
 
-    /* perform Chamfer matching with all templates */
+    /* perform Chamfer matching with all templates and scales at once */
+    ChamferEngine     engine( imgDT );
     CombiCandidateSet vCandidates;
     int nMaxCandidates = 150;
     int nNumScales = 7;
@@ -353,14 +355,11 @@ void ISMReco::verifyHyposTemplate( const vector<Hypothesis> &vInitHypos,
         int miny = nStartY - nWinSize;
         int maxx = nStartX + nWinSize;
         int maxy = nStartY + nWinSize;
-        ChamferMatching::matchTemplateOnWindow( vCandidates, imgDT, 
-                                                m_vSilhMasks[i], 
-                                                m_vTemplates[i], i,
-                                                minx, miny, maxx, maxy, 
-                                                dScaleFact, nStepSize,
-                                                nMaxCandidates );
+        engine.addJob( m_vSilhMasks[i], m_vTemplates[i], i,
+                       minx, miny, maxx, maxy, dScaleFact, nStepSize );
       }
     }
+    engine.matchJobs( vCandidates, nMaxCandidates );
     
     /* compute the Bhattacharya coefficients of the best-matching candidates */
     /* print out the results */
@@ -746,13 +746,20 @@ void ISMReco::collectPatches( bool process )
   /* pling, or by applying an interest point detector.               */
   /*******************************************************************/
 {
+  /* cues that enable it share the scale space of this frame, so the */
+  /* image is only smoothed once (the cache is filled on demand)      */
+  ScaleSpaceCache ssCache( m_grayImg );
+
   for(unsigned k=0; k<m_nNumCues; k++ ) {
     /* process the original image */
+    if( m_vCues[k].params()->m_bUseScaleCache )
+      m_vCues[k].setScaleSpaceCache( &ssCache );
     m_vCues[k].processImage( m_sImgFullName, m_grayImg, m_grayImgMap, m_img, 
                              m_vCues[k].params()->m_nFeatureType,
                              m_vPoints, m_vvPointsInside[k], 
                              m_vImagePatches, m_vvFeatures[k],
                              m_bShowTxtDetails );
+    m_vCues[k].setScaleSpaceCache( 0 );
     
     if( m_vProcessBothDir[k] ) {
       /* process the flipped image */
@@ -36,7 +36,7 @@ QT_LIBS      = -lqt-mt -lQtTools
 IMGDB_LIBS   = -lImgDB
 #PCCV_LIBS    = -lrgbdisp 
 IMAGE_LIBS   = -limage -lGrayImage -lRGBImage -lGaussDeriv -lCanny -lMorphology 
-SCALE_LIBS   = -lScaleSpace -lInterestPts -lPatchExtraction5
+SCALE_LIBS   = -lScaleSpace2 -lInterestPts2 -lPatchExtraction5
 FEATURE_LIBS = -lFeatures -lPCA -lMath -lMatrix -lChiSquare -lNNSearch2 -lCluster2 -lHistogram -lEdgeSIFT -lChamfer 
 RECO_LIBS    = -lContainer -lCodebook2 -lVotingSpace2 -lISM2 -lDetector2 -lCalibration
 OTHER_LIBS     = -lHelpers -lIDL -lOrientationPlanes 
@@ -64,6 +64,9 @@ const string USAGE =
   "\n"
   "-centers         - only save the cluster centers, not all features\n"
   "\n"
+  "-binary          - save codebook and occurrences in the binary model \n"
+  "                   format (loaded without parsing) \n"
+  "\n"
   "  -v             - verbose output \n"
   "  -wocc <file>   - write out the #occs to a file\n"
   "\n" );
@@ -323,6 +326,7 @@ int main( int argc, char **argv )
   bool   bFilterOccs     = false;
   bool   bRemoveClusters = false;
   bool   bOnlySaveCenters= false;
+  bool   bSaveBinary     = false;
   bool   bVerbose        = true;
 
   string sMaskTrace="";
@@ -367,6 +371,9 @@ int main( int argc, char **argv )
     } else if(!strcmp(argv[i],"-centers")){
       bOnlySaveCenters = true;
 
+    } else if(!strcmp(argv[i],"-binary")){
+      bSaveBinary = true;
+
     } else if(!strcmp(argv[i],"-v")){
       bVerbose = true;
     } else if(!strcmp(argv[i],"-wocc")){
@@ -885,7 +892,10 @@ int main( int argc, char **argv )
   /*----------------------------*/
   if( bVerbose )
     cout << "  Saving codebook...    " << flush;
-  cbCodebook.saveCodebook( sOutCB, false, false );
+  if( bSaveBinary )
+    cbCodebook.saveCodebookBinary( sOutCB, false );
+  else
+    cbCodebook.saveCodebook( sOutCB, false, false );
   if( bVerbose )
     cout << "written " << cbCodebook.getNumClusters() << " clusters." << endl;
   
@@ -910,7 +920,10 @@ int main( int argc, char **argv )
   /*-------------------------------*/
   if( bVerbose )
     cout << "  Saving occurrences... " << flush;
-  ismReco.saveOccurrences( sOutOcc, false );
+  if( bSaveBinary )
+    ismReco.saveOccurrencesBinary( sOutOcc, false );
+  else
+    ismReco.saveOccurrences( sOutOcc, false );
   if( bVerbose )
     cout << "written " << ismReco.getNumOccs() << " occurrences and " 
          << ismReco.getOccMaps().size() << " occ maps." << endl;
@@ -7,6 +7,11 @@
  * arrays of 'Pixel' values. Basic functionalities like copying, assignment, 
  * and access in either read-only or read-write mode.
  *------------------------------- CVS logs ------------------------------------
+ * The reference counter of the shared ImageData is updated atomically, so
+ * images can be copied and released from several threads without locking.
+ * For inner loops, the image provides unchecked access to its rows
+ * (rowPtr(), dataPtr(), stride()) and a read-only ImageView.
+ *------------------------------- CVS logs ------------------------------------
  * $Log: image.h,v $
  * Revision 1.2  2005/04/26 15:20:35  leibe
  * Most recent version.
@@ -78,14 +83,21 @@
 using namespace std;
 
 #include <string.h>
+#include <assert.h>
 #include <algorithm>
 
-#ifdef __THREAD_SAVE__
-#include <pthread.h>
-#endif
-
 template<class Pixel> class Image;
 
+//-----------------------------------------------------------------------------
+// Atomic reference counting (gcc builtins with a full memory barrier).
+// Reading the counter needs no barrier: only the owner of the last
+// reference can see a count of 1, and no one can add a reference to it
+// without going through that owner.
+//-----------------------------------------------------------------------------
+inline int imageRefInc(int *count){ return __sync_add_and_fetch(count,1); }
+inline int imageRefDec(int *count){ return __sync_sub_and_fetch(count,1); }
+inline int imageRefGet(const int *count){ return *(const volatile int*)count; }
+
 /******************************************************************************
  *                              class ImageData                               *
  *****************************************************************************/
@@ -103,10 +115,6 @@ class ImageData
   int _height;
   Pixel *_data;
 
-#ifdef __THREAD_SAVE__
-  pthread_mutex_t _mutex;
-#endif
-
  public:
   class ObjectInUseException{};
 
@@ -124,10 +132,6 @@ ImageData<Pixel>::ImageData(){
   _width = 0;
   _height = 0;
   _data = 0;
-
-#ifdef __THREAD_SAVE__
-  pthread_mutex_init(&_mutex,0);
-#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -148,10 +152,6 @@ ImageData<Pixel>::ImageData(const int width, const int height,
     _height = 0;
     _data = 0;
   }
-
-#ifdef __THREAD_SAVE__
-  pthread_mutex_init(&_mutex,0);
-#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -159,20 +159,11 @@ ImageData<Pixel>::ImageData(const int width, const int height,
 //-----------------------------------------------------------------------------
 template<class Pixel>
 ImageData<Pixel>::~ImageData(){
-#ifdef __THREAD_SAVE__
-  pthread_mutex_lock(&_mutex);
-#endif
-
   if(_refcount > 1)
     throw ObjectInUseException();
   
   if(_data != 0)
     delete[] _data;
-
-#ifdef __THREAD_SAVE__
-  pthread_mutex_unlock(&_mutex);
-  pthread_mutex_destroy(&_mutex);
-#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -187,6 +178,40 @@ ImageData<Pixel>* ImageData<Pixel>::clone() const {
   return tmp;
 }
 
+/******************************************************************************
+ *                              class ImageView                               *
+ *****************************************************************************/
+// Read-only view of the pixels of an image: a pointer to the first pixel,
+// the size, and the row stride (in pixels). Access is not bounds-checked
+// (only by assert). The view stays valid as long as the image it was
+// taken from is neither written to, nor assigned, nor destroyed.
+template<class Pixel>
+class ImageView
+{
+ public:
+  ImageView() : _data(0), _width(0), _height(0), _stride(0) {}
+  ImageView(const Pixel *data, const int width, const int height,
+	    const int stride)
+    : _data(data), _width(width), _height(height), _stride(stride) {}
+
+  int width() const {return _width;}
+  int height() const {return _height;}
+  int stride() const {return _stride;}
+  bool isEmpty() const {return _data==0;}
+
+  const Pixel* rowPtr(const int y) const {
+    assert(y>=0 && y<_height); return _data + y*_stride;}
+  const Pixel& operator()(const int x, const int y) const {
+    assert(x>=0 && x<_width && y>=0 && y<_height);
+    return _data[y*_stride+x];}
+
+ private:
+  const Pixel *_data;
+  int _width;
+  int _height;
+  int _stride;
+};
+
 /******************************************************************************
  *                                  class Image                               *
  *****************************************************************************/
@@ -206,9 +231,23 @@ class Image
   bool isValid(const int x,const int y) const;
 
   Image<Pixel>& operator=(const Image<Pixel>&);
+  void swap(Image<Pixel>&);
   Pixel operator()(const int x, const int y) const;
   Pixel& operator()(const int x, const int y);
 
+  // Unchecked access for inner loops. Rows are stored contiguously,
+  // stride() pixels apart. The non-const versions make the data unique
+  // first (copy-on-write), so the returned pointers may be used for
+  // writing until the image is copied, assigned, or destroyed.
+  int stride() const {return width();}
+  const Pixel* dataPtr() const;
+  Pixel* dataPtr();
+  const Pixel* rowPtr(const int y) const;
+  Pixel* rowPtr(const int y);
+  ImageView<Pixel> view() const;
+
+  void detach();
+
   void drawEllipse(const int, const int, const int, const int, const Pixel&);
   void drawLine(const int,const int,const int, const int,const Pixel&);
 
@@ -216,6 +255,7 @@ class Image
 
  protected:
   void copy(const Image<Pixel>&,bool constructor=false);
+  void release();
 
  private:
   void drawEllipsePoint(const int,const int,const int,const int,const Pixel&);
@@ -258,23 +298,7 @@ Image<Pixel>::Image(const Image<Pixel>& src){
 //-----------------------------------------------------------------------------
 template<class Pixel>
 Image<Pixel>::~Image(){
-  if(_img != 0){
-#ifdef __THREAD_SAVE__
-    pthread_mutex_lock(&_img->_mutex);
-#endif
-    if(_img->_refcount > 1){
-      _img->_refcount--;
-#ifdef __THREAD_SAVE__
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
-    }
-    else{
-#ifdef __THREAD_SAVE__
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
-      delete _img;
-    }
-  }
+  release();
 }
 
 //-----------------------------------------------------------------------------
@@ -282,19 +306,7 @@ Image<Pixel>::~Image(){
 //-----------------------------------------------------------------------------
 template<class Pixel>
 int Image<Pixel>::width() const {
-  int result;
-  if(_img == 0)
-    result = 0;
-  else{
-#ifdef __THREAD_SAVE__
-    pthread_mutex_lock(&_img->_mutex);
-#endif
-    result = _img->_width;
-#ifdef __THREAD_SAVE__
-    pthread_mutex_unlock(&_img->_mutex);
-#endif
-  }
-  return result;
+  return (_img == 0) ? 0 : _img->_width;
 }
 
 //-----------------------------------------------------------------------------
@@ -302,19 +314,7 @@ int Image<Pixel>::width() const {
 //-----------------------------------------------------------------------------
 template<class Pixel>
 int Image<Pixel>::height() const {
-  int result;
-  if(_img == 0)
-    result = 0;
-  else{
-#ifdef __THREAD_SAVE__
-    pthread_mutex_lock(&_img->_mutex);
-#endif
-    result = _img->_height;
-#ifdef __THREAD_SAVE__
-    pthread_mutex_unlock(&_img->_mutex);
-#endif
-  }
-  return result;
+  return (_img == 0) ? 0 : _img->_height;
 }
 
 //-----------------------------------------------------------------------------
@@ -335,30 +335,29 @@ Image<Pixel>& Image<Pixel>::operator=(const Image<Pixel>& src){
   return *this;
 }
 
+//-----------------------------------------------------------------------------
+// Exchanges the image data of two images in O(1), without touching the
+// reference counts. Use this instead of an assignment when the source is
+// not needed anymore.
+//-----------------------------------------------------------------------------
+template<class Pixel>
+void Image<Pixel>::swap(Image<Pixel>& other){
+  ImageData<Pixel> *tmp = _img;
+  _img = other._img;
+  other._img = tmp;
+}
+
 //-----------------------------------------------------------------------------
 // Read-only access
 //-----------------------------------------------------------------------------
 template<class Pixel>
 Pixel Image<Pixel>::operator()(const int x, const int y) const {
-#ifdef __THREAD_SAVE__
-  if(_img != 0)
-    pthread_mutex_lock(&_img->_mutex);
-#endif
   if(_img == 0 || _img->_data == 0 ||
      x<0 || x>=_img->_width ||
-     y<0 || y>=_img->_height){
-#ifdef __THREAD_SAVE__
-    if(_img != 0)
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
+     y<0 || y>=_img->_height)
     throw OutOfBoundaryException();
-  }
   
-  Pixel result = _img->_data[y*_img->_width+x];
-#ifdef __THREAD_SAVE__
-  pthread_mutex_unlock(&_img->_mutex);
-#endif
-  return result;
+  return _img->_data[y*_img->_width+x];
 }
 
 //-----------------------------------------------------------------------------
@@ -366,31 +365,66 @@ Pixel Image<Pixel>::operator()(const int x, const int y) const {
 //-----------------------------------------------------------------------------
 template<class Pixel>
 Pixel& Image<Pixel>::operator()(const int x, const int y){
-#ifdef __THREAD_SAVE__
-  if(_img != 0 && _img->_refcount > 1)
-    pthread_mutex_lock(&_img->_mutex);
-#endif
   if(_img == 0 || _img->_data == 0 ||
      x<0 || x>=_img->_width ||
-     y<0 || y>=_img->_height){
-#ifdef __THREAD_SAVE__
-    if(_img != 0)
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
+     y<0 || y>=_img->_height)
     throw OutOfBoundaryException();
-  }
 
   // make an identical copy if necessary
-  if(_img->_refcount > 1){
+  detach();
+
+  return _img->_data[y*_img->_width+x];
+}
+
+//-----------------------------------------------------------------------------
+// Make the image data unique, i.e. copy it if it is shared with another
+// image (copy-on-write).
+//-----------------------------------------------------------------------------
+template<class Pixel>
+void Image<Pixel>::detach(){
+  if(_img != 0 && imageRefGet(&_img->_refcount) > 1){
     ImageData<Pixel> *tmp = _img->clone();
-    _img->_refcount--;
-#ifdef __THREAD_SAVE__
-    pthread_mutex_unlock(&_img->_mutex);
-#endif
+    release();
     _img = tmp;
   }
+}
 
-  return _img->_data[y*_img->_width+x];
+//-----------------------------------------------------------------------------
+// Unchecked read-only access to the pixel data and rows
+//-----------------------------------------------------------------------------
+template<class Pixel>
+const Pixel* Image<Pixel>::dataPtr() const {
+  return (_img == 0) ? 0 : _img->_data;
+}
+
+template<class Pixel>
+const Pixel* Image<Pixel>::rowPtr(const int y) const {
+  assert(_img != 0 && y>=0 && y<_img->_height);
+  return _img->_data + y*_img->_width;
+}
+
+template<class Pixel>
+ImageView<Pixel> Image<Pixel>::view() const {
+  if(_img == 0)
+    return ImageView<Pixel>();
+  return ImageView<Pixel>(_img->_data,_img->_width,_img->_height,
+			  _img->_width);
+}
+
+//-----------------------------------------------------------------------------
+// Unchecked read-write access to the pixel data and rows (detaches first)
+//-----------------------------------------------------------------------------
+template<class Pixel>
+Pixel* Image<Pixel>::dataPtr() {
+  detach();
+  return (_img == 0) ? 0 : _img->_data;
+}
+
+template<class Pixel>
+Pixel* Image<Pixel>::rowPtr(const int y) {
+  assert(_img != 0 && y>=0 && y<_img->_height);
+  detach();
+  return _img->_data + y*_img->_width;
 }
 
 //-----------------------------------------------------------------------------
@@ -546,34 +580,23 @@ bool Image<Pixel>::operator==(const Image<Pixel>& other){
 //-----------------------------------------------------------------------------
 template<class Pixel>
 void Image<Pixel>::copy(const Image<Pixel>& src, bool constr) {
-  if(!constr && _img != 0){
-#ifdef __THREAD_SAVE__
-    pthread_mutex_lock(&_img->_mutex);
-#endif
-    if(_img->_refcount > 1){
-      _img->_refcount--;
-#ifdef __THREAD_SAVE__
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
-    }
-    else{
-#ifdef __THREAD_SAVE__
-      pthread_mutex_unlock(&_img->_mutex);
-#endif
-      delete _img;
-    }
-  }
+  // take the new reference first (src might be released with the old one)
+  if(src._img != 0)
+    imageRefInc(&src._img->_refcount);
+  if(!constr)
+    release();
 
   _img = src._img;
-  if(_img != 0){
-#ifdef __THREAD_SAVE__
-    pthread_mutex_lock(&_img->_mutex);
-#endif
-    _img->_refcount++;
-#ifdef __THREAD_SAVE_
-    pthread_mutex_unlock(&_img->_mutex);
-#endif
-  }
+}
+
+//-----------------------------------------------------------------------------
+// Drops the reference to the image data and deletes it if it was the last.
+//-----------------------------------------------------------------------------
+template<class Pixel>
+void Image<Pixel>::release() {
+  if(_img != 0 && imageRefDec(&_img->_refcount) == 0)
+    delete _img;
+  _img = 0;
 }
  
 //-----------------------------------------------------------------------------
@@ -450,6 +450,9 @@ void RFISMReco::train()
 		return;
 	}
 	m_rfForest.trainRandomForest(m_vpsPatch4Train);
+	// The forest keeps the patches, our images aren't needed any more
+	m_rfForest.releasePatchImages(m_vpsPatch4Train);
+	m_cfForest.compile(m_rfForest);
 
     //Display the trained nodes
 	m_rfForest.drawClusters( qClassView );	
@@ -473,6 +476,9 @@ void RFISMReco::trainwithpuri()
 	vector<uint32_t> removedIndex;
 	vector<uint32_t> top100DiscriminantIndex;
 	m_rfForest.trainRandomForest(m_vpsPatch4Train);
+	// The forest keeps the patches, our images aren't needed any more
+	m_rfForest.releasePatchImages(m_vpsPatch4Train);
+	m_cfForest.compile(m_rfForest);
 	m_rfForest.drawClusters(qClassView);
 	m_rfForest.purifyTrainingSet(removedIndex, top100DiscriminantIndex);
 	//Display the removed patches
@@ -480,8 +486,9 @@ void RFISMReco::trainwithpuri()
 	vector<QImage> vQImg;
 	for(int i=0;i<removedIndex.size();i++)
 	{
-		vImg.push_back(m_vpsPatch4Train[removedIndex[i]].vChannels[0]);
-		vQImg.push_back(m_vpsPatch4Train[removedIndex[i]].vChannels[0].getQtImage());
+		OpGrayImage img = m_rfForest.getPatchSample(removedIndex[i]).vChannels[0];
+		vImg.push_back(img);
+		vQImg.push_back(img.getQtImage());
 	}
 	QtImgBrowser *qtSupportingBrowser = new QtImgBrowser(0, "Removed positive patches");
 	qtSupportingBrowser->setGeometry(950, 200, 300, 350);
@@ -494,8 +501,9 @@ void RFISMReco::trainwithpuri()
 	vQImg.clear();
 	for(int i=0;i<top100DiscriminantIndex.size();i++)
 	{
-		vImg.push_back(m_vpsPatch4Train[top100DiscriminantIndex[i]].vChannels[0]);
-		vQImg.push_back(m_vpsPatch4Train[top100DiscriminantIndex[i]].vChannels[0].getQtImage());
+		OpGrayImage img = m_rfForest.getPatchSample(top100DiscriminantIndex[i]).vChannels[0];
+		vImg.push_back(img);
+		vQImg.push_back(img.getQtImage());
 	}
 	QtImgBrowser *qtSupportingBrowser2 = new QtImgBrowser(0, "The most discriminant patches");
 	qtSupportingBrowser2->setGeometry(950, 200, 300, 350);
@@ -659,6 +667,7 @@ void RFISMReco::loadRandomForest()
                            "XML (*.xml *.XML *.Xml);;All files (*.*)", this, "imageset", "Select Images" );
 
 	m_rfForest.loadRandomForest(fileName.toStdString().data());
+	m_cfForest.compile(m_rfForest);
 }
 
 void RFISMReco::test()
@@ -690,11 +699,8 @@ void RFISMReco::test()
                             DEFAULTOBJECTWIDTH, DEFAULTOBJECTHEIGHT,	
 							DEFAULTMINSCALE, DEFAULTMAXSCALE,
 							DEFAULTDIM, vBins,
-							&m_rfForest); 
- for(int i=0;i<m_vpsPatch4Test.size();i++)
- {
-	vsHough->voteWithPatch( m_vpsPatch4Test[i], i );
- }
+							&m_rfForest, &m_cfForest); 
+ vsHough->voteWithPatches( m_vpsPatch4Test );
  vsHough->displayConfMap();
  vector<FeatureVector> vfvCoord;
  vector<float> vdValue;
@@ -833,11 +839,8 @@ void RFISMReco::test(	vector<FeatureVector>&				vfvCoord,
                             DEFAULTOBJECTWIDTH, DEFAULTOBJECTHEIGHT,	
 							DEFAULTMINSCALE, DEFAULTMAXSCALE,
 							DEFAULTDIM, vBins,
-							&m_rfForest); 
- for(int i=0;i<m_vpsPatch4Test.size();i++)
- {
-	vsHough->voteWithPatch( m_vpsPatch4Test[i], i );
- }
+							&m_rfForest, &m_cfForest); 
+ vsHough->voteWithPatches( m_vpsPatch4Test );
  FeatureVector fvResult;
  float dScore;
  vfvCoord.clear();
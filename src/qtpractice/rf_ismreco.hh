@@ -28,6 +28,7 @@ using namespace std;
 #include <featurecue.hh>
 #include <featuregui.hh>
 #include <randomforest.hh>
+#include <compiledforest.hh>
 #include <randomforestgui.hh>
 #include <votingspace.hh>
 /********************************/
@@ -87,6 +88,7 @@ private:
 
 	FeatureCue		m_fcCue;	
 	RandomForest	m_rfForest;
+	CompiledForest	m_cfForest;	// compiled once per trained/loaded forest
 	PointVector		m_vPoints;
 	PointVector		m_vPointsInside;
 
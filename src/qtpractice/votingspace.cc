@@ -78,7 +78,8 @@ void HoughVote::copyFromOther(const HoughVote& other)
 VotingSpace::VotingSpace(int nWidth, int nHeight, int nBoxWidth, int nBoxHeight, 
 			int nMinScale, int nMaxScale,
 			int nDims, vector<int> vBins, 
-			RandomForest*  prfRandomForest)
+			RandomForest*  prfRandomForest,
+			const CompiledForest* pcfForest)
 {
 	m_nWidth = nWidth;
 	m_nHeight = nHeight;
@@ -98,8 +99,9 @@ VotingSpace::VotingSpace(int nWidth, int nHeight, int nBoxWidth, int nBoxHeight,
 	}
     // The scale dimension is determined by min and max.
     m_vBins[2] = m_nMaxScale - m_nMinScale + 1;
+	m_bGaussianSplat = true;
 	if(prfRandomForest!=NULL)
-		m_prfRandomForest = prfRandomForest;
+		loadRandomForest(prfRandomForest, pcfForest);
 	else
 	{
 		cout<<" error: randomforest is not available."<<endl;
@@ -111,11 +113,13 @@ VotingSpace::VotingSpace(int nWidth, int nHeight, int nBoxWidth, int nBoxHeight,
 VotingSpace::~VotingSpace()
 {	
 	m_prfRandomForest = NULL;
+	m_pcfForest = NULL;
 }
 
-void VotingSpace::loadRandomForest(RandomForest*  prfForest)
+void VotingSpace::loadRandomForest(RandomForest*  prfForest, const CompiledForest* pcfForest)
 {
 	m_prfRandomForest = prfForest;
+	m_pcfForest = (pcfForest!=NULL && !pcfForest->isEmpty()) ? pcfForest : NULL;
 }
 void VotingSpace::createVotingSpace()
 /*========================================================================*/
@@ -139,6 +143,9 @@ void VotingSpace::createVotingSpace(vector<int> vBins)
 	vector< list<HoughVote> > tmpvHoughVote(nBins, tmpHoughVote);
 	// !! The voting space for class 0 is also stored, but DO NOT use it !
 	m_vvlVotes.assign(m_prfRandomForest->getTotalClasses(), tmpvHoughVote);
+	m_vdSliceSums.assign(m_vBins[0]*m_vBins[1], 0);
+	m_vbSliceHit.assign(m_vBins[0]*m_vBins[1], 0);
+	m_vnSliceHits.clear();
 }
 
 void VotingSpace::voteWithPatch(const PatchSample& patch, int nIndex, int nClass)
@@ -147,64 +154,21 @@ void VotingSpace::voteWithPatch(const PatchSample& patch, int nIndex, int nClass
 /* This function only fill in the voting space of class nClass.               */
 /*============================================================================*/
 {
-	// Center and Scale
-	int x = patch.fvOffset.x;
-	int y = patch.fvOffset.y;
-	float dScale = patch.fvOffset.scale;
 	// Test the patch in the randomforest
 	float dThres = 1.0/m_vvlVotes.size();
 	vector<FeatureVector> vfvCoords;
 	vector<float> vCoeff;
 	vector<uint32_t> vnLeafNodes;
 	vector<float> vdConfidence;
-	m_prfRandomForest->testRandomForestSingleClass( patch,dThres, vfvCoords, vCoeff, vnLeafNodes, vdConfidence, nClass );
-	// Traverse the nearby region of the test patch in the Patch's scale.
-	float dTmp = 100;
-	int nTmpIndex;
-	for(int i=m_nMinScale;i<=m_nMaxScale;i++)
-	{
-		if(fabs(dScale - pow(sqrt(2),i))<dTmp)
-		{
-			dTmp = fabs(dScale - pow(sqrt(2),i));
-			nTmpIndex = i;
-		}
-	}
-	if(dTmp>=THRESHOLD_SCALE)
-	{
-		cout<<"error in voteWithPatch: scale unidentified!"<<endl;
-		exit(0);
-	}
-	// The start index and end index in the vector
-	int nStartIndex = (nTmpIndex - m_nMinScale) * m_vBins[0] * m_vBins[1];
-	int nEndIndex = nStartIndex + m_vBins[0]*m_vBins[1] - 1;
-	FeatureVector fvBinOffsetScaled(2);
-	FeatureVector fvDiff(2);
-	for( int i=nStartIndex;i<=nEndIndex;i++)
+	if(m_pcfForest==NULL)
+		m_prfRandomForest->testRandomForestSingleClass( patch,dThres, vfvCoords, vCoeff, vnLeafNodes, vdConfidence, nClass );
+	else
 	{
-		FeatureVector fvBinPos = getBinOffSet(i);
-		fvBinOffsetScaled.setValue(0, (fvBinPos.at(0) - x)*dScale);
-		fvBinOffsetScaled.setValue(1, (fvBinPos.at(1) - y)*dScale);
-		if(isInBox(x, y, dScale, fvBinPos.at(0), fvBinPos.at(1)))
-		{
-		// This bin is in the nearby box, calculate the votes.
-			double value = 0; 
-			for(int j=0;j<vCoeff.size();j++)
-			{
-				fvDiff = fvBinOffsetScaled - vfvCoords[j];
-				/*cout<<"Voting for bin at("<<fvBinPos.at(0)<<","<<fvBinPos.at(1)
-                    <<")"<<endl;
-                cout<<"Diff = ("<<fvDiff.at(0)<<","<<fvDiff.at(1)<<")"<<endl;
-                cout<<"Voting Score = "<<vCoeff[j]*exp(-fvDiff.dot(fvDiff)/2/EPS2)/2/PI/EPS2<<endl;*/
-				value+=vCoeff[j]*exp(-fvDiff.dot(fvDiff)/2/EPS2)/2/PI/EPS2;
-			}
-		// generate the vote with this patch
-			HoughVote vote(fvBinOffsetScaled.at(0), fvBinOffsetScaled.at(1), dScale,value, 
-							nIndex, vnLeafNodes, vdConfidence);
-		// Insert the vote in m_vvlVotes
-			m_vvlVotes[nClass][i].push_back(vote);
-		}
+		vector<uint32_t> vLeaves;
+		m_pcfForest->testPatch( patch, vLeaves );
+		m_pcfForest->getVotesSingleClass( &vLeaves[0], dThres, vfvCoords, vCoeff, vnLeafNodes, vdConfidence, nClass );
 	}
-	
+	scatterVotes( patch, nIndex, nClass, vfvCoords, vCoeff, vnLeafNodes, vdConfidence );
 }
 
 void VotingSpace::voteWithPatch(const PatchSample& patch, int nIndex)
@@ -212,18 +176,165 @@ void VotingSpace::voteWithPatch(const PatchSample& patch, int nIndex)
 /* Test the patch and fill in the voting space. All classes are voted for */
 /*========================================================================*/
 {
-	// Center and Scale
-	int x = patch.fvOffset.x;
-	int y = patch.fvOffset.y;
-	float dScale = patch.fvOffset.scale;
 	// Test the patch in the randomforest
 	float dThres = 1.0/m_vvlVotes.size();
 	vector< vector<FeatureVector> > vvfvCoords;
 	vector< vector<float> > vvCoeff;
 	vector<uint32_t> vnLeafNodes;
 	vector< vector<float> > vvdConfidence;
-	m_prfRandomForest->testRandomForestMultiClass( patch, dThres, vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence);
-	// Traverse the nearby region of the test patch in the Patch's scale.
+	if(m_pcfForest==NULL)
+		m_prfRandomForest->testRandomForestMultiClass( patch, dThres, vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence);
+	else
+	{
+		vector<uint32_t> vLeaves;
+		m_pcfForest->testPatch( patch, vLeaves );
+		m_pcfForest->getVotesMultiClass( &vLeaves[0], dThres, vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence);
+	}
+	castVotes( patch, nIndex, vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence );
+}
+
+void VotingSpace::voteWithPatches(const vector<PatchSample>& vPatches)
+/*========================================================================*/
+/* Test all patches in one go (in parallel) and fill in the voting space. */
+/* The result is the same as calling voteWithPatch(vPatches[i], i).       */
+/*========================================================================*/
+{
+	if(m_pcfForest==NULL)
+	{
+		for(int i=0;i<vPatches.size();i++)
+			voteWithPatch( vPatches[i], i );
+		return;
+	}
+	vector<uint32_t> vLeaves;
+	m_pcfForest->testPatches( vPatches, vLeaves );
+	if(vLeaves.size() != vPatches.size()*m_pcfForest->numTrees())
+	{
+		cout<<"error in voteWithPatches: the patches could not be tested!"<<endl;
+		return;
+	}
+	float dThres = 1.0/m_vvlVotes.size();
+	vector< vector<FeatureVector> > vvfvCoords;
+	vector< vector<float> > vvCoeff;
+	vector<uint32_t> vnLeafNodes;
+	vector< vector<float> > vvdConfidence;
+	for(int i=0;i<vPatches.size();i++)
+	{
+		m_pcfForest->getVotesMultiClass( &vLeaves[i*m_pcfForest->numTrees()], dThres,
+									   vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence);
+		castVotes( vPatches[i], i, vvfvCoords, vvCoeff, vnLeafNodes, vvdConfidence );
+	}
+}
+
+void VotingSpace::castVotes(const PatchSample& patch, int nIndex,
+							const vector< vector<FeatureVector> >& vvfvCoords,
+							const vector< vector<float> >& vvCoeff,
+							const vector<uint32_t>& vnLeafNodes,
+							const vector< vector<float> >& vvdConfidence)
+/*========================================================================*/
+/* Fill in the votes of a tested patch for all classes.                   */
+/*========================================================================*/
+{
+	for(int nClass=1;nClass<m_vvlVotes.size();nClass++)
+		scatterVotes( patch, nIndex, nClass, vvfvCoords[nClass], vvCoeff[nClass],
+					  vnLeafNodes, vvdConfidence[nClass] );
+}
+
+void VotingSpace::scatterVotes(const PatchSample& patch, int nIndex, int nClass,
+							   const vector<FeatureVector>& vfvCoords,
+							   const vector<float>& vCoeff,
+							   const vector<uint32_t>& vnLeafNodes,
+							   const vector<float>& vdConfidence)
+/*========================================================================*/
+/* Fill in the votes of a tested patch for class nClass. Each offset goes */
+/* directly to the bins around the position it points to, instead of     */
+/* testing every bin of the scale slice against every offset. A bin gets  */
+/*     sum_j  Coeff_j * exp(-|d_j|^2/2/EPS2)/2/PI/EPS2                    */
+/* with d_j the difference between the offset of the bin from the patch  */
+/* (in the patch's scale) and offset j. Bins further than SPLAT_RADIUS    */
+/* std. deviations from an offset are left out for that offset.          */
+/* Without Gaussian splatting, an offset adds the peak value of the       */
+/* kernel to the bin it falls in. As before, only bins inside the box     */
+/* around the patch are voted for, and each bin hit gets one HoughVote.   */
+/*========================================================================*/
+{
+	// Center and Scale
+	int x = patch.fvOffset.x;
+	int y = patch.fvOffset.y;
+	float dScale = patch.fvOffset.scale;
+	int nStartIndex = getScaleIndex(dScale) * m_vBins[0] * m_vBins[1];
+	float dXStep = getXStep();
+	float dYStep = getYStep();
+	// Radius of the kernel in the image
+	float dRadius = SPLAT_RADIUS*sqrt(EPS2)/dScale;
+	for(int j=0;j<vCoeff.size();j++)
+	{
+		// Position in the image the offset points to
+		float ox = vfvCoords[j].at(0);
+		float oy = vfvCoords[j].at(1);
+		float tx = x + ox/dScale;
+		float ty = y + oy/dScale;
+		if(!m_bGaussianSplat)
+		{
+			int nX = (int)floor(tx/dXStep);
+			int nY = (int)floor(ty/dYStep);
+			if(nX<0 || nX>=m_vBins[0] || nY<0 || nY>=m_vBins[1] ||
+			   !isInBox(x, y, dScale, dXStep*(nX+0.5), dYStep*(nY+0.5)))
+				continue;
+			int nBin = nX + nY*m_vBins[0];
+			if(!m_vbSliceHit[nBin])
+			{
+				m_vbSliceHit[nBin] = 1;
+				m_vnSliceHits.push_back(nBin);
+			}
+			m_vdSliceSums[nBin] += vCoeff[j]/2/PI/EPS2;
+			continue;
+		}
+		// Bins whose centers are within the radius
+		int nXMin = max(0, (int)ceil((tx - dRadius)/dXStep - 0.5));
+		int nXMax = min(m_vBins[0]-1, (int)floor((tx + dRadius)/dXStep - 0.5));
+		int nYMin = max(0, (int)ceil((ty - dRadius)/dYStep - 0.5));
+		int nYMax = min(m_vBins[1]-1, (int)floor((ty + dRadius)/dYStep - 0.5));
+		for(int nY=nYMin;nY<=nYMax;nY++)
+		{
+			float dBinY = dYStep*(nY+0.5);
+			for(int nX=nXMin;nX<=nXMax;nX++)
+			{
+				float dBinX = dXStep*(nX+0.5);
+				if(!isInBox(x, y, dScale, dBinX, dBinY))
+					continue;
+				float dx = (dBinX - x)*dScale - ox;
+				float dy = (dBinY - y)*dScale - oy;
+				float dDist = dx*dx + dy*dy;
+				int nBin = nX + nY*m_vBins[0];
+				if(!m_vbSliceHit[nBin])
+				{
+					m_vbSliceHit[nBin] = 1;
+					m_vnSliceHits.push_back(nBin);
+				}
+				m_vdSliceSums[nBin] += vCoeff[j]*exp(-dDist/2/EPS2)/2/PI/EPS2;
+			}
+		}
+	}
+	// Generate the votes of this patch and reset the scratch space
+	for(int i=0;i<m_vnSliceHits.size();i++)
+	{
+		int nBin = m_vnSliceHits[i];
+		float dBinX = dXStep*(nBin%m_vBins[0]+0.5);
+		float dBinY = dYStep*(nBin/m_vBins[0]+0.5);
+		HoughVote vote((dBinX - x)*dScale, (dBinY - y)*dScale, dScale, m_vdSliceSums[nBin],
+						nIndex, vnLeafNodes, vdConfidence);
+		m_vvlVotes[nClass][nStartIndex + nBin].push_back(vote);
+		m_vdSliceSums[nBin] = 0;
+		m_vbSliceHit[nBin] = 0;
+	}
+	m_vnSliceHits.clear();
+}
+
+int VotingSpace::getScaleIndex(float dScale)
+/*========================================================================*/
+/* Find the scale slice (0..m_vBins[2]-1) of a patch with scale dScale.   */
+/*========================================================================*/
+{
 	float dTmp = 100;
 	int nTmpIndex;
 	for(int i=m_nMinScale;i<=m_nMaxScale;i++)
@@ -239,43 +350,9 @@ void VotingSpace::voteWithPatch(const PatchSample& patch, int nIndex)
 		cout<<"error in voteWithPatch: scale unidentified!"<<endl;
 		exit(0);
 	}
-	// Fill in the nearby bins in current scale
-	int nStartIndex = (nTmpIndex - m_nMinScale) * m_vBins[0] * m_vBins[1];
-	int nEndIndex = nStartIndex + m_vBins[0]*m_vBins[1] - 1;
-	FeatureVector fvBinOffsetScaled(2);
-	FeatureVector fvDiff(2);
-	for( int i=nStartIndex;i<=nEndIndex;i++)
-	{
-		FeatureVector fvBinPos = getBinOffSet(i);
-		fvBinOffsetScaled.setValue(0, (fvBinPos.at(0) - x)*dScale);
-		fvBinOffsetScaled.setValue(1, (fvBinPos.at(1) - y)*dScale);
-		if(isInBox(x, y, dScale, fvBinPos.at(0), fvBinPos.at(1)))
-		{
-			for(int nClass=1;nClass<m_vvlVotes.size();nClass++)
-			{
-				// This bin is in the nearby box, calculate the votes.
-				double value = 0; 
-				for(int j=0;j<vvCoeff[nClass].size();j++)
-				{
-					fvDiff = fvBinOffsetScaled - vvfvCoords[nClass][j];
-					/*cout<<"Voting for bin at("<<fvBinPos.at(0)<<","<<fvBinPos.at(1)
-						<<")"<<endl;
-					cout<<"Diff = ("<<fvDiff.at(0)<<","<<fvDiff.at(1)<<")"<<endl;
-					cout<<"Voting Score = "<<vCoeff[j]*exp(-fvDiff.dot(fvDiff)/2/EPS2)/2/PI/EPS2<<endl;*/
-					value+=vvCoeff[nClass][j]*exp(-fvDiff.dot(fvDiff)/2/EPS2)/2/PI/EPS2;
-				}
-				// generate the vote with this patch, if the average coffidence of this patch is above 
-				// dThres
-			
-				HoughVote vote(fvBinOffsetScaled.at(0), fvBinOffsetScaled.at(1), dScale,value, 
-								nIndex, vnLeafNodes, vvdConfidence[nClass]);
-				// Insert the vote in m_vvlVotes
-				m_vvlVotes[nClass][i].push_back(vote);
-			}
-		}
-	}
-	
+	return nTmpIndex - m_nMinScale;
 }
+
 FeatureVector  VotingSpace::getBinOffSet( int index )
 {
   // The bins are arranges from the first dimension to the last, such as:
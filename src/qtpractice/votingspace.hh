@@ -16,6 +16,7 @@
 /*     Includes    */
 /*******************/ 
 #include <randomforest.hh>
+#include <compiledforest.hh>
 #include <featurevector.hh>
 #include <opgrayimage.hh>
 #include <vector>
@@ -28,6 +29,7 @@
 const float THRESHOLD_PROBABILITYVOTE = 0.1;
 const float THRESHOLD_SCALE = 0.001;
 const float EPS2 = 9;
+const float SPLAT_RADIUS = 4;	// Radius of the vote kernel in std. deviations (sqrt(EPS2))
 const float EPS_MSME = 0.00005; //??
 const float SCALE_FACTOR = sqrt(2);
 const float PI = 3.1415926535;
@@ -88,17 +90,26 @@ public:
 	VotingSpace(int nWidth, int nHeight, int nBoxWidth, int nBoxHeight,
 				int dMinScale, int dMaxScale, 
 				int nDims, vector<int> vBins, 
-				RandomForest* prfRandomForest);
+				RandomForest* prfRandomForest,
+				const CompiledForest* pcfForest = NULL);
 	~VotingSpace();
 public:
 	/*  Random Forest  */
-	void loadRandomForest(RandomForest*  prfForest);
+	// The patches are tested with pcfForest (compiled from prfForest by
+	// the caller, once per forest) if it is given and not empty.
+	void loadRandomForest(RandomForest*  prfForest, const CompiledForest* pcfForest = NULL);
 	/*  Create Voting Space */
 	void createVotingSpace();
 	void createVotingSpace(vector<int> vBins);
 	//void clearVotingSpace();
    	void voteWithPatch(const PatchSample& patch, int nIndex, int nClass);	
 	void voteWithPatch(const PatchSample& patch, int nIndex); 
+	// Vote with all patches (patch i has the index i). The patches are
+	// tested together if there is a compiled forest.
+	void voteWithPatches(const vector<PatchSample>& vPatches);
+	// Spread each offset vote over the nearby bins with the Gaussian kernel
+	// (default), or put it into the bin it points to only.
+	void setGaussianSplatting(bool bSplat){m_bGaussianSplat = bSplat;}
 	/*	Get the result */
 private:
 	/* Functions that I dont want to use */
@@ -118,6 +129,17 @@ private:
 							FeatureVector& fvNewPos, float& dScore);
 	inline float getXStep(){ return float(m_nWidth)/m_vBins[0];}
 	inline float getYStep(){ return float(m_nHeight)/m_vBins[1];}
+	int getScaleIndex(float dScale);	// Index of the scale slice of a patch
+	void castVotes(	const PatchSample& patch, int nIndex,
+					const vector< vector<FeatureVector> >& vvfvCoords,
+					const vector< vector<float> >& vvCoeff,
+					const vector<uint32_t>& vnLeafNodes,
+					const vector< vector<float> >& vvdConfidence);
+	void scatterVotes(	const PatchSample& patch, int nIndex, int nClass,
+						const vector<FeatureVector>& vfvCoords,
+						const vector<float>& vCoeff,
+						const vector<uint32_t>& vnLeafNodes,
+						const vector<float>& vdConfidence);
 	
 public:
 	/* results */
@@ -142,6 +164,7 @@ public:
 private:	
 	/* Member variants */
     RandomForest*	m_prfRandomForest;
+	const CompiledForest* m_pcfForest;	// flat copy of m_prfRandomForest for testing
 	vector<HoughVote> m_vVotes;
 	int m_nDims;			// Number of dimensions
 	vector<int> m_vBins;	// Number of Bins of each dimension
@@ -152,6 +175,12 @@ private:
 	int m_nMaxScale;	// Max and Min Scale index for sqrt(2)'s power
 	int m_nMinScale;	
 	vector< vector< list<HoughVote> > > m_vvlVotes;
+	bool m_bGaussianSplat;
+	// Scratch space of scatterVotes(): the sums of one scale slice and
+	// the bins that have been hit
+	vector<double> m_vdSliceSums;
+	vector<char> m_vbSliceHit;
+	vector<int> m_vnSliceHits;
 	
 };
 
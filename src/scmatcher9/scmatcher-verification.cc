@@ -31,6 +31,7 @@
 #include <opgrayimage.hh>
 #include <qtimgbrowser.hh>
 #include <chamfermatching.h>
+#include <chamferengine.h>
 
 #include "scmatcher.hh"
 
@@ -585,7 +586,8 @@ void ISMReco::verifyHyposChamfer( const vector<Hypothesis> &vInitialHypos,
     QImage      qimgDT = ChamferMatching::drawDT( imgDT );
     vResultQImgs.push_back( qimgDT );
 
-    /* perform Chamfer matching with all templates */
+    /* perform Chamfer matching with all templates at once */
+    ChamferEngine     engine( imgDT );
     CombiCandidateSet vCandidates;
     int nMaxCandidates = 10;
     for( int i=0; i<(int)m_vTemplates.size(); i++ ) {
@@ -595,12 +597,10 @@ void ISMReco::verifyHyposChamfer( const vector<Hypothesis> &vInitialHypos,
                    (int)floor(m_vSilhouettes[i].width()*0.75+0.5) );
       int maxy = ( imgDT.height() - 
                    (int)floor(m_vSilhouettes[i].height()*0.75+0.5) );
-      ChamferMatching:: matchTemplateOnWindow( vCandidates, imgDT, 
-                                               m_vSilhouettes[i], 
-                                               m_vTemplates[i], i,
-                                               minx, miny, maxx, maxy, 
-                                               nMaxCandidates );
+      engine.addJob( m_vSilhouettes[i], m_vTemplates[i], i,
+                     minx, miny, maxx, maxy );
     }
+    engine.matchJobs( vCandidates, nMaxCandidates );
     
     /* display the best-matching templates */
     QImage qimgResult = ChamferMatching:: drawImageResult( vCandidates, 
@@ -710,7 +710,8 @@ void ISMReco::verifyHyposTemplate( const vector<Hypothesis> &vInitHypos,
     QImage      qimgDT = ChamferMatching::drawDT( imgDT );
     vResultQImgs.push_back( qimgDT );
 
-    /* perform Chamfer matching with all templates */
+    /* perform Chamfer matching with all templates and scales at once */
+    ChamferEngine     engine( imgDT );
     CombiCandidateSet vCandidates;
     int nMaxCandidates = 150;
     int nNumScales = 7;
@@ -745,14 +746,11 @@ void ISMReco::verifyHyposTemplate( const vector<Hypothesis> &vInitHypos,
         int miny = nStartY - nWinSize;
         int maxx = nStartX + nWinSize;
         int maxy = nStartY + nWinSize;
-        ChamferMatching::matchTemplateOnWindow( vCandidates, imgDT, 
-                                                m_vSilhMasks[i], 
-                                                m_vTemplates[i], i,
-                                                minx, miny, maxx, maxy, 
-                                                dScaleFact, nStepSize,
-                                                nMaxCandidates );
+        engine.addJob( m_vSilhMasks[i], m_vTemplates[i], i,
+                       minx, miny, maxx, maxy, dScaleFact, nStepSize );
       }
     }
+    engine.matchJobs( vCandidates, nMaxCandidates );
     
     /* compute the Bhattacharya coefficients of the best-matching candidates */
     /* print out the results */
@@ -2307,7 +2307,7 @@ void ISMReco::refineHypothesesMultiScale( bool bDisplayResults )
   /***********************/
   /* Get the occurrences */
   /***********************/
-  VecVecOccurrence vvOccurrences = m_ismReco.getOccurrences();
+  const VecVecOccurrence &vvOccurrences = m_ismReco.getOccurrences();
 
   /*************************************************/
   /*   Look up all possibly contributing patches   */
@@ -2675,8 +2675,8 @@ vector<Hypothesis> ISMReco::getPatchHypotheses( bool bDisplayResults )
       
       for( int i=0; i<(int)vVotes.size(); i++ ) {
 	if(vVotes[i].getValue()>=0){
-	   hScales.insertValue( vVotes[i].getCoords().at(2) );
-	   hScaleScores.incrementValue( vVotes[i].getCoords().at(2),
+	   hScales.insertValue( vVotes[i].coord(2) );
+	   hScaleScores.incrementValue( vVotes[i].coord(2),
 					     vVotes[i].getValue() );
 	}
       }
@@ -2759,7 +2759,7 @@ vector<HoughVote> ISMReco::filterVotes( const Hypothesis &hypo,
   float dMinAspect = tan(dAspect - dMSMESizeA);
   float dMaxAspect = tan(dAspect + dMSMESizeA);
 
-  VecVecOccurrence vvOccurrences = m_ismReco.getOccurrences();
+  const VecVecOccurrence &vvOccurrences = m_ismReco.getOccurrences();
 
   /* Filter the votes to the selected rotation and aspect */
   vector<HoughVote> vResults;
@@ -3094,7 +3094,7 @@ void ISMReco::displayScaleFootprint()
   QImage imgQScaleHisto; 
 
   /* Get the occurrences */
-  VecVecOccurrence vvOccurrences = m_ismReco.getOccurrences();
+  const VecVecOccurrence &vvOccurrences = m_ismReco.getOccurrences();
 
   /* create a scale footprint for the interest points */
   for( int i=0; i<(int)m_vPointsInside.size(); i++ )